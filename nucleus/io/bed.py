@@ -89,18 +89,29 @@ class NativeBedReader(genomics_reader.GenomicsReader):
     self._reader = bed_reader.BedReader.from_file(bed_path, options)
     self.header = self._reader.header
 
-  def query(self):
+  def query(self, region):
     """Returns an iterator for going through the records in the region.
 
-    NOTE: This function is not currently implemented by NativeBedReader though
-    it could be implemented for sorted, tabix-indexed BED files.
+    Requires a bgzip-compressed file with a tabix or CSI index (see
+    nucleus.io.tabix.build_index with preset='bed').
+
+    Args:
+      region: nucleus.genomics.v1.Range. The region to query.
     """
-    raise NotImplementedError('Can not currently query a BED file')
+    return self._reader.query(region)
 
   def iterate(self):
     """Returns an iterable of BedRecord protos in the file."""
     return self._reader.iterate()
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -140,6 +151,10 @@ class NativeBedWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -19,11 +19,12 @@
 
 #include <algorithm>
 #include <utility>
-#include <vector>
 
 #include "absl/strings/match.h"
-#include "absl/strings/numbers.h"
-#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "nucleus/io/field_scanner.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bed.pb.h"
 #include "nucleus/util/utils.h"
@@ -51,28 +52,28 @@ bool ValidNumBedFields(const int fields) {
           fields == 8 || fields == 9 || fields == 12);
 }
 
-// Read the next non-comment line.
-tf::Status NextNonCommentLine(TextReader& text_reader, string* line) {
+// The maximum number of fields in a BED record.
+constexpr int kMaxBedFields = 12;
+
+// Read the next non-comment line. On success, *line points into text_reader's
+// line buffer and remains valid until the next read.
+tf::Status NextNonCommentLine(TextReader& text_reader,
+                              absl::string_view* line) {
   CHECK(line != nullptr);
-  string tmp;
   do {
-    StatusOr<string> line_or = text_reader.ReadLine();
-    TF_RETURN_IF_ERROR(line_or.status());
-    tmp = line_or.ValueOrDie();
-  } while (absl::StartsWith(tmp, BED_COMMENT_PREFIX));
-
-  *line = tmp;
+    TF_RETURN_IF_ERROR(text_reader.ReadLine(line));
+  } while (absl::StartsWith(*line, BED_COMMENT_PREFIX));
   return tf::Status::OK();
 }
 
-tf::Status ConvertToPb(const string& line, const int desiredNumFields,
+tf::Status ConvertToPb(absl::string_view line, const int desiredNumFields,
                        int* numTokensSeen,
                        nucleus::genomics::v1::BedRecord* record) {
   CHECK(record != nullptr) << "BED record cannot be null";
   record->Clear();
 
-  std::vector<string> tokens = absl::StrSplit(line, '\t');
-  int numTokens = static_cast<int>(tokens.size());
+  absl::string_view tokens[kMaxBedFields];
+  int numTokens = SplitFields(line, '\t', absl::MakeSpan(tokens));
   *numTokensSeen = numTokens;
   if (!ValidNumBedFields(numTokens)) {
     return tf::errors::Unknown("BED record has invalid number of fields");
@@ -80,15 +81,21 @@ tf::Status ConvertToPb(const string& line, const int desiredNumFields,
   int numFields =
       desiredNumFields == 0 ? numTokens : std::min(numTokens, desiredNumFields);
   int64 int64Value;
-  record->set_reference_name(tokens[0]);
-  CHECK(absl::SimpleAtoi(tokens[1], &int64Value));
+  record->set_reference_name(tokens[0].data(), tokens[0].size());
+  if (!ParseInt64(tokens[1], &int64Value)) {
+    return tf::errors::Unknown("Unable to parse start position in BED");
+  }
   record->set_start(int64Value);
-  CHECK(absl::SimpleAtoi(tokens[2], &int64Value));
+  if (!ParseInt64(tokens[2], &int64Value)) {
+    return tf::errors::Unknown("Unable to parse end position in BED");
+  }
   record->set_end(int64Value);
-  if (numFields > 3) record->set_name(tokens[3]);
+  if (numFields > 3) record->set_name(tokens[3].data(), tokens[3].size());
   if (numFields > 4) {
     double value;
-    CHECK(absl::SimpleAtod(tokens[4].c_str(), &value));
+    if (!ParseDouble(tokens[4], &value)) {
+      return tf::errors::Unknown("Unable to parse score in BED");
+    }
     record->set_score(value);
   }
   if (numFields > 5) {
@@ -102,18 +109,24 @@ tf::Status ConvertToPb(const string& line, const int desiredNumFields,
       return tf::errors::Unknown("Invalid BED record with unknown strand");
   }
   if (numFields > 7) {
-    CHECK(absl::SimpleAtoi(tokens[6], &int64Value));
+    if (!ParseInt64(tokens[6], &int64Value)) {
+      return tf::errors::Unknown("Unable to parse thick start in BED");
+    }
     record->set_thick_start(int64Value);
-    CHECK(absl::SimpleAtoi(tokens[7], &int64Value));
+    if (!ParseInt64(tokens[7], &int64Value)) {
+      return tf::errors::Unknown("Unable to parse thick end in BED");
+    }
     record->set_thick_end(int64Value);
   }
-  if (numFields > 8) record->set_item_rgb(tokens[8]);
+  if (numFields > 8) record->set_item_rgb(tokens[8].data(), tokens[8].size());
   if (numFields >= 12) {
     int32 int32Value;
-    CHECK(absl::SimpleAtoi(tokens[9], &int32Value));
+    if (!ParseInt32(tokens[9], &int32Value)) {
+      return tf::errors::Unknown("Unable to parse block count in BED");
+    }
     record->set_block_count(int32Value);
-    record->set_block_sizes(tokens[10]);
-    record->set_block_starts(tokens[11]);
+    record->set_block_sizes(tokens[10].data(), tokens[10].size());
+    record->set_block_starts(tokens[11].data(), tokens[11].size());
   }
 
   return tf::Status::OK();
@@ -125,15 +138,13 @@ tf::Status ConvertToPb(const string& line, const int desiredNumFields,
 // then rewinding the stream to 0 would be a nicer solution.
 tf::Status GetNumFields(const string& path, int* numFields) {
   CHECK(numFields != nullptr);
-  string line;
+  absl::string_view line;
   StatusOr<std::unique_ptr<TextReader>> status_or = TextReader::FromFile(path);
   TF_RETURN_IF_ERROR(status_or.status());
   std::unique_ptr<TextReader> text_reader = std::move(status_or.ValueOrDie());
   TF_RETURN_IF_ERROR(NextNonCommentLine(*text_reader, &line));
-  TF_RETURN_IF_ERROR(text_reader->Close());
-  std::vector<string> tokens = absl::StrSplit(line, '\t');
-  *numFields = static_cast<int>(tokens.size());
-  return tf::Status::OK();
+  *numFields = CountFields(line, '\t');
+  return text_reader->Close();
 }
 }  // namespace
 
@@ -148,6 +159,21 @@ class BedFullFileIterable : public BedIterable {
   ~BedFullFileIterable() override;
 };
 
+// Iterable class for traversing BED records overlapping a query region.
+class BedQueryIterable : public BedIterable {
+ public:
+  // Advance to the next record.
+  StatusOr<bool> Next(nucleus::genomics::v1::BedRecord* out) override;
+
+  // Constructor is invoked via BedReader::Query.
+  BedQueryIterable(const BedReader* reader,
+                   std::unique_ptr<TextRegionIterator> iter);
+  ~BedQueryIterable() override;
+
+ private:
+  std::unique_ptr<TextRegionIterator> iter_;
+};
+
 StatusOr<std::unique_ptr<BedReader>> BedReader::FromFile(
     const string& bed_path,
     const nucleus::genomics::v1::BedReaderOptions& options) {
@@ -162,7 +188,7 @@ StatusOr<std::unique_ptr<BedReader>> BedReader::FromFile(
         "Invalid requested number of fields to parse");
   }
   StatusOr<std::unique_ptr<TextReader>> status_or =
-      TextReader::FromFile(bed_path);
+      TextReader::FromFile(bed_path, TextReader::LOAD_INDEX);
   TF_RETURN_IF_ERROR(status_or.status());
   return std::unique_ptr<BedReader>(
       new BedReader(std::move(status_or.ValueOrDie()), options, header));
@@ -173,7 +199,9 @@ BedReader::BedReader(std::unique_ptr<TextReader> text_reader,
                      const nucleus::genomics::v1::BedHeader& header)
     : options_(options),
       header_(header),
-      text_reader_(std::move(text_reader)) {}
+      text_reader_(std::move(text_reader)) {
+  text_reader_->set_io_stats(io_stats());
+}
 
 BedReader::~BedReader() {
   if (text_reader_) {
@@ -206,22 +234,41 @@ StatusOr<std::shared_ptr<BedIterable>> BedReader::Iterate() const {
       MakeIterable<BedFullFileIterable>(this));
 }
 
+StatusOr<std::shared_ptr<BedIterable>> BedReader::Query(
+    const nucleus::genomics::v1::Range& region) {
+  if (!text_reader_)
+    return tf::errors::FailedPrecondition("Cannot Query a closed BedReader.");
+  if (!HasIndex())
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  StatusOr<std::unique_ptr<TextRegionIterator>> iter_or = text_reader_->Query(
+      region.reference_name(), region.start(), region.end());
+  TF_RETURN_IF_ERROR(iter_or.status());
+  return StatusOr<std::shared_ptr<BedIterable>>(
+      MakeIterable<BedQueryIterable>(this, std::move(iter_or.ValueOrDie())));
+}
+
 // Iterable class definitions.
 StatusOr<bool> BedFullFileIterable::Next(
     nucleus::genomics::v1::BedRecord* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
   const BedReader* bed_reader = static_cast<const BedReader*>(reader_);
-  string line;
+  absl::string_view line;
   tf::Status status = NextNonCommentLine(*bed_reader->text_reader_, &line);
   if (tf::errors::IsOutOfRange(status)) {
     return false;
   } else if (!status.ok()) {
     return status;
   }
+  IoStats* stats = IoStatsEnabled() ? bed_reader->io_stats() : nullptr;
+  if (stats != nullptr) stats->AddRecordDecoded();
   int numTokens;
-  TF_RETURN_IF_ERROR(
-      ConvertToPb(line, bed_reader->Options().num_fields(), &numTokens, out));
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(ConvertToPb(line, bed_reader->Options().num_fields(),
+                                   &numTokens, out));
+  }
   TF_RETURN_IF_ERROR(bed_reader->Validate(numTokens));
+  if (stats != nullptr) stats->AddRecordKept();
   return true;
 }
 
@@ -230,4 +277,33 @@ BedFullFileIterable::~BedFullFileIterable() {}
 BedFullFileIterable::BedFullFileIterable(const BedReader* reader)
     : Iterable(reader) {}
 
+StatusOr<bool> BedQueryIterable::Next(nucleus::genomics::v1::BedRecord* out) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  const BedReader* bed_reader = static_cast<const BedReader*>(reader_);
+  absl::string_view line;
+  tf::Status status = iter_->ReadLine(&line);
+  if (tf::errors::IsOutOfRange(status)) {
+    return false;
+  } else if (!status.ok()) {
+    return status;
+  }
+  IoStats* stats = IoStatsEnabled() ? bed_reader->io_stats() : nullptr;
+  if (stats != nullptr) stats->AddRecordDecoded();
+  int numTokens;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(ConvertToPb(line, bed_reader->Options().num_fields(),
+                                   &numTokens, out));
+  }
+  TF_RETURN_IF_ERROR(bed_reader->Validate(numTokens));
+  if (stats != nullptr) stats->AddRecordKept();
+  return true;
+}
+
+BedQueryIterable::~BedQueryIterable() {}
+
+BedQueryIterable::BedQueryIterable(const BedReader* reader,
+                                   std::unique_ptr<TextRegionIterator> iter)
+    : Iterable(reader), iter_(std::move(iter)) {}
+
 }  // namespace nucleus
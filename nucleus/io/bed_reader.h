@@ -24,6 +24,7 @@
 #include "nucleus/io/text_reader.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bed.pb.h"
+#include "nucleus/protos/range.pb.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -39,19 +40,22 @@ using BedIterable = Iterable<nucleus::genomics::v1::BedRecord>;
 //
 // https://genome.ucsc.edu/FAQ/FAQformat.html#format1
 //
-// This class provides a method to iterate through a BED file.
+// This class provides methods to iterate through a BED file or, if the file is
+// bgzip-compressed and tabix-indexed, to query it by region.
 //
-// The objects returned by iterate() are nucleus.genomics.v1.BedRecord
-// objects parsed from the BED records in the file.
+// The objects returned by iterate() and query() are
+// nucleus.genomics.v1.BedRecord objects parsed from the BED records in the
+// file.
 //
-// Note: Only tab-delimited BED files are supported, for ease of future support
-// for tabix-indexed BED file querying.
+// Note: Only tab-delimited BED files are supported.
 //
 class BedReader : public Reader {
  public:
   // Creates a new BedReader reading reads from the BED file bed_path.
   //
-  // bed_path must point to an existing BED formatted file.
+  // bed_path must point to an existing BED formatted file. If the file is
+  // bgzip-compressed, a tabix index at bed_path + '.tbi' (or a CSI index at
+  // bed_path + '.csi') is loaded when present to support Query.
   //
   // Returns a StatusOr that is OK if the BedReader could be successfully
   // created or an error code indicating the error that occurred.
@@ -72,6 +76,17 @@ class BedReader : public Reader {
   // constructed, or not OK otherwise.
   StatusOr<std::shared_ptr<BedIterable>> Iterate() const;
 
+  // Gets all of the BED records that overlap any bases in range.
+  //
+  // The cost is O(n) for the n records overlapping region rather than O(N) for
+  // the N records in the file. This function is only available if an index was
+  // loaded; otherwise a non-OK status value is returned.
+  StatusOr<std::shared_ptr<BedIterable>> Query(
+      const nucleus::genomics::v1::Range& region);
+
+  // Returns true if a tabix or CSI index was loaded for this file.
+  bool HasIndex() const { return text_reader_ && text_reader_->HasIndex(); }
+
   // Close the underlying resource descriptors. Returns a Status to indicate if
   // everything went OK with the close.
   tensorflow::Status Close();
@@ -109,6 +124,7 @@ class BedReader : public Reader {
 
   // Allow BedIterable objects to access fp_.
   friend class BedFullFileIterable;
+  friend class BedQueryIterable;
 };
 
 }  // namespace nucleus
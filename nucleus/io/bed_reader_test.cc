@@ -17,6 +17,7 @@
 
 #include "nucleus/io/bed_reader.h"
 
+#include <fstream>
 #include <utility>
 #include <vector>
 
@@ -25,6 +26,8 @@
 #include <gmock/gmock-more-matchers.h>
 
 #include "tensorflow/core/platform/test.h"
+#include "nucleus/io/tabix_indexer.h"
+#include "nucleus/io/text_writer.h"
 #include "nucleus/testing/protocol-buffer-matchers.h"
 #include "nucleus/testing/test_utils.h"
 #include "nucleus/util/utils.h"
@@ -125,6 +128,65 @@ TEST_F(BedReaderTest, MalformedBedRecord) {
                "BED record has invalid number of fields");
 }
 
+TEST_F(BedReaderTest, NonNumericPositionIsAnError) {
+  const string path = MakeTempFile("non_numeric_position.bed");
+  std::ofstream(path) << "chr1\t10\t20\nchr1\tabc\t200\n";
+  std::unique_ptr<BedReader> reader = std::move(
+      BedReader::FromFile(path, nucleus::genomics::v1::BedReaderOptions())
+          .ValueOrDie());
+  std::shared_ptr<BedIterable> iterable = reader->Iterate().ValueOrDie();
+  nucleus::genomics::v1::BedRecord record;
+  EXPECT_TRUE(iterable->Next(&record).ValueOrDie());
+  EXPECT_EQ(10, record.start());
+  StatusOr<bool> next = iterable->Next(&record);
+  EXPECT_FALSE(next.ok());
+  EXPECT_EQ("Unable to parse start position in BED",
+            next.status().error_message());
+}
+
+TEST_F(BedReaderTest, QueriesIndexedFile) {
+  const string path = MakeTempFile("query.bed.gz");
+  {
+    std::unique_ptr<TextWriter> writer = std::move(
+        TextWriter::ToFile(path, TextWriter::COMPRESS).ValueOrDie());
+    TF_CHECK_OK(writer->Write("chr1\t10\t20\n"));
+    TF_CHECK_OK(writer->Write("chr1\t100\t200\n"));
+    TF_CHECK_OK(writer->Write("chr2\t5\t15\n"));
+    TF_CHECK_OK(writer->Close());
+  }
+  TF_CHECK_OK(TbxIndexBuild(path, "bed"));
+
+  std::unique_ptr<BedReader> reader = std::move(
+      BedReader::FromFile(path, nucleus::genomics::v1::BedReaderOptions())
+          .ValueOrDie());
+  ASSERT_TRUE(reader->HasIndex());
+
+  // BED intervals are zero-based and half-open, so [20, 100) touches neither
+  // of the chr1 records.
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr1", 20, 100))),
+              ::testing::IsEmpty());
+  vector<nucleus::genomics::v1::BedRecord> records =
+      as_vector(reader->Query(MakeRange("chr1", 19, 101)));
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(10, records[0].start());
+  EXPECT_EQ(100, records[1].start());
+  records = as_vector(reader->Query(MakeRange("chr2", 0, 100)));
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ("chr2", records[0].reference_name());
+  // Contigs absent from the file yield no records.
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr3", 0, 100))),
+              ::testing::IsEmpty());
+}
+
+TEST_F(BedReaderTest, QueryWithoutIndexFails) {
+  std::unique_ptr<BedReader> reader = std::move(
+      BedReader::FromFile(GetTestData(kBedFilename),
+                          nucleus::genomics::v1::BedReaderOptions())
+          .ValueOrDie());
+  EXPECT_FALSE(reader->HasIndex());
+  EXPECT_FALSE(reader->Query(MakeRange("chr1", 0, 100)).ok());
+}
+
 TEST_F(BedReaderTest, FiveColBedRecord) {
   auto status = BedReader::FromFile(GetTestData(k5ColumnBedFileName),
                                     nucleus::genomics::v1::BedReaderOptions());
@@ -20,7 +20,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
-#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bed.pb.h"
 #include "nucleus/util/utils.h"
@@ -57,6 +57,7 @@ BedWriter::BedWriter(std::unique_ptr<TextWriter> text_writer,
     : header_(header),
       options_(options),
       text_writer_(std::move(text_writer)) {
+  text_writer_->set_io_stats(&io_stats_);
 }
 
 BedWriter::~BedWriter() {
@@ -69,6 +70,9 @@ tf::Status BedWriter::Close() {
   if (!text_writer_)
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed BedWriter");
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "BedWriter statistics: " << io_stats_.ToJson();
+  }
   // Close the file pointer we have been writing to.
   tf::Status close_status = text_writer_->Close();
   text_writer_ = nullptr;
@@ -78,42 +82,55 @@ tf::Status BedWriter::Close() {
 tf::Status BedWriter::Write(const nucleus::genomics::v1::BedRecord& record) {
   if (!text_writer_)
     return tf::errors::FailedPrecondition("Cannot write to closed BED stream.");
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(AppendRecord(record));
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
+  return text_writer_->MaybeFlush();
+}
+
+tf::Status BedWriter::AppendRecord(
+    const nucleus::genomics::v1::BedRecord& record) {
   int numFields = header_.num_fields();
-  string out = "";
-  absl::StrAppend(&out,
-                  record.reference_name(),
-                  "\t", record.start(),
-                  "\t", record.end());
-  if (numFields > 3) absl::StrAppend(&out, "\t", record.name());
-  if (numFields > 4) absl::StrAppend(&out, "\t", record.score());
+  // Validate the strand before anything is appended, so that a bad record
+  // leaves no partial line behind.
+  absl::string_view strand;
   if (numFields > 5) {
     switch (record.strand()) {
       case nucleus::genomics::v1::BedRecord::FORWARD_STRAND:
-        absl::StrAppend(&out, "\t+");
+        strand = "\t+";
         break;
       case nucleus::genomics::v1::BedRecord::REVERSE_STRAND:
-        absl::StrAppend(&out, "\t-");
+        strand = "\t-";
         break;
       case nucleus::genomics::v1::BedRecord::NO_STRAND:
-        absl::StrAppend(&out, "\t.");
+        strand = "\t.";
         break;
       default:
         return tf::errors::Unknown("Unknown strand encoding in the BED proto.");
     }
   }
+  TextWriter& out = *text_writer_;
+  out.Append(record.reference_name(),
+             "\t", record.start(),
+             "\t", record.end());
+  if (numFields > 3) out.Append("\t", record.name());
+  if (numFields > 4) out.Append("\t", record.score());
+  out.Append(strand);
   if (numFields > 7)
-    absl::StrAppend(&out,
-                    "\t", record.thick_start(),
-                    "\t", record.thick_end());
-  if (numFields > 8) absl::StrAppend(&out, "\t", record.item_rgb());
+    out.Append("\t", record.thick_start(),
+               "\t", record.thick_end());
+  if (numFields > 8) out.Append("\t", record.item_rgb());
   if (numFields == 12)
-    absl::StrAppend(&out,
-                    "\t", record.block_count(),
-                    "\t", record.block_sizes(),
-                    "\t", record.block_starts());
-  absl::StrAppend(&out, "\n");
-  TF_RETURN_IF_ERROR(text_writer_->Write(out));
-
+    out.Append("\t", record.block_count(),
+               "\t", record.block_sizes(),
+               "\t", record.block_starts());
+  out.Append("\n");
   return tf::Status::OK();
 }
 
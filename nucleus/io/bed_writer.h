@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 
+#include "nucleus/io/io_stats.h"
 #include "nucleus/io/text_writer.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bed.pb.h"
@@ -64,6 +65,12 @@ class BedWriter {
   // error occurred.
   tensorflow::Status Close();
 
+  // Returns a snapshot of the statistics of this writer (see io_stats.h).
+  // Text still buffered is not counted until it is flushed.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // Provide access to the header.
   const nucleus::genomics::v1::BedHeader& Header() const { return header_; }
 
@@ -77,12 +84,20 @@ class BedWriter {
             const nucleus::genomics::v1::BedHeader& header,
             const nucleus::genomics::v1::BedWriterOptions& options);
 
+  // Appends the line of record to text_writer_, without flushing it.
+  tensorflow::Status AppendRecord(
+      const nucleus::genomics::v1::BedRecord& record);
+
   // The header of the BED file.
   const nucleus::genomics::v1::BedHeader header_;
 
   // Our options that control the behavior of this class.
   const nucleus::genomics::v1::BedWriterOptions options_;
 
+  // The statistics of this writer. text_writer_ updates them, so they must
+  // outlive it.
+  IoStats io_stats_;
+
   // Underlying file writer.
   std::unique_ptr<TextWriter> text_writer_;
 
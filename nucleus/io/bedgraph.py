@@ -84,18 +84,29 @@ class NativeBedGraphReader(genomics_reader.GenomicsReader):
     bedgraph_path = input_path.encode('utf8')
     self._reader = bedgraph_reader.BedGraphReader.from_file(bedgraph_path)
 
-  def query(self):
+  def query(self, region):
     """Returns an iterator for going through the records in the region.
 
-    NOTE: This function is not currently implemented by NativeBedGraphReader
-    though it could be implemented for sorted, tabix-indexed BedGraph files.
+    Requires a bgzip-compressed file with a tabix or CSI index (see
+    nucleus.io.tabix.build_index with preset='bed').
+
+    Args:
+      region: nucleus.genomics.v1.Range. The region to query.
     """
-    raise NotImplementedError('Can not currently query a BedGraph file')
+    return self._reader.query(region)
 
   def iterate(self):
     """Returns an iterable of BedGraphRecord protos in the file."""
     return self._reader.iterate()
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -129,6 +140,10 @@ class NativeBedGraphWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
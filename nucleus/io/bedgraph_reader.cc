@@ -19,11 +19,12 @@
 
 #include <algorithm>
 #include <utility>
-#include <vector>
 
 #include "absl/strings/match.h"
-#include "absl/strings/numbers.h"
-#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "nucleus/io/field_scanner.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bedgraph.pb.h"
 #include "nucleus/util/utils.h"
@@ -45,32 +46,47 @@ constexpr char BED_COMMENT_PREFIX[] = "#";
 
 namespace {
 
-tf::Status ConvertToPb(const string& line,
+// The number of fields in a BedGraph record.
+constexpr int kNumBedGraphFields = 4;
+
+tf::Status ConvertToPb(absl::string_view line,
                        nucleus::genomics::v1::BedGraphRecord* record) {
   DCHECK_NE(nullptr, record) << "BedGraph record cannot be null";
   record->Clear();
 
-  std::vector<string> tokens = absl::StrSplit(line, '\t');
-  if (tokens.size() != 4) {
+  absl::string_view tokens[kNumBedGraphFields];
+  if (SplitFields(line, '\t', absl::MakeSpan(tokens)) != kNumBedGraphFields) {
     return tf::errors::Unknown("BedGraph record has invalid number of fields");
   }
-  record->set_reference_name(tokens[0]);
+  record->set_reference_name(tokens[0].data(), tokens[0].size());
   int64 start, end = 0;
-  if (!absl::SimpleAtoi(tokens[1], &start) ||
-      !absl::SimpleAtoi(tokens[2], &end)) {
+  if (!ParseInt64(tokens[1], &start) || !ParseInt64(tokens[2], &end)) {
     return tf::errors::Unknown(
         "Unable to parse start and end positions in BedGraph");
   }
   record->set_start(start);
   record->set_end(end);
   double value = 0;
-  if (!absl::SimpleAtod(tokens[3].c_str(), &value)) {
+  if (!ParseDouble(tokens[3], &value)) {
     return tf::errors::Unknown("Unable to parse data value in BedGraph");
   }
   record->set_data_value(value);
   return tf::Status::OK();
 }
 
+// ConvertToPb, counting the record in the statistics of reader.
+tf::Status ConvertCounted(const BedGraphReader* reader, absl::string_view line,
+                          nucleus::genomics::v1::BedGraphRecord* record) {
+  IoStats* stats = IoStatsEnabled() ? reader->io_stats() : nullptr;
+  if (stats != nullptr) stats->AddRecordDecoded();
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(ConvertToPb(line, record));
+  }
+  if (stats != nullptr) stats->AddRecordKept();
+  return tf::Status::OK();
+}
+
 }  // namespace
 
 // Iterable class for traversing all BedGraph records in the file.
@@ -84,17 +100,34 @@ class BedGraphFullFileIterable : public BedGraphIterable {
   ~BedGraphFullFileIterable() override;
 };
 
+// Iterable class for traversing BedGraph records overlapping a query region.
+class BedGraphQueryIterable : public BedGraphIterable {
+ public:
+  // Advance to the next record.
+  StatusOr<bool> Next(nucleus::genomics::v1::BedGraphRecord* out) override;
+
+  // Constructor is invoked via BedGraphReader::Query.
+  BedGraphQueryIterable(const BedGraphReader* reader,
+                        std::unique_ptr<TextRegionIterator> iter);
+  ~BedGraphQueryIterable() override;
+
+ private:
+  std::unique_ptr<TextRegionIterator> iter_;
+};
+
 StatusOr<std::unique_ptr<BedGraphReader>> BedGraphReader::FromFile(
     const string& bedgraph_path) {
   StatusOr<std::unique_ptr<TextReader>> status_or =
-      TextReader::FromFile(bedgraph_path);
+      TextReader::FromFile(bedgraph_path, TextReader::LOAD_INDEX);
   TF_RETURN_IF_ERROR(status_or.status());
   return std::unique_ptr<BedGraphReader>(
       new BedGraphReader(std::move(status_or.ValueOrDie())));
 }
 
 BedGraphReader::BedGraphReader(std::unique_ptr<TextReader> text_reader)
-    : text_reader_(std::move(text_reader)) {}
+    : text_reader_(std::move(text_reader)) {
+  text_reader_->set_io_stats(io_stats());
+}
 
 BedGraphReader::~BedGraphReader() {
   if (!text_reader_) {
@@ -124,24 +157,40 @@ StatusOr<std::shared_ptr<BedGraphIterable>> BedGraphReader::Iterate() const {
       MakeIterable<BedGraphFullFileIterable>(this));
 }
 
+StatusOr<std::shared_ptr<BedGraphIterable>> BedGraphReader::Query(
+    const nucleus::genomics::v1::Range& region) {
+  if (!text_reader_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot query a closed BedGraphReader");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  }
+  StatusOr<std::unique_ptr<TextRegionIterator>> iter_or = text_reader_->Query(
+      region.reference_name(), region.start(), region.end());
+  TF_RETURN_IF_ERROR(iter_or.status());
+  return StatusOr<std::shared_ptr<BedGraphIterable>>(
+      MakeIterable<BedGraphQueryIterable>(this,
+                                          std::move(iter_or.ValueOrDie())));
+}
+
 // Iterable class definitions.
 StatusOr<bool> BedGraphFullFileIterable::Next(
     nucleus::genomics::v1::BedGraphRecord* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
   const BedGraphReader* bedgraph_reader =
       static_cast<const BedGraphReader*>(reader_);
-  string line;
+  absl::string_view line;
   do {
-    StatusOr<string> line_or = bedgraph_reader->text_reader_->ReadLine();
-    if (!line_or.ok()) {
-      if (tf::errors::IsOutOfRange(line_or.status())) {
+    tf::Status status = bedgraph_reader->text_reader_->ReadLine(&line);
+    if (!status.ok()) {
+      if (tf::errors::IsOutOfRange(status)) {
         return false;
       }
-      return line_or.status();
+      return status;
     }
-    line = line_or.ValueOrDie();
   } while (absl::StartsWith(line, BED_COMMENT_PREFIX));
-  TF_RETURN_IF_ERROR(ConvertToPb(line, out));
+  TF_RETURN_IF_ERROR(ConvertCounted(bedgraph_reader, line, out));
   return true;
 }
 
@@ -150,4 +199,26 @@ BedGraphFullFileIterable::~BedGraphFullFileIterable() {}
 BedGraphFullFileIterable::BedGraphFullFileIterable(const BedGraphReader* reader)
     : Iterable(reader) {}
 
+StatusOr<bool> BedGraphQueryIterable::Next(
+    nucleus::genomics::v1::BedGraphRecord* out) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  absl::string_view line;
+  tf::Status status = iter_->ReadLine(&line);
+  if (!status.ok()) {
+    if (tf::errors::IsOutOfRange(status)) {
+      return false;
+    }
+    return status;
+  }
+  TF_RETURN_IF_ERROR(
+      ConvertCounted(static_cast<const BedGraphReader*>(reader_), line, out));
+  return true;
+}
+
+BedGraphQueryIterable::~BedGraphQueryIterable() {}
+
+BedGraphQueryIterable::BedGraphQueryIterable(
+    const BedGraphReader* reader, std::unique_ptr<TextRegionIterator> iter)
+    : Iterable(reader), iter_(std::move(iter)) {}
+
 }  // namespace nucleus
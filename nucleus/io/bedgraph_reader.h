@@ -24,6 +24,7 @@
 #include "nucleus/io/text_reader.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/bedgraph.pb.h"
+#include "nucleus/protos/range.pb.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -39,15 +40,19 @@ using BedGraphIterable = Iterable<nucleus::genomics::v1::BedGraphRecord>;
 //
 // https://genome.ucsc.edu/goldenpath/help/bedgraph.html
 //
-// This class provides a method to iterate through a BedGraph file.
+// This class provides methods to iterate through a BedGraph file or, if the
+// file is bgzip-compressed and tabix-indexed (with the "bed" preset), to query
+// it by region.
 //
-// The objects returned by iterate() are nucleus.genomics.v1.BedGraphRecord
-// objects parsed from the BedGraph records in the file.
+// The objects returned by iterate() and query() are
+// nucleus.genomics.v1.BedGraphRecord objects parsed from the BedGraph records
+// in the file.
 //
 class BedGraphReader : public Reader {
  public:
   // Creates a new BedGraphReader reading reads from the BedGraph file at
-  // |bedgraph_path|.
+  // |bedgraph_path|. An index next to a bgzip-compressed file is loaded when
+  // present to support Query.
   //
   // Returns a StatusOr that is OK if the BedGraphReader could be successfully
   // created or an error code indicating the error that occurred.
@@ -64,6 +69,15 @@ class BedGraphReader : public Reader {
   // status if the iterable can be constructed, or not OK otherwise.
   StatusOr<std::shared_ptr<BedGraphIterable>> Iterate() const;
 
+  // Gets all of the BedGraph records that overlap any bases in region. This
+  // function is only available if an index was loaded; otherwise a non-OK
+  // status value is returned.
+  StatusOr<std::shared_ptr<BedGraphIterable>> Query(
+      const nucleus::genomics::v1::Range& region);
+
+  // Returns true if a tabix or CSI index was loaded for this file.
+  bool HasIndex() const { return text_reader_ && text_reader_->HasIndex(); }
+
   // Closes the underlying resource descriptors. Returns a Status to indicate if
   // everything went OK with the close.
   tensorflow::Status Close();
@@ -81,6 +95,7 @@ class BedGraphReader : public Reader {
 
   // Allow BedGraphIterable objects to access fp_.
   friend class BedGraphFullFileIterable;
+  friend class BedGraphQueryIterable;
 };
 
 }  // namespace nucleus
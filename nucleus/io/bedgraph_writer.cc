@@ -19,7 +19,6 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
-#include "absl/strings/substitute.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/util/utils.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -53,6 +52,9 @@ tf::Status BedGraphWriter::Close() {
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed BedGraphWriter");
   }
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "BedGraphWriter statistics: " << io_stats_.ToJson();
+  }
   tf::Status close_status = text_writer_->Close();
   text_writer_ = nullptr;
   return close_status;
@@ -64,13 +66,22 @@ tf::Status BedGraphWriter::Write(
     return tf::errors::FailedPrecondition(
         "Cannot write to closed bedgraph stream.");
   }
-  TF_RETURN_IF_ERROR(text_writer_->Write(
-      absl::Substitute("$0\t$1\t$2\t$3\n", record.reference_name(),
-                       record.start(), record.end(), record.data_value())));
-  return tf::Status::OK();
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    text_writer_->Append(record.reference_name(), "\t", record.start(), "\t",
+                         record.end(), "\t", record.data_value(), "\n");
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
+  return text_writer_->MaybeFlush();
 }
 
 BedGraphWriter::BedGraphWriter(std::unique_ptr<TextWriter> text_writer)
-    : text_writer_(std::move(text_writer)) {}
+    : text_writer_(std::move(text_writer)) {
+  text_writer_->set_io_stats(&io_stats_);
+}
 
 }  // namespace nucleus
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of byte_balanced_partitioner.h
+#include "nucleus/io/byte_balanced_partitioner.h"
+
+#include <algorithm>
+
+#include "nucleus/util/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::Range;
+
+namespace {
+
+// The compressed file offset of a BGZF virtual offset.
+int64 CompressedOffset(uint64 virtual_offset) { return virtual_offset >> 16; }
+
+}  // namespace
+
+tf::Status EstimateIndexedBytes(
+    const hts_idx_t* idx, const std::function<int(const string&)>& tid_of,
+    absl::Span<const Range> regions, int64 resolution,
+    std::vector<Range>* windows, std::vector<int64>* bytes) {
+  if (resolution <= 0) {
+    return tf::errors::InvalidArgument("resolution must be positive, not ",
+                                       resolution);
+  }
+  windows->clear();
+  bytes->clear();
+  for (const Range& region : regions) {
+    const int tid = tid_of(region.reference_name());
+    const size_t first_window = windows->size();
+    // The offset of the first chunk read for each window, or -1 if the index
+    // has no data for it, and the end of the last chunk of the region.
+    std::vector<int64> starts;
+    int64 region_end = 0;
+    for (int64 start = region.start(); start < region.end();
+         start += resolution) {
+      const int64 end = std::min<int64>(start + resolution, region.end());
+      windows->push_back(MakeRange(region.reference_name(), start, end));
+      starts.push_back(-1);
+      if (tid < 0) continue;
+      hts_itr_t* iter = hts_itr_query(idx, tid, start, end, nullptr);
+      if (iter == nullptr) continue;
+      // The chunks are sorted by start and do not overlap.
+      if (iter->n_off > 0) {
+        starts.back() = CompressedOffset(iter->off[0].u);
+        region_end = std::max(
+            region_end, CompressedOffset(iter->off[iter->n_off - 1].v));
+      }
+      hts_itr_destroy(iter);
+    }
+
+    bytes->resize(windows->size(), 0);
+    int64 next_start = region_end;
+    for (size_t i = starts.size(); i-- > 0;) {
+      if (starts[i] < 0) continue;
+      (*bytes)[first_window + i] = std::max<int64>(0, next_start - starts[i]);
+      next_start = starts[i];
+    }
+  }
+  return tf::Status::OK();
+}
+
+StatusOr<std::vector<Range>> PartitionByIndexedBytes(
+    const hts_idx_t* idx, const std::function<int(const string&)>& tid_of,
+    absl::Span<const Range> regions, int num_shards, int64 resolution) {
+  if (num_shards <= 0) {
+    return tf::errors::InvalidArgument("num_shards must be positive, not ",
+                                       num_shards);
+  }
+  std::vector<Range> windows;
+  std::vector<int64> bytes;
+  TF_RETURN_IF_ERROR(EstimateIndexedBytes(idx, tid_of, regions, resolution,
+                                          &windows, &bytes));
+  return partitioner_internal::SplitByWeight(windows, bytes, num_shards);
+}
+
+namespace partitioner_internal {
+
+std::vector<Range> SplitByWeight(absl::Span<const Range> windows,
+                                 absl::Span<const int64> weights,
+                                 int num_shards) {
+  int64 total = 0;
+  for (int64 weight : weights) total += weight;
+  const bool by_length = total == 0;
+  if (by_length) {
+    for (const Range& window : windows) total += window.end() - window.start();
+  }
+  const int64 target =
+      std::max<int64>(1, (total + num_shards - 1) / std::max(num_shards, 1));
+
+  std::vector<Range> shards;
+  Range shard;
+  bool open = false;
+  int64 size = 0;
+  for (size_t i = 0; i < windows.size(); ++i) {
+    const Range& window = windows[i];
+    const int64 weight =
+        by_length ? window.end() - window.start() : weights[i];
+    const bool contiguous = open &&
+                            window.reference_name() == shard.reference_name() &&
+                            window.start() == shard.end();
+    // Close the shard before this window if the window does not continue it,
+    // or if adding the window would overshoot the target by more than
+    // stopping short of it.
+    if (open &&
+        (!contiguous || (size > 0 && size + weight - target > target - size))) {
+      shards.push_back(shard);
+      open = false;
+    }
+    if (!open) {
+      shard = window;
+      size = 0;
+      open = true;
+    }
+    shard.set_end(window.end());
+    size += weight;
+    if (size >= target) {
+      shards.push_back(shard);
+      open = false;
+    }
+  }
+  if (open) shards.push_back(shard);
+  return shards;
+}
+
+}  // namespace partitioner_internal
+
+}  // namespace nucleus
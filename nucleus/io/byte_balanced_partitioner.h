@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Splits regions into shards holding roughly equal amounts of data.
+//
+// Splitting by base pairs gives shards over centromeres, amplifications or
+// capture targets wildly different amounts of data. Instead, the regions are
+// cut into windows and the compressed size of each window is estimated from
+// the bins and linear index of a BAI, CSI or TBI index: the window starts at
+// the first chunk the index would read for it, and its size is the distance
+// to the start of the next window holding data. Windows are then grouped into
+// consecutive shards of about equal size. Nothing but the index is read.
+#ifndef THIRD_PARTY_NUCLEUS_IO_BYTE_BALANCED_PARTITIONER_H_
+#define THIRD_PARTY_NUCLEUS_IO_BYTE_BALANCED_PARTITIONER_H_
+
+#include <functional>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "htslib/hts.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+// The default width of the windows whose sizes are estimated: the 16 kb
+// resolution of the linear index.
+constexpr int64 kDefaultPartitionResolution = 16384;
+
+// Replaces *windows with the windows of at most resolution bases covering
+// regions, in order, and *bytes with the estimated compressed size of each.
+// tid_of returns the id of a reference name in idx, or a negative value if
+// idx holds no records for it.
+tensorflow::Status EstimateIndexedBytes(
+    const hts_idx_t* idx, const std::function<int(const string&)>& tid_of,
+    absl::Span<const nucleus::genomics::v1::Range> regions, int64 resolution,
+    std::vector<nucleus::genomics::v1::Range>* windows,
+    std::vector<int64>* bytes);
+
+// Splits regions into about num_shards shards of roughly equal compressed
+// size, estimated from idx as described above. Shards do not span regions, so
+// there are at least as many shards as non-empty regions.
+StatusOr<std::vector<nucleus::genomics::v1::Range>> PartitionByIndexedBytes(
+    const hts_idx_t* idx, const std::function<int(const string&)>& tid_of,
+    absl::Span<const nucleus::genomics::v1::Range> regions, int num_shards,
+    int64 resolution = kDefaultPartitionResolution);
+
+namespace partitioner_internal {
+
+// Groups windows, which are sorted and touch each other within a region, into
+// consecutive shards of about the total weight divided by num_shards. If all
+// weights are zero, the length of each window is used instead.
+std::vector<nucleus::genomics::v1::Range> SplitByWeight(
+    absl::Span<const nucleus::genomics::v1::Range> windows,
+    absl::Span<const int64> weights, int num_shards);
+
+}  // namespace partitioner_internal
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_BYTE_BALANCED_PARTITIONER_H_
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/byte_balanced_partitioner.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/io/vcf_reader.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+
+namespace nucleus {
+
+using genomics::v1::Range;
+using genomics::v1::SamReaderOptions;
+using genomics::v1::VcfReaderOptions;
+using partitioner_internal::SplitByWeight;
+using ::testing::Ge;
+using ::testing::Pointwise;
+using ::testing::SizeIs;
+
+// Returns the windows of width 10 covering [start, end) of chr.
+std::vector<Range> Windows(const string& chr, int64 start, int64 end) {
+  std::vector<Range> windows;
+  for (int64 i = start; i < end; i += 10) {
+    windows.push_back(MakeRange(chr, i, std::min<int64>(i + 10, end)));
+  }
+  return windows;
+}
+
+// Expects shards to be sorted, not to overlap, and to cover exactly region.
+void ExpectTiles(const std::vector<Range>& shards, const Range& region) {
+  ASSERT_THAT(shards, ::testing::Not(::testing::IsEmpty()));
+  EXPECT_EQ(region.start(), shards.front().start());
+  EXPECT_EQ(region.end(), shards.back().end());
+  for (size_t i = 0; i < shards.size(); ++i) {
+    EXPECT_EQ(region.reference_name(), shards[i].reference_name());
+    EXPECT_LT(shards[i].start(), shards[i].end());
+    if (i > 0) EXPECT_EQ(shards[i - 1].end(), shards[i].start());
+  }
+}
+
+TEST(SplitByWeightTest, BalancesWeight) {
+  // The data is concentrated in the middle windows.
+  const std::vector<Range> windows = Windows("chr1", 0, 100);
+  const std::vector<int64> weights = {1, 1, 1, 1, 50, 50, 1, 1, 1, 1};
+  EXPECT_THAT(SplitByWeight(windows, weights, 3),
+              Pointwise(EqualsProto(), std::vector<Range>{
+                                           MakeRange("chr1", 0, 50),
+                                           MakeRange("chr1", 50, 60),
+                                           MakeRange("chr1", 60, 100)}));
+}
+
+TEST(SplitByWeightTest, DoesNotSpanRegions) {
+  std::vector<Range> windows = Windows("chr1", 0, 30);
+  for (const Range& window : Windows("chr2", 0, 30)) windows.push_back(window);
+  const std::vector<int64> weights(windows.size(), 1);
+  EXPECT_THAT(SplitByWeight(windows, weights, 1),
+              Pointwise(EqualsProto(), std::vector<Range>{
+                                           MakeRange("chr1", 0, 30),
+                                           MakeRange("chr2", 0, 30)}));
+}
+
+TEST(SplitByWeightTest, FallsBackToLengthWithoutData) {
+  const std::vector<Range> windows = Windows("chr1", 0, 40);
+  const std::vector<int64> weights(windows.size(), 0);
+  EXPECT_THAT(SplitByWeight(windows, weights, 2),
+              Pointwise(EqualsProto(), std::vector<Range>{
+                                           MakeRange("chr1", 0, 20),
+                                           MakeRange("chr1", 20, 40)}));
+}
+
+TEST(ByteBalancedPartitionerTest, PartitionsBam) {
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData("test.bam"), SamReaderOptions())
+          .ValueOrDie());
+  const Range region = MakeRange("chr20", 9990000, 10010000);
+  StatusOr<std::vector<Range>> shards = reader->PartitionByBytes({region}, 4);
+  ASSERT_THAT(shards, IsOK());
+  ExpectTiles(shards.ValueOrDie(), region);
+
+  // Every read starting in the region starts in exactly one shard.
+  const auto num_starting_reads = [&reader](const Range& range) {
+    int64 n = 0;
+    for (const auto& read : as_vector(reader->Query(range))) {
+      if (ReadStart(read) >= range.start()) ++n;
+    }
+    return n;
+  };
+  int64 num_reads = 0;
+  for (const Range& shard : shards.ValueOrDie()) {
+    num_reads += num_starting_reads(shard);
+  }
+  EXPECT_EQ(num_starting_reads(region), num_reads);
+
+  EXPECT_THAT(reader->PartitionByBytes({MakeRange("chrUnknown", 0, 100)}, 4),
+              IsNotOKWithCode(tensorflow::error::NOT_FOUND));
+  EXPECT_THAT(reader->PartitionByBytes({region}, 0),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+}
+
+TEST(ByteBalancedPartitionerTest, PartitionsVcf) {
+  std::unique_ptr<VcfReader> reader =
+      std::move(VcfReader::FromFile(GetTestData("test_samples.vcf.gz"),
+                                    VcfReaderOptions())
+                    .ValueOrDie());
+  const std::vector<Range> regions = {MakeRange("chr1", 0, 1000000),
+                                      MakeRange("chr4", 0, 1000000)};
+  StatusOr<std::vector<Range>> shards = reader->PartitionByBytes(regions, 8);
+  ASSERT_THAT(shards, IsOK());
+  // chr4 has no records, and so forms a single shard.
+  ASSERT_THAT(shards.ValueOrDie(), SizeIs(Ge(2)));
+  EXPECT_THAT(shards.ValueOrDie().back(), EqualsProto(regions[1]));
+  std::vector<Range> chr1_shards(shards.ValueOrDie().begin(),
+                                 shards.ValueOrDie().end() - 1);
+  ExpectTiles(chr1_shards, regions[0]);
+}
+
+}  // namespace nucleus
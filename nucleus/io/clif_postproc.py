@@ -58,6 +58,19 @@ class WrappedCppIterable(six.Iterator):
   def __iter__(self):
     return self
 
+  def tell(self):
+    """Returns a checkpoint of the position of this iterator.
+
+    Passing it to seek(), on this iterator or another one over the same file,
+    resumes iteration after the last record returned. Only iterators over
+    whole SAM/BAM and VCF files support checkpoints.
+    """
+    return self._cc_iterable.Tell()
+
+  def seek(self, offset):
+    """Resumes iteration at offset, as returned by tell()."""
+    self._cc_iterable.Seek(offset)
+
   @abc.abstractmethod
   def _raw_next(self):
     """Sub-classes should implement __next__ in this method."""
@@ -127,6 +140,14 @@ class WrappedSamIterable(WrappedCppIterable):
     return record, not_done
 
 
+class WrappedSamFragmentIterable(WrappedCppIterable):
+
+  def _raw_next(self):
+    record = reads_pb2.Fragment()
+    not_done = self._cc_iterable.PythonNext(record)
+    return record, not_done
+
+
 class WrappedVariantIterable(WrappedCppIterable):
 
   def _raw_next(self):
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Throughput benchmarks for the conversions between htslib records and protos:
+// SAM/BAM reads (ConvertToPb, ParseAuxFields and PopulateNativeBody), VCF
+// variants (VcfRecordConverter) and FASTQ records.
+//
+// Inputs are synthetic records of controlled size: short and long reads with
+// few or many aux tags, and variants with 1, 100 or 10k samples. Each reader
+// benchmark writes its input file once, then repeatedly iterates over it,
+// reporting records/sec and (uncompressed) bytes/sec; each writer benchmark
+// repeatedly writes the records to a fresh file. After timing, one more pass
+// is made with I/O statistics enabled (see io_stats.h) to report how the time
+// per record splits between htslib, conversion and aux parsing, without
+// slowing the timed passes.
+//
+// For tracking over time, write the results as JSON with
+//   --benchmark_out=results.json --benchmark_out_format=json
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "nucleus/io/fastq_reader.h"
+#include "nucleus/io/io_stats.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/io/sam_writer.h"
+#include "nucleus/io/vcf_reader.h"
+#include "nucleus/io/vcf_writer.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/io_stats.pb.h"
+#include "nucleus/protos/reads.pb.h"
+#include "nucleus/protos/variants.pb.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace nucleus {
+
+namespace {
+
+using genomics::v1::FastqReaderOptions;
+using genomics::v1::IoStatistics;
+using genomics::v1::Read;
+using genomics::v1::SamHeader;
+using genomics::v1::SamReaderOptions;
+using genomics::v1::Variant;
+using genomics::v1::VcfHeader;
+using genomics::v1::VcfReaderOptions;
+using genomics::v1::VcfWriterOptions;
+
+string TmpPath(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                  absl::StrCat("benchmark_", name));
+}
+
+// Reports the time per record spent in each part of the conversion, measured
+// by an instrumented pass run by run_pass, as counters of state.
+template <typename RunPass>
+void ReportKernelTimes(benchmark::State* state, RunPass run_pass) {
+  SetIoStatsEnabled(true);
+  const IoStatistics stats = run_pass();
+  SetIoStatsEnabled(false);
+  if (stats.records_decoded() == 0) return;
+  const double n = stats.records_decoded();
+  state->counters["hts_ns"] = stats.hts_nanos() / n;
+  state->counters["convert_ns"] = stats.convert_nanos() / n;
+  state->counters["aux_parse_ns"] = stats.aux_parse_nanos() / n;
+}
+
+// SAM/BAM reads.
+
+SamHeader BenchmarkSamHeader() {
+  SamHeader header;
+  auto* contig = header.add_contigs();
+  contig->set_name("chr1");
+  contig->set_n_bases(248956422);
+  return header;
+}
+
+// Returns read i of read_length bases, with n_tags aux tags alternating
+// between integer and string values.
+Read BenchmarkRead(int i, int read_length, int n_tags) {
+  string bases(read_length, 'A');
+  for (int j = 0; j < read_length; ++j) bases[j] = "ACGT"[(i + j * 7) % 4];
+  Read read = MakeRead("chr1", 100 * i, bases,
+                       {absl::StrCat(read_length, "M")});
+  read.set_fragment_name(absl::StrCat("read_", i));
+  for (int j = 0; j < n_tags; ++j) {
+    // Lowercase tags are reserved for end users, so never clash with the
+    // standard ones.
+    const string tag = {static_cast<char>('a' + j / 10),
+                        static_cast<char>('0' + j % 10)};
+    if (j % 2 == 0) {
+      SetInfoField(tag, i + j, &read);
+    } else {
+      SetInfoField(tag, absl::StrCat("value_", i, "_", j), &read);
+    }
+  }
+  return read;
+}
+
+std::vector<Read> BenchmarkReads(const benchmark::State& state) {
+  std::vector<Read> reads;
+  for (int i = 0; i < state.range(0); ++i) {
+    reads.push_back(BenchmarkRead(i, state.range(1), state.range(2)));
+  }
+  return reads;
+}
+
+// Writes reads to a new BAM file at path.
+void WriteBam(const string& path, const std::vector<Read>& reads) {
+  auto writer =
+      std::move(SamWriter::ToFile(path, BenchmarkSamHeader()).ValueOrDie());
+  for (const Read& read : reads) TF_CHECK_OK(writer->Write(read));
+  TF_CHECK_OK(writer->Close());
+}
+
+// Writes (once per process) the BAM file of the reads of state, returning its
+// path and the total length of their bases.
+std::pair<string, int64> SyntheticBam(const benchmark::State& state) {
+  static auto* cache = new std::map<string, std::pair<string, int64>>();
+  const string key = absl::StrCat("reads_", state.range(0), "_",
+                                  state.range(1), "_", state.range(2), ".bam");
+  auto it = cache->find(key);
+  if (it != cache->end()) return it->second;
+  const string path = TmpPath(key);
+  WriteBam(path, BenchmarkReads(state));
+  return (*cache)[key] =
+             std::make_pair(path, int64{state.range(0)} * state.range(1));
+}
+
+// Arguments: number of reads, read length and number of aux tags.
+void SamArgs(benchmark::internal::Benchmark* b) {
+  b->Args({100000, 100, 0})
+      ->Args({100000, 100, 20})
+      ->Args({1000, 10000, 0})
+      ->Args({1000, 10000, 20});
+}
+
+void BM_SamReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticBam(state);
+  SamReaderOptions options;
+  options.set_aux_field_handling(SamReaderOptions::PARSE_ALL_AUX_FIELDS);
+  const auto read_all = [&file, &options]() {
+    auto reader =
+        std::move(SamReader::FromFile(file.first, options).ValueOrDie());
+    for (const auto& read : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(read.ValueOrDie());
+    }
+    return reader->Stats();
+  };
+  for (auto _ : state) read_all();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+  ReportKernelTimes(&state, read_all);
+}
+BENCHMARK(BM_SamReaderIterate)->Apply(SamArgs);
+
+void BM_SamWriterWrite(benchmark::State& state) {
+  const std::vector<Read> reads = BenchmarkReads(state);
+  const string path = TmpPath("out.bam");
+  const auto write_all = [&reads, &path]() {
+    auto writer =
+        std::move(SamWriter::ToFile(path, BenchmarkSamHeader()).ValueOrDie());
+    for (const Read& read : reads) TF_CHECK_OK(writer->Write(read));
+    const IoStatistics stats = writer->Stats();
+    TF_CHECK_OK(writer->Close());
+    return stats;
+  };
+  for (auto _ : state) write_all();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+  ReportKernelTimes(&state, write_all);
+}
+BENCHMARK(BM_SamWriterWrite)->Apply(SamArgs);
+
+// VCF variants.
+
+// Returns the VCF text of n_records variants with n_samples samples each.
+string VcfText(int n_records, int n_samples) {
+  string text =
+      "##fileformat=VCFv4.2\n"
+      "##contig=<ID=chr1,length=248956422>\n"
+      "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Depth\">\n"
+      "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+      "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Quality\">\n"
+      "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Depth\">\n"
+      "##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Depths\">\n"
+      "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT";
+  for (int j = 0; j < n_samples; ++j) absl::StrAppend(&text, "\tS", j);
+  text += "\n";
+  for (int i = 0; i < n_records; ++i) {
+    absl::StrAppend(&text, "chr1\t", 100 * i + 1, "\t.\tA\tC\t50\tPASS\tDP=",
+                    30 * n_samples, "\tGT:GQ:DP:AD");
+    for (int j = 0; j < n_samples; ++j) {
+      absl::StrAppend(&text, (i + j) % 3 == 0 ? "\t0/0" : "\t0/1", ":",
+                      (i + j) % 99, ":30:", (i + j) % 30, ",",
+                      30 - (i + j) % 30);
+    }
+    text += "\n";
+  }
+  return text;
+}
+
+// Writes (once per process) the VCF file of the variants of state, returning
+// its path and size in bytes.
+std::pair<string, int64> SyntheticVcf(const benchmark::State& state) {
+  static auto* cache = new std::map<string, std::pair<string, int64>>();
+  const string key =
+      absl::StrCat("variants_", state.range(0), "_", state.range(1), ".vcf");
+  auto it = cache->find(key);
+  if (it != cache->end()) return it->second;
+  const string path = TmpPath(key);
+  const string text = VcfText(state.range(0), state.range(1));
+  std::ofstream out(path);
+  out << text;
+  CHECK(out.good()) << "Failed to write " << path;
+  return (*cache)[key] = std::make_pair(path, static_cast<int64>(text.size()));
+}
+
+// Arguments: number of variants and number of samples.
+void VcfArgs(benchmark::internal::Benchmark* b) {
+  b->Args({20000, 1})->Args({2000, 100})->Args({20, 10000});
+}
+
+void BM_VcfReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticVcf(state);
+  const auto read_all = [&file]() {
+    auto reader = std::move(
+        VcfReader::FromFile(file.first, VcfReaderOptions()).ValueOrDie());
+    for (const auto& variant : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(variant.ValueOrDie());
+    }
+    return reader->Stats();
+  };
+  for (auto _ : state) read_all();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+  ReportKernelTimes(&state, read_all);
+}
+BENCHMARK(BM_VcfReaderIterate)->Apply(VcfArgs);
+
+void BM_VcfWriterWrite(benchmark::State& state) {
+  const auto file = SyntheticVcf(state);
+  auto reader = std::move(
+      VcfReader::FromFile(file.first, VcfReaderOptions()).ValueOrDie());
+  const VcfHeader header = reader->Header();
+  const std::vector<Variant> variants = as_vector(reader->Iterate());
+  const string path = TmpPath("out.vcf");
+  const auto write_all = [&header, &variants, &path]() {
+    auto writer = std::move(
+        VcfWriter::ToFile(path, header, VcfWriterOptions()).ValueOrDie());
+    for (const Variant& variant : variants) {
+      TF_CHECK_OK(writer->Write(variant));
+    }
+    const IoStatistics stats = writer->Stats();
+    TF_CHECK_OK(writer->Close());
+    return stats;
+  };
+  for (auto _ : state) write_all();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+  ReportKernelTimes(&state, write_all);
+}
+BENCHMARK(BM_VcfWriterWrite)->Apply(VcfArgs);
+
+// FASTQ records.
+
+// Writes (once per process) the FASTQ file of the reads of state, returning
+// its path and size in bytes.
+std::pair<string, int64> SyntheticFastq(const benchmark::State& state) {
+  static auto* cache = new std::map<string, std::pair<string, int64>>();
+  const string key =
+      absl::StrCat("reads_", state.range(0), "_", state.range(1), ".fastq");
+  auto it = cache->find(key);
+  if (it != cache->end()) return it->second;
+  const string path = TmpPath(key);
+  std::ofstream out(path);
+  int64 n_bytes = 0;
+  for (int i = 0; i < state.range(0); ++i) {
+    const string record = absl::StrCat(
+        "@read_", i, " description\n",
+        BenchmarkRead(i, state.range(1), 0).aligned_sequence(), "\n+\n",
+        string(state.range(1), 'I'), "\n");
+    out << record;
+    n_bytes += record.size();
+  }
+  CHECK(out.good()) << "Failed to write " << path;
+  return (*cache)[key] = std::make_pair(path, n_bytes);
+}
+
+void BM_FastqReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticFastq(state);
+  for (auto _ : state) {
+    auto reader = std::move(
+        FastqReader::FromFile(file.first, FastqReaderOptions()).ValueOrDie());
+    for (const auto& record : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(record.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+}
+// Arguments: number of records and read length.
+BENCHMARK(BM_FastqReaderIterate)->Args({100000, 100})->Args({1000, 10000});
+
+}  // namespace
+
+}  // namespace nucleus
@@ -0,0 +1,488 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of coverage_calculator.h
+#include "nucleus/io/coverage_calculator.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "nucleus/io/parallel_region_executor.h"
+#include "nucleus/io/sam_utils.h"
+#include "nucleus/protos/cigar.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::CigarUnit;
+using genomics::v1::CoverageOptions;
+using genomics::v1::Range;
+using genomics::v1::Read;
+
+namespace {
+
+constexpr int64 kDefaultChunkSize = 65536;
+
+// Combines runs of equal depth that meet at the boundary of two regions.
+class RunMerger {
+ public:
+  RunMerger(int num_tracks, const CoverageEmitter& emit)
+      : emit_(emit), pending_(num_tracks), has_pending_(num_tracks, false) {}
+
+  tf::Status Add(int track, const BedGraphRecord& record) {
+    BedGraphRecord& pending = pending_[track];
+    if (has_pending_[track] && pending.end() == record.start() &&
+        pending.data_value() == record.data_value() &&
+        pending.reference_name() == record.reference_name()) {
+      pending.set_end(record.end());
+      return tf::Status::OK();
+    }
+    if (has_pending_[track]) {
+      TF_RETURN_IF_ERROR(emit_(track, pending));
+    }
+    pending = record;
+    has_pending_[track] = true;
+    return tf::Status::OK();
+  }
+
+  tf::Status Flush() {
+    for (size_t track = 0; track < pending_.size(); ++track) {
+      if (has_pending_[track]) {
+        has_pending_[track] = false;
+        TF_RETURN_IF_ERROR(emit_(track, pending_[track]));
+      }
+    }
+    return tf::Status::OK();
+  }
+
+ private:
+  const CoverageEmitter& emit_;
+  std::vector<BedGraphRecord> pending_;
+  std::vector<bool> has_pending_;
+};
+
+// The runs of one track.
+using Run = std::pair<int, BedGraphRecord>;
+
+// Feeds every read of iterable to calculator.
+tf::Status AddReads(const StatusOr<std::shared_ptr<SamIterable>>& reads,
+                    CoverageCalculator* calculator) {
+  TF_RETURN_IF_ERROR(reads.status());
+  const std::shared_ptr<SamIterable>& iterable = reads.ValueOrDie();
+  if (iterable == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot compute coverage while the SamReader is being iterated");
+  }
+  Read read;
+  while (true) {
+    StatusOr<bool> more = iterable->Next(&read);
+    TF_RETURN_IF_ERROR(more.status());
+    if (!more.ValueOrDie()) return tf::Status::OK();
+    TF_RETURN_IF_ERROR(calculator->AddRead(read));
+  }
+}
+
+}  // namespace
+
+namespace coverage_internal {
+
+int32 PrefixSum(absl::Span<int32> values, int32 initial) {
+  int32* data = values.data();
+  const size_t n = values.size();
+  size_t i = 0;
+#ifdef __SSE2__
+  // Sums four lanes at a time: two shifted adds turn the lanes into their
+  // prefix sums, then the running total is added to every lane.
+  __m128i total = _mm_set1_epi32(initial);
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi32(x, total);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), x);
+    total = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  initial = _mm_cvtsi128_si32(total);
+#endif
+  for (; i < n; ++i) {
+    initial += data[i];
+    data[i] = initial;
+  }
+  return initial;
+}
+
+}  // namespace coverage_internal
+
+CoverageEmitter EmitToBedGraphWriters(
+    absl::Span<BedGraphWriter* const> writers) {
+  std::vector<BedGraphWriter*> targets(writers.begin(), writers.end());
+  return [targets](int track, const BedGraphRecord& record) {
+    return targets[track]->Write(record);
+  };
+}
+
+CoverageCalculator::CoverageCalculator(const CoverageOptions& options,
+                                       CoverageEmitter emit)
+    : options_(options),
+      emit_(std::move(emit)),
+      chunk_size_(options.chunk_size() > 0 ? options.chunk_size()
+                                           : kDefaultChunkSize),
+      num_mapq_buckets_(
+          std::max(1, options.mapping_quality_thresholds_size())) {
+  const int num_tracks = NumTracks(options);
+  diffs_.assign(num_tracks * chunk_size_, 0);
+  depths_.assign(num_tracks, 0);
+  run_starts_.assign(num_tracks, 0);
+  run_depths_.assign(num_tracks, 0);
+}
+
+int CoverageCalculator::NumTracks(const CoverageOptions& options) {
+  return (options.split_by_strand() ? 2 : 1) *
+         std::max(1, options.mapping_quality_thresholds_size());
+}
+
+string CoverageCalculator::TrackName(int track) const {
+  std::vector<string> parts;
+  if (options_.split_by_strand()) {
+    parts.push_back(track / num_mapq_buckets_ == 0 ? "forward" : "reverse");
+  }
+  const auto& thresholds = options_.mapping_quality_thresholds();
+  if (!thresholds.empty()) {
+    const int bucket = track % num_mapq_buckets_;
+    parts.push_back(
+        bucket + 1 < thresholds.size()
+            ? absl::StrCat("mapq_", thresholds[bucket], "_",
+                           thresholds[bucket + 1])
+            : absl::StrCat("mapq_", thresholds[bucket], "_up"));
+  }
+  return parts.empty() ? "all" : absl::StrJoin(parts, ".");
+}
+
+int CoverageCalculator::TrackOf(const Read& read) const {
+  if (options_.has_read_requirements() &&
+      !sam_reader_internal::ReadSatisfiesRequirements(
+          read, options_.read_requirements())) {
+    return -1;
+  }
+  int bucket = 0;
+  const auto& thresholds = options_.mapping_quality_thresholds();
+  if (!thresholds.empty()) {
+    bucket = static_cast<int>(
+        std::upper_bound(thresholds.begin(), thresholds.end(),
+                         read.alignment().mapping_quality()) -
+        thresholds.begin()) - 1;
+    if (bucket < 0) return -1;
+  }
+  const bool reverse = read.alignment().position().reverse_strand();
+  return (options_.split_by_strand() && reverse ? num_mapq_buckets_ : 0) +
+         bucket;
+}
+
+tf::Status CoverageCalculator::StartRegion(const Range& region) {
+  if (in_region_) {
+    return tf::errors::FailedPrecondition(
+        "StartRegion called before FinishRegion");
+  }
+  if (region.start() < 0 || region.end() <= region.start()) {
+    return tf::errors::InvalidArgument("Invalid coverage region ",
+                                       region.reference_name(), ":",
+                                       region.start(), "-", region.end());
+  }
+  region_ = region;
+  in_region_ = true;
+  last_read_start_ = std::numeric_limits<int64>::min();
+  chunk_start_ = region.start();
+  std::fill(depths_.begin(), depths_.end(), 0);
+  std::fill(run_starts_.begin(), run_starts_.end(), region.start());
+  std::fill(run_depths_.begin(), run_depths_.end(), 0);
+  record_.set_reference_name(region.reference_name());
+  return tf::Status::OK();
+}
+
+tf::Status CoverageCalculator::AddRead(const Read& read) {
+  if (!in_region_) {
+    return tf::errors::FailedPrecondition("AddRead called outside a region");
+  }
+  if (!read.has_alignment() ||
+      read.alignment().position().reference_name() !=
+          region_.reference_name()) {
+    return tf::Status::OK();
+  }
+  const int64 start = read.alignment().position().position();
+  if (start < last_read_start_) {
+    return tf::errors::FailedPrecondition(
+        "Reads must be added in order of alignment start, but read ",
+        read.fragment_name(), " starts at ", start, " after a read at ",
+        last_read_start_);
+  }
+  last_read_start_ = start;
+  const int track = TrackOf(read);
+  if (track < 0 || start >= region_.end()) {
+    return tf::Status::OK();
+  }
+  while (start >= chunk_start_ + chunk_size_) {
+    TF_RETURN_IF_ERROR(FlushChunk(start));
+  }
+
+  // Adds [segment_start, segment_end), clipped to the region.
+  const auto add_segment = [this, track](int64 segment_start,
+                                         int64 segment_end) {
+    segment_start = std::max<int64>(segment_start, region_.start());
+    segment_end = std::min<int64>(segment_end, region_.end());
+    if (segment_start >= segment_end) return;
+    AddEvent(segment_start, track, 1);
+    if (segment_end < region_.end()) AddEvent(segment_end, track, -1);
+  };
+  // Adjacent counted operations are merged into a single segment.
+  int64 position = start;
+  int64 segment_start = start;
+  const auto add_operation = [&](CigarUnit::Operation operation,
+                                  int64 length) {
+    switch (operation) {
+      case CigarUnit::ALIGNMENT_MATCH:
+      case CigarUnit::SEQUENCE_MATCH:
+      case CigarUnit::SEQUENCE_MISMATCH:
+        position += length;
+        break;
+      case CigarUnit::DELETE:
+        if (options_.count_deletions()) {
+          position += length;
+          break;
+        }
+        // FALLTHROUGH_INTENDED
+      case CigarUnit::SKIP:
+        add_segment(segment_start, position);
+        position += length;
+        segment_start = position;
+        break;
+      default:
+        // Insertions, clips and padding consume no reference bases.
+        break;
+    }
+  };
+  if (read.alignment().cigar_size() > 0) {
+    for (const CigarUnit& unit : read.alignment().cigar()) {
+      add_operation(unit.operation(), unit.operation_length());
+    }
+  } else {
+    // Reads in the compact encoding have a packed cigar instead.
+    for (const uint32 packed : read.alignment().packed_cigar()) {
+      add_operation(PackedCigarOperation(packed), PackedCigarLength(packed));
+    }
+  }
+  add_segment(segment_start, position);
+  return tf::Status::OK();
+}
+
+void CoverageCalculator::AddEvent(int64 position, int track, int32 delta) {
+  DCHECK_GE(position, chunk_start_);
+  if (position < chunk_start_ + chunk_size_) {
+    diffs_[track * chunk_size_ + (position - chunk_start_)] += delta;
+  } else {
+    pending_.emplace(position, track, delta);
+  }
+}
+
+tf::Status CoverageCalculator::FlushChunk(int64 limit) {
+  const int64 n = std::min<int64>(chunk_size_, region_.end() - chunk_start_);
+  bool all_zero = true;
+  for (int track = 0; track < NumTracks(); ++track) {
+    const absl::Span<int32> depths(&diffs_[track * chunk_size_], n);
+    depths_[track] = coverage_internal::PrefixSum(depths, depths_[track]);
+    all_zero = all_zero && depths_[track] == 0;
+    for (int64 i = 0; i < n; ++i) {
+      if (depths[i] != run_depths_[track]) {
+        TF_RETURN_IF_ERROR(EmitRun(track, chunk_start_ + i));
+        run_starts_[track] = chunk_start_ + i;
+        run_depths_[track] = depths[i];
+      }
+    }
+    std::fill(depths.begin(), depths.end(), 0);
+  }
+
+  int64 next = chunk_start_ + n;
+  if (all_zero) {
+    // Nothing is covered until the next read or pending change, so skip
+    // straight to it.
+    int64 target = std::min<int64>(limit, region_.end());
+    if (!pending_.empty()) {
+      target = std::min<int64>(target, std::get<0>(pending_.top()));
+    }
+    next = std::max(next, target);
+  }
+  chunk_start_ = next;
+  while (!pending_.empty() &&
+         std::get<0>(pending_.top()) < chunk_start_ + chunk_size_) {
+    const Event event = pending_.top();
+    pending_.pop();
+    AddEvent(std::get<0>(event), std::get<1>(event), std::get<2>(event));
+  }
+  return tf::Status::OK();
+}
+
+tf::Status CoverageCalculator::EmitRun(int track, int64 end) {
+  if (end <= run_starts_[track] ||
+      (run_depths_[track] == 0 && !options_.write_zero_coverage())) {
+    return tf::Status::OK();
+  }
+  record_.set_start(run_starts_[track]);
+  record_.set_end(end);
+  record_.set_data_value(run_depths_[track]);
+  return emit_(track, record_);
+}
+
+tf::Status CoverageCalculator::FinishRegion() {
+  if (!in_region_) {
+    return tf::errors::FailedPrecondition(
+        "FinishRegion called outside a region");
+  }
+  in_region_ = false;
+  while (chunk_start_ < region_.end()) {
+    TF_RETURN_IF_ERROR(FlushChunk(region_.end()));
+  }
+  for (int track = 0; track < NumTracks(); ++track) {
+    TF_RETURN_IF_ERROR(EmitRun(track, region_.end()));
+  }
+  return tf::Status::OK();
+}
+
+tf::Status ComputeCoverage(const SamReader& reader, const Range& region,
+                           const CoverageOptions& options,
+                           const CoverageEmitter& emit) {
+  CoverageCalculator calculator(options, emit);
+  TF_RETURN_IF_ERROR(calculator.StartRegion(region));
+  TF_RETURN_IF_ERROR(AddReads(reader.Query(region), &calculator));
+  return calculator.FinishRegion();
+}
+
+tf::Status ComputeCoverage(const SamReader& reader,
+                           const CoverageOptions& options,
+                           const CoverageEmitter& emit) {
+  // Regions spanning each reference, skipping references of unknown length.
+  std::vector<Range> contigs;
+  std::map<string, int> contig_ids;
+  for (const auto& contig : reader.Header().contigs()) {
+    if (contig.n_bases() <= 0) continue;
+    contig_ids[contig.name()] = static_cast<int>(contigs.size());
+    Range range;
+    range.set_reference_name(contig.name());
+    range.set_start(0);
+    range.set_end(contig.n_bases());
+    contigs.push_back(range);
+  }
+
+  CoverageCalculator calculator(options, emit);
+  int current = -1;
+  // Moves the calculator to contig, covering the references in between.
+  const auto advance_to = [&](int contig) -> tf::Status {
+    if (current >= 0) {
+      TF_RETURN_IF_ERROR(calculator.FinishRegion());
+    }
+    while (++current < contig) {
+      TF_RETURN_IF_ERROR(calculator.StartRegion(contigs[current]));
+      TF_RETURN_IF_ERROR(calculator.FinishRegion());
+    }
+    return current < static_cast<int>(contigs.size())
+               ? calculator.StartRegion(contigs[current])
+               : tf::Status::OK();
+  };
+
+  StatusOr<std::shared_ptr<SamIterable>> reads = reader.Iterate();
+  TF_RETURN_IF_ERROR(reads.status());
+  const std::shared_ptr<SamIterable>& iterable = reads.ValueOrDie();
+  if (iterable == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot compute coverage while the SamReader is being iterated");
+  }
+  Read read;
+  while (true) {
+    StatusOr<bool> more = iterable->Next(&read);
+    TF_RETURN_IF_ERROR(more.status());
+    if (!more.ValueOrDie()) break;
+    if (!read.has_alignment()) continue;
+    auto it = contig_ids.find(read.alignment().position().reference_name());
+    if (it == contig_ids.end()) continue;
+    if (it->second < current) {
+      return tf::errors::FailedPrecondition(
+          "Computing the coverage of a whole file requires reads sorted by "
+          "coordinate, but read ", read.fragment_name(), " on ", it->first,
+          " follows reads on ", contigs[current].reference_name());
+    }
+    if (it->second > current) {
+      TF_RETURN_IF_ERROR(advance_to(it->second));
+    }
+    TF_RETURN_IF_ERROR(calculator.AddRead(read));
+  }
+  return advance_to(static_cast<int>(contigs.size()));
+}
+
+tf::Status ComputeCoverage(
+    const std::function<StatusOr<std::unique_ptr<SamReader>>()>& open_reader,
+    absl::Span<const Range> regions, const CoverageOptions& options,
+    const CoverageEmitter& emit) {
+  const int num_tracks = CoverageCalculator::NumTracks(options);
+  RunMerger merger(num_tracks, emit);
+  const CoverageEmitter merge = [&merger](int track,
+                                          const BedGraphRecord& record) {
+    return merger.Add(track, record);
+  };
+
+  if (options.num_threads() <= 0 || regions.size() <= 1) {
+    StatusOr<std::unique_ptr<SamReader>> reader = open_reader();
+    TF_RETURN_IF_ERROR(reader.status());
+    for (const Range& region : regions) {
+      TF_RETURN_IF_ERROR(
+          ComputeCoverage(*reader.ValueOrDie(), region, options, merge));
+    }
+    return merger.Flush();
+  }
+
+  ParallelRegionExecutor<std::unique_ptr<SamReader>, std::vector<Run>>
+      executor(open_reader, options.num_threads());
+  TF_RETURN_IF_ERROR(executor.Run(
+      regions,
+      [&options](std::unique_ptr<SamReader>* reader, const Range& region,
+                 std::vector<Run>* runs) {
+        return ComputeCoverage(
+            **reader, region, options,
+            [runs](int track, const BedGraphRecord& record) {
+              runs->emplace_back(track, record);
+              return tf::Status::OK();
+            });
+      },
+      [&merger](const Range& region, std::vector<Run>* runs) {
+        for (const Run& run : *runs) {
+          TF_RETURN_IF_ERROR(merger.Add(run.first, run.second));
+        }
+        return tf::Status::OK();
+      }));
+  return merger.Flush();
+}
+
+}  // namespace nucleus
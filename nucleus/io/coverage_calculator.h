@@ -0,0 +1,166 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Per-base depth of coverage of aligned reads, output as BedGraph records.
+//
+// Coverage is accumulated one chunk of the reference at a time: each aligned
+// block of a read adds +1 at its start and -1 at its end to a difference array
+// covering the chunk, and once no later read can touch the chunk a prefix sum
+// turns the differences into depths, which are output as runs of equal depth.
+// The cost is proportional to the number of aligned blocks plus the length of
+// the covered reference, independent of read length or depth.
+#ifndef THIRD_PARTY_NUCLEUS_IO_COVERAGE_CALCULATOR_H_
+#define THIRD_PARTY_NUCLEUS_IO_COVERAGE_CALCULATOR_H_
+
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "nucleus/io/bedgraph_writer.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/bedgraph.pb.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/protos/reads.pb.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+// Receives the coverage runs of track, in increasing position order per
+// track.
+using CoverageEmitter = std::function<tensorflow::Status(
+    int track, const nucleus::genomics::v1::BedGraphRecord& record)>;
+
+// Returns a CoverageEmitter writing the runs of track i to writers[i].
+CoverageEmitter EmitToBedGraphWriters(absl::Span<BedGraphWriter* const> writers);
+
+// Accumulates the coverage of reads over one region at a time.
+//
+// Reads are counted in one or more tracks, depending on the strand and
+// mapping quality splits requested in the options.
+class CoverageCalculator {
+ public:
+  CoverageCalculator(const nucleus::genomics::v1::CoverageOptions& options,
+                     CoverageEmitter emit);
+
+  // Disable copy and assignment operations.
+  CoverageCalculator(const CoverageCalculator& other) = delete;
+  CoverageCalculator& operator=(const CoverageCalculator&) = delete;
+
+  // The number of tracks coverage is split into by a calculator with options.
+  static int NumTracks(const nucleus::genomics::v1::CoverageOptions& options);
+
+  // The number of tracks coverage is split into.
+  int NumTracks() const { return NumTracks(options_); }
+
+  // A name for track, such as "all", "reverse" or "forward.mapq_20_60",
+  // suitable for making file names.
+  string TrackName(int track) const;
+
+  // Starts accumulating coverage over region, which must not be called while
+  // another region is in progress.
+  tensorflow::Status StartRegion(const nucleus::genomics::v1::Range& region);
+
+  // Counts the aligned bases of read that fall in the current region. Reads
+  // must be added in order of alignment start; reads that are unaligned, on
+  // another reference or filtered out by the options are ignored.
+  tensorflow::Status AddRead(const nucleus::genomics::v1::Read& read);
+
+  // Outputs the coverage of the rest of the current region and ends it.
+  tensorflow::Status FinishRegion();
+
+ private:
+  // A change of depth of one track at a position past the current chunk.
+  using Event = std::tuple<int64, int, int32>;
+
+  // Returns the track read is counted in, or -1 if it is not counted.
+  int TrackOf(const nucleus::genomics::v1::Read& read) const;
+
+  // Adds delta to the depth of track from position on.
+  void AddEvent(int64 position, int track, int32 delta);
+
+  // Outputs the depths of the current chunk and moves to the next chunk that
+  // may have a non-zero depth, but no further than limit.
+  tensorflow::Status FlushChunk(int64 limit);
+
+  // Outputs the run of track ending at end, if any.
+  tensorflow::Status EmitRun(int track, int64 end);
+
+  const nucleus::genomics::v1::CoverageOptions options_;
+  const CoverageEmitter emit_;
+  const int64 chunk_size_;
+  const int num_mapq_buckets_;
+
+  // The current region, and whether one is in progress.
+  nucleus::genomics::v1::Range region_;
+  bool in_region_ = false;
+  int64 last_read_start_ = 0;
+
+  // The depth changes of the chunk [chunk_start_, chunk_start_ + chunk_size_),
+  // chunk_size_ per track, and the depth of each track before the chunk.
+  int64 chunk_start_ = 0;
+  std::vector<int32> diffs_;
+  std::vector<int32> depths_;
+  // Depth changes past the current chunk, earliest first.
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> pending_;
+
+  // The run of equal depth being extended in each track.
+  std::vector<int64> run_starts_;
+  std::vector<int32> run_depths_;
+  nucleus::genomics::v1::BedGraphRecord record_;
+};
+
+// Outputs the coverage of the reads of reader overlapping region.
+tensorflow::Status ComputeCoverage(
+    const SamReader& reader, const nucleus::genomics::v1::Range& region,
+    const nucleus::genomics::v1::CoverageOptions& options,
+    const CoverageEmitter& emit);
+
+// Outputs the coverage of every reference in the header of reader, whose reads
+// must be sorted by coordinate.
+tensorflow::Status ComputeCoverage(
+    const SamReader& reader,
+    const nucleus::genomics::v1::CoverageOptions& options,
+    const CoverageEmitter& emit);
+
+// Outputs the coverage of regions, which must not overlap, using
+// options.num_threads threads that each read from their own reader returned by
+// open_reader. The runs are output on the calling thread, in the order of the
+// regions, and runs of equal depth meeting at the boundary of adjacent regions
+// are merged.
+tensorflow::Status ComputeCoverage(
+    const std::function<StatusOr<std::unique_ptr<SamReader>>()>& open_reader,
+    absl::Span<const nucleus::genomics::v1::Range> regions,
+    const nucleus::genomics::v1::CoverageOptions& options,
+    const CoverageEmitter& emit);
+
+namespace coverage_internal {
+
+// Replaces values[i] with initial + values[0] + ... + values[i], returning
+// the last sum (or initial if values is empty). Uses SSE2 when available.
+int32 PrefixSum(absl::Span<int32> values, int32 initial);
+
+}  // namespace coverage_internal
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_COVERAGE_CALCULATOR_H_
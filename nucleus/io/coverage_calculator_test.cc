@@ -0,0 +1,306 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/coverage_calculator.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "absl/strings/str_cat.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::CoverageOptions;
+using genomics::v1::Range;
+using genomics::v1::Read;
+using genomics::v1::SamReaderOptions;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+
+namespace {
+
+constexpr char kBamTestFilename[] = "test.bam";
+
+// Collects the runs output for each track.
+class Collector {
+ public:
+  explicit Collector(int num_tracks) : runs_(num_tracks) {}
+
+  CoverageEmitter Emitter() {
+    return [this](int track, const BedGraphRecord& record) {
+      runs_[track].push_back(record);
+      return tensorflow::Status::OK();
+    };
+  }
+
+  const std::vector<BedGraphRecord>& Runs(int track) const {
+    return runs_[track];
+  }
+
+ private:
+  std::vector<std::vector<BedGraphRecord>> runs_;
+};
+
+// Returns the runs of reads over region, computed with options.
+std::vector<BedGraphRecord> Coverage(const std::vector<Read>& reads,
+                                     int64 start, int64 end,
+                                     const CoverageOptions& options) {
+  Collector collector(1);
+  CoverageCalculator calculator(options, collector.Emitter());
+  TF_CHECK_OK(calculator.StartRegion(MakeRange("chr1", start, end)));
+  for (const Read& read : reads) {
+    TF_CHECK_OK(calculator.AddRead(read));
+  }
+  TF_CHECK_OK(calculator.FinishRegion());
+  return collector.Runs(0);
+}
+
+// A read of length matching bases on chr1 with the given cigar.
+Read MakeTestRead(int start, const std::vector<string>& cigar,
+                  int num_bases) {
+  return MakeRead("chr1", start, string(num_bases, 'A'), cigar);
+}
+
+BedGraphRecord MakeRun(int64 start, int64 end, double depth) {
+  BedGraphRecord r;
+  r.set_reference_name("chr1");
+  r.set_start(start);
+  r.set_end(end);
+  r.set_data_value(depth);
+  return r;
+}
+
+}  // namespace
+
+TEST(CoverageCalculatorTest, PrefixSumMatchesScalarSum) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int32> value(-3, 3);
+  for (int n = 0; n < 40; ++n) {
+    std::vector<int32> values(n);
+    for (int32& v : values) v = value(rng);
+    std::vector<int32> expected = values;
+    int32 sum = 7;
+    for (int32& v : expected) v = sum += v;
+    EXPECT_THAT(coverage_internal::PrefixSum(absl::MakeSpan(values), 7),
+                Eq(sum));
+    EXPECT_THAT(values, Eq(expected));
+  }
+}
+
+TEST(CoverageCalculatorTest, OutputsRunsOfEqualDepth) {
+  EXPECT_THAT(Coverage({MakeTestRead(10, {"10M"}, 10),
+                        MakeTestRead(15, {"10M"}, 10),
+                        MakeTestRead(30, {"5M"}, 5)},
+                       0, 100, CoverageOptions()),
+              ElementsAre(EqualsProto(MakeRun(10, 15, 1)),
+                          EqualsProto(MakeRun(15, 20, 2)),
+                          EqualsProto(MakeRun(20, 25, 1)),
+                          EqualsProto(MakeRun(30, 35, 1))));
+}
+
+TEST(CoverageCalculatorTest, FollowsCigar) {
+  const std::vector<Read> reads = {
+      MakeTestRead(10, {"2S", "3M", "1I", "2D", "3M", "1N", "2M", "2H"}, 11)};
+  EXPECT_THAT(Coverage(reads, 0, 100, CoverageOptions()),
+              ElementsAre(EqualsProto(MakeRun(10, 13, 1)),
+                          EqualsProto(MakeRun(15, 18, 1)),
+                          EqualsProto(MakeRun(19, 21, 1))));
+  CoverageOptions options;
+  options.set_count_deletions(true);
+  EXPECT_THAT(Coverage(reads, 0, 100, options),
+              ElementsAre(EqualsProto(MakeRun(10, 18, 1)),
+                          EqualsProto(MakeRun(19, 21, 1))));
+}
+
+TEST(CoverageCalculatorTest, ClipsReadsToRegion) {
+  CoverageOptions options;
+  options.set_write_zero_coverage(true);
+  EXPECT_THAT(Coverage({MakeTestRead(5, {"10M"}, 10),
+                        MakeTestRead(18, {"10M"}, 10)},
+                       10, 20, options),
+              ElementsAre(EqualsProto(MakeRun(10, 15, 1)),
+                          EqualsProto(MakeRun(15, 18, 0)),
+                          EqualsProto(MakeRun(18, 20, 1))));
+  EXPECT_THAT(Coverage({}, 10, 20, options),
+              ElementsAre(EqualsProto(MakeRun(10, 20, 0))));
+  EXPECT_THAT(Coverage({}, 10, 20, CoverageOptions()), IsEmpty());
+}
+
+TEST(CoverageCalculatorTest, SplitsByStrandAndMappingQuality) {
+  CoverageOptions options;
+  options.set_split_by_strand(true);
+  options.add_mapping_quality_thresholds(10);
+  options.add_mapping_quality_thresholds(30);
+  Collector collector(4);
+  CoverageCalculator calculator(options, collector.Emitter());
+  ASSERT_THAT(calculator.NumTracks(), Eq(4));
+  EXPECT_THAT(CoverageCalculator::NumTracks(options), Eq(4));
+  EXPECT_THAT(CoverageCalculator::NumTracks(CoverageOptions()), Eq(1));
+  EXPECT_THAT(calculator.TrackName(0), Eq("forward.mapq_10_30"));
+  EXPECT_THAT(calculator.TrackName(3), Eq("reverse.mapq_30_up"));
+
+  std::vector<Read> reads(4, MakeTestRead(0, {"5M"}, 5));
+  reads[0].mutable_alignment()->set_mapping_quality(5);  // Dropped.
+  reads[1].mutable_alignment()->set_mapping_quality(10);
+  reads[2].mutable_alignment()->set_mapping_quality(60);
+  reads[3].mutable_alignment()->set_mapping_quality(30);
+  reads[3].mutable_alignment()->mutable_position()->set_reverse_strand(true);
+  ASSERT_THAT(calculator.StartRegion(MakeRange("chr1", 0, 10)), IsOK());
+  for (const Read& read : reads) {
+    ASSERT_THAT(calculator.AddRead(read), IsOK());
+  }
+  ASSERT_THAT(calculator.FinishRegion(), IsOK());
+  EXPECT_THAT(collector.Runs(0), ElementsAre(EqualsProto(MakeRun(0, 5, 1))));
+  EXPECT_THAT(collector.Runs(1), ElementsAre(EqualsProto(MakeRun(0, 5, 1))));
+  EXPECT_THAT(collector.Runs(2), IsEmpty());
+  EXPECT_THAT(collector.Runs(3), ElementsAre(EqualsProto(MakeRun(0, 5, 1))));
+}
+
+TEST(CoverageCalculatorTest, AppliesReadRequirements) {
+  CoverageOptions options;
+  options.mutable_read_requirements()->set_min_mapping_quality(20);
+  Read duplicate = MakeTestRead(0, {"5M"}, 5);
+  duplicate.set_duplicate_fragment(true);
+  Read low_quality = MakeTestRead(2, {"5M"}, 5);
+  low_quality.mutable_alignment()->set_mapping_quality(10);
+  EXPECT_THAT(Coverage({duplicate, low_quality, MakeTestRead(4, {"2M"}, 2)},
+                       0, 10, options),
+              ElementsAre(EqualsProto(MakeRun(4, 6, 1))));
+}
+
+TEST(CoverageCalculatorTest, MatchesNaiveCountAcrossChunks) {
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int> length(1, 30);
+  std::uniform_int_distribution<int> gap(0, 40);
+  std::uniform_int_distribution<int> op(0, 5);
+  const char* kOps = "MMDNI=";
+  for (int chunk_size : {1, 3, 16, 1000}) {
+    std::vector<Read> reads;
+    int start = 0;
+    for (int i = 0; i < 200; ++i) {
+      start += gap(rng) / 4;
+      std::vector<string> cigar = {"5M"};
+      int num_bases = 5;
+      for (int j = op(rng); j > 0; --j) {
+        const char o = kOps[op(rng)];
+        const int n = length(rng) * (o == 'N' ? 5 : 1);
+        cigar.push_back(absl::StrCat(n, string(1, o)));
+        if (o != 'D' && o != 'N') num_bases += n;
+      }
+      reads.push_back(MakeTestRead(start, cigar, num_bases));
+    }
+
+    // Count every base of the region [100, 2000) directly.
+    const int64 region_start = 100, region_end = 2000;
+    std::vector<int> naive(region_end, 0);
+    for (const Read& read : reads) {
+      int64 position = read.alignment().position().position();
+      for (const auto& unit : read.alignment().cigar()) {
+        const bool counted =
+            unit.operation() == genomics::v1::CigarUnit::ALIGNMENT_MATCH ||
+            unit.operation() == genomics::v1::CigarUnit::SEQUENCE_MATCH;
+        const bool consumes =
+            counted || unit.operation() == genomics::v1::CigarUnit::DELETE ||
+            unit.operation() == genomics::v1::CigarUnit::SKIP;
+        for (int64 k = 0; consumes && k < unit.operation_length();
+             ++k, ++position) {
+          if (counted && position < region_end) ++naive[position];
+        }
+      }
+    }
+
+    CoverageOptions options;
+    options.set_chunk_size(chunk_size);
+    options.set_write_zero_coverage(true);
+    std::vector<int> computed;
+    int64 expected_start = region_start;
+    for (const BedGraphRecord& run :
+         Coverage(reads, region_start, region_end, options)) {
+      ASSERT_THAT(run.start(), Eq(expected_start));
+      computed.insert(computed.end(), run.end() - run.start(),
+                      static_cast<int>(run.data_value()));
+      expected_start = run.end();
+    }
+    EXPECT_THAT(expected_start, Eq(region_end));
+    EXPECT_THAT(computed,
+                Eq(std::vector<int>(naive.begin() + region_start,
+                                    naive.end())))
+        << "chunk_size " << chunk_size;
+  }
+}
+
+TEST(CoverageCalculatorTest, RejectsUnsortedReads) {
+  Collector collector(1);
+  CoverageCalculator calculator(CoverageOptions(), collector.Emitter());
+  EXPECT_THAT(calculator.AddRead(MakeTestRead(0, {"5M"}, 5)),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+  ASSERT_THAT(calculator.StartRegion(MakeRange("chr1", 0, 100)), IsOK());
+  EXPECT_THAT(calculator.StartRegion(MakeRange("chr1", 0, 100)),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+  ASSERT_THAT(calculator.AddRead(MakeTestRead(10, {"5M"}, 5)), IsOK());
+  EXPECT_THAT(calculator.AddRead(MakeTestRead(5, {"5M"}, 5)),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
+TEST(CoverageCalculatorTest, ShardedRegionsMatchWholeFile) {
+  const auto open_reader = []() {
+    return SamReader::FromFile(GetTestData(kBamTestFilename),
+                               SamReaderOptions());
+  };
+  std::unique_ptr<SamReader> reader =
+      std::move(open_reader().ValueOrDie());
+  CoverageOptions options;
+  options.set_split_by_strand(true);
+  options.set_chunk_size(100);
+  Collector whole_file(2);
+  ASSERT_THAT(ComputeCoverage(*reader, options, whole_file.Emitter()), IsOK());
+
+  // Split every reference into four shards.
+  std::vector<Range> shards;
+  for (const auto& contig : reader->Header().contigs()) {
+    for (int i = 0; i < 4; ++i) {
+      shards.push_back(MakeRange(contig.name(), contig.n_bases() * i / 4,
+                                 contig.n_bases() * (i + 1) / 4));
+    }
+  }
+  options.set_num_threads(3);
+  Collector sharded(2);
+  ASSERT_THAT(ComputeCoverage(open_reader, shards, options, sharded.Emitter()),
+              IsOK());
+  for (int track = 0; track < 2; ++track) {
+    EXPECT_THAT(whole_file.Runs(track), ::testing::Not(IsEmpty()));
+    EXPECT_THAT(sharded.Runs(track),
+                ::testing::Pointwise(EqualsProto(), whole_file.Runs(track)));
+  }
+}
+
+}  // namespace nucleus
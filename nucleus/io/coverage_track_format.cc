@@ -0,0 +1,394 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of coverage_track_format.h
+#include "nucleus/io/coverage_track_format.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+namespace coverage_track {
+
+namespace tf = tensorflow;
+
+namespace {
+
+// How the values of a block are stored.
+enum ValueEncoding : uint8 {
+  kZigZagValues = 0,
+  kFloatValues = 1,
+  kDoubleValues = 2,
+};
+
+// Values with a larger magnitude are not stored as integers, so that every
+// integer-encoded value converts back to the same double.
+constexpr double kMaxIntegerValue = 9007199254740992.0;  // 2^53
+
+uint64 ZigZag(int64 v) {
+  return (static_cast<uint64>(v) << 1) ^ static_cast<uint64>(v >> 63);
+}
+
+int64 UnZigZag(uint64 v) {
+  return static_cast<int64>(v >> 1) ^ -static_cast<int64>(v & 1);
+}
+
+bool IsExactInteger(double v) {
+  return std::abs(v) <= kMaxIntegerValue && std::floor(v) == v &&
+         !(v == 0 && std::signbit(v));
+}
+
+bool IsExactFloat(double v) {
+  return static_cast<double>(static_cast<float>(v)) == v;
+}
+
+ValueEncoding ChooseEncoding(absl::Span<const Interval> intervals) {
+  ValueEncoding encoding = kZigZagValues;
+  for (const Interval& interval : intervals) {
+    if (encoding == kZigZagValues && !IsExactInteger(interval.value)) {
+      encoding = kFloatValues;
+    }
+    if (encoding == kFloatValues && !IsExactFloat(interval.value)) {
+      return kDoubleValues;
+    }
+  }
+  return encoding;
+}
+
+void PutDouble(string* out, double value) {
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  tf::core::PutFixed64(out, bits);
+}
+
+// Reads fixed-width and varint fields from the front of a buffer, remembering
+// whether any read ran past its end.
+class Decoder {
+ public:
+  explicit Decoder(absl::string_view data) : data_(data) {}
+
+  uint64 Varint() {
+    uint64 value = 0;
+    if (ok_ && !tf::core::GetVarint64(&data_, &value)) ok_ = false;
+    return ok_ ? value : 0;
+  }
+
+  uint32 Fixed32() {
+    if (!ok_ || data_.size() < 4) return Fail();
+    uint32 value = tf::core::DecodeFixed32(data_.data());
+    data_.remove_prefix(4);
+    return value;
+  }
+
+  uint64 Fixed64() {
+    if (!ok_ || data_.size() < 8) return Fail();
+    uint64 value = tf::core::DecodeFixed64(data_.data());
+    data_.remove_prefix(8);
+    return value;
+  }
+
+  double Double() {
+    uint64 bits = Fixed64();
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  absl::string_view Bytes(uint64 n) {
+    if (!ok_ || data_.size() < n) {
+      Fail();
+      return absl::string_view();
+    }
+    absl::string_view bytes = data_.substr(0, n);
+    data_.remove_prefix(n);
+    return bytes;
+  }
+
+  // Reads a count of items that each take at least min_item_size bytes,
+  // failing if there cannot be that many left.
+  uint64 Count(size_t min_item_size) {
+    uint64 n = Varint();
+    if (n > data_.size() / min_item_size) return Fail();
+    return n;
+  }
+
+  bool ok() const { return ok_; }
+  bool done() const { return data_.empty(); }
+
+ private:
+  uint64 Fail() {
+    ok_ = false;
+    return 0;
+  }
+
+  absl::string_view data_;
+  bool ok_ = true;
+};
+
+// The largest coordinate accepted from a file, so that sums of coordinates
+// cannot overflow.
+constexpr uint64 kMaxPosition = uint64{1} << 60;
+
+}  // namespace
+
+void Summary::Add(double value, int64 bases) {
+  if (bases_covered == 0) {
+    min_value = max_value = value;
+  } else {
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+  }
+  bases_covered += bases;
+  sum += value * bases;
+  sum_squares += value * value * bases;
+}
+
+void Summary::Merge(const Summary& other, double fraction) {
+  const int64 bases = std::llround(other.bases_covered * fraction);
+  if (bases == 0) return;
+  if (bases_covered == 0) {
+    min_value = other.min_value;
+    max_value = other.max_value;
+  } else {
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+  }
+  bases_covered += bases;
+  sum += other.sum * fraction;
+  sum_squares += other.sum_squares * fraction;
+}
+
+void EncodeBlock(absl::Span<const Interval> intervals, int64 block_start,
+                 string* out) {
+  const ValueEncoding encoding = ChooseEncoding(intervals);
+  out->push_back(static_cast<char>(encoding));
+  int64 previous_end = block_start;
+  for (const Interval& interval : intervals) {
+    tf::core::PutVarint64(out, interval.start - previous_end);
+    tf::core::PutVarint64(out, interval.end - interval.start);
+    switch (encoding) {
+      case kZigZagValues:
+        tf::core::PutVarint64(out, ZigZag(static_cast<int64>(interval.value)));
+        break;
+      case kFloatValues: {
+        const float value = static_cast<float>(interval.value);
+        uint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        tf::core::PutFixed32(out, bits);
+        break;
+      }
+      case kDoubleValues:
+        PutDouble(out, interval.value);
+        break;
+    }
+    previous_end = interval.end;
+  }
+}
+
+tf::Status DecodeBlock(absl::string_view data, const Block& block,
+                       std::vector<Interval>* intervals) {
+  intervals->clear();
+  if (data.empty()) {
+    return tf::errors::DataLoss("Empty coverage track block");
+  }
+  const uint8 encoding = static_cast<uint8>(data[0]);
+  if (encoding > kDoubleValues) {
+    return tf::errors::DataLoss("Unknown coverage track value encoding ",
+                                static_cast<int>(encoding));
+  }
+  Decoder decoder(data.substr(1));
+  intervals->reserve(block.num_intervals);
+  int64 previous_end = block.start;
+  for (uint32 i = 0; i < block.num_intervals && decoder.ok(); ++i) {
+    Interval interval;
+    const uint64 gap = decoder.Varint();
+    const uint64 length = decoder.Varint();
+    if (gap > kMaxPosition || length > kMaxPosition) break;
+    interval.start = previous_end + gap;
+    interval.end = interval.start + length;
+    switch (encoding) {
+      case kZigZagValues:
+        interval.value = static_cast<double>(UnZigZag(decoder.Varint()));
+        break;
+      case kFloatValues: {
+        const uint32 bits = decoder.Fixed32();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        interval.value = value;
+        break;
+      }
+      default:
+        interval.value = decoder.Double();
+        break;
+    }
+    if (interval.end > block.end) break;
+    intervals->push_back(interval);
+    previous_end = interval.end;
+  }
+  if (!decoder.ok() || !decoder.done() ||
+      intervals->size() != block.num_intervals ||
+      (!intervals->empty() && (intervals->front().start != block.start ||
+                               intervals->back().end != block.end))) {
+    intervals->clear();
+    return tf::errors::DataLoss("Corrupt coverage track block at offset ",
+                                block.offset);
+  }
+  return tf::Status::OK();
+}
+
+void EncodeIndex(const Index& index, string* out) {
+  tf::core::PutVarint64(out, index.contigs.size());
+  for (const string& contig : index.contigs) {
+    tf::core::PutVarint64(out, contig.size());
+    out->append(contig);
+  }
+  tf::core::PutVarint64(out, index.blocks.size());
+  for (const Block& block : index.blocks) {
+    tf::core::PutVarint64(out, block.contig);
+    tf::core::PutVarint64(out, block.start);
+    tf::core::PutVarint64(out, block.end - block.start);
+    tf::core::PutVarint64(out, block.offset);
+    tf::core::PutVarint64(out, block.size);
+    tf::core::PutVarint64(out, block.num_intervals);
+  }
+  tf::core::PutVarint64(out, index.zoom_levels.size());
+  for (const ZoomLevel& level : index.zoom_levels) {
+    tf::core::PutVarint64(out, level.bin_size);
+    tf::core::PutVarint64(out, level.bins.size());
+    for (const ZoomBin& bin : level.bins) {
+      tf::core::PutVarint64(out, bin.contig);
+      tf::core::PutVarint64(out, bin.start / level.bin_size);
+      tf::core::PutVarint64(out, bin.summary.bases_covered);
+      PutDouble(out, bin.summary.min_value);
+      PutDouble(out, bin.summary.max_value);
+      PutDouble(out, bin.summary.sum);
+      PutDouble(out, bin.summary.sum_squares);
+    }
+  }
+}
+
+tf::Status DecodeIndex(absl::string_view data, uint64 data_size,
+                       Index* index) {
+  const auto corrupt = [](const char* what) {
+    return tf::errors::DataLoss("Corrupt coverage track index: ", what);
+  };
+  *index = Index();
+  Decoder decoder(data);
+
+  const uint64 num_contigs = decoder.Count(1);
+  index->contigs.reserve(num_contigs);
+  for (uint64 i = 0; i < num_contigs && decoder.ok(); ++i) {
+    absl::string_view name = decoder.Bytes(decoder.Varint());
+    index->contigs.emplace_back(name.data(), name.size());
+  }
+  if (num_contigs > static_cast<uint64>(std::numeric_limits<int32>::max())) {
+    return corrupt("too many references");
+  }
+
+  // Each block takes at least 6 bytes.
+  const uint64 num_blocks = decoder.Count(6);
+  index->blocks.reserve(num_blocks);
+  for (uint64 i = 0; i < num_blocks && decoder.ok(); ++i) {
+    const uint64 contig = decoder.Varint();
+    const uint64 start = decoder.Varint();
+    const uint64 length = decoder.Varint();
+    const uint64 offset = decoder.Varint();
+    const uint64 size = decoder.Varint();
+    const uint64 num_intervals = decoder.Varint();
+    if (!decoder.ok()) break;
+    if (contig >= num_contigs || start > kMaxPosition ||
+        length > kMaxPosition || offset < kMagicSize || size > data_size ||
+        offset > data_size - size || num_intervals == 0 ||
+        num_intervals > size) {
+      return corrupt("invalid block");
+    }
+    Block block;
+    block.contig = static_cast<int32>(contig);
+    block.start = static_cast<int64>(start);
+    block.end = block.start + static_cast<int64>(length);
+    block.offset = offset;
+    block.size = static_cast<uint32>(size);
+    block.num_intervals = static_cast<uint32>(num_intervals);
+    if (!index->blocks.empty()) {
+      const Block& previous = index->blocks.back();
+      if (block.contig < previous.contig ||
+          (block.contig == previous.contig && block.start < previous.end)) {
+        return corrupt("blocks out of order");
+      }
+    }
+    index->blocks.push_back(block);
+  }
+
+  // Each zoom bin takes at least 35 bytes.
+  const uint64 num_levels = decoder.Count(2);
+  index->zoom_levels.resize(num_levels);
+  for (uint64 i = 0; i < num_levels && decoder.ok(); ++i) {
+    ZoomLevel& level = index->zoom_levels[i];
+    const uint64 bin_size = decoder.Varint();
+    if (bin_size == 0 || bin_size > kMaxPosition ||
+        (i > 0 &&
+         static_cast<int64>(bin_size) <= index->zoom_levels[i - 1].bin_size)) {
+      return corrupt("invalid zoom level");
+    }
+    level.bin_size = static_cast<int64>(bin_size);
+    const uint64 num_bins = decoder.Count(35);
+    level.bins.reserve(num_bins);
+    for (uint64 j = 0; j < num_bins && decoder.ok(); ++j) {
+      const uint64 contig = decoder.Varint();
+      const uint64 bin = decoder.Varint();
+      ZoomBin zoom_bin;
+      zoom_bin.summary.bases_covered = decoder.Varint();
+      zoom_bin.summary.min_value = decoder.Double();
+      zoom_bin.summary.max_value = decoder.Double();
+      zoom_bin.summary.sum = decoder.Double();
+      zoom_bin.summary.sum_squares = decoder.Double();
+      if (!decoder.ok()) break;
+      if (contig >= num_contigs || bin > kMaxPosition / bin_size ||
+          zoom_bin.summary.bases_covered <= 0 ||
+          zoom_bin.summary.bases_covered > level.bin_size) {
+        return corrupt("invalid zoom bin");
+      }
+      zoom_bin.contig = static_cast<int32>(contig);
+      zoom_bin.start = static_cast<int64>(bin) * level.bin_size;
+      zoom_bin.end = zoom_bin.start + level.bin_size;
+      if (!level.bins.empty()) {
+        const ZoomBin& previous = level.bins.back();
+        if (zoom_bin.contig < previous.contig ||
+            (zoom_bin.contig == previous.contig &&
+             zoom_bin.start <= previous.start)) {
+          return corrupt("zoom bins out of order");
+        }
+      }
+      level.bins.push_back(zoom_bin);
+    }
+  }
+
+  if (!decoder.ok() || !decoder.done()) {
+    *index = Index();
+    return corrupt("truncated or trailing data");
+  }
+  return tf::Status::OK();
+}
+
+}  // namespace coverage_track
+}  // namespace nucleus
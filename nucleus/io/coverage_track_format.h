@@ -0,0 +1,137 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// The on-disk layout shared by CoverageTrackWriter and CoverageTrackReader.
+//
+// A coverage track holds the records of a BedGraph file: non-overlapping
+// intervals with a value, sorted by start within each reference. A track file
+// is laid out as
+//
+//   kMagic
+//   data blocks
+//   index
+//   footer: the offset of the index (fixed64), then kMagic
+//
+// Each data block holds a run of consecutive intervals on one reference. It
+// starts with a ValueEncoding byte, followed for each interval by the varint
+// gap between its start and the end of the previous interval (or the start of
+// the block), its varint length and its value. Values are zigzag varints,
+// floats or doubles, whichever is the narrowest to represent every value of
+// the block exactly, so integer depths take one or two bytes each.
+//
+// The index lists the reference names, the extent and location of every block
+// and, for each zoom level, the summary of every bin of that level's width
+// that overlaps an interval. All fixed-width numbers are little-endian.
+#ifndef THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_FORMAT_H_
+#define THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_FORMAT_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "nucleus/platform/types.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+namespace coverage_track {
+
+// Identifies coverage track files. Includes the terminating NUL.
+constexpr char kMagic[] = "NUCCOV\x01";
+constexpr size_t kMagicSize = sizeof(kMagic);
+
+// The size of the footer: the index offset followed by kMagic.
+constexpr size_t kFooterSize = 8 + kMagicSize;
+
+// One record of a track, on the reference of the block holding it.
+struct Interval {
+  int64 start;
+  int64 end;
+  double value;
+};
+
+// The extent and location in the file of a data block.
+struct Block {
+  int32 contig;
+  // The start of the first and the end of the last interval of the block.
+  int64 start;
+  int64 end;
+  uint64 offset;
+  uint32 size;
+  uint32 num_intervals;
+};
+
+// Statistics of the values over a set of bases.
+struct Summary {
+  int64 bases_covered = 0;
+  double min_value = 0;
+  double max_value = 0;
+  double sum = 0;
+  double sum_squares = 0;
+
+  // Adds bases bases with the given value.
+  void Add(double value, int64 bases);
+
+  // Adds the given fraction of the bases summarized by other, assuming they
+  // are spread evenly. min_value and max_value are taken from other as is.
+  void Merge(const Summary& other, double fraction);
+};
+
+// The summary of the bases in [start, end) of a reference.
+struct ZoomBin {
+  int32 contig;
+  int64 start;
+  int64 end;
+  Summary summary;
+};
+
+// The non-empty bins of bin_size bases, sorted by contig and start.
+struct ZoomLevel {
+  int64 bin_size;
+  std::vector<ZoomBin> bins;
+};
+
+struct Index {
+  std::vector<string> contigs;
+  // Sorted by contig and start; the blocks of a contig do not overlap.
+  std::vector<Block> blocks;
+  // Sorted by increasing bin_size.
+  std::vector<ZoomLevel> zoom_levels;
+};
+
+// Appends the encoding of intervals, which must be sorted and non-overlapping
+// and start at or after block_start, to *out.
+void EncodeBlock(absl::Span<const Interval> intervals, int64 block_start,
+                 string* out);
+
+// Replaces *intervals with the intervals encoded in data, the contents of
+// block.
+tensorflow::Status DecodeBlock(absl::string_view data, const Block& block,
+                               std::vector<Interval>* intervals);
+
+// Appends the encoding of index to *out.
+void EncodeIndex(const Index& index, string* out);
+
+// Decodes an index written by EncodeIndex, checking that its blocks lie
+// within the first data_size bytes of the file.
+tensorflow::Status DecodeIndex(absl::string_view data, uint64 data_size,
+                               Index* index);
+
+}  // namespace coverage_track
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_FORMAT_H_
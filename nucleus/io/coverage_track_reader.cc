@@ -0,0 +1,341 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of coverage_track_reader.h
+#include "nucleus/io/coverage_track_reader.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "nucleus/io/file_util.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::CoverageSummary;
+using genomics::v1::Range;
+
+namespace {
+
+// Names coverage tracks in the errors of ReadExactly.
+constexpr char kFileKind[] = "Coverage track";
+
+}  // namespace
+
+// Iterable class for traversing the records of a range of blocks, optionally
+// restricted to those overlapping [start, end).
+class CoverageTrackIterable : public BedGraphIterable {
+ public:
+  // Advance to the next record.
+  StatusOr<bool> Next(BedGraphRecord* out) override;
+
+  // Constructor is invoked via CoverageTrackReader::Iterate and Query.
+  CoverageTrackIterable(const CoverageTrackReader* reader, int first_block,
+                        int end_block, int64 start, int64 end);
+  ~CoverageTrackIterable() override;
+
+ private:
+  int next_block_;
+  int end_block_;
+  int64 start_;
+  int64 end_;
+
+  // The decoded intervals of the current block, on contig_.
+  std::vector<coverage_track::Interval> intervals_;
+  size_t next_interval_ = 0;
+  int32 contig_ = -1;
+  string scratch_;
+};
+
+StatusOr<std::unique_ptr<CoverageTrackReader>> CoverageTrackReader::FromFile(
+    const string& path) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->GetFileSize(path, &file_size));
+  std::unique_ptr<tf::RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->NewRandomAccessFile(path, &file));
+
+  string scratch;
+  absl::string_view data;
+  if (file_size < coverage_track::kMagicSize + coverage_track::kFooterSize) {
+    return tf::errors::DataLoss("Not a coverage track: ", path);
+  }
+  TF_RETURN_IF_ERROR(ReadExactly(*file, 0, coverage_track::kMagicSize,
+                                 kFileKind, &scratch, &data));
+  const absl::string_view magic(coverage_track::kMagic,
+                                coverage_track::kMagicSize);
+  if (data != magic) {
+    return tf::errors::DataLoss("Not a coverage track: ", path);
+  }
+  const uint64 footer_offset = file_size - coverage_track::kFooterSize;
+  TF_RETURN_IF_ERROR(ReadExactly(*file, footer_offset,
+                                 coverage_track::kFooterSize, kFileKind,
+                                 &scratch, &data));
+  const uint64 index_offset = tf::core::DecodeFixed64(data.data());
+  if (data.substr(8) != magic) {
+    return tf::errors::DataLoss("Coverage track is truncated: ", path);
+  }
+  if (index_offset < coverage_track::kMagicSize ||
+      index_offset > footer_offset) {
+    return tf::errors::DataLoss("Corrupt coverage track footer: ", path);
+  }
+  TF_RETURN_IF_ERROR(ReadExactly(*file, index_offset,
+                                 footer_offset - index_offset, kFileKind,
+                                 &scratch, &data));
+  coverage_track::Index index;
+  TF_RETURN_IF_ERROR(coverage_track::DecodeIndex(data, index_offset, &index));
+  return absl::WrapUnique(
+      new CoverageTrackReader(std::move(file), std::move(index)));
+}
+
+CoverageTrackReader::CoverageTrackReader(
+    std::unique_ptr<tf::RandomAccessFile> file, coverage_track::Index index)
+    : file_(std::move(file)), index_(std::move(index)) {
+  for (size_t i = 0; i < index_.contigs.size(); ++i) {
+    contig_ids_.emplace(index_.contigs[i], static_cast<int>(i));
+  }
+}
+
+CoverageTrackReader::~CoverageTrackReader() {
+  if (!file_) {
+    return;
+  }
+  tf::Status status = Close();
+  if (!status.ok()) {
+    LOG(WARNING) << "Closing CoverageTrackReader encountered an error";
+  }
+}
+
+tf::Status CoverageTrackReader::Close() {
+  if (!file_) {
+    return tf::errors::FailedPrecondition("CoverageTrackReader already closed");
+  }
+  file_ = nullptr;
+  return tf::Status::OK();
+}
+
+StatusOr<std::shared_ptr<BedGraphIterable>> CoverageTrackReader::Iterate()
+    const {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot iterate a closed CoverageTrackReader");
+  }
+  return StatusOr<std::shared_ptr<BedGraphIterable>>(
+      MakeIterable<CoverageTrackIterable>(
+          this, 0, static_cast<int>(index_.blocks.size()),
+          std::numeric_limits<int64>::min(),
+          std::numeric_limits<int64>::max()));
+}
+
+StatusOr<std::shared_ptr<BedGraphIterable>> CoverageTrackReader::Query(
+    const Range& region) const {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot query a closed CoverageTrackReader");
+  }
+  std::pair<int, int> blocks(0, 0);
+  const int contig = FindContig(region.reference_name());
+  if (contig >= 0) {
+    blocks = FindBlocks(contig, region.start(), region.end());
+  }
+  return StatusOr<std::shared_ptr<BedGraphIterable>>(
+      MakeIterable<CoverageTrackIterable>(this, blocks.first, blocks.second,
+                                          region.start(), region.end()));
+}
+
+tf::Status CoverageTrackReader::Summarize(
+    const Range& region, int num_bins,
+    std::vector<CoverageSummary>* summaries) const {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot summarize a closed CoverageTrackReader");
+  }
+  const int64 start = region.start();
+  const int64 width = region.end() - start;
+  if (num_bins <= 0 || width < num_bins) {
+    return tf::errors::InvalidArgument(
+        "Cannot divide a region of ", width, " bases into ", num_bins,
+        " bins");
+  }
+
+  // Bin i covers [bounds[i], bounds[i + 1]); the first width % num_bins bins
+  // are one base wider than the others.
+  const int64 bin_width = width / num_bins;
+  const int64 remainder = width % num_bins;
+  std::vector<int64> bounds(num_bins + 1);
+  for (int i = 0; i <= num_bins; ++i) {
+    bounds[i] = start + i * bin_width + std::min<int64>(i, remainder);
+  }
+  std::vector<coverage_track::Summary> bins(num_bins);
+
+  // Calls add(bin, overlap) for each bin overlapping [s, e).
+  const auto for_each_bin = [&bounds, num_bins](int64 s, int64 e,
+                                                const auto& add) {
+    int bin = static_cast<int>(
+        std::upper_bound(bounds.begin(), bounds.end(), s) - bounds.begin() - 1);
+    for (bin = std::max(bin, 0); bin < num_bins && bounds[bin] < e; ++bin) {
+      const int64 overlap =
+          std::min(e, bounds[bin + 1]) - std::max(s, bounds[bin]);
+      if (overlap > 0) add(bin, overlap);
+    }
+  };
+
+  const int contig = FindContig(region.reference_name());
+  const coverage_track::ZoomLevel* zoom = nullptr;
+  for (const coverage_track::ZoomLevel& level : index_.zoom_levels) {
+    if (2 * level.bin_size <= bin_width) zoom = &level;
+  }
+  if (contig < 0) {
+    // The reference has no records.
+  } else if (zoom != nullptr) {
+    auto it = std::partition_point(
+        zoom->bins.begin(), zoom->bins.end(),
+        [contig, start](const coverage_track::ZoomBin& bin) {
+          return bin.contig < contig ||
+                 (bin.contig == contig && bin.end <= start);
+        });
+    for (; it != zoom->bins.end() && it->contig == contig &&
+           it->start < region.end();
+         ++it) {
+      const coverage_track::ZoomBin& zoom_bin = *it;
+      for_each_bin(zoom_bin.start, zoom_bin.end,
+                   [&bins, &zoom_bin, zoom](int bin, int64 overlap) {
+                     bins[bin].Merge(zoom_bin.summary,
+                                     static_cast<double>(overlap) /
+                                         zoom->bin_size);
+                   });
+    }
+  } else {
+    const std::pair<int, int> blocks =
+        FindBlocks(contig, start, region.end());
+    std::vector<coverage_track::Interval> intervals;
+    string scratch;
+    for (int block = blocks.first; block < blocks.second; ++block) {
+      TF_RETURN_IF_ERROR(ReadBlock(block, &intervals, &scratch));
+      for (const coverage_track::Interval& interval : intervals) {
+        for_each_bin(interval.start, interval.end,
+                     [&bins, &interval](int bin, int64 overlap) {
+                       bins[bin].Add(interval.value, overlap);
+                     });
+      }
+    }
+  }
+
+  summaries->clear();
+  summaries->reserve(num_bins);
+  for (int i = 0; i < num_bins; ++i) {
+    CoverageSummary summary;
+    summary.mutable_range()->set_reference_name(region.reference_name());
+    summary.mutable_range()->set_start(bounds[i]);
+    summary.mutable_range()->set_end(bounds[i + 1]);
+    summary.set_bases_covered(bins[i].bases_covered);
+    summary.set_min_value(bins[i].min_value);
+    summary.set_max_value(bins[i].max_value);
+    summary.set_sum(bins[i].sum);
+    summary.set_sum_squares(bins[i].sum_squares);
+    summaries->push_back(std::move(summary));
+  }
+  return tf::Status::OK();
+}
+
+int CoverageTrackReader::FindContig(absl::string_view reference_name) const {
+  auto it = contig_ids_.find(reference_name);
+  return it == contig_ids_.end() ? -1 : it->second;
+}
+
+std::pair<int, int> CoverageTrackReader::FindBlocks(int contig, int64 start,
+                                                    int64 end) const {
+  // Blocks are sorted by contig and do not overlap within a contig, so both
+  // their starts and their ends increase.
+  const auto first = std::partition_point(
+      index_.blocks.begin(), index_.blocks.end(),
+      [contig, start](const coverage_track::Block& block) {
+        return block.contig < contig ||
+               (block.contig == contig && block.end <= start);
+      });
+  const auto last = std::partition_point(
+      first, index_.blocks.end(),
+      [contig, end](const coverage_track::Block& block) {
+        return block.contig == contig && block.start < end;
+      });
+  return {static_cast<int>(first - index_.blocks.begin()),
+          static_cast<int>(last - index_.blocks.begin())};
+}
+
+tf::Status CoverageTrackReader::ReadBlock(
+    int block, std::vector<coverage_track::Interval>* intervals,
+    string* scratch) const {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot read from a closed CoverageTrackReader");
+  }
+  const coverage_track::Block& info = index_.blocks[block];
+  absl::string_view data;
+  TF_RETURN_IF_ERROR(
+      ReadExactly(*file_, info.offset, info.size, kFileKind, scratch, &data));
+  return coverage_track::DecodeBlock(data, info, intervals);
+}
+
+// Iterable class definitions.
+StatusOr<bool> CoverageTrackIterable::Next(BedGraphRecord* out) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  const CoverageTrackReader* track =
+      static_cast<const CoverageTrackReader*>(reader_);
+  while (true) {
+    while (next_interval_ < intervals_.size()) {
+      const coverage_track::Interval& interval = intervals_[next_interval_++];
+      if (interval.end <= start_) continue;
+      if (interval.start >= end_) {
+        next_block_ = end_block_;
+        intervals_.clear();
+        return false;
+      }
+      out->Clear();
+      out->set_reference_name(track->index_.contigs[contig_]);
+      out->set_start(interval.start);
+      out->set_end(interval.end);
+      out->set_data_value(interval.value);
+      return true;
+    }
+    if (next_block_ >= end_block_) {
+      return false;
+    }
+    contig_ = track->index_.blocks[next_block_].contig;
+    next_interval_ = 0;
+    TF_RETURN_IF_ERROR(track->ReadBlock(next_block_++, &intervals_, &scratch_));
+  }
+}
+
+CoverageTrackIterable::~CoverageTrackIterable() {}
+
+CoverageTrackIterable::CoverageTrackIterable(const CoverageTrackReader* reader,
+                                             int first_block, int end_block,
+                                             int64 start, int64 end)
+    : Iterable(reader),
+      next_block_(first_block),
+      end_block_(end_block),
+      start_(start),
+      end_(end) {}
+
+}  // namespace nucleus
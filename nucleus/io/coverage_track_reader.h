@@ -0,0 +1,117 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_READER_H_
+#define THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_READER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "nucleus/io/bedgraph_reader.h"
+#include "nucleus/io/coverage_track_format.h"
+#include "nucleus/io/reader_base.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/bedgraph.pb.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace nucleus {
+
+// A reader of the binary coverage tracks written by CoverageTrackWriter.
+//
+// Opening a track reads only its index. Query then reads just the blocks
+// overlapping the requested region, and Summarize answers most requests from
+// the precomputed zoom levels without reading any records.
+class CoverageTrackReader : public Reader {
+ public:
+  // Opens the coverage track at |path| and loads its index.
+  //
+  // Returns a StatusOr that is OK if the CoverageTrackReader could be
+  // successfully created or an error code indicating the error that occurred.
+  static StatusOr<std::unique_ptr<CoverageTrackReader>> FromFile(
+      const string& path);
+
+  ~CoverageTrackReader();
+
+  // Disable copy and assignment operations.
+  CoverageTrackReader(const CoverageTrackReader& other) = delete;
+  CoverageTrackReader& operator=(const CoverageTrackReader&) = delete;
+
+  // Gets all of the records in the track, in the order they were written.
+  StatusOr<std::shared_ptr<BedGraphIterable>> Iterate() const;
+
+  // Gets all of the records that overlap any bases in region. A reference that
+  // is not in the track has no records.
+  StatusOr<std::shared_ptr<BedGraphIterable>> Query(
+      const nucleus::genomics::v1::Range& region) const;
+
+  // Divides region into num_bins bins of (nearly) equal width and replaces
+  // *summaries with the summary of the values in each.
+  //
+  // If a zoom level has bins no more than half as wide as the requested ones,
+  // the coarsest such level is used; its bins straddling a boundary are split
+  // in proportion to their overlap with each side, so that the counts and
+  // sums are estimates there. Otherwise the summaries are computed exactly
+  // from the records.
+  tensorflow::Status Summarize(
+      const nucleus::genomics::v1::Range& region, int num_bins,
+      std::vector<nucleus::genomics::v1::CoverageSummary>* summaries) const;
+
+  // The reference names in the track, in the order they were written.
+  const std::vector<string>& ReferenceNames() const { return index_.contigs; }
+
+  // Closes the underlying file. Returns a Status to indicate if everything went
+  // OK with the close.
+  tensorflow::Status Close();
+
+  // This no-op function is needed only for Python context manager support.
+  void PythonEnter() const {}
+
+ private:
+  // Private constructor. Use FromFile to safely create a CoverageTrackReader.
+  CoverageTrackReader(std::unique_ptr<tensorflow::RandomAccessFile> file,
+                      coverage_track::Index index);
+
+  // Returns the index of the reference named reference_name, or -1.
+  int FindContig(absl::string_view reference_name) const;
+
+  // Returns the half-open range of blocks holding intervals of contig that
+  // overlap [start, end).
+  std::pair<int, int> FindBlocks(int contig, int64 start, int64 end) const;
+
+  // Reads and decodes the intervals of the given block.
+  tensorflow::Status ReadBlock(int block,
+                               std::vector<coverage_track::Interval>* intervals,
+                               string* scratch) const;
+
+  std::unique_ptr<tensorflow::RandomAccessFile> file_;
+  coverage_track::Index index_;
+  std::map<string, int, std::less<>> contig_ids_;
+
+  // Allow the iterable to read blocks.
+  friend class CoverageTrackIterable;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_READER_H_
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Tests of CoverageTrackWriter and CoverageTrackReader.
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/io/coverage_track_reader.h"
+#include "nucleus/io/coverage_track_writer.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::CoverageSummary;
+using genomics::v1::CoverageTrackWriterOptions;
+using ::testing::DoubleEq;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::Pointwise;
+using ::testing::SizeIs;
+
+namespace {
+
+BedGraphRecord MakeTestRecord(const string& name, int64 start, int64 end,
+                              double data_value) {
+  BedGraphRecord r;
+  r.set_reference_name(name);
+  r.set_start(start);
+  r.set_end(end);
+  r.set_data_value(data_value);
+  return r;
+}
+
+// Writes records to a new track in the temporary directory.
+string WriteTrack(const string& filename,
+                  const std::vector<BedGraphRecord>& records,
+                  const CoverageTrackWriterOptions& options) {
+  const string path = MakeTempFile(filename);
+  std::unique_ptr<CoverageTrackWriter> writer =
+      std::move(CoverageTrackWriter::ToFile(path, options).ValueOrDie());
+  for (const BedGraphRecord& record : records) {
+    TF_CHECK_OK(writer->Write(record));
+  }
+  TF_CHECK_OK(writer->Close());
+  return path;
+}
+
+// Records on two contigs with integer, float and double values, split into
+// blocks of two records.
+std::vector<BedGraphRecord> TestRecords() {
+  return {MakeTestRecord("chr1", 10, 20, 3),
+          MakeTestRecord("chr1", 20, 25, -4),
+          MakeTestRecord("chr1", 40, 100, 0.5),
+          MakeTestRecord("chr1", 100, 110, 250.25),
+          MakeTestRecord("chr1", 150, 160, 100.1),
+          MakeTestRecord("chr2", 0, 1000, 30)};
+}
+
+CoverageTrackWriterOptions TestOptions() {
+  CoverageTrackWriterOptions options;
+  options.set_records_per_block(2);
+  options.add_zoom_bin_sizes(10);
+  options.add_zoom_bin_sizes(100);
+  return options;
+}
+
+}  // namespace
+
+TEST(CoverageTrackTest, RoundTripsRecords) {
+  const std::vector<BedGraphRecord> records = TestRecords();
+  const string path = WriteTrack("roundtrip.cov", records, TestOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  EXPECT_THAT(reader->ReferenceNames(), ElementsAre("chr1", "chr2"));
+  EXPECT_THAT(as_vector(reader->Iterate()),
+              Pointwise(EqualsProto(), records));
+}
+
+TEST(CoverageTrackTest, RoundTripsWithDefaultOptions) {
+  const std::vector<BedGraphRecord> records = TestRecords();
+  const string path = WriteTrack("default.cov", records,
+                                 CoverageTrackWriterOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  EXPECT_THAT(as_vector(reader->Iterate()),
+              Pointwise(EqualsProto(), records));
+}
+
+TEST(CoverageTrackTest, QueriesRegions) {
+  const std::vector<BedGraphRecord> records = TestRecords();
+  const string path = WriteTrack("query.cov", records, TestOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr1", 22, 45))),
+              ElementsAre(EqualsProto(records[1]), EqualsProto(records[2])));
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr1", 105, 151))),
+              ElementsAre(EqualsProto(records[3]), EqualsProto(records[4])));
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr1", 25, 40))), IsEmpty());
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr1", 160, 1000))),
+              IsEmpty());
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr2", 999, 2000))),
+              ElementsAre(EqualsProto(records[5])));
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr3", 0, 100))), IsEmpty());
+}
+
+TEST(CoverageTrackTest, SummarizesFromRecords) {
+  const string path = WriteTrack("summary.cov", TestRecords(), TestOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  // Bins of 15 bases are too narrow for the 10 base zoom level.
+  std::vector<CoverageSummary> summaries;
+  ASSERT_THAT(reader->Summarize(MakeRange("chr1", 0, 30), 2, &summaries),
+              IsOK());
+  EXPECT_THAT(summaries, ElementsAre(EqualsProto(R"(
+    range { reference_name: "chr1" start: 0 end: 15 }
+    bases_covered: 5 min_value: 3 max_value: 3 sum: 15 sum_squares: 45
+  )"), EqualsProto(R"(
+    range { reference_name: "chr1" start: 15 end: 30 }
+    bases_covered: 10 min_value: -4 max_value: 3 sum: -5 sum_squares: 125
+  )")));
+}
+
+TEST(CoverageTrackTest, SummarizesFromZoomLevels) {
+  const string path = WriteTrack("zoom.cov", TestRecords(), TestOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  // Bins of 200 bases are answered from the 100 base zoom level, whose bins
+  // line up with them.
+  std::vector<CoverageSummary> summaries;
+  ASSERT_THAT(reader->Summarize(MakeRange("chr2", 0, 1000), 5, &summaries),
+              IsOK());
+  ASSERT_THAT(summaries, SizeIs(5));
+  for (const CoverageSummary& summary : summaries) {
+    EXPECT_THAT(summary.bases_covered(), Eq(200));
+    EXPECT_THAT(summary.min_value(), Eq(30));
+    EXPECT_THAT(summary.max_value(), Eq(30));
+    EXPECT_THAT(summary.sum(), DoubleEq(6000));
+  }
+
+  // A bin ending halfway through the zoom bin [100, 110) gets half of it.
+  ASSERT_THAT(reader->Summarize(MakeRange("chr1", 0, 105), 1, &summaries),
+              IsOK());
+  ASSERT_THAT(summaries, SizeIs(1));
+  EXPECT_THAT(summaries[0].bases_covered(), Eq(80));
+  EXPECT_THAT(summaries[0].min_value(), Eq(-4));
+  EXPECT_THAT(summaries[0].max_value(), Eq(250.25));
+  EXPECT_THAT(summaries[0].sum(), DoubleEq(30 - 20 + 30 + 1251.25));
+}
+
+TEST(CoverageTrackTest, SummarizesUnknownReferenceAsEmpty) {
+  const string path = WriteTrack("unknown.cov", TestRecords(), TestOptions());
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(path).ValueOrDie());
+  std::vector<CoverageSummary> summaries;
+  ASSERT_THAT(reader->Summarize(MakeRange("chrX", 0, 100), 4, &summaries),
+              IsOK());
+  ASSERT_THAT(summaries, SizeIs(4));
+  EXPECT_THAT(summaries[3], EqualsProto(R"(
+    range { reference_name: "chrX" start: 75 end: 100 }
+  )"));
+  EXPECT_THAT(reader->Summarize(MakeRange("chr1", 0, 3), 4, &summaries),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+}
+
+TEST(CoverageTrackTest, RejectsOutOfOrderRecords) {
+  const string path = MakeTempFile("unsorted.cov");
+  std::unique_ptr<CoverageTrackWriter> writer =
+      std::move(CoverageTrackWriter::ToFile(path).ValueOrDie());
+  ASSERT_THAT(writer->Write(MakeTestRecord("chr1", 10, 20, 1)), IsOK());
+  EXPECT_THAT(writer->Write(MakeTestRecord("chr1", 15, 30, 1)),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+  EXPECT_THAT(writer->Write(MakeTestRecord("chr1", 30, 30, 1)),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+  ASSERT_THAT(writer->Write(MakeTestRecord("chr2", 0, 5, 1)), IsOK());
+  EXPECT_THAT(writer->Write(MakeTestRecord("chr1", 50, 60, 1)),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+  ASSERT_THAT(writer->Close(), IsOK());
+}
+
+TEST(CoverageTrackTest, RejectsCorruptFiles) {
+  const string path = WriteTrack("corrupt.cov", TestRecords(), TestOptions());
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(), path,
+                                           &contents));
+  const string truncated_path = MakeTempFile("truncated.cov");
+  TF_CHECK_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), truncated_path,
+      contents.substr(0, contents.size() - 1)));
+  EXPECT_THAT(CoverageTrackReader::FromFile(truncated_path).status(),
+              IsNotOKWithCode(tensorflow::error::DATA_LOSS));
+
+  // Damage the length of the first interval so that it overruns its block.
+  const string damaged_path = MakeTempFile("damaged.cov");
+  contents[coverage_track::kMagicSize + 2] = 0x7f;
+  TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                            damaged_path, contents));
+  std::unique_ptr<CoverageTrackReader> reader =
+      std::move(CoverageTrackReader::FromFile(damaged_path).ValueOrDie());
+  auto iterable = reader->Iterate().ValueOrDie();
+  BedGraphRecord record;
+  EXPECT_THAT(iterable->Next(&record).status(),
+              IsNotOKWithCode(tensorflow::error::DATA_LOSS));
+}
+
+}  // namespace nucleus
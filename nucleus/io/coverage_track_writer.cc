@@ -0,0 +1,199 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of coverage_track_writer.h
+#include "nucleus/io/coverage_track_writer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::CoverageTrackWriterOptions;
+
+namespace {
+
+constexpr int kDefaultRecordsPerBlock = 512;
+constexpr int64 kDefaultZoomBinSizes[] = {10000, 100000, 1000000};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<CoverageTrackWriter>> CoverageTrackWriter::ToFile(
+    const string& path, const CoverageTrackWriterOptions& options) {
+  if (options.records_per_block() < 0) {
+    return tf::errors::InvalidArgument("records_per_block must be positive");
+  }
+  for (int i = 0; i < options.zoom_bin_sizes_size(); ++i) {
+    if (options.zoom_bin_sizes(i) <= 0 ||
+        (i > 0 && options.zoom_bin_sizes(i) <= options.zoom_bin_sizes(i - 1))) {
+      return tf::errors::InvalidArgument(
+          "zoom_bin_sizes must be positive and increasing");
+    }
+  }
+  std::unique_ptr<tf::WritableFile> file;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->NewWritableFile(path, &file));
+  auto writer =
+      absl::WrapUnique(new CoverageTrackWriter(std::move(file), options));
+  TF_RETURN_IF_ERROR(writer->file_->Append(
+      absl::string_view(coverage_track::kMagic, coverage_track::kMagicSize)));
+  writer->offset_ = coverage_track::kMagicSize;
+  return std::move(writer);
+}
+
+CoverageTrackWriter::CoverageTrackWriter(
+    std::unique_ptr<tf::WritableFile> file,
+    const CoverageTrackWriterOptions& options)
+    : file_(std::move(file)),
+      records_per_block_(options.records_per_block() > 0
+                             ? options.records_per_block()
+                             : kDefaultRecordsPerBlock) {
+  if (options.zoom_bin_sizes().empty()) {
+    for (int64 bin_size : kDefaultZoomBinSizes) {
+      index_.zoom_levels.push_back({bin_size, {}});
+    }
+  } else {
+    for (int64 bin_size : options.zoom_bin_sizes()) {
+      index_.zoom_levels.push_back({bin_size, {}});
+    }
+  }
+  coverage_track::ZoomBin closed;
+  closed.contig = -1;
+  closed.start = closed.end = 0;
+  open_bins_.assign(index_.zoom_levels.size(), closed);
+  pending_.reserve(records_per_block_);
+}
+
+CoverageTrackWriter::~CoverageTrackWriter() {
+  if (!file_) {
+    return;
+  }
+  tf::Status status = Close();
+  if (!status.ok()) {
+    LOG(WARNING) << "Closing CoverageTrackWriter encountered an error: "
+                 << status;
+  }
+}
+
+tf::Status CoverageTrackWriter::Write(const BedGraphRecord& record) {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot write to closed coverage track.");
+  }
+  if (record.start() < 0 || record.end() <= record.start()) {
+    return tf::errors::InvalidArgument("Invalid coverage track record range ",
+                                       record.reference_name(), ":",
+                                       record.start(), "-", record.end());
+  }
+  if (contig_ < 0 || record.reference_name() != index_.contigs[contig_]) {
+    if (contig_ids_.count(record.reference_name())) {
+      return tf::errors::InvalidArgument(
+          "Coverage track records must be grouped by reference_name; saw ",
+          record.reference_name(), " again after other references");
+    }
+    TF_RETURN_IF_ERROR(FlushBlock());
+    contig_ = static_cast<int32>(index_.contigs.size());
+    index_.contigs.push_back(record.reference_name());
+    contig_ids_[record.reference_name()] = contig_;
+    end_ = 0;
+  } else if (record.start() < end_) {
+    return tf::errors::InvalidArgument(
+        "Coverage track records must be sorted and non-overlapping; ",
+        record.reference_name(), ":", record.start(), "-", record.end(),
+        " starts before the end of the previous record, ", end_);
+  }
+  pending_.push_back({record.start(), record.end(), record.data_value()});
+  AddToZoomLevels(record.start(), record.end(), record.data_value());
+  end_ = record.end();
+  if (static_cast<int>(pending_.size()) >= records_per_block_) {
+    return FlushBlock();
+  }
+  return tf::Status::OK();
+}
+
+tf::Status CoverageTrackWriter::FlushBlock() {
+  if (pending_.empty()) {
+    return tf::Status::OK();
+  }
+  buffer_.clear();
+  coverage_track::EncodeBlock(pending_, pending_.front().start, &buffer_);
+  coverage_track::Block block;
+  block.contig = contig_;
+  block.start = pending_.front().start;
+  block.end = pending_.back().end;
+  block.offset = offset_;
+  block.size = static_cast<uint32>(buffer_.size());
+  block.num_intervals = static_cast<uint32>(pending_.size());
+  index_.blocks.push_back(block);
+  pending_.clear();
+  offset_ += buffer_.size();
+  return file_->Append(buffer_);
+}
+
+void CoverageTrackWriter::AddToZoomLevels(int64 start, int64 end,
+                                          double value) {
+  for (size_t i = 0; i < index_.zoom_levels.size(); ++i) {
+    coverage_track::ZoomLevel& level = index_.zoom_levels[i];
+    coverage_track::ZoomBin& bin = open_bins_[i];
+    for (int64 bin_start = start - start % level.bin_size; bin_start < end;
+         bin_start += level.bin_size) {
+      if (bin.contig != contig_ || bin.start != bin_start) {
+        if (bin.contig >= 0) level.bins.push_back(bin);
+        bin.contig = contig_;
+        bin.start = bin_start;
+        bin.end = bin_start + level.bin_size;
+        bin.summary = coverage_track::Summary();
+      }
+      bin.summary.Add(value,
+                      std::min(end, bin.end) - std::max(start, bin.start));
+    }
+  }
+}
+
+tf::Status CoverageTrackWriter::Close() {
+  if (!file_) {
+    return tf::errors::FailedPrecondition(
+        "Cannot close an already closed CoverageTrackWriter");
+  }
+  tf::Status status = FlushBlock();
+  for (size_t i = 0; i < open_bins_.size(); ++i) {
+    if (open_bins_[i].contig >= 0) {
+      index_.zoom_levels[i].bins.push_back(open_bins_[i]);
+    }
+  }
+  if (status.ok()) {
+    buffer_.clear();
+    coverage_track::EncodeIndex(index_, &buffer_);
+    tf::core::PutFixed64(&buffer_, offset_);
+    buffer_.append(coverage_track::kMagic, coverage_track::kMagicSize);
+    status = file_->Append(buffer_);
+  }
+  tf::Status close_status = file_->Close();
+  file_ = nullptr;
+  index_ = coverage_track::Index();
+  return status.ok() ? close_status : status;
+}
+
+}  // namespace nucleus
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_WRITER_H_
+#define THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_WRITER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nucleus/io/coverage_track_format.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/bedgraph.pb.h"
+#include "nucleus/util/proto_ptr.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace nucleus {
+
+// A writer of binary coverage tracks.
+//
+// A coverage track stores the same data as a BedGraph file in a compact binary
+// form with a block index, so that CoverageTrackReader can fetch the records
+// of a region without reading the rest of the file, and with precomputed
+// summaries at several zoom levels, so that it can summarize large regions
+// without reading their records at all. See coverage_track_format.h for the
+// layout.
+//
+// Records must be written grouped by reference_name and, within a reference,
+// sorted by start and non-overlapping.
+class CoverageTrackWriter {
+ public:
+  // Creates a new CoverageTrackWriter writing to the file at |path|, which is
+  // opened and created if needed. Returns either a unique_ptr to the
+  // CoverageTrackWriter or a Status indicating why an error occurred.
+  static StatusOr<std::unique_ptr<CoverageTrackWriter>> ToFile(
+      const string& path,
+      const nucleus::genomics::v1::CoverageTrackWriterOptions& options =
+          nucleus::genomics::v1::CoverageTrackWriterOptions());
+
+  ~CoverageTrackWriter();
+
+  // Disables copy and assignment operations.
+  CoverageTrackWriter(const CoverageTrackWriter& other) = delete;
+  CoverageTrackWriter& operator=(const CoverageTrackWriter&) = delete;
+
+  // Writes a BedGraphRecord to the track. Returns an InvalidArgument error if
+  // the record is empty or out of order.
+  tensorflow::Status Write(const nucleus::genomics::v1::BedGraphRecord& record);
+  tensorflow::Status WritePython(
+      const ConstProtoPtr<const nucleus::genomics::v1::BedGraphRecord>&
+      wrapped) {
+    return Write(*(wrapped.p_));
+  }
+
+  // Writes the remaining records, the index and the zoom levels, then closes
+  // the file. The track is not readable until it has been closed.
+  tensorflow::Status Close();
+
+  // This no-op function is needed only for Python context manager support. Do
+  // not use it.
+  void PythonEnter() const {}
+
+ private:
+  // Private constructor. Use ToFile to safely create a CoverageTrackWriter.
+  CoverageTrackWriter(
+      std::unique_ptr<tensorflow::WritableFile> file,
+      const nucleus::genomics::v1::CoverageTrackWriterOptions& options);
+
+  // Writes the pending intervals as a data block.
+  tensorflow::Status FlushBlock();
+
+  // Adds value over [start, end) of the current contig to every zoom level.
+  void AddToZoomLevels(int64 start, int64 end, double value);
+
+  std::unique_ptr<tensorflow::WritableFile> file_;
+  // The number of bytes written to file_.
+  uint64 offset_ = 0;
+  int records_per_block_;
+
+  // The index written when the track is closed.
+  coverage_track::Index index_;
+  std::map<string, int32> contig_ids_;
+
+  // The contig and end of the last record written.
+  int32 contig_ = -1;
+  int64 end_ = 0;
+
+  // Intervals of contig_ not yet written to a block.
+  std::vector<coverage_track::Interval> pending_;
+  // The bin of each zoom level that records are being added to.
+  std::vector<coverage_track::ZoomBin> open_bins_;
+
+  // Reused buffer for block encoding.
+  string buffer_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_COVERAGE_TRACK_WRITER_H_
@@ -93,6 +93,14 @@ class NativeFastqReader(genomics_reader.GenomicsReader):
     """Returns an iterable of FastqRecord protos in the file."""
     return self._reader.iterate()
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -129,6 +137,10 @@ class NativeFastqWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -16,6 +16,7 @@
 
 // Implementation of fastq_reader.h
 #include "nucleus/io/fastq_reader.h"
+#include "nucleus/io/io_stats.h"
 
 #include <stddef.h>
 #include <utility>
@@ -102,7 +103,9 @@ StatusOr<std::unique_ptr<FastqReader>> FastqReader::FromFile(
 
 FastqReader::FastqReader(std::unique_ptr<TextReader> text_reader,
                          const FastqReaderOptions& options)
-    : options_(options), text_reader_(std::move(text_reader)) {}
+    : options_(options), text_reader_(std::move(text_reader)) {
+  text_reader_->set_io_stats(io_stats());
+}
 
 FastqReader::~FastqReader() {
   if (text_reader_) {
@@ -173,7 +176,13 @@ StatusOr<bool> FastqFullFileIterable::Next(FastqRecord* out) {
       return status;
     }
   }
-  TF_RETURN_IF_ERROR(ConvertToPb(header, sequence, pad, quality, out));
+  IoStats* stats = IoStatsEnabled() ? fastq_reader->io_stats() : nullptr;
+  if (stats != nullptr) stats->AddRecordDecoded();
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(ConvertToPb(header, sequence, pad, quality, out));
+  }
+  if (stats != nullptr) stats->AddRecordKept();
   return true;
 }
 
@@ -20,7 +20,6 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
-#include "absl/strings/str_cat.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/fastq.pb.h"
 #include "nucleus/util/utils.h"
@@ -55,6 +54,7 @@ FastqWriter::FastqWriter(
     std::unique_ptr<TextWriter> text_writer,
     const nucleus::genomics::v1::FastqWriterOptions& options)
     : options_(options), text_writer_(std::move(text_writer)) {
+  text_writer_->set_io_stats(&io_stats_);
 }
 
 FastqWriter::~FastqWriter() {
@@ -67,6 +67,9 @@ tf::Status FastqWriter::Close() {
   if (!text_writer_)
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed FastqWriter");
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "FastqWriter statistics: " << io_stats_.ToJson();
+  }
   // Close the file pointer we have been writing to.
   tf::Status close_status = text_writer_->Close();
   text_writer_ = nullptr;
@@ -78,16 +81,21 @@ tf::Status FastqWriter::Write(
   if (!text_writer_)
     return tf::errors::FailedPrecondition(
         "Cannot write to closed FASTQ stream.");
-  string out = "@";
-  absl::StrAppend(&out, record.id());
-  if (!record.description().empty()) {
-    absl::StrAppend(&out, " ", record.description());
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    text_writer_->Append("@", record.id());
+    if (!record.description().empty()) {
+      text_writer_->Append(" ", record.description());
+    }
+    text_writer_->Append("\n", record.sequence(), "\n+\n", record.quality(),
+                         "\n");
   }
-  absl::StrAppend(&out, "\n", record.sequence(), "\n+\n", record.quality(),
-                  "\n");
-  TF_RETURN_IF_ERROR(text_writer_->Write(out));
-
-  return tf::Status::OK();
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
+  return text_writer_->MaybeFlush();
 }
 
 }  // namespace nucleus
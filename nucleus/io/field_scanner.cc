@@ -0,0 +1,197 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of field_scanner.h
+#include "nucleus/io/field_scanner.h"
+
+#include <string.h>
+
+#include <limits>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace nucleus {
+
+namespace {
+
+// Width, in bytes, of one SIMD comparison.
+constexpr int kChunkSize = 16;
+
+// Exact powers of ten representable as doubles, used by the ParseDouble fast
+// path. 1e15 is the largest we need since we only take the fast path when the
+// number has at most kMaxFastPathDigits digits.
+constexpr double kExactPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                        1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15};
+
+// Any integer with at most 15 decimal digits is exactly representable as a
+// double, so m / 10^k is a single correctly rounded IEEE division.
+constexpr int kMaxFastPathDigits = 15;
+
+#ifdef __SSE2__
+// Returns a bitmask with bit i set iff p[i] == delim, for i in [0, 16).
+inline uint32 DelimiterMask(const char* p, __m128i needle) {
+  const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+}
+#endif
+
+}  // namespace
+
+const char* FindDelimiter(const char* begin, const char* end, char delim) {
+  const char* p = begin;
+#ifdef __SSE2__
+  const __m128i needle = _mm_set1_epi8(delim);
+  for (; end - p >= kChunkSize; p += kChunkSize) {
+    const uint32 mask = DelimiterMask(p, needle);
+    if (mask != 0) return p + __builtin_ctz(mask);
+  }
+#endif
+  const void* found = memchr(p, delim, end - p);
+  return found == nullptr ? end : static_cast<const char*>(found);
+}
+
+int SplitFields(absl::string_view line, char delim,
+                absl::Span<absl::string_view> fields) {
+  const char* const end = line.data() + line.size();
+  const int capacity = static_cast<int>(fields.size());
+  const char* field_start = line.data();
+  int n_fields = 0;
+
+  // Records the field ending at field_end, which is either a delimiter or the
+  // end of the line.
+  auto emit = [&](const char* field_end) {
+    if (n_fields < capacity) {
+      fields[n_fields] = absl::string_view(field_start, field_end - field_start);
+    }
+    ++n_fields;
+    field_start = field_end + 1;
+  };
+
+  const char* p = line.data();
+#ifdef __SSE2__
+  // Visit every delimiter in each 16-byte chunk through its bitmask, so a
+  // line with many short fields costs one comparison per chunk rather than
+  // one search per field.
+  const __m128i needle = _mm_set1_epi8(delim);
+  for (; end - p >= kChunkSize; p += kChunkSize) {
+    for (uint32 mask = DelimiterMask(p, needle); mask != 0; mask &= mask - 1) {
+      emit(p + __builtin_ctz(mask));
+    }
+  }
+#endif
+  for (; p < end; ++p) {
+    if (*p == delim) emit(p);
+  }
+  emit(end);
+  return n_fields;
+}
+
+int CountFields(absl::string_view line, char delim) {
+  return SplitFields(line, delim, absl::Span<absl::string_view>());
+}
+
+bool ParseInt64(absl::string_view text, int64* value) {
+  text = absl::StripAsciiWhitespace(text);
+  const char* p = text.data();
+  const char* const end = p + text.size();
+  if (p == end) return false;
+
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    if (++p == end) return false;
+  }
+
+  const uint64 limit =
+      static_cast<uint64>(std::numeric_limits<int64>::max()) + negative;
+  uint64 result = 0;
+  for (; p < end; ++p) {
+    const uint32 digit = static_cast<unsigned char>(*p) - '0';
+    if (digit > 9) return false;
+    if (result > (limit - digit) / 10) return false;
+    result = result * 10 + digit;
+  }
+  *value = static_cast<int64>(negative ? 0 - result : result);
+  return true;
+}
+
+bool ParseInt32(absl::string_view text, int32* value) {
+  int64 wide;
+  if (!ParseInt64(text, &wide) || wide < std::numeric_limits<int32>::min() ||
+      wide > std::numeric_limits<int32>::max()) {
+    return false;
+  }
+  *value = static_cast<int32>(wide);
+  return true;
+}
+
+bool ParseDouble(absl::string_view text, double* value) {
+  text = absl::StripAsciiWhitespace(text);
+  const char* p = text.data();
+  const char* const end = p + text.size();
+
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64 mantissa = 0;
+  int n_digits = 0;
+  int n_fraction_digits = 0;
+  bool seen_point = false;
+  for (; p < end; ++p) {
+    const uint32 digit = static_cast<unsigned char>(*p) - '0';
+    if (digit <= 9) {
+      mantissa = mantissa * 10 + digit;
+      ++n_digits;
+      n_fraction_digits += seen_point;
+    } else if (*p == '.' && !seen_point) {
+      seen_point = true;
+    } else {
+      break;
+    }
+  }
+  if (p == end && n_digits > 0 && n_digits <= kMaxFastPathDigits) {
+    const double magnitude = static_cast<double>(mantissa) /
+                             kExactPowersOfTen[n_fraction_digits];
+    *value = negative ? -magnitude : magnitude;
+    return true;
+  }
+  double parsed;
+  if (!absl::SimpleAtod(text, &parsed)) return false;
+  *value = parsed;
+  return true;
+}
+
+bool ParseFloat(absl::string_view text, float* value) {
+  // Rounding to double and then to float can differ from rounding directly to
+  // float, so there is no fast path here.
+  float parsed;
+  if (!absl::SimpleAtof(absl::StripAsciiWhitespace(text), &parsed)) {
+    return false;
+  }
+  *value = parsed;
+  return true;
+}
+
+}  // namespace nucleus
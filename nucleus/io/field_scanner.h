@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Allocation-free helpers for parsing delimited text records.
+//
+// The text formats we read (BED, BedGraph, GFF, ...) are all lines of
+// delimiter-separated fields. The routines here split a line into
+// absl::string_view fields that point into the caller's buffer, and parse
+// numeric fields directly from those views. Nothing here allocates, and
+// nothing here CHECK-fails on malformed input: every parser reports failure
+// through its return value so the readers can surface a proper Status.
+#ifndef THIRD_PARTY_NUCLEUS_IO_FIELD_SCANNER_H_
+#define THIRD_PARTY_NUCLEUS_IO_FIELD_SCANNER_H_
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "nucleus/platform/types.h"
+
+namespace nucleus {
+
+// Returns a pointer to the first occurrence of delim in [begin, end), or end
+// if delim does not occur in the range. Uses SSE2 when available.
+const char* FindDelimiter(const char* begin, const char* end, char delim);
+
+// Splits line on delim, storing the first fields.size() fields into fields.
+//
+// Returns the total number of fields in line, which may be larger than
+// fields.size(); fields beyond the capacity of the span are counted but not
+// stored. As with absl::StrSplit, an empty line has a single empty field and
+// adjacent delimiters produce empty fields. The stored views point into line
+// and are only valid as long as the underlying buffer is.
+int SplitFields(absl::string_view line, char delim,
+                absl::Span<absl::string_view> fields);
+
+// Returns the number of delim-separated fields in line.
+int CountFields(absl::string_view line, char delim);
+
+// Parses a base-10 integer from text into *value.
+//
+// Leading and trailing ASCII whitespace is ignored, and an optional leading
+// '+' or '-' is accepted. Returns false, leaving *value untouched, if text is
+// not a valid integer or does not fit in the result type.
+bool ParseInt64(absl::string_view text, int64* value);
+bool ParseInt32(absl::string_view text, int32* value);
+
+// Parses a floating point number from text into *value.
+//
+// Short decimal numbers (the overwhelmingly common case in genomics text
+// formats) are converted on a fast path that produces the same correctly
+// rounded result as strtod; everything else, including exponents, "inf" and
+// "nan", is delegated to absl::SimpleAtod/SimpleAtof. Returns false, leaving
+// *value untouched, if text is not a valid number.
+bool ParseDouble(absl::string_view text, double* value);
+bool ParseFloat(absl::string_view text, float* value);
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_FIELD_SCANNER_H_
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/field_scanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+
+namespace nucleus {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+
+std::vector<absl::string_view> Split(absl::string_view line, int capacity) {
+  std::vector<absl::string_view> fields(capacity);
+  int n = SplitFields(line, '\t', absl::MakeSpan(fields));
+  fields.resize(std::min(n, capacity));
+  return fields;
+}
+
+TEST(FindDelimiterTest, FindsFirstOccurrence) {
+  // Lengths chosen to exercise the SIMD chunks as well as the scalar tail.
+  for (int length : {0, 1, 15, 16, 17, 31, 32, 33, 100}) {
+    for (int pos = 0; pos <= length; ++pos) {
+      std::string text(length, 'x');
+      if (pos < length) text[pos] = '\t';
+      const char* begin = text.data();
+      const char* end = begin + text.size();
+      EXPECT_THAT(FindDelimiter(begin, end, '\t') - begin, Eq(pos))
+          << "length=" << length << " pos=" << pos;
+    }
+  }
+}
+
+TEST(SplitFieldsTest, MatchesStrSplit) {
+  for (const std::string& line :
+       {std::string(""), std::string("\t"), std::string("a"),
+        std::string("chr1\t10\t20"), std::string("\t\tx\t\t"),
+        std::string("chr1\t10\t20\tfirst\t100\t+\t12\t18\t255,124,1\t3\t2,6,2"
+                    "\t10,12,18"),
+        std::string(70, 'a') + "\t" + std::string(3, 'b') + "\t\t" +
+            std::string(40, 'c')}) {
+    std::vector<absl::string_view> expected = absl::StrSplit(line, '\t');
+    EXPECT_THAT(Split(line, 32), ElementsAreArray(expected)) << line;
+    EXPECT_THAT(CountFields(line, '\t'), Eq(expected.size())) << line;
+  }
+}
+
+TEST(SplitFieldsTest, CountsFieldsBeyondCapacity) {
+  absl::string_view fields[2];
+  EXPECT_THAT(SplitFields("a\tb\tc\td", '\t', absl::MakeSpan(fields)), Eq(4));
+  EXPECT_THAT(fields, ElementsAre("a", "b"));
+}
+
+TEST(SplitFieldsTest, HonorsOtherDelimiters) {
+  std::vector<absl::string_view> fields(4);
+  EXPECT_THAT(SplitFields("ID=1;Name=x", ';', absl::MakeSpan(fields)), Eq(2));
+  EXPECT_THAT(fields[0], Eq("ID=1"));
+  EXPECT_THAT(fields[1], Eq("Name=x"));
+}
+
+TEST(ParseInt64Test, ParsesValidIntegers) {
+  int64 value = 0;
+  EXPECT_TRUE(ParseInt64("0", &value));
+  EXPECT_THAT(value, Eq(0));
+  EXPECT_TRUE(ParseInt64("1234567", &value));
+  EXPECT_THAT(value, Eq(1234567));
+  EXPECT_TRUE(ParseInt64("-42", &value));
+  EXPECT_THAT(value, Eq(-42));
+  EXPECT_TRUE(ParseInt64("+7", &value));
+  EXPECT_THAT(value, Eq(7));
+  EXPECT_TRUE(ParseInt64(" 12\r", &value));
+  EXPECT_THAT(value, Eq(12));
+  EXPECT_TRUE(ParseInt64("9223372036854775807", &value));
+  EXPECT_THAT(value, Eq(std::numeric_limits<int64>::max()));
+  EXPECT_TRUE(ParseInt64("-9223372036854775808", &value));
+  EXPECT_THAT(value, Eq(std::numeric_limits<int64>::min()));
+}
+
+TEST(ParseInt64Test, RejectsInvalidIntegers) {
+  for (absl::string_view bad :
+       {"", "-", "+", "abc", "12a", "1.5", "1 2", "9223372036854775808",
+        "-9223372036854775809", "99999999999999999999"}) {
+    int64 value = 17;
+    EXPECT_FALSE(ParseInt64(bad, &value)) << bad;
+    EXPECT_THAT(value, Eq(17)) << bad;
+  }
+}
+
+TEST(ParseInt32Test, ChecksRange) {
+  int32 value = 0;
+  EXPECT_TRUE(ParseInt32("2147483647", &value));
+  EXPECT_THAT(value, Eq(std::numeric_limits<int32>::max()));
+  EXPECT_TRUE(ParseInt32("-2147483648", &value));
+  EXPECT_THAT(value, Eq(std::numeric_limits<int32>::min()));
+  EXPECT_FALSE(ParseInt32("2147483648", &value));
+  EXPECT_FALSE(ParseInt32("-2147483649", &value));
+}
+
+TEST(ParseDoubleTest, MatchesSimpleAtod) {
+  for (absl::string_view text :
+       {"0", "-0", "100", "150.1", "20.13", "0.1", ".5", "5.", "-3.25",
+        "123456789012345", "0.000000000000001", "1e10", "1.5E-3", "inf",
+        "-inf", "12345678901234567890.5", "2.5"}) {
+    double expected = 0;
+    ASSERT_TRUE(absl::SimpleAtod(text, &expected)) << text;
+    double value = 0;
+    EXPECT_TRUE(ParseDouble(text, &value)) << text;
+    EXPECT_THAT(value, Eq(expected)) << text;
+    EXPECT_THAT(std::signbit(value), Eq(std::signbit(expected))) << text;
+  }
+}
+
+TEST(ParseDoubleTest, RejectsInvalidNumbers) {
+  for (absl::string_view bad : {"", ".", "-", "abc", "1.2.3", "1,5", "--1"}) {
+    double value = 17;
+    EXPECT_FALSE(ParseDouble(bad, &value)) << bad;
+    EXPECT_THAT(value, Eq(17)) << bad;
+  }
+}
+
+TEST(ParseFloatTest, ParsesValidAndRejectsInvalid) {
+  float value = 0;
+  EXPECT_TRUE(ParseFloat("2.5", &value));
+  EXPECT_THAT(value, Eq(2.5f));
+  EXPECT_FALSE(ParseFloat("x", &value));
+  EXPECT_THAT(value, Eq(2.5f));
+}
+
+}  // namespace nucleus
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of file_util.h
+#include "nucleus/io/file_util.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+tf::Status ReadExactly(const tf::RandomAccessFile& file, uint64 offset,
+                       size_t n, absl::string_view file_kind, string* scratch,
+                       absl::string_view* data) {
+  scratch->resize(n);
+  tf::StringPiece result;
+  tf::Status status = file.Read(offset, n, &result, &(*scratch)[0]);
+  if (result.size() == n) {
+    *data = result;
+    return tf::Status::OK();
+  }
+  if (status.ok() || tf::errors::IsOutOfRange(status)) {
+    return tf::errors::DataLoss(file_kind, " is truncated at offset ", offset);
+  }
+  return status;
+}
+
+}  // namespace nucleus
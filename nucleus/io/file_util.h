@@ -0,0 +1,40 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Helpers for reading the binary sidecar files written by Nucleus, such as
+// coverage tracks and read name indexes, through TensorFlow's file system.
+#ifndef THIRD_PARTY_NUCLEUS_IO_FILE_UTIL_H_
+#define THIRD_PARTY_NUCLEUS_IO_FILE_UTIL_H_
+
+#include "absl/strings/string_view.h"
+#include "nucleus/platform/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace nucleus {
+
+// Reads exactly n bytes at offset from file into *data, which may point into
+// *scratch. A file ending before offset + n gives a DataLoss status saying
+// that file_kind, such as "Coverage track", is truncated.
+tensorflow::Status ReadExactly(const tensorflow::RandomAccessFile& file,
+                               uint64 offset, size_t n,
+                               absl::string_view file_kind, string* scratch,
+                               absl::string_view* data);
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_FILE_UTIL_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/file_util.h"
+
+#include <memory>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+using ::testing::Eq;
+
+class ReadExactlyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string path = MakeTempFile("read_exactly.bin");
+    TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                              path, "0123456789"));
+    TF_CHECK_OK(tensorflow::Env::Default()->NewRandomAccessFile(path, &file_));
+  }
+
+  std::unique_ptr<tensorflow::RandomAccessFile> file_;
+  string scratch_;
+  absl::string_view data_;
+};
+
+TEST_F(ReadExactlyTest, ReadsTheRequestedBytes) {
+  ASSERT_THAT(ReadExactly(*file_, 2, 5, "Test file", &scratch_, &data_),
+              IsOK());
+  EXPECT_THAT(data_, Eq("23456"));
+  ASSERT_THAT(ReadExactly(*file_, 0, 10, "Test file", &scratch_, &data_),
+              IsOK());
+  EXPECT_THAT(data_, Eq("0123456789"));
+}
+
+TEST_F(ReadExactlyTest, ReportsTruncationAsDataLoss) {
+  EXPECT_THAT(ReadExactly(*file_, 8, 5, "Test file", &scratch_, &data_),
+              IsNotOKWithCodeAndMessage(tensorflow::error::DATA_LOSS,
+                                        "Test file is truncated at offset 8"));
+  EXPECT_THAT(ReadExactly(*file_, 20, 1, "Test file", &scratch_, &data_),
+              IsNotOKWithCode(tensorflow::error::DATA_LOSS));
+}
+
+}  // namespace nucleus
@@ -172,6 +172,15 @@ class TFRecordReader(GenomicsReader):
     """
     raise NotImplementedError('Can not query TFRecord file')
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True). Records are parsed in Python,
+    so convert_nanos stays zero.
+    """
+    return self.reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self.reader.close()
 
@@ -124,6 +124,10 @@ class TFRecordWriter(GenomicsWriter):
     """Writes the proto to the TFRecord file."""
     self._writer.write(proto.SerializeToString())
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self.close()
 
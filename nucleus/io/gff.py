@@ -73,30 +73,51 @@ class NativeGffReader(genomics_reader.GenomicsReader):
   filename's extension.
   """
 
-  def __init__(self, input_path):
+  def __init__(self,
+               input_path,
+               keep_raw_attributes=False,
+               included_attribute_keys=None):
     """Initializes a NativeGffReader.
 
     Args:
       input_path: string. A path to a resource containing GFF records.
+      keep_raw_attributes: bool. If True, the attributes column is not parsed
+        but stored verbatim in GffRecord.raw_attributes.
+      included_attribute_keys: list(str). If non-empty, only attributes with
+        these keys (e.g. 'ID', 'Parent') are parsed into
+        GffRecord.attributes.
     """
     super(NativeGffReader, self).__init__()
     gff_path = input_path.encode('utf8')
-    reader_options = gff_pb2.GffReaderOptions()
+    reader_options = gff_pb2.GffReaderOptions(
+        keep_raw_attributes=keep_raw_attributes,
+        included_attribute_keys=included_attribute_keys)
     self._reader = gff_reader.GffReader.from_file(gff_path, reader_options)
     self.header = self._reader.header
 
-  def query(self):
+  def query(self, region):
     """Returns an iterator for going through the records in the region.
 
-    NOTE: This function is not currently implemented by NativeGffReader though
-    it could be implemented for sorted, tabix-indexed GFF files.
+    Requires a bgzip-compressed file with a tabix or CSI index (see
+    nucleus.io.tabix.build_index with preset='gff').
+
+    Args:
+      region: nucleus.genomics.v1.Range. The region to query.
     """
-    raise NotImplementedError('Can not currently query a GFF file')
+    return self._reader.query(region)
 
   def iterate(self):
     """Returns an iterable of GffRecord protos in the file."""
     return self._reader.iterate()
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -134,6 +155,10 @@ class NativeGffWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
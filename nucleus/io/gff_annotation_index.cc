@@ -0,0 +1,620 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of gff_annotation_index.h
+#include "nucleus/io/gff_annotation_index.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using nucleus::genomics::v1::GffReaderOptions;
+using nucleus::genomics::v1::GffRecord;
+using nucleus::genomics::v1::Range;
+
+constexpr GffAnnotationIndex::Handle GffAnnotationIndex::kNoFeature;
+
+namespace {
+
+// Identifies the binary index format; the trailing byte is the version.
+constexpr char kIndexMagic[] = "NUCGFFX\x01";
+constexpr int kIndexMagicLength = 8;
+
+// Subtrees of the implicit interval tree at or below this level hold at most
+// 2^(kLinearScanLevel+1) - 1 features, few enough to scan linearly.
+constexpr int kLinearScanLevel = 3;
+
+// Returns the value of attribute key in record, or the empty string.
+absl::string_view Attribute(const GffRecord& record, const string& key) {
+  auto it = record.attributes().find(key);
+  return it == record.attributes().end() ? absl::string_view()
+                                         : absl::string_view(it->second);
+}
+
+// Appends fixed-width values to a byte buffer in host byte order.
+class ByteWriter {
+ public:
+  explicit ByteWriter(string* out) : out_(out) {}
+
+  template <typename T>
+  void Put(T value) {
+    out_->append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void PutVector(const std::vector<T>& values) {
+    Put<int64>(values.size());
+    out_->append(reinterpret_cast<const char*>(values.data()),
+                 values.size() * sizeof(T));
+  }
+
+  void PutString(absl::string_view s) {
+    Put<int64>(s.size());
+    out_->append(s.data(), s.size());
+  }
+
+ private:
+  string* out_;
+};
+
+// Reads the values written by ByteWriter, failing on truncated input.
+class ByteReader {
+ public:
+  explicit ByteReader(absl::string_view in) : in_(in) {}
+
+  template <typename T>
+  bool Get(T* value) {
+    if (in_.size() < sizeof(T)) return false;
+    memcpy(value, in_.data(), sizeof(T));
+    in_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  template <typename T>
+  bool GetVector(std::vector<T>* values) {
+    int64 size;
+    if (!Get(&size) || size < 0 ||
+        static_cast<uint64>(size) > in_.size() / sizeof(T)) {
+      return false;
+    }
+    values->resize(size);
+    memcpy(values->data(), in_.data(), size * sizeof(T));
+    in_.remove_prefix(size * sizeof(T));
+    return true;
+  }
+
+  bool GetString(string* s) {
+    int64 size;
+    if (!Get(&size) || size < 0 || static_cast<uint64>(size) > in_.size()) {
+      return false;
+    }
+    s->assign(in_.data(), size);
+    in_.remove_prefix(size);
+    return true;
+  }
+
+  bool AtEnd() const { return in_.empty(); }
+
+ private:
+  absl::string_view in_;
+};
+
+// Returns true if offsets is a valid CSR offset array over n rows and size
+// elements.
+bool ValidOffsets(const std::vector<int32>& offsets, size_t n, size_t size) {
+  return offsets.size() == n + 1 && offsets.front() == 0 &&
+         static_cast<size_t>(offsets.back()) == size &&
+         std::is_sorted(offsets.begin(), offsets.end());
+}
+
+// Returns true if every handle is in [0, n).
+bool ValidHandles(const std::vector<GffAnnotationIndex::Handle>& handles,
+                  int n) {
+  return std::all_of(handles.begin(), handles.end(),
+                     [n](GffAnnotationIndex::Handle h) {
+                       return h >= 0 && h < n;
+                     });
+}
+
+}  // namespace
+
+// ------- Building
+
+void GffAnnotationIndex::PackedStrings::Add(absl::string_view s) {
+  data_.append(s.data(), s.size());
+  offsets_.push_back(data_.size());
+}
+
+void GffAnnotationIndex::Builder::Add(const GffRecord& record) {
+  const string& reference_name = record.range().reference_name();
+  auto contig = contig_ids_.find(reference_name);
+  if (contig == contig_ids_.end()) {
+    contig = contig_ids_.emplace(reference_name, contig_names_.size()).first;
+    contig_names_.push_back(reference_name);
+  }
+  auto type = type_ids_.find(record.type());
+  if (type == type_ids_.end()) {
+    type = type_ids_.emplace(record.type(), types_.size()).first;
+    types_.push_back(record.type());
+  }
+  absl::string_view name = Attribute(record, "Name");
+  if (name.empty()) name = Attribute(record, "gene_name");
+
+  PendingFeature feature;
+  feature.contig = contig->second;
+  feature.start = record.range().start();
+  feature.end = record.range().end();
+  feature.type = type->second;
+  feature.strand = static_cast<int8>(record.strand());
+  feature.id = string(Attribute(record, "ID"));
+  feature.name = string(name);
+  feature.parents = string(Attribute(record, "Parent"));
+  features_.push_back(std::move(feature));
+}
+
+StatusOr<std::unique_ptr<GffAnnotationIndex>>
+GffAnnotationIndex::Builder::Build() {
+  if (features_.size() >
+      static_cast<size_t>(std::numeric_limits<Handle>::max())) {
+    return tf::errors::ResourceExhausted("Too many GFF features to index: ",
+                                         features_.size());
+  }
+  // Among features with the same start, longer ones come first, so that a
+  // gene precedes its transcripts and a transcript its first exon.
+  std::stable_sort(features_.begin(), features_.end(),
+                   [](const PendingFeature& a, const PendingFeature& b) {
+                     return std::tie(a.contig, a.start, b.end) <
+                            std::tie(b.contig, b.start, a.end);
+                   });
+
+  auto index = absl::WrapUnique(new GffAnnotationIndex());
+  const int n = features_.size();
+  index->contig_names_ = contig_names_;
+  for (int i = 0; i < static_cast<int>(contig_names_.size()); ++i) {
+    index->contig_ids_.emplace(contig_names_[i], i);
+  }
+  for (const string& type : types_) index->types_.Add(type);
+  index->contig_offsets_.assign(contig_names_.size() + 1, 0);
+  index->starts_.reserve(n);
+  index->ends_.reserve(n);
+  index->type_ids_.reserve(n);
+  index->strands_.reserve(n);
+
+  // Handles follow the sorted order, so IDs can be resolved to handles once
+  // every feature has been placed.
+  std::unordered_map<string, Handle> handles_by_id;
+  for (Handle h = 0; h < n; ++h) {
+    const PendingFeature& feature = features_[h];
+    ++index->contig_offsets_[feature.contig + 1];
+    index->starts_.push_back(feature.start);
+    index->ends_.push_back(feature.end);
+    index->type_ids_.push_back(feature.type);
+    index->strands_.push_back(feature.strand);
+    index->ids_.Add(feature.id);
+    index->names_.Add(feature.name);
+    if (!feature.id.empty()) {
+      handles_by_id.emplace(feature.id, h);
+      index->id_order_.push_back(h);
+    }
+  }
+  std::partial_sum(index->contig_offsets_.begin(),
+                   index->contig_offsets_.end(),
+                   index->contig_offsets_.begin());
+
+  // Resolve Parent attributes, which may list several comma-separated IDs.
+  index->parent_offsets_.reserve(n + 1);
+  index->parent_offsets_.push_back(0);
+  std::vector<int32> n_children(n + 1, 0);
+  for (const PendingFeature& feature : features_) {
+    if (!feature.parents.empty()) {
+      for (absl::string_view parent_id : absl::StrSplit(feature.parents, ',')) {
+        auto parent = handles_by_id.find(string(parent_id));
+        if (parent == handles_by_id.end()) continue;
+        index->parents_.push_back(parent->second);
+        ++n_children[parent->second + 1];
+      }
+    }
+    index->parent_offsets_.push_back(index->parents_.size());
+  }
+
+  // Invert the parent lists; children come out in increasing handle order.
+  std::partial_sum(n_children.begin(), n_children.end(), n_children.begin());
+  index->child_offsets_ = n_children;
+  index->children_.resize(index->parents_.size());
+  for (Handle h = 0; h < n; ++h) {
+    for (Handle parent : index->Parents(h)) {
+      index->children_[n_children[parent]++] = h;
+    }
+  }
+
+  const GffAnnotationIndex& ids = *index;
+  std::sort(index->id_order_.begin(), index->id_order_.end(),
+            [&ids](Handle a, Handle b) {
+              return std::make_pair(ids.Id(a), a) <
+                     std::make_pair(ids.Id(b), b);
+            });
+
+  index->BuildIntervalTrees();
+  features_.clear();
+  return std::move(index);
+}
+
+// Lays each contig's features out as an implicit interval tree (Li, 2019;
+// https://github.com/lh3/cgranges): in an array of intervals sorted by start,
+// the node at index i has level equal to the number of trailing one bits of i,
+// and max_ends_[i] is the largest end in the subtree rooted at i.
+void GffAnnotationIndex::BuildIntervalTrees() {
+  max_ends_ = ends_;
+  contig_levels_.assign(NumContigs(), -1);
+  for (int c = 0; c < NumContigs(); ++c) {
+    int64* const max_end = max_ends_.data() + contig_offsets_[c];
+    const int64* const end = ends_.data() + contig_offsets_[c];
+    const int64 n = contig_offsets_[c + 1] - contig_offsets_[c];
+    if (n == 0) continue;
+
+    // last_i tracks the rightmost node at the current level, whose right
+    // subtree may be truncated by the end of the array; last is its max_end.
+    int64 last_i = 0;
+    int64 last = 0;
+    for (int64 i = 0; i < n; i += 2) {
+      last_i = i;
+      last = end[i];
+    }
+    int level = 1;
+    for (; (int64{1} << level) <= n; ++level) {
+      const int64 x = int64{1} << (level - 1);
+      const int64 step = x << 2;
+      for (int64 i = (x << 1) - 1; i < n; i += step) {
+        const int64 left = max_end[i - x];
+        const int64 right = i + x < n ? max_end[i + x] : last;
+        max_end[i] = std::max({end[i], left, right});
+      }
+      last_i = (last_i >> level & 1) ? last_i - x : last_i + x;
+      if (last_i < n && max_end[last_i] > last) last = max_end[last_i];
+    }
+    contig_levels_[c] = level - 1;
+  }
+}
+
+StatusOr<std::unique_ptr<GffAnnotationIndex>> GffAnnotationIndex::FromReader(
+    const GffReader& reader) {
+  StatusOr<std::shared_ptr<GffIterable>> iterable_or = reader.Iterate();
+  TF_RETURN_IF_ERROR(iterable_or.status());
+  std::shared_ptr<GffIterable> iterable = iterable_or.ValueOrDie();
+  if (iterable == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot index a GffReader with an active iterable");
+  }
+  Builder builder;
+  GffRecord record;
+  while (true) {
+    StatusOr<bool> more = iterable->Next(&record);
+    TF_RETURN_IF_ERROR(more.status());
+    if (!more.ValueOrDie()) break;
+    builder.Add(record);
+  }
+  return builder.Build();
+}
+
+StatusOr<std::unique_ptr<GffAnnotationIndex>> GffAnnotationIndex::FromFile(
+    const string& gff_path) {
+  GffReaderOptions options;
+  for (const char* key : {"ID", "Name", "gene_name", "Parent"}) {
+    options.add_included_attribute_keys(key);
+  }
+  StatusOr<std::unique_ptr<GffReader>> reader_or =
+      GffReader::FromFile(gff_path, options);
+  TF_RETURN_IF_ERROR(reader_or.status());
+  return FromReader(*reader_or.ValueOrDie());
+}
+
+// ------- Accessors
+
+absl::string_view GffAnnotationIndex::ReferenceName(Handle handle) const {
+  // The contig holding handle is the last one starting at or before it.
+  auto it = std::upper_bound(contig_offsets_.begin(), contig_offsets_.end(),
+                             handle);
+  return contig_names_[it - contig_offsets_.begin() - 1];
+}
+
+absl::Span<const GffAnnotationIndex::Handle> GffAnnotationIndex::Parents(
+    Handle handle) const {
+  return absl::MakeConstSpan(parents_.data() + parent_offsets_[handle],
+                             parents_.data() + parent_offsets_[handle + 1]);
+}
+
+absl::Span<const GffAnnotationIndex::Handle> GffAnnotationIndex::Children(
+    Handle handle) const {
+  return absl::MakeConstSpan(children_.data() + child_offsets_[handle],
+                             children_.data() + child_offsets_[handle + 1]);
+}
+
+GffRecord GffAnnotationIndex::Record(Handle handle) const {
+  GffRecord record;
+  absl::string_view reference_name = ReferenceName(handle);
+  record.mutable_range()->set_reference_name(reference_name.data(),
+                                             reference_name.size());
+  record.mutable_range()->set_start(Start(handle));
+  record.mutable_range()->set_end(End(handle));
+  absl::string_view type = Type(handle);
+  record.set_type(type.data(), type.size());
+  record.set_strand(Strand(handle));
+  auto& attributes = *record.mutable_attributes();
+  if (!Id(handle).empty()) attributes["ID"] = string(Id(handle));
+  if (!Name(handle).empty()) attributes["Name"] = string(Name(handle));
+  if (!Parents(handle).empty()) {
+    attributes["Parent"] = absl::StrJoin(
+        Parents(handle), ",", [this](string* out, Handle parent) {
+          absl::string_view id = Id(parent);
+          out->append(id.data(), id.size());
+        });
+  }
+  return record;
+}
+
+GffAnnotationIndex::Handle GffAnnotationIndex::FindById(
+    absl::string_view id) const {
+  auto it = std::lower_bound(
+      id_order_.begin(), id_order_.end(), id,
+      [this](Handle h, absl::string_view value) { return Id(h) < value; });
+  if (it == id_order_.end() || Id(*it) != id) return kNoFeature;
+  return *it;
+}
+
+int GffAnnotationIndex::FindContig(absl::string_view reference_name) const {
+  auto it = contig_ids_.find(reference_name);
+  return it == contig_ids_.end() ? -1 : it->second;
+}
+
+// ------- Queries
+
+void GffAnnotationIndex::Query(absl::string_view reference_name, int64 start,
+                               int64 end, std::vector<Handle>* hits) const {
+  hits->clear();
+  const int contig = FindContig(reference_name);
+  if (contig < 0 || contig_levels_[contig] < 0) return;
+  const Handle offset = contig_offsets_[contig];
+  const int64 n = contig_offsets_[contig + 1] - offset;
+  const int64* const starts = starts_.data() + offset;
+  const int64* const ends = ends_.data() + offset;
+  const int64* const max_ends = max_ends_.data() + offset;
+
+  // Top-down traversal of the implicit tree. Each stack entry is a node x at
+  // level, and whether its left subtree has been visited yet. Visiting the
+  // left subtree, then the node, then the right subtree keeps hits sorted.
+  struct StackEntry {
+    int level;
+    int64 x;
+    bool left_done;
+  };
+  StackEntry stack[64];
+  int top = 0;
+  const int root_level = contig_levels_[contig];
+  stack[top++] = {root_level, (int64{1} << root_level) - 1, false};
+  while (top > 0) {
+    const StackEntry node = stack[--top];
+    if (node.level <= kLinearScanLevel) {
+      // Small subtree: scan it linearly.
+      const int64 begin = node.x >> node.level << node.level;
+      const int64 stop =
+          std::min(begin + (int64{1} << (node.level + 1)) - 1, n);
+      for (int64 i = begin; i < stop && starts[i] < end; ++i) {
+        if (start < ends[i]) hits->push_back(static_cast<Handle>(offset + i));
+      }
+    } else if (!node.left_done) {
+      // The left child may lie past the end of the array, in which case it
+      // has no max_end of its own and must be descended into.
+      const int64 left = node.x - (int64{1} << (node.level - 1));
+      stack[top++] = {node.level, node.x, true};
+      if (left >= n || max_ends[left] > start) {
+        stack[top++] = {node.level - 1, left, false};
+      }
+    } else if (node.x < n && starts[node.x] < end) {
+      if (start < ends[node.x]) {
+        hits->push_back(static_cast<Handle>(offset + node.x));
+      }
+      stack[top++] = {node.level - 1, node.x + (int64{1} << (node.level - 1)),
+                      false};
+    }
+  }
+}
+
+void GffAnnotationIndex::QueryBatch(absl::Span<const Range> regions,
+                                    std::vector<std::vector<Handle>>* hits)
+    const {
+  hits->resize(regions.size());
+
+  // Sweep state: the contig being swept, the next feature on it not yet
+  // considered, and the considered features that may still overlap a query.
+  bool sweeping = false;
+  absl::string_view contig_name;
+  int contig = -1;
+  int64 previous_start = 0;
+  Handle next = 0;
+  std::vector<Handle> active;
+
+  for (size_t i = 0; i < regions.size(); ++i) {
+    const Range& region = regions[i];
+    std::vector<Handle>& out = (*hits)[i];
+    out.clear();
+    if (!sweeping || region.reference_name() != contig_name ||
+        region.start() < previous_start) {
+      sweeping = true;
+      contig_name = region.reference_name();
+      contig = FindContig(contig_name);
+      next = contig < 0 ? 0 : contig_offsets_[contig];
+      active.clear();
+    }
+    previous_start = region.start();
+    if (contig < 0) continue;
+
+    // Features ending at or before this start cannot overlap this region or
+    // any later one in the run.
+    active.erase(std::remove_if(active.begin(), active.end(),
+                                [&](Handle h) {
+                                  return ends_[h] <= region.start();
+                                }),
+                 active.end());
+    const Handle contig_end = contig_offsets_[contig + 1];
+    for (; next < contig_end && starts_[next] < region.end(); ++next) {
+      if (ends_[next] > region.start()) active.push_back(next);
+    }
+    // Features admitted for an earlier, longer region may start past this
+    // region's end.
+    for (Handle h : active) {
+      if (starts_[h] < region.end()) out.push_back(h);
+    }
+  }
+}
+
+// ------- Serialization
+
+tf::Status GffAnnotationIndex::Save(const string& index_path) const {
+  string buffer(kIndexMagic, kIndexMagicLength);
+  ByteWriter writer(&buffer);
+  writer.Put<int64>(contig_names_.size());
+  for (const string& name : contig_names_) writer.PutString(name);
+  writer.PutVector(contig_offsets_);
+  writer.PutVector(contig_levels_);
+  writer.PutVector(starts_);
+  writer.PutVector(ends_);
+  writer.PutVector(max_ends_);
+  writer.PutVector(type_ids_);
+  writer.PutVector(strands_);
+  for (const PackedStrings* strings : {&ids_, &names_, &types_}) {
+    writer.PutString(strings->data_);
+    writer.PutVector(strings->offsets_);
+  }
+  writer.PutVector(parent_offsets_);
+  writer.PutVector(parents_);
+  writer.PutVector(child_offsets_);
+  writer.PutVector(children_);
+  writer.PutVector(id_order_);
+  return tf::WriteStringToFile(tf::Env::Default(), index_path, buffer);
+}
+
+StatusOr<std::unique_ptr<GffAnnotationIndex>> GffAnnotationIndex::Load(
+    const string& index_path) {
+  string buffer;
+  TF_RETURN_IF_ERROR(
+      tf::ReadFileToString(tf::Env::Default(), index_path, &buffer));
+  if (buffer.compare(0, kIndexMagicLength, kIndexMagic, kIndexMagicLength)) {
+    return tf::errors::DataLoss(index_path, " is not a GFF annotation index");
+  }
+
+  auto index = absl::WrapUnique(new GffAnnotationIndex());
+  ByteReader reader(absl::string_view(buffer).substr(kIndexMagicLength));
+  int64 n_contigs;
+  bool ok = reader.Get(&n_contigs) && n_contigs >= 0;
+  for (int64 i = 0; ok && i < n_contigs; ++i) {
+    string name;
+    ok = reader.GetString(&name);
+    index->contig_ids_.emplace(name, i);
+    index->contig_names_.push_back(std::move(name));
+  }
+  ok = ok && reader.GetVector(&index->contig_offsets_) &&
+       reader.GetVector(&index->contig_levels_) &&
+       reader.GetVector(&index->starts_) && reader.GetVector(&index->ends_) &&
+       reader.GetVector(&index->max_ends_) &&
+       reader.GetVector(&index->type_ids_) &&
+       reader.GetVector(&index->strands_);
+  for (PackedStrings* strings :
+       {&index->ids_, &index->names_, &index->types_}) {
+    ok = ok && reader.GetString(&strings->data_) &&
+         reader.GetVector(&strings->offsets_);
+  }
+  ok = ok && reader.GetVector(&index->parent_offsets_) &&
+       reader.GetVector(&index->parents_) &&
+       reader.GetVector(&index->child_offsets_) &&
+       reader.GetVector(&index->children_) &&
+       reader.GetVector(&index->id_order_) && reader.AtEnd();
+  if (!ok) {
+    return tf::errors::DataLoss("Truncated or corrupt GFF annotation index ",
+                                index_path);
+  }
+  tf::Status status = index->Validate();
+  if (!status.ok()) {
+    return tf::errors::DataLoss("Corrupt GFF annotation index ", index_path,
+                                ": ", status.error_message());
+  }
+  return std::move(index);
+}
+
+tf::Status GffAnnotationIndex::Validate() const {
+  const size_t n = starts_.size();
+  if (contig_names_.size() != contig_ids_.size()) {
+    return tf::errors::DataLoss("duplicate contig names");
+  }
+  if (!ValidOffsets(contig_offsets_, contig_names_.size(), n) ||
+      contig_levels_.size() != contig_names_.size()) {
+    return tf::errors::DataLoss("bad contig table");
+  }
+  if (ends_.size() != n || max_ends_.size() != n || type_ids_.size() != n ||
+      strands_.size() != n || ids_.size() != static_cast<int>(n) ||
+      names_.size() != static_cast<int>(n)) {
+    return tf::errors::DataLoss("inconsistent feature columns");
+  }
+  for (const PackedStrings* strings : {&ids_, &names_, &types_}) {
+    if (strings->offsets_.empty() || strings->offsets_.front() != 0 ||
+        static_cast<size_t>(strings->offsets_.back()) !=
+            strings->data_.size() ||
+        !std::is_sorted(strings->offsets_.begin(), strings->offsets_.end())) {
+      return tf::errors::DataLoss("bad string table");
+    }
+  }
+  for (int32 type : type_ids_) {
+    if (type < 0 || type >= types_.size()) {
+      return tf::errors::DataLoss("bad feature type");
+    }
+  }
+  if (!ValidOffsets(parent_offsets_, n, parents_.size()) ||
+      !ValidOffsets(child_offsets_, n, children_.size()) ||
+      !ValidHandles(parents_, n) || !ValidHandles(children_, n) ||
+      !ValidHandles(id_order_, n)) {
+    return tf::errors::DataLoss("bad feature hierarchy");
+  }
+  for (int c = 0; c < NumContigs(); ++c) {
+    const int64 size = contig_offsets_[c + 1] - contig_offsets_[c];
+    const int level = contig_levels_[c];
+    // The root of a tree over size nodes is at the largest level with
+    // 2^level <= size.
+    if (size == 0 ? level != -1
+                  : level < 0 || level > 62 || (int64{1} << level) > size ||
+                        (int64{1} << (level + 1)) <= size) {
+      return tf::errors::DataLoss("bad interval tree");
+    }
+  }
+  return tf::Status::OK();
+}
+
+}  // namespace nucleus
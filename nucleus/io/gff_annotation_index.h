@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// An in-memory index over the features of a GFF file.
+//
+// Variant annotation repeatedly asks "which genes, transcripts and exons
+// overlap this position?". GffAnnotationIndex answers that without touching
+// GffRecord protos: features are stored per contig in flat arrays sorted by
+// start, laid out as an implicit augmented interval tree (the cgranges layout),
+// so an overlap query costs O(log n + k) for k hits and walks contiguous
+// memory. The GFF3 ID/Parent hierarchy is resolved to integer handles when the
+// index is built, and the index can be saved to and loaded from a compact
+// binary file so that large annotations need not be re-parsed at startup.
+#ifndef THIRD_PARTY_NUCLEUS_IO_GFF_ANNOTATION_INDEX_H_
+#define THIRD_PARTY_NUCLEUS_IO_GFF_ANNOTATION_INDEX_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "nucleus/io/gff_reader.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/gff.pb.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+class GffAnnotationIndex {
+ public:
+  // Identifies a feature in the index. Handles are dense in
+  // [0, NumFeatures()) and ordered by contig (in order of first appearance in
+  // the input), then by start, then from the longest to the shortest feature.
+  using Handle = int32;
+
+  // Returned by FindById when no feature has the requested ID.
+  static constexpr Handle kNoFeature = -1;
+
+  // Accumulates features and builds a GffAnnotationIndex from them.
+  class Builder {
+   public:
+    // Adds a feature. Only the range, type, strand and the ID, Name (or
+    // gene_name) and Parent attributes of record are indexed.
+    void Add(const nucleus::genomics::v1::GffRecord& record);
+
+    // Builds the index from all features added so far, resolving each
+    // feature's Parent IDs to handles. Parent IDs that do not name any feature
+    // are ignored.
+    StatusOr<std::unique_ptr<GffAnnotationIndex>> Build();
+
+   private:
+    struct PendingFeature {
+      int contig;
+      int64 start;
+      int64 end;
+      int type;
+      int8 strand;
+      string id;
+      string name;
+      string parents;
+    };
+
+    std::vector<PendingFeature> features_;
+    std::vector<string> contig_names_;
+    std::map<string, int, std::less<>> contig_ids_;
+    std::vector<string> types_;
+    std::map<string, int, std::less<>> type_ids_;
+  };
+
+  // Builds an index of every record returned by reader->Iterate().
+  static StatusOr<std::unique_ptr<GffAnnotationIndex>> FromReader(
+      const GffReader& reader);
+
+  // Builds an index of the GFF file at gff_path, parsing only the attributes
+  // the index needs.
+  static StatusOr<std::unique_ptr<GffAnnotationIndex>> FromFile(
+      const string& gff_path);
+
+  // Loads an index previously written by Save.
+  static StatusOr<std::unique_ptr<GffAnnotationIndex>> Load(
+      const string& index_path);
+
+  // Writes this index to index_path in a binary format readable by Load. The
+  // format uses the host's byte order.
+  tensorflow::Status Save(const string& index_path) const;
+
+  // Disable copy and assignment operations.
+  GffAnnotationIndex(const GffAnnotationIndex& other) = delete;
+  GffAnnotationIndex& operator=(const GffAnnotationIndex&) = delete;
+
+  int NumFeatures() const { return static_cast<int>(starts_.size()); }
+  int NumContigs() const { return static_cast<int>(contig_names_.size()); }
+
+  // Accessors for the feature identified by handle, which must be in
+  // [0, NumFeatures()). Coordinates are zero-based and end-exclusive.
+  absl::string_view ReferenceName(Handle handle) const;
+  int64 Start(Handle handle) const { return starts_[handle]; }
+  int64 End(Handle handle) const { return ends_[handle]; }
+  absl::string_view Type(Handle handle) const {
+    return types_.Get(type_ids_[handle]);
+  }
+  nucleus::genomics::v1::GffRecord::Strand Strand(Handle handle) const {
+    return static_cast<nucleus::genomics::v1::GffRecord::Strand>(
+        strands_[handle]);
+  }
+  absl::string_view Id(Handle handle) const { return ids_.Get(handle); }
+  absl::string_view Name(Handle handle) const { return names_.Get(handle); }
+  absl::Span<const Handle> Parents(Handle handle) const;
+  absl::Span<const Handle> Children(Handle handle) const;
+
+  // Returns the indexed fields of the feature as a GffRecord.
+  nucleus::genomics::v1::GffRecord Record(Handle handle) const;
+
+  // Returns the feature with the given ID, or kNoFeature. GFF3 features that
+  // span several lines (e.g. a CDS) share an ID; the first one is returned.
+  Handle FindById(absl::string_view id) const;
+
+  // Replaces *hits with the handles, in increasing order, of the features
+  // overlapping [start, end) on reference_name.
+  void Query(absl::string_view reference_name, int64 start, int64 end,
+             std::vector<Handle>* hits) const;
+  void Query(const nucleus::genomics::v1::Range& region,
+             std::vector<Handle>* hits) const {
+    Query(region.reference_name(), region.start(), region.end(), hits);
+  }
+
+  // Replaces *hits with the features overlapping the single base at position.
+  void QueryPoint(absl::string_view reference_name, int64 position,
+                  std::vector<Handle>* hits) const {
+    Query(reference_name, position, position + 1, hits);
+  }
+
+  // Answers a batch of queries, storing the hits for regions[i] in
+  // (*hits)[i] exactly as Query would.
+  //
+  // Runs of regions on the same contig sorted by start, as produced by a
+  // sorted variant stream, are answered with a single sweep over the contig's
+  // features instead of a tree search per region. Unsorted input is still
+  // answered correctly, restarting the sweep wherever the order breaks.
+  void QueryBatch(absl::Span<const nucleus::genomics::v1::Range> regions,
+                  std::vector<std::vector<Handle>>* hits) const;
+
+ private:
+  // A list of strings stored back to back in one buffer.
+  class PackedStrings {
+   public:
+    void Add(absl::string_view s);
+    absl::string_view Get(int i) const {
+      return absl::string_view(data_.data() + offsets_[i],
+                               offsets_[i + 1] - offsets_[i]);
+    }
+    int size() const { return static_cast<int>(offsets_.size()) - 1; }
+
+   private:
+    string data_;
+    std::vector<int64> offsets_ = {0};
+
+    friend class GffAnnotationIndex;
+  };
+
+  GffAnnotationIndex() = default;
+
+  // Returns the index of the contig named reference_name, or -1.
+  int FindContig(absl::string_view reference_name) const;
+
+  // Fills max_ends_ and contig_levels_ from starts_ and ends_.
+  void BuildIntervalTrees();
+
+  // Checks the invariants Query relies upon, for indices read from disk.
+  tensorflow::Status Validate() const;
+
+  // Contig names and the [begin, end) range of handles on each contig, which
+  // has contig_offsets_.size() == NumContigs() + 1 entries.
+  std::vector<string> contig_names_;
+  std::map<string, int, std::less<>> contig_ids_;
+  std::vector<Handle> contig_offsets_;
+  // The level of the root of each contig's implicit interval tree, or -1 for
+  // a contig without features.
+  std::vector<int32> contig_levels_;
+
+  // Per-feature columns, indexed by handle.
+  std::vector<int64> starts_;
+  std::vector<int64> ends_;
+  // The largest end in the implicit tree subtree rooted at each feature.
+  std::vector<int64> max_ends_;
+  std::vector<int32> type_ids_;
+  std::vector<int8> strands_;
+  PackedStrings ids_;
+  PackedStrings names_;
+
+  // The distinct feature types, indexed by type_ids_.
+  PackedStrings types_;
+
+  // Parents and children of each feature in compressed sparse row form: the
+  // parents of handle h are parents_[parent_offsets_[h]..parent_offsets_[h+1]).
+  std::vector<int32> parent_offsets_;
+  std::vector<Handle> parents_;
+  std::vector<int32> child_offsets_;
+  std::vector<Handle> children_;
+
+  // Handles of the features with an ID, sorted by (ID, handle).
+  std::vector<Handle> id_order_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_GFF_ANNOTATION_INDEX_H_
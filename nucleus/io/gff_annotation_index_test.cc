@@ -0,0 +1,271 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/gff_annotation_index.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "absl/strings/str_cat.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+namespace {
+
+using nucleus::genomics::v1::GffRecord;
+using nucleus::genomics::v1::Range;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+using Handle = GffAnnotationIndex::Handle;
+
+GffRecord MakeFeature(const string& chr, int64 start, int64 end,
+                      const string& type, const string& id,
+                      const string& parent) {
+  GffRecord record;
+  record.mutable_range()->set_reference_name(chr);
+  record.mutable_range()->set_start(start);
+  record.mutable_range()->set_end(end);
+  record.set_type(type);
+  record.set_strand(GffRecord::FORWARD_STRAND);
+  if (!id.empty()) (*record.mutable_attributes())["ID"] = id;
+  if (!parent.empty()) (*record.mutable_attributes())["Parent"] = parent;
+  return record;
+}
+
+// A small gene model: one gene with two transcripts sharing an exon, and a
+// CDS spanning two lines with the same ID.
+std::unique_ptr<GffAnnotationIndex> GeneModelIndex() {
+  GffAnnotationIndex::Builder builder;
+  builder.Add(MakeFeature("chr2", 50, 60, "gene", "gene2", ""));
+  builder.Add(MakeFeature("chr1", 100, 1000, "gene", "gene1", ""));
+  builder.Add(MakeFeature("chr1", 100, 1000, "mRNA", "tx1", "gene1"));
+  builder.Add(MakeFeature("chr1", 100, 800, "mRNA", "tx2", "gene1"));
+  builder.Add(MakeFeature("chr1", 100, 200, "exon", "exon1", "tx1,tx2"));
+  builder.Add(MakeFeature("chr1", 700, 1000, "exon", "exon2", "tx1"));
+  builder.Add(MakeFeature("chr1", 150, 200, "CDS", "cds1", "tx1"));
+  builder.Add(MakeFeature("chr1", 700, 750, "CDS", "cds1", "tx1"));
+  builder.Add(MakeFeature("chr1", 900, 950, "exon", "", "missing_parent"));
+  return std::move(builder.Build().ValueOrDie());
+}
+
+// Returns the IDs of the features identified by handles.
+std::vector<string> Ids(const GffAnnotationIndex& index,
+                        absl::Span<const Handle> handles) {
+  std::vector<string> ids;
+  for (Handle h : handles) ids.push_back(string(index.Id(h)));
+  return ids;
+}
+
+TEST(GffAnnotationIndexTest, ResolvesHierarchy) {
+  auto index = GeneModelIndex();
+  EXPECT_EQ(9, index->NumFeatures());
+  EXPECT_EQ(2, index->NumContigs());
+
+  const Handle gene1 = index->FindById("gene1");
+  ASSERT_NE(GffAnnotationIndex::kNoFeature, gene1);
+  EXPECT_EQ("chr1", index->ReferenceName(gene1));
+  EXPECT_EQ("gene", index->Type(gene1));
+  EXPECT_THAT(Ids(*index, index->Children(gene1)), ElementsAre("tx1", "tx2"));
+  EXPECT_THAT(index->Parents(gene1), IsEmpty());
+
+  const Handle exon1 = index->FindById("exon1");
+  EXPECT_THAT(Ids(*index, index->Parents(exon1)), ElementsAre("tx1", "tx2"));
+  EXPECT_THAT(Ids(*index, index->Children(index->FindById("tx2"))),
+              ElementsAre("exon1"));
+  EXPECT_THAT(Ids(*index, index->Children(index->FindById("tx1"))),
+              ElementsAre("exon1", "cds1", "exon2", "cds1"));
+
+  // Multi-line features share an ID; FindById returns the first.
+  EXPECT_EQ(150, index->Start(index->FindById("cds1")));
+  EXPECT_EQ(GffAnnotationIndex::kNoFeature, index->FindById("missing"));
+
+  const Handle gene2 = index->FindById("gene2");
+  EXPECT_EQ("chr2", index->ReferenceName(gene2));
+  EXPECT_EQ(50, index->Start(gene2));
+  EXPECT_EQ(60, index->End(gene2));
+}
+
+TEST(GffAnnotationIndexTest, ReconstructsRecords) {
+  auto index = GeneModelIndex();
+  GffRecord record = index->Record(index->FindById("exon1"));
+  EXPECT_EQ("chr1", record.range().reference_name());
+  EXPECT_EQ(100, record.range().start());
+  EXPECT_EQ(200, record.range().end());
+  EXPECT_EQ("exon", record.type());
+  EXPECT_EQ(GffRecord::FORWARD_STRAND, record.strand());
+  EXPECT_EQ("exon1", record.attributes().at("ID"));
+  EXPECT_EQ("tx1,tx2", record.attributes().at("Parent"));
+}
+
+TEST(GffAnnotationIndexTest, AnswersPointAndRangeQueries) {
+  auto index = GeneModelIndex();
+  std::vector<Handle> hits;
+  index->QueryPoint("chr1", 160, &hits);
+  EXPECT_THAT(Ids(*index, hits),
+              ElementsAre("gene1", "tx1", "tx2", "exon1", "cds1"));
+  index->QueryPoint("chr1", 99, &hits);
+  EXPECT_THAT(hits, IsEmpty());
+  index->Query(MakeRange("chr1", 800, 900), &hits);
+  EXPECT_THAT(Ids(*index, hits), ElementsAre("gene1", "tx1", "exon2"));
+  index->Query("chr2", 0, 1000, &hits);
+  EXPECT_THAT(Ids(*index, hits), ElementsAre("gene2"));
+  index->Query("chrX", 0, 1000, &hits);
+  EXPECT_THAT(hits, IsEmpty());
+}
+
+// Random features, including a few very long ones, on several contigs.
+std::vector<GffRecord> RandomFeatures(int n, std::mt19937* rng) {
+  std::uniform_int_distribution<int> contig(0, 2);
+  std::uniform_int_distribution<int64> start(0, 100000);
+  std::uniform_int_distribution<int64> length(1, 2000);
+  std::vector<GffRecord> records;
+  for (int i = 0; i < n; ++i) {
+    int64 s = start(*rng);
+    int64 e = s + (i % 97 == 0 ? 50000 : length(*rng));
+    records.push_back(MakeFeature(absl::StrCat("chr", contig(*rng)), s, e,
+                                  "exon", absl::StrCat("f", i), ""));
+  }
+  return records;
+}
+
+std::vector<Handle> BruteForceQuery(const GffAnnotationIndex& index,
+                                    const Range& region) {
+  std::vector<Handle> hits;
+  for (Handle h = 0; h < index.NumFeatures(); ++h) {
+    if (index.ReferenceName(h) == region.reference_name() &&
+        index.Start(h) < region.end() && region.start() < index.End(h)) {
+      hits.push_back(h);
+    }
+  }
+  return hits;
+}
+
+TEST(GffAnnotationIndexTest, QueriesMatchBruteForce) {
+  std::mt19937 rng(42);
+  for (int n : {1, 2, 3, 15, 16, 17, 100, 1000, 3000}) {
+    GffAnnotationIndex::Builder builder;
+    for (const GffRecord& record : RandomFeatures(n, &rng)) {
+      builder.Add(record);
+    }
+    auto index = std::move(builder.Build().ValueOrDie());
+
+    std::uniform_int_distribution<int> contig(0, 3);
+    std::uniform_int_distribution<int64> start(0, 110000);
+    std::uniform_int_distribution<int64> length(1, 500);
+    std::vector<Range> regions;
+    for (int i = 0; i < 200; ++i) {
+      int64 s = start(rng);
+      regions.push_back(
+          MakeRange(absl::StrCat("chr", contig(rng)), s, s + length(rng)));
+    }
+    std::vector<Handle> hits;
+    for (const Range& region : regions) {
+      index->Query(region, &hits);
+      EXPECT_EQ(BruteForceQuery(*index, region), hits) << "n=" << n;
+    }
+
+    // Batched queries agree with Query, both unsorted and sorted.
+    std::vector<std::vector<Handle>> batch_hits;
+    for (bool sorted : {false, true}) {
+      if (sorted) {
+        std::sort(regions.begin(), regions.end(),
+                  [](const Range& a, const Range& b) {
+                    return std::make_pair(a.reference_name(), a.start()) <
+                           std::make_pair(b.reference_name(), b.start());
+                  });
+      }
+      index->QueryBatch(regions, &batch_hits);
+      ASSERT_EQ(regions.size(), batch_hits.size());
+      for (size_t i = 0; i < regions.size(); ++i) {
+        EXPECT_EQ(BruteForceQuery(*index, regions[i]), batch_hits[i])
+            << "n=" << n << " sorted=" << sorted;
+      }
+    }
+  }
+}
+
+TEST(GffAnnotationIndexTest, SavesAndLoads) {
+  auto index = GeneModelIndex();
+  const string path = MakeTempFile("gene_model.gffidx");
+  ASSERT_THAT(index->Save(path), IsOK());
+
+  auto loaded_or = GffAnnotationIndex::Load(path);
+  ASSERT_THAT(loaded_or.status(), IsOK());
+  auto loaded = std::move(loaded_or.ValueOrDie());
+  ASSERT_EQ(index->NumFeatures(), loaded->NumFeatures());
+  for (Handle h = 0; h < index->NumFeatures(); ++h) {
+    EXPECT_EQ(index->Record(h).DebugString(), loaded->Record(h).DebugString());
+    EXPECT_EQ(Ids(*index, index->Children(h)),
+              Ids(*loaded, loaded->Children(h)));
+  }
+  std::vector<Handle> hits;
+  loaded->QueryPoint("chr1", 160, &hits);
+  EXPECT_THAT(Ids(*loaded, hits),
+              ElementsAre("gene1", "tx1", "tx2", "exon1", "cds1"));
+  EXPECT_EQ(index->FindById("exon2"), loaded->FindById("exon2"));
+}
+
+TEST(GffAnnotationIndexTest, LoadRejectsCorruptFiles) {
+  auto index = GeneModelIndex();
+  const string path = MakeTempFile("corrupt.gffidx");
+  ASSERT_THAT(index->Save(path), IsOK());
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(), path,
+                                           &contents));
+
+  const string truncated_path = MakeTempFile("truncated.gffidx");
+  TF_CHECK_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), truncated_path,
+      contents.substr(0, contents.size() - 3)));
+  EXPECT_TRUE(tensorflow::errors::IsDataLoss(
+      GffAnnotationIndex::Load(truncated_path).status()));
+
+  const string garbage_path = MakeTempFile("garbage.gffidx");
+  TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(),
+                                            garbage_path, "not an index"));
+  EXPECT_TRUE(tensorflow::errors::IsDataLoss(
+      GffAnnotationIndex::Load(garbage_path).status()));
+}
+
+TEST(GffAnnotationIndexTest, BuildsFromFile) {
+  auto index_or =
+      GffAnnotationIndex::FromFile(GetTestData("test_features.gff"));
+  ASSERT_THAT(index_or.status(), IsOK());
+  auto index = std::move(index_or.ValueOrDie());
+  EXPECT_EQ(2, index->NumFeatures());
+  const Handle gene = index->FindById("gene00001");
+  ASSERT_NE(GffAnnotationIndex::kNoFeature, gene);
+  EXPECT_EQ("EDEN", index->Name(gene));
+  std::vector<Handle> hits;
+  index->QueryPoint("ctg123", 999, &hits);
+  EXPECT_EQ(2, hits.size());
+}
+
+}  // namespace
+}  // namespace nucleus
@@ -28,6 +28,9 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "nucleus/io/field_scanner.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/range.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -48,21 +51,21 @@ constexpr char kGffCommentPrefix[] = "#";
 constexpr char kGffMissingField[] = ".";
 constexpr double kGffMissingDouble = -std::numeric_limits<double>::infinity();
 constexpr int32 kGffMissingInt32 = -1;
+constexpr int kGffNumFields = 9;
 
 namespace {
 
-tf::Status ParseGffHeaderLine(const string& line, GffHeader* header) {
+tf::Status ParseGffHeaderLine(absl::string_view line, GffHeader* header) {
   if (absl::StartsWith(line, "##gff-version")) {
-    // TODO(b/79165137): get rid of pessimizing string_view -> string
-    // conversions
-    header->set_gff_version(string(absl::StripPrefix(line, "##")));
+    absl::string_view version = absl::StripPrefix(line, "##");
+    header->set_gff_version(version.data(), version.size());
   } else if (absl::StartsWith(line, "##sequence-region")) {
-    std::vector<string> tokens = absl::StrSplit(line, ' ');
+    std::vector<absl::string_view> tokens = absl::StrSplit(line, ' ');
     if (tokens.size() != 4) {
       return tf::errors::DataLoss("Invalid sequence-region GFF header.");
     }
     // Parse seqid.
-    string seqid = tokens[1];
+    absl::string_view seqid = tokens[1];
     // Parse start, end.
     int64 start1, end1;
     if (!absl::SimpleAtoi(tokens[2], &start1)) {
@@ -76,7 +79,7 @@ tf::Status ParseGffHeaderLine(const string& line, GffHeader* header) {
     int64 end = end1;
     // Write on header record.
     auto* sequence_region = header->add_sequence_regions();
-    sequence_region->set_reference_name(seqid);
+    sequence_region->set_reference_name(seqid.data(), seqid.size());
     sequence_region->set_start(start);
     sequence_region->set_end(end);
   } else {
@@ -86,25 +89,28 @@ tf::Status ParseGffHeaderLine(const string& line, GffHeader* header) {
   return tf::Status::OK();
 }
 
-// Peeks into the GFF file to extract the header.
-// TODO(b/109754425): refactor header reading
-tf::Status ReadGffHeader(const string& path, GffHeader* header) {
+// Reads the header directives at the top of the file, leaving text_reader
+// positioned just past the first record. That record's line has to be read to
+// find the end of the header, so it is copied into *first_record; it is left
+// unset if the file has no records.
+tf::Status ReadGffHeader(TextReader& text_reader, GffHeader* header,
+                         absl::optional<string>* first_record) {
   CHECK(header != nullptr);
+  CHECK(first_record != nullptr);
   header->Clear();
-
-  StatusOr<std::unique_ptr<TextReader>> reader_or = TextReader::FromFile(path);
-  TF_RETURN_IF_ERROR(reader_or.status());
-  std::unique_ptr<TextReader> text_reader = std::move(reader_or.ValueOrDie());
-
-  StatusOr<string> line_or;
-  string line;
-  while ((line_or = text_reader->ReadLine()).ok() &&
-         absl::StartsWith(line = line_or.ValueOrDie(), kGffCommentPrefix)) {
+  first_record->reset();
+
+  absl::string_view line;
+  tf::Status status;
+  while ((status = text_reader.ReadLine(&line)).ok()) {
+    if (!absl::StartsWith(line, kGffCommentPrefix)) {
+      *first_record = string(line);
+      break;
+    }
     TF_RETURN_IF_ERROR(ParseGffHeaderLine(line, header));
   }
 
   // Propagate error, if any.
-  tf::Status status = line_or.status();
   if (!status.ok() && !tf::errors::IsOutOfRange(status)) {
     return status;
   }
@@ -112,70 +118,105 @@ tf::Status ReadGffHeader(const string& path, GffHeader* header) {
   return tf::Status::OK();
 }
 
-tf::Status NextNonCommentLine(TextReader& text_reader, string* line) {
+// Reads the next non-comment line. On success, *line points into
+// text_reader's line buffer and remains valid until the next read.
+tf::Status NextNonCommentLine(TextReader& text_reader,
+                              absl::string_view* line) {
   CHECK(line != nullptr);
-  string tmp;
   do {
-    StatusOr<string> line_or = text_reader.ReadLine();
-    TF_RETURN_IF_ERROR(line_or.status());
-    tmp = line_or.ValueOrDie();
-  } while (absl::StartsWith(tmp, kGffCommentPrefix));
-
-  *line = tmp;
+    TF_RETURN_IF_ERROR(text_reader.ReadLine(line));
+  } while (absl::StartsWith(*line, kGffCommentPrefix));
   return tf::Status::OK();
 }
 
-// Parses the text `attributes_string`, which is a ';'-delimited list
-// of string-to-string '=' assignments, into a proto string->string map.
-tf::Status ParseGffAttributes(const string& attributes_string,
-                              google::protobuf::Map<string, string>* attributes_map) {
+// Splits a GFF attribute assignment "key=value" into its key and value.
+// Returns false unless assignment contains exactly one '='.
+bool SplitGffAttribute(absl::string_view assignment, absl::string_view* key,
+                       absl::string_view* value) {
+  const size_t equals = assignment.find('=');
+  if (equals == absl::string_view::npos ||
+      assignment.find('=', equals + 1) != absl::string_view::npos) {
+    return false;
+  }
+  *key = assignment.substr(0, equals);
+  *value = assignment.substr(equals + 1);
+  return true;
+}
+
+// Checks that the text `attributes_string` is a ';'-delimited list of
+// string-to-string '=' assignments.
+tf::Status ValidateGffAttributes(absl::string_view attributes_string) {
   if (attributes_string == kGffMissingField || attributes_string.empty()) {
-    attributes_map->clear();
     return tf::Status::OK();
   }
-
-  google::protobuf::Map<string, string> tmp;
-  std::vector<absl::string_view> assignments =
-      absl::StrSplit(attributes_string, ';');
-  for (absl::string_view assignment : assignments) {
-    std::vector<absl::string_view> tokens = absl::StrSplit(assignment, '=');
-    if (tokens.size() != 2) {
+  absl::string_view key, value;
+  for (absl::string_view assignment : absl::StrSplit(attributes_string, ';')) {
+    if (!SplitGffAttribute(assignment, &key, &value)) {
       return tf::errors::Unknown("Cannot parse GFF attributes string");
     }
-    // TODO(b/79165137): get rid of pessimizing string_view -> string
-    // conversions
-    string lhs = string(tokens[0]);
-    string rhs = string(tokens[1]);
-    tmp[lhs] = rhs;
   }
-  *attributes_map = tmp;
   return tf::Status::OK();
 }
 
+// Returns true if the attribute named key should be stored under options.
+bool IsIncludedAttribute(absl::string_view key,
+                         const GffReaderOptions& options) {
+  if (options.included_attribute_keys().empty()) return true;
+  for (const string& included : options.included_attribute_keys()) {
+    if (key == included) return true;
+  }
+  return false;
+}
+
+// Adds the assignments in `attributes_string`, which must have passed
+// ValidateGffAttributes, to attributes_map, skipping any keys excluded by
+// options.
+void ParseGffAttributes(absl::string_view attributes_string,
+                        const GffReaderOptions& options,
+                        google::protobuf::Map<string, string>* attributes_map) {
+  if (attributes_string == kGffMissingField || attributes_string.empty()) {
+    return;
+  }
+  absl::string_view key, value;
+  for (absl::string_view assignment : absl::StrSplit(attributes_string, ';')) {
+    SplitGffAttribute(assignment, &key, &value);
+    if (IsIncludedAttribute(key, options)) {
+      (*attributes_map)[string(key)] = string(value);
+    }
+  }
+}
+
+// Returns the empty string if field is the GFF missing value, or field
+// otherwise.
+absl::string_view FieldOrEmpty(absl::string_view field) {
+  return field == kGffMissingField ? absl::string_view("") : field;
+}
+
 // Converts a text GFF line into a GffRecord proto message, or returns an error
 // code if the line is malformed.  The record will only be modified if the call
 // succeeds.
-tf::Status ConvertToPb(const string& line, GffRecord* record) {
+tf::Status ConvertToPb(absl::string_view line, const GffReaderOptions& options,
+                       GffRecord* record) {
   CHECK(record != nullptr);
 
-  std::vector<string> fields = absl::StrSplit(line, '\t');
-  if (fields.size() != 9) {
+  absl::string_view fields[kGffNumFields];
+  if (SplitFields(line, '\t', absl::MakeSpan(fields)) != kGffNumFields) {
     return tf::errors::Unknown("Incorrect number of columns in a GFF record.");
   }
 
   // Parse line.
-  string seq_id = fields[0];
+  absl::string_view seq_id = fields[0];
   if (seq_id == kGffMissingField || seq_id.empty()) {
     return tf::errors::Unknown("GFF mandatory seq_id field is missing");
   }
-  string source = (fields[1] == kGffMissingField ? "" : fields[1]);
-  string type = (fields[2] == kGffMissingField ? "" : fields[2]);
+  absl::string_view source = FieldOrEmpty(fields[1]);
+  absl::string_view type = FieldOrEmpty(fields[2]);
 
   int64 start1, end1;
-  if (!absl::SimpleAtoi(fields[3], &start1)) {
+  if (!ParseInt64(fields[3], &start1)) {
     return tf::errors::Unknown("Cannot parse GFF record `start`");
   }
-  if (!absl::SimpleAtoi(fields[4], &end1)) {
+  if (!ParseInt64(fields[4], &end1)) {
     return tf::errors::Unknown("Cannot parse GFF record `end`");
   }
   // Convert to zero-based end-exclusive coordinate system.
@@ -187,14 +228,14 @@ tf::Status ConvertToPb(const string& line, GffRecord* record) {
   absl::optional<float> score;
   if (fields[5] != kGffMissingField) {
     float value;
-    if (!absl::SimpleAtof(fields[5], &value)) {
+    if (!ParseFloat(fields[5], &value)) {
       return tf::errors::Unknown("Cannot parse GFF record `score`");
     }
     score = value;
   }
   // Parse strand.
   GffRecord::Strand strand;
-  const string& strand_field = fields[6];
+  absl::string_view strand_field = fields[6];
   if (strand_field == kGffMissingField) {
     strand = GffRecord::UNSPECIFIED_STRAND;
   } else if (strand_field == "+") {
@@ -206,34 +247,55 @@ tf::Status ConvertToPb(const string& line, GffRecord* record) {
   }
   // Parse phase.
   absl::optional<int> phase;
-  const string& phase_field = fields[7];
+  absl::string_view phase_field = fields[7];
   if (phase_field != kGffMissingField) {
-    int value;
-    if (!absl::SimpleAtoi(phase_field, &value) ||
+    int32 value;
+    if (!ParseInt32(phase_field, &value) ||
         !((value >= 0) && (value < 3))) {
       return tf::errors::Unknown("Invalid GFF record `phase` encoding.");
     }
     phase = value;
   }
-  // Parse attributes dictionary.
-  google::protobuf::Map<string, string> attributes_map;
-  TF_RETURN_IF_ERROR(ParseGffAttributes(fields[8], &attributes_map));
+  // Check the attributes dictionary, unless it is kept unparsed.
+  absl::string_view attributes = fields[8];
+  if (!options.keep_raw_attributes()) {
+    TF_RETURN_IF_ERROR(ValidateGffAttributes(attributes));
+  }
 
   // Write on the record.
   record->Clear();
-  record->mutable_range()->set_reference_name(seq_id);
+  record->mutable_range()->set_reference_name(seq_id.data(), seq_id.size());
   record->mutable_range()->set_start(start);
   record->mutable_range()->set_end(end);
-  record->set_source(source);
-  record->set_type(type);
+  record->set_source(source.data(), source.size());
+  record->set_type(type.data(), type.size());
   record->set_score(score.value_or(kGffMissingDouble));
   record->set_strand(strand);
   record->set_phase(phase.value_or(kGffMissingInt32));
-  *record->mutable_attributes() = attributes_map;
+  if (options.keep_raw_attributes()) {
+    attributes = FieldOrEmpty(attributes);
+    record->set_raw_attributes(attributes.data(), attributes.size());
+  } else {
+    ParseGffAttributes(attributes, options, record->mutable_attributes());
+  }
 
   return tf::Status::OK();
 }
 
+// ConvertToPb with the options of reader, counting the record in its
+// statistics.
+tf::Status ConvertCounted(const GffReader* reader, absl::string_view line,
+                          GffRecord* record) {
+  IoStats* stats = IoStatsEnabled() ? reader->io_stats() : nullptr;
+  if (stats != nullptr) stats->AddRecordDecoded();
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(ConvertToPb(line, reader->Options(), record));
+  }
+  if (stats != nullptr) stats->AddRecordKept();
+  return tf::Status::OK();
+}
+
 }  // namespace
 
 // ------- GFF iteration class
@@ -254,14 +316,21 @@ StatusOr<bool> GffFullFileIterable::Next(
     nucleus::genomics::v1::GffRecord* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
   const GffReader* gff_reader = static_cast<const GffReader*>(reader_);
-  string line;
+  if (gff_reader->first_record_) {
+    // The first record was read along with the header.
+    const string line = std::move(*gff_reader->first_record_);
+    gff_reader->first_record_.reset();
+    TF_RETURN_IF_ERROR(ConvertCounted(gff_reader, line, out));
+    return true;
+  }
+  absl::string_view line;
   tf::Status status = NextNonCommentLine(*gff_reader->text_reader_, &line);
   if (tf::errors::IsOutOfRange(status)) {
     return false;
   } else {
     TF_RETURN_IF_ERROR(status);
   }
-  TF_RETURN_IF_ERROR(ConvertToPb(line, out));
+  TF_RETURN_IF_ERROR(ConvertCounted(gff_reader, line, out));
   return true;
 }
 
@@ -270,27 +339,69 @@ GffFullFileIterable::~GffFullFileIterable() {}
 GffFullFileIterable::GffFullFileIterable(const GffReader* reader)
     : Iterable(reader) {}
 
+// Iterable class for traversing GFF records overlapping a query region.
+class GffQueryIterable : public GffIterable {
+ public:
+  // Advance to the next record.
+  StatusOr<bool> Next(nucleus::genomics::v1::GffRecord* out) override;
+
+  // Constructor is invoked via GffReader::Query.
+  GffQueryIterable(const GffReader* reader,
+                   std::unique_ptr<TextRegionIterator> iter);
+  ~GffQueryIterable() override;
+
+ private:
+  std::unique_ptr<TextRegionIterator> iter_;
+};
+
+StatusOr<bool> GffQueryIterable::Next(nucleus::genomics::v1::GffRecord* out) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  const GffReader* gff_reader = static_cast<const GffReader*>(reader_);
+  absl::string_view line;
+  tf::Status status = iter_->ReadLine(&line);
+  if (tf::errors::IsOutOfRange(status)) {
+    return false;
+  } else {
+    TF_RETURN_IF_ERROR(status);
+  }
+  TF_RETURN_IF_ERROR(ConvertCounted(gff_reader, line, out));
+  return true;
+}
+
+GffQueryIterable::~GffQueryIterable() {}
+
+GffQueryIterable::GffQueryIterable(const GffReader* reader,
+                                   std::unique_ptr<TextRegionIterator> iter)
+    : Iterable(reader), iter_(std::move(iter)) {}
+
 // ------- GFF reader class
 
 StatusOr<std::unique_ptr<GffReader>> GffReader::FromFile(
     const string& gff_path,
     const nucleus::genomics::v1::GffReaderOptions& options) {
   StatusOr<std::unique_ptr<TextReader>> text_reader_or =
-      TextReader::FromFile(gff_path);
+      TextReader::FromFile(gff_path, TextReader::LOAD_INDEX);
   TF_RETURN_IF_ERROR(text_reader_or.status());
+  std::unique_ptr<TextReader> text_reader =
+      std::move(text_reader_or.ValueOrDie());
 
   GffHeader header;
-  TF_RETURN_IF_ERROR(ReadGffHeader(gff_path, &header));
+  absl::optional<string> first_record;
+  TF_RETURN_IF_ERROR(ReadGffHeader(*text_reader, &header, &first_record));
 
-  return std::unique_ptr<GffReader>(
-      new GffReader(std::move(text_reader_or.ValueOrDie()), options, header));
+  return std::unique_ptr<GffReader>(new GffReader(
+      std::move(text_reader), options, header, std::move(first_record)));
 }
 
 GffReader::GffReader(std::unique_ptr<TextReader> text_reader,
-                     const GffReaderOptions& options, const GffHeader& header)
+                     const GffReaderOptions& options, const GffHeader& header,
+                     absl::optional<string> first_record)
     : text_reader_(std::move(text_reader)),
       options_(options),
-      header_(header) {}
+      header_(header),
+      first_record_(std::move(first_record)) {
+  text_reader_->set_io_stats(io_stats());
+}
 
 StatusOr<std::shared_ptr<GffIterable>> GffReader::Iterate() const {
   if (!text_reader_)
@@ -299,6 +410,19 @@ StatusOr<std::shared_ptr<GffIterable>> GffReader::Iterate() const {
       MakeIterable<GffFullFileIterable>(this));
 }
 
+StatusOr<std::shared_ptr<GffIterable>> GffReader::Query(
+    const nucleus::genomics::v1::Range& region) {
+  if (!text_reader_)
+    return tf::errors::FailedPrecondition("Cannot Query a closed GffReader.");
+  if (!HasIndex())
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  StatusOr<std::unique_ptr<TextRegionIterator>> iter_or = text_reader_->Query(
+      region.reference_name(), region.start(), region.end());
+  TF_RETURN_IF_ERROR(iter_or.status());
+  return StatusOr<std::shared_ptr<GffIterable>>(
+      MakeIterable<GffQueryIterable>(this, std::move(iter_or.ValueOrDie())));
+}
+
 tensorflow::Status GffReader::Close() {
   if (!text_reader_) {
     return tf::errors::FailedPrecondition("GffReader already closed");
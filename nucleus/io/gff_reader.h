@@ -21,10 +21,12 @@
 #include <memory>
 #include <string>
 
+#include "absl/types/optional.h"
 #include "nucleus/io/reader_base.h"
 #include "nucleus/io/text_reader.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/gff.pb.h"
+#include "nucleus/protos/range.pb.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -40,7 +42,8 @@ class GffReader : public Reader {
   // Creates a new GffReader reading reads from the GFF file gff_path.
   //
   // gff_path must point to an existing GFF formatted file (or gzipped
-  // equivalent).
+  // equivalent). If the file is bgzip-compressed, a tabix or CSI index built
+  // with the "gff" preset is loaded when present to support Query.
   //
   // The GFF format is described here:
   // https://github.com/The-Sequence-Ontology/Specifications/blob/master/gff3.md
@@ -64,6 +67,16 @@ class GffReader : public Reader {
   // nucleus.genomics.v1.GffRecord
   StatusOr<std::shared_ptr<GffIterable>> Iterate() const;
 
+  // Gets all of the GFF records that overlap any bases in region, which is
+  // zero-based and half-open like the ranges of the records returned. This
+  // function is only available if an index was loaded; otherwise a non-OK
+  // status value is returned.
+  StatusOr<std::shared_ptr<GffIterable>> Query(
+      const nucleus::genomics::v1::Range& region);
+
+  // Returns true if a tabix or CSI index was loaded for this file.
+  bool HasIndex() const { return text_reader_ && text_reader_->HasIndex(); }
+
   // Closes the underlying resource descriptors. Returns a Status to
   // indicate if everything went OK with the close.
   tensorflow::Status Close();
@@ -84,7 +97,8 @@ class GffReader : public Reader {
   // Private constructor used by FromFile factory.
   GffReader(std::unique_ptr<TextReader> text_reader,
             const nucleus::genomics::v1::GffReaderOptions& options,
-            const nucleus::genomics::v1::GffHeader& header);
+            const nucleus::genomics::v1::GffHeader& header,
+            absl::optional<string> first_record);
 
   // A pointer to a raw TextReader object.
   std::unique_ptr<TextReader> text_reader_;
@@ -95,8 +109,13 @@ class GffReader : public Reader {
   // The GFF header, reflecting how to interpret fields.
   const nucleus::genomics::v1::GffHeader header_;
 
+  // The line of the first record, which is read along with the header in a
+  // single pass over the file and handed out by the first full-file iteration.
+  mutable absl::optional<string> first_record_;
+
   // Allow iteration to access the underlying reader.
   friend class GffFullFileIterable;
+  friend class GffQueryIterable;
 };
 
 }  // namespace nucleus
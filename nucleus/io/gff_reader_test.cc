@@ -26,15 +26,19 @@
 #include <gmock/gmock-more-matchers.h>
 
 #include "tensorflow/core/platform/test.h"
+#include "nucleus/io/tabix_indexer.h"
+#include "nucleus/io/text_writer.h"
 #include "nucleus/protos/gff.pb.h"
 #include "nucleus/protos/range.pb.h"
 #include "nucleus/testing/protocol-buffer-matchers.h"
 #include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
 
 namespace nucleus {
 namespace {
 
 using nucleus::genomics::v1::GffHeader;
+using nucleus::genomics::v1::GffReaderOptions;
 using nucleus::genomics::v1::GffRecord;
 
 const char kExpectedHeaderRecord[] =
@@ -95,6 +99,63 @@ TEST(GffReaderTest, ReadsExampleFile) {
   EXPECT_THAT(gff_records[1], EqualsProto(kExpectedGffRecord2));
 }
 
+TEST(GffReaderTest, KeepsRawAttributes) {
+  GffReaderOptions options;
+  options.set_keep_raw_attributes(true);
+  auto reader = std::move(
+      GffReader::FromFile(GetTestData("test_features.gff"), options)
+          .ValueOrDie());
+  EXPECT_THAT(reader->Header(), EqualsProto(kExpectedHeaderRecord));
+
+  std::vector<GffRecord> gff_records = as_vector(reader->Iterate());
+  ASSERT_EQ(2, gff_records.size());
+  EXPECT_TRUE(gff_records[0].attributes().empty());
+  EXPECT_EQ("ID=gene00001;Name=EDEN", gff_records[0].raw_attributes());
+  EXPECT_EQ("", gff_records[1].raw_attributes());
+}
+
+TEST(GffReaderTest, ParsesOnlyIncludedAttributes) {
+  GffReaderOptions options;
+  options.add_included_attribute_keys("ID");
+  options.add_included_attribute_keys("Parent");
+  auto reader = std::move(
+      GffReader::FromFile(GetTestData("test_features.gff"), options)
+          .ValueOrDie());
+
+  std::vector<GffRecord> gff_records = as_vector(reader->Iterate());
+  ASSERT_EQ(2, gff_records.size());
+  EXPECT_EQ(1, gff_records[0].attributes().size());
+  EXPECT_EQ("gene00001", gff_records[0].attributes().at("ID"));
+  EXPECT_TRUE(gff_records[0].raw_attributes().empty());
+}
+
+TEST(GffReaderTest, QueriesIndexedFile) {
+  const string path = MakeTempFile("query.gff.gz");
+  {
+    auto writer = std::move(
+        TextWriter::ToFile(path, TextWriter::COMPRESS).ValueOrDie());
+    TF_CHECK_OK(writer->Write("##gff-version 3.2.1\n"));
+    TF_CHECK_OK(writer->Write("ctg123\t.\tgene\t1000\t9000\t.\t+\t.\t.\n"));
+    TF_CHECK_OK(writer->Write("ctg123\t.\texon\t9500\t9800\t.\t+\t.\t.\n"));
+    TF_CHECK_OK(writer->Close());
+  }
+  TF_CHECK_OK(TbxIndexBuild(path, "gff"));
+
+  auto reader = std::move(GffReader::FromFile(path).ValueOrDie());
+  ASSERT_TRUE(reader->HasIndex());
+
+  // The one-based GFF start 1000 is position 999 in the zero-based query.
+  std::vector<GffRecord> records =
+      as_vector(reader->Query(MakeRange("ctg123", 998, 999)));
+  EXPECT_TRUE(records.empty());
+  records = as_vector(reader->Query(MakeRange("ctg123", 999, 1000)));
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ("gene", records[0].type());
+  records = as_vector(reader->Query(MakeRange("ctg123", 8999, 9500)));
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(9499, records[1].range().start());
+}
+
 // TODO(dhalexander): Add more comprehensive tests
 
 }  // namespace
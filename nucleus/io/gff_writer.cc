@@ -16,15 +16,14 @@
 
 #include "nucleus/io/gff_writer.h"
 
+#include <algorithm>
 #include <limits>
-#include <map>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/map.h"
 #include "absl/memory/memory.h"
-#include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
-#include "absl/strings/substitute.h"
+#include "absl/strings/string_view.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/gff.pb.h"
 #include "nucleus/protos/range.pb.h"
@@ -52,46 +51,45 @@ constexpr int32 kGffMissingInt32 = -1;
 namespace {
 
 tf::Status WriteGffHeader(const GffHeader& header, TextWriter* text_writer) {
-  TF_RETURN_IF_ERROR(text_writer->Write("##gff-version 3.2.1\n"));
+  text_writer->Append("##gff-version 3.2.1\n");
   for (const Range& range : header.sequence_regions()) {
-    TF_RETURN_IF_ERROR(text_writer->Write(
-        // Range start converted from 0- to 1-based, end-inclusive.
-        absl::Substitute("##sequence-region $0 $1 $2\n", range.reference_name(),
-                         range.start() + 1, range.end())));
+    // Range start converted from 0- to 1-based, end-inclusive.
+    text_writer->Append("##sequence-region ", range.reference_name(), " ",
+                        range.start() + 1, " ", range.end(), "\n");
   }
   // TODO(dhalexander): write ontology headers.
-  return tf::Status::OK();
+  return text_writer->MaybeFlush();
 }
 
-tf::Status FormatGffAttributes(const GffRecord& record,
-                               string* gff_attributes) {
+void AppendGffAttributes(const GffRecord& record, TextWriter* text_writer) {
+  if (record.attributes().empty()) {
+    // The record was read without parsing its attributes.
+    text_writer->Append(record.raw_attributes());
+    return;
+  }
   // Sort to ensure deterministic iteration order.
-  std::map<string, string> sorted_attributes(record.attributes().begin(),
-                                             record.attributes().end());
-  *gff_attributes =
-      absl::StrJoin(sorted_attributes, ";", absl::PairFormatter("="));
-  return tf::Status::OK();
+  using Attribute = google::protobuf::Map<string, string>::value_type;
+  std::vector<const Attribute*> sorted_attributes;
+  sorted_attributes.reserve(record.attributes().size());
+  for (const Attribute& attribute : record.attributes()) {
+    sorted_attributes.push_back(&attribute);
+  }
+  std::sort(sorted_attributes.begin(), sorted_attributes.end(),
+            [](const Attribute* a, const Attribute* b) {
+              return a->first < b->first;
+            });
+  absl::string_view separator = "";
+  for (const Attribute* attribute : sorted_attributes) {
+    text_writer->Append(separator, attribute->first, "=", attribute->second);
+    separator = ";";
+  }
 }
 
-tf::Status FormatGffLine(const GffRecord& record, string* gff_line) {
-  string tmp, attributes;
-  absl::StrAppend(&tmp, record.range().reference_name(), "\t");
-  absl::StrAppend(
-      &tmp, (record.source().empty() ? kGffMissingField : record.source()),
-      "\t");
-  absl::StrAppend(
-      &tmp, (record.type().empty() ? kGffMissingField : record.type()), "\t");
-  // Convert range to 1-based coordinates for GFF text.
-  int64 start1 = record.range().start() + 1;
-  int64 end1 = record.range().end();
-  absl::StrAppend(&tmp, start1, "\t", end1, "\t");
-  // Score
-  string score_str =
-      (record.score() == kGffMissingDouble ? kGffMissingField
-                                           : absl::StrCat(record.score()));
-  absl::StrAppend(&tmp, score_str, "\t");
-  // Strand
-  string strand_code;
+// Appends the line of record to text_writer, without flushing it.
+tf::Status AppendGffLine(const GffRecord& record, TextWriter* text_writer) {
+  // Validate the strand and phase before anything is appended, so that a bad
+  // record leaves no partial line behind.
+  absl::string_view strand_code;
   switch (record.strand()) {
     case GffRecord::UNSPECIFIED_STRAND:
       strand_code = kGffMissingField;
@@ -105,22 +103,40 @@ tf::Status FormatGffLine(const GffRecord& record, string* gff_line) {
     default:
       return tf::errors::InvalidArgument("Illegal GffRecord strand encoding");
   }
-  absl::StrAppend(&tmp, strand_code, "\t");
-  // Phase
   int phase = record.phase();
-  if (phase >= 0 && phase <= 2) {
-    absl::StrAppend(&tmp, phase, "\t");
-  } else if (phase == kGffMissingInt32) {
-    absl::StrAppend(&tmp, kGffMissingField, "\t");
-  } else {
+  if (!(phase >= 0 && phase <= 2) && phase != kGffMissingInt32) {
     return tf::errors::InvalidArgument("Illegal GffRecord phase encoding");
   }
-  // Attributes
-  TF_RETURN_IF_ERROR(FormatGffAttributes(record, &attributes));
-  absl::StrAppend(&tmp, attributes);
-  absl::StrAppend(&tmp, "\n");
 
-  *gff_line = tmp;
+  text_writer->Append(
+      record.range().reference_name(), "\t",
+      (record.source().empty() ? absl::string_view(kGffMissingField)
+                               : record.source()),
+      "\t",
+      (record.type().empty() ? absl::string_view(kGffMissingField)
+                             : record.type()),
+      "\t");
+  // Convert range to 1-based coordinates for GFF text.
+  int64 start1 = record.range().start() + 1;
+  int64 end1 = record.range().end();
+  text_writer->Append(start1, "\t", end1, "\t");
+  // Score
+  if (record.score() == kGffMissingDouble) {
+    text_writer->Append(kGffMissingField, "\t");
+  } else {
+    text_writer->Append(record.score(), "\t");
+  }
+  // Strand
+  text_writer->Append(strand_code, "\t");
+  // Phase
+  if (phase == kGffMissingInt32) {
+    text_writer->Append(kGffMissingField, "\t");
+  } else {
+    text_writer->Append(phase, "\t");
+  }
+  // Attributes
+  AppendGffAttributes(record, text_writer);
+  text_writer->Append("\n");
   return tf::Status::OK();
 }
 
@@ -144,15 +160,25 @@ StatusOr<std::unique_ptr<GffWriter>> GffWriter::ToFile(
 tf::Status GffWriter::Write(const GffRecord& record) {
   if (!text_writer_)
     return tf::errors::FailedPrecondition("Cannot write to closed GFF stream.");
-  string line;
-  TF_RETURN_IF_ERROR(FormatGffLine(record, &line));
-  return text_writer_->Write(line);
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(AppendGffLine(record, text_writer_.get()));
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
+  return text_writer_->MaybeFlush();
 }
 
 tf::Status GffWriter::Close() {
   if (!text_writer_)
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed GffWriter");
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "GffWriter statistics: " << io_stats_.ToJson();
+  }
   // Close the file pointer we have been writing to.
   tf::Status close_status = text_writer_->Close();
   text_writer_ = nullptr;
@@ -163,6 +189,8 @@ GffWriter::GffWriter(std::unique_ptr<TextWriter> text_writer,
                      const GffHeader& header, const GffWriterOptions& options)
     : header_(header),
       options_(options),
-      text_writer_(std::move(text_writer)) {}
+      text_writer_(std::move(text_writer)) {
+  text_writer_->set_io_stats(&io_stats_);
+}
 
 }  // namespace nucleus
@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 
+#include "nucleus/io/io_stats.h"
 #include "nucleus/io/text_writer.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/gff.pb.h"
@@ -65,6 +66,12 @@ class GffWriter {
   // error occurred.
   tensorflow::Status Close();
 
+  // Returns a snapshot of the statistics of this writer (see io_stats.h).
+  // Text still buffered is not counted until it is flushed.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // Provides access to the header.
   const nucleus::genomics::v1::GffHeader& Header() const { return header_; }
 
@@ -84,6 +91,10 @@ class GffWriter {
   // Our options that control the behavior of this class.
   const nucleus::genomics::v1::GffWriterOptions options_;
 
+  // The statistics of this writer. text_writer_ updates them, so they must
+  // outlive it.
+  IoStats io_stats_;
+
   // Underlying file writer.
   std::unique_ptr<TextWriter> text_writer_;
 };
@@ -111,5 +111,28 @@ TEST(GffWriterTest, WritesGffRecords) {
   EXPECT_EQ(kExpectedGffText, contents);
 }
 
+TEST(GffWriterTest, WritesRawAttributes) {
+  GffHeader header;
+  google::protobuf::TextFormat::ParseFromString(kHeaderRecord, &header);
+
+  GffRecord record1, record2;
+  google::protobuf::TextFormat::ParseFromString(kGffRecord1, &record1);
+  google::protobuf::TextFormat::ParseFromString(kGffRecord2, &record2);
+  record1.clear_attributes();
+  record1.set_raw_attributes("ID=gene00001;Name=EDEN");
+
+  string out_fname = MakeTempFile("gff_writer_test_2.gff");
+  std::unique_ptr<GffWriter> gff_writer =
+      std::move(GffWriter::ToFile(out_fname, header).ValueOrDie());
+  ASSERT_THAT(gff_writer->Write(record1), IsOK());
+  ASSERT_THAT(gff_writer->Write(record2), IsOK());
+  ASSERT_THAT(gff_writer->Close(), IsOK());
+
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                           out_fname, &contents));
+  EXPECT_EQ(kExpectedGffText, contents);
+}
+
 }  // namespace
 }  // namespace nucleus
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of hts_offsets.h
+#include "nucleus/io/hts_offsets.h"
+
+#include <stdio.h>
+
+#include "htslib/bgzf.h"
+#include "htslib/hfile.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+namespace {
+
+// Returns true if the BGZF handle of fp reads a BGZF-compressed or
+// uncompressed stream, whose virtual offsets can be seeked to. A gzipped
+// stream is also read through a BGZF handle, but is not seekable.
+bool HasSeekableBgzf(const htsFile* fp) {
+  return fp->is_bgzf && !fp->is_cram &&
+         fp->format.compression != gzip;
+}
+
+// Returns true if fp reads an uncompressed stream through a plain hFILE.
+bool HasSeekableHfile(const htsFile* fp) {
+  return !fp->is_bgzf && !fp->is_cram &&
+         fp->format.compression == no_compression;
+}
+
+}  // namespace
+
+StatusOr<int64> TellRecordOffset(htsFile* fp) {
+  if (HasSeekableBgzf(fp)) return bgzf_tell(fp->fp.bgzf);
+  if (HasSeekableHfile(fp)) {
+    const off_t offset = htell(fp->fp.hfile);
+    if (offset < 0) return tf::errors::DataLoss("htell() failed");
+    return offset;
+  }
+  return tf::errors::FailedPrecondition(
+      "Offsets require a BGZF-compressed or uncompressed file");
+}
+
+tf::Status SeekRecordOffset(htsFile* fp, int64 offset) {
+  if (offset < 0) {
+    return tf::errors::InvalidArgument("Offset must be non-negative, not ",
+                                       offset);
+  }
+  int64 result;
+  if (HasSeekableBgzf(fp)) {
+    result = bgzf_seek(fp->fp.bgzf, offset, SEEK_SET);
+  } else if (HasSeekableHfile(fp)) {
+    result = hseek(fp->fp.hfile, offset, SEEK_SET);
+  } else {
+    return tf::errors::FailedPrecondition(
+        "Offsets require a BGZF-compressed or uncompressed file");
+  }
+  if (result < 0) {
+    return tf::errors::InvalidArgument("Failed to seek to offset ", offset);
+  }
+  // Drop any line read ahead of the old position, such as the first record
+  // of a SAM file, which is read along with the header.
+  fp->line.l = 0;
+  return tf::Status::OK();
+}
+
+void HtsByteCounts(htsFile* fp, int64* compressed, int64* uncompressed) {
+  *compressed = 0;
+  *uncompressed = 0;
+  if (fp->is_cram) return;
+  if (fp->is_bgzf) {
+    *compressed = htell(fp->fp.bgzf->fp);
+    *uncompressed = bgzf_utell(fp->fp.bgzf);
+  } else {
+    *compressed = htell(fp->fp.hfile);
+    *uncompressed = *compressed;
+  }
+}
+
+ScopedHtsBytes::ScopedHtsBytes(htsFile* fp, IoStats* stats)
+    : fp_(fp), stats_(IoStatsEnabled() ? stats : nullptr) {
+  if (stats_ != nullptr) HtsByteCounts(fp_, &compressed_, &uncompressed_);
+}
+
+ScopedHtsBytes::~ScopedHtsBytes() {
+  if (stats_ == nullptr) return;
+  int64 compressed, uncompressed;
+  HtsByteCounts(fp_, &compressed, &uncompressed);
+  stats_->AddBytes(compressed - compressed_, uncompressed - uncompressed_);
+}
+
+}  // namespace nucleus
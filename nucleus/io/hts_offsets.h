@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Checkpoints of the position of sequential reads through an htsFile.
+//
+// The offset of a BGZF-compressed file (BAM, or bgzipped SAM or VCF) is the
+// BGZF virtual offset of the next record: the compressed offset of its block
+// in the upper 48 bits and its offset within the uncompressed block in the
+// lower 16. The offset of an uncompressed file is a plain byte offset. Other
+// files, such as CRAM or gzipped but not bgzipped text, have no offsets.
+//
+// The byte counts of an htsFile, which instrument readers and writers, are
+// also read here.
+#ifndef THIRD_PARTY_NUCLEUS_IO_HTS_OFFSETS_H_
+#define THIRD_PARTY_NUCLEUS_IO_HTS_OFFSETS_H_
+
+#include "htslib/hts.h"
+#include "nucleus/io/io_stats.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+// Returns the offset of the next record fp would read.
+StatusOr<int64> TellRecordOffset(htsFile* fp);
+
+// Moves fp to offset, as returned by TellRecordOffset for the same file, so
+// that the next record read is the one following the checkpoint.
+tensorflow::Status SeekRecordOffset(htsFile* fp, int64 offset);
+
+// Sets *compressed to the bytes of storage fp has read or written so far, and
+// *uncompressed to the bytes of record data they hold. Both are 0 for CRAM
+// files, whose storage is not accessible.
+void HtsByteCounts(htsFile* fp, int64* compressed, int64* uncompressed);
+
+// Adds the bytes fp reads or writes between its construction and destruction
+// to stats, if collection is enabled.
+class ScopedHtsBytes {
+ public:
+  ScopedHtsBytes(htsFile* fp, IoStats* stats);
+  ~ScopedHtsBytes();
+
+  ScopedHtsBytes(const ScopedHtsBytes& other) = delete;
+  ScopedHtsBytes& operator=(const ScopedHtsBytes&) = delete;
+
+ private:
+  htsFile* const fp_;
+  // Null if collection is disabled.
+  IoStats* const stats_;
+  int64 compressed_ = 0;
+  int64 uncompressed_ = 0;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_HTS_OFFSETS_H_
@@ -62,4 +62,9 @@ int tbx_index_build_x(const std::string &fn, int min_shift,
   return tbx_index_build(new_path.c_str(), min_shift, conf);
 }
 
+int sam_index_build_x(const std::string &fn, int min_shift) {
+  string new_path = fix_path(fn);
+  return sam_index_build(new_path.c_str(), min_shift);
+}
+
 }  // namespace nucleus
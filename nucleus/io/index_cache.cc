@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of index_cache.h
+#include "nucleus/io/index_cache.h"
+
+#include <iterator>
+
+#include "htslib/sam.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+IndexCache* IndexCache::Global() {
+  static IndexCache* cache = new IndexCache();
+  return cache;
+}
+
+std::shared_ptr<hts_idx_t> IndexCache::LoadSamIndex(const string& path,
+                                                    htsFile* fp) {
+  return Load<hts_idx_t>("sam", path,
+                         [fp]() { return sam_index_load(fp, fp->fn); },
+                         hts_idx_destroy);
+}
+
+std::shared_ptr<tbx_t> IndexCache::LoadTabixIndex(const string& path,
+                                                  htsFile* fp) {
+  return Load<tbx_t>("tabix", path, [fp]() { return tbx_index_load(fp->fn); },
+                     tbx_destroy);
+}
+
+int IndexCache::size() {
+  absl::MutexLock lock(&mutex_);
+  int n = 0;
+  for (const auto& entry : entries_) {
+    if (!entry.second.expired()) ++n;
+  }
+  return n;
+}
+
+template <class Index>
+std::shared_ptr<Index> IndexCache::Load(const string& kind,
+                                        const string& path,
+                                        const std::function<Index*()>& load,
+                                        void (*destroy)(Index*)) {
+  const auto own = [destroy](Index* index) {
+    return index == nullptr ? nullptr : std::shared_ptr<Index>(index, destroy);
+  };
+  // Files whose modification time is unknown are not cached, as a rewritten
+  // file could not be told apart from the cached one.
+  tf::FileStatistics stats;
+  if (!tf::Env::Default()->Stat(path, &stats).ok()) return own(load());
+  const Key key(kind, path, stats.mtime_nsec);
+
+  {
+    absl::MutexLock lock(&mutex_);
+    const auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      std::shared_ptr<void> index = it->second.lock();
+      if (index != nullptr) return std::static_pointer_cast<Index>(index);
+    }
+  }
+
+  // Load without holding the lock, so other files can be loaded meanwhile.
+  std::shared_ptr<Index> index = own(load());
+  if (index == nullptr) return nullptr;
+
+  absl::MutexLock lock(&mutex_);
+  // Drop the entries of indexes that have been freed.
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = it->second.expired() ? entries_.erase(it) : std::next(it);
+  }
+  std::weak_ptr<void>& entry = entries_[key];
+  // Another reader may have loaded the index concurrently; keep its copy.
+  std::shared_ptr<void> existing = entry.lock();
+  if (existing != nullptr) return std::static_pointer_cast<Index>(existing);
+  entry = index;
+  return index;
+}
+
+}  // namespace nucleus
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// A process-wide cache of the htslib indexes loaded by readers.
+//
+// Opening a reader normally loads and parses the index of its file, which for
+// a large BAM file takes long and holds megabytes, so workers opening the same
+// file once per shard pay for it over and over. Readers that opt in through
+// the share_index option of their options proto get their index from this
+// cache instead: it is loaded once and shared, read-only, by all of the live
+// readers of the file, and freed when the last of them is closed. Entries are
+// keyed by the path and modification time of the file, so a file that is
+// rewritten gets a freshly loaded index.
+#ifndef THIRD_PARTY_NUCLEUS_IO_INDEX_CACHE_H_
+#define THIRD_PARTY_NUCLEUS_IO_INDEX_CACHE_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "absl/synchronization/mutex.h"
+#include "htslib/hts.h"
+#include "htslib/tbx.h"
+#include "nucleus/platform/types.h"
+
+namespace nucleus {
+
+class IndexCache {
+ public:
+  // Returns the cache shared by the whole process.
+  static IndexCache* Global();
+
+  IndexCache() = default;
+
+  // Disable copy or assignment
+  IndexCache(const IndexCache& other) = delete;
+  IndexCache& operator=(const IndexCache&) = delete;
+
+  // Returns the BAI or CSI index of the BAM file at path, open as fp, loading
+  // it with sam_index_load unless a live reader already shares it. Returns
+  // null if the file has no index.
+  std::shared_ptr<hts_idx_t> LoadSamIndex(const string& path, htsFile* fp);
+
+  // Returns the tabix index of the bgzipped file at path, open as fp,
+  // loading it with tbx_index_load unless a live reader already shares it.
+  // Returns null if the file has no index.
+  std::shared_ptr<tbx_t> LoadTabixIndex(const string& path, htsFile* fp);
+
+  // Returns the number of indexes held by live readers.
+  int size();
+
+ private:
+  // The kind of index, the path of its file and the file's modification time.
+  using Key = std::tuple<string, string, int64>;
+
+  // Returns the index of kind for path, loading it with load, which returns
+  // an index to free with destroy or null, if it is not already cached.
+  template <class Index>
+  std::shared_ptr<Index> Load(const string& kind, const string& path,
+                              const std::function<Index*()>& load,
+                              void (*destroy)(Index*));
+
+  absl::Mutex mutex_;
+  // Weak references to the indexes, which are owned by the readers.
+  std::map<Key, std::weak_ptr<void>> entries_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_INDEX_CACHE_H_
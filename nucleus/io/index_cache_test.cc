@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/index_cache.h"
+
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/io/hts_path.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/io/vcf_reader.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+
+namespace nucleus {
+
+using genomics::v1::SamReaderOptions;
+using genomics::v1::VcfReaderOptions;
+using ::testing::SizeIs;
+
+// Opens path, or fails the test.
+std::unique_ptr<htsFile, int (*)(htsFile*)> Open(const string& path) {
+  std::unique_ptr<htsFile, int (*)(htsFile*)> fp(hts_open_x(path, "r"),
+                                                 hts_close);
+  EXPECT_NE(nullptr, fp);
+  return fp;
+}
+
+TEST(IndexCacheTest, SharesIndexesWhileHeld) {
+  IndexCache cache;
+  const string path = GetTestData("test.bam");
+  auto fp1 = Open(path);
+  auto fp2 = Open(path);
+  std::shared_ptr<hts_idx_t> idx1 = cache.LoadSamIndex(path, fp1.get());
+  ASSERT_NE(nullptr, idx1);
+  EXPECT_EQ(idx1, cache.LoadSamIndex(path, fp2.get()));
+  EXPECT_EQ(1, cache.size());
+
+  // Once every holder lets go the index is freed, and reloaded on demand.
+  idx1.reset();
+  EXPECT_EQ(0, cache.size());
+  EXPECT_NE(nullptr, cache.LoadSamIndex(path, fp1.get()));
+}
+
+TEST(IndexCacheTest, SeparatesFilesAndKinds) {
+  IndexCache cache;
+  const string bam_path = GetTestData("test.bam");
+  const string vcf_path = GetTestData("test_samples.vcf.gz");
+  auto bam_fp = Open(bam_path);
+  auto vcf_fp = Open(vcf_path);
+  std::shared_ptr<hts_idx_t> bam_idx =
+      cache.LoadSamIndex(bam_path, bam_fp.get());
+  std::shared_ptr<tbx_t> vcf_idx =
+      cache.LoadTabixIndex(vcf_path, vcf_fp.get());
+  ASSERT_NE(nullptr, bam_idx);
+  ASSERT_NE(nullptr, vcf_idx);
+  EXPECT_EQ(2, cache.size());
+}
+
+TEST(IndexCacheTest, FilesWithoutIndexesAreNotCached) {
+  IndexCache cache;
+  const string path = GetTestData("unindexed.bam");
+  auto fp = Open(path);
+  EXPECT_EQ(nullptr, cache.LoadSamIndex(path, fp.get()));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(IndexCacheTest, ReadersShareIndexes) {
+  const string path = GetTestData("test.bam");
+  const int before = IndexCache::Global()->size();
+  SamReaderOptions options;
+  options.set_share_index(true);
+
+  // Each thread opens and queries readers of its own, concurrently.
+  std::vector<std::unique_ptr<SamReader>> readers(8);
+  std::vector<std::thread> threads;
+  for (auto& reader : readers) {
+    threads.emplace_back([&reader, &path, &options]() {
+      reader = std::move(SamReader::FromFile(path, options).ValueOrDie());
+      EXPECT_THAT(
+          as_vector(reader->Query(MakeRange("chr20", 9999999, 10000000))),
+          SizeIs(45));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(before + 1, IndexCache::Global()->size());
+
+  for (auto& reader : readers) ASSERT_THAT(reader->Close(), IsOK());
+  EXPECT_EQ(before, IndexCache::Global()->size());
+
+  VcfReaderOptions vcf_options;
+  vcf_options.set_share_index(true);
+  std::unique_ptr<VcfReader> vcf_reader = std::move(
+      VcfReader::FromFile(GetTestData("test_samples.vcf.gz"), vcf_options)
+          .ValueOrDie());
+  EXPECT_TRUE(vcf_reader->HasIndex());
+  EXPECT_EQ(before + 1, IndexCache::Global()->size());
+  EXPECT_THAT(as_vector(vcf_reader->Query(MakeRange("chr3", 0, 198295559))),
+              SizeIs(6));
+}
+
+}  // namespace nucleus
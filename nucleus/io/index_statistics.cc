@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of index_statistics.h
+#include "nucleus/io/index_statistics.h"
+
+#include <algorithm>
+
+namespace nucleus {
+
+using genomics::v1::ContigIndexStatistics;
+using genomics::v1::IndexStatistics;
+
+namespace {
+
+// Returns the number of compressed bytes between the first and last chunks
+// idx would read for contig tid.
+int64 CompressedSpan(const hts_idx_t* idx, int tid) {
+  hts_itr_t* iter = hts_itr_query(idx, tid, 0, HTS_POS_MAX, nullptr);
+  if (iter == nullptr) return 0;
+  int64 span = 0;
+  if (iter->n_off > 0) {
+    uint64 last = 0;
+    for (int i = 0; i < iter->n_off; ++i) {
+      last = std::max<uint64>(last, iter->off[i].v);
+    }
+    // The chunks are sorted by start, and the offsets are BGZF virtual
+    // offsets holding the compressed offset in their upper 48 bits.
+    span = static_cast<int64>(last >> 16) -
+           static_cast<int64>(iter->off[0].u >> 16);
+  }
+  hts_itr_destroy(iter);
+  return span;
+}
+
+}  // namespace
+
+IndexStatistics ReadIndexStatistics(
+    const hts_idx_t* idx, absl::Span<const string> names,
+    const std::function<int(const string&)>& tid_of) {
+  IndexStatistics stats;
+  for (const string& name : names) {
+    ContigIndexStatistics* contig = stats.add_contigs();
+    contig->set_name(name);
+    const int tid = tid_of(name);
+    if (tid < 0) continue;
+    uint64_t mapped = 0, unmapped = 0;
+    if (hts_idx_get_stat(idx, tid, &mapped, &unmapped) == 0) {
+      contig->set_n_mapped(mapped);
+      contig->set_n_unmapped(unmapped);
+    }
+    contig->set_n_compressed_bytes(CompressedSpan(idx, tid));
+  }
+  stats.set_n_no_coordinate(hts_idx_get_n_no_coor(idx));
+  return stats;
+}
+
+}  // namespace nucleus
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Reads per-contig record counts and sizes from a BAI, CSI or TBI index.
+//
+// Indexes written by htslib keep a pseudo-bin for each contig counting its
+// mapped and unmapped records, and the no-coordinate count at their end, so
+// these statistics cost a lookup per contig rather than a pass over the file.
+#ifndef THIRD_PARTY_NUCLEUS_IO_INDEX_STATISTICS_H_
+#define THIRD_PARTY_NUCLEUS_IO_INDEX_STATISTICS_H_
+
+#include <functional>
+
+#include "absl/types/span.h"
+#include "htslib/hts.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/reference.pb.h"
+
+namespace nucleus {
+
+// Returns the statistics idx records for the contigs named names, in order.
+// tid_of returns the id of a name in idx, or a negative value if idx holds no
+// records for it. Contigs absent from idx, and indexes written without
+// pseudo-bins, give zero counts.
+nucleus::genomics::v1::IndexStatistics ReadIndexStatistics(
+    const hts_idx_t* idx, absl::Span<const string> names,
+    const std::function<int(const string&)>& tid_of);
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_INDEX_STATISTICS_H_
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of io_stats.h
+#include "nucleus/io/io_stats.h"
+
+#include "google/protobuf/util/json_util.h"
+
+namespace nucleus {
+
+using genomics::v1::IoStatistics;
+
+namespace {
+
+std::atomic<bool> enabled(false);
+
+}  // namespace
+
+void SetIoStatsEnabled(bool value) {
+  enabled.store(value, std::memory_order_relaxed);
+}
+
+bool IoStatsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+IoStatistics IoStats::ToProto() const {
+  IoStatistics stats;
+  stats.set_compressed_bytes(compressed_bytes_.load());
+  stats.set_uncompressed_bytes(uncompressed_bytes_.load());
+  stats.set_records_decoded(records_decoded_.load());
+  stats.set_records_kept(records_kept_.load());
+  stats.set_hts_nanos(nanos_[kHts].load());
+  stats.set_convert_nanos(nanos_[kConvert].load());
+  stats.set_aux_parse_nanos(nanos_[kAuxParse].load());
+  return stats;
+}
+
+string IoStats::ToJson() const {
+  google::protobuf::util::JsonPrintOptions options;
+  options.always_print_primitive_fields = true;
+  options.preserve_proto_field_names = true;
+  string json;
+  if (!google::protobuf::util::MessageToJsonString(ToProto(), &json, options)
+           .ok()) {
+    return "{}";
+  }
+  return json;
+}
+
+}  // namespace nucleus
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Instrumentation of the work done by readers and writers.
+//
+// Readers and writers keep an IoStats counting the bytes and records they move
+// and the time they spend in htslib and in proto conversion, which can be
+// queried as an IoStatistics proto and is logged as JSON when a writer, or a
+// SAM, VCF or TFRecord reader, is closed. Readers and writers of text formats
+// count through their TextReader or TextWriter (see their set_io_stats). See
+// io_stats.proto for the readers which collect nothing.
+// Collection is disabled by default, and then costs a single relaxed atomic
+// load per record: enable it for the whole process with SetIoStatsEnabled.
+#ifndef THIRD_PARTY_NUCLEUS_IO_IO_STATS_H_
+#define THIRD_PARTY_NUCLEUS_IO_IO_STATS_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/io_stats.pb.h"
+
+namespace nucleus {
+
+// Enables or disables the collection of statistics by all of the readers and
+// writers of this process.
+void SetIoStatsEnabled(bool enabled);
+
+// Returns true if statistics are being collected.
+bool IoStatsEnabled();
+
+// The statistics of a reader or writer. They can be updated from several
+// threads at once, as by the cursors of a reader.
+class IoStats {
+ public:
+  // The timers of IoStatistics.
+  enum Timer { kHts, kConvert, kAuxParse, kNumTimers };
+
+  IoStats() = default;
+
+  // Disable copy or assignment
+  IoStats(const IoStats& other) = delete;
+  IoStats& operator=(const IoStats&) = delete;
+
+  // Adds compressed and uncompressed bytes moved to or from storage.
+  void AddBytes(int64 compressed, int64 uncompressed) {
+    compressed_bytes_.fetch_add(compressed, std::memory_order_relaxed);
+    uncompressed_bytes_.fetch_add(uncompressed, std::memory_order_relaxed);
+  }
+
+  // Counts a record decoded or encoded.
+  void AddRecordDecoded() {
+    records_decoded_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Counts a decoded record returned to the client.
+  void AddRecordKept() {
+    records_kept_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Adds nanos to timer.
+  void AddNanos(Timer timer, int64 nanos) {
+    nanos_[timer].fetch_add(nanos, std::memory_order_relaxed);
+  }
+
+  // Returns a snapshot of the statistics.
+  nucleus::genomics::v1::IoStatistics ToProto() const;
+
+  // Returns a snapshot of the statistics as a JSON object.
+  string ToJson() const;
+
+ private:
+  std::atomic<int64> compressed_bytes_{0};
+  std::atomic<int64> uncompressed_bytes_{0};
+  std::atomic<int64> records_decoded_{0};
+  std::atomic<int64> records_kept_{0};
+  std::atomic<int64> nanos_[kNumTimers] = {};
+};
+
+// Adds the time between its construction and destruction to a timer of
+// stats. If collection is disabled, or stats is null, it does nothing and
+// does not read the clock.
+class ScopedIoTimer {
+ public:
+  ScopedIoTimer(IoStats* stats, IoStats::Timer timer)
+      : stats_(stats != nullptr && IoStatsEnabled() ? stats : nullptr),
+        timer_(timer) {
+    if (stats_ != nullptr) start_ = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedIoTimer() {
+    if (stats_ == nullptr) return;
+    stats_->AddNanos(timer_,
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start_)
+                         .count());
+  }
+
+  ScopedIoTimer(const ScopedIoTimer& other) = delete;
+  ScopedIoTimer& operator=(const ScopedIoTimer&) = delete;
+
+ private:
+  IoStats* const stats_;
+  const IoStats::Timer timer_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_IO_STATS_H_
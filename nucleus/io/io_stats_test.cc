@@ -0,0 +1,219 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/io_stats.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/io/bed_reader.h"
+#include "nucleus/io/bedgraph_writer.h"
+#include "nucleus/io/fastq_reader.h"
+#include "nucleus/io/fastq_writer.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/io/tfrecord_reader.h"
+#include "nucleus/io/tfrecord_writer.h"
+#include "nucleus/protos/io_stats.pb.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+using genomics::v1::BedGraphRecord;
+using genomics::v1::BedReaderOptions;
+using genomics::v1::FastqReaderOptions;
+using genomics::v1::FastqRecord;
+using genomics::v1::FastqWriterOptions;
+using genomics::v1::IoStatistics;
+using genomics::v1::SamReaderOptions;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+
+// Enables collection for the lifetime of a test.
+class IoStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SetIoStatsEnabled(true); }
+  void TearDown() override { SetIoStatsEnabled(false); }
+};
+
+TEST_F(IoStatsTest, CountsAndFormats) {
+  IoStats stats;
+  stats.AddBytes(10, 40);
+  stats.AddRecordDecoded();
+  stats.AddRecordDecoded();
+  stats.AddRecordKept();
+  stats.AddNanos(IoStats::kConvert, 7);
+  EXPECT_THAT(stats.ToProto(), EqualsProto(R"(
+    compressed_bytes: 10 uncompressed_bytes: 40
+    records_decoded: 2 records_kept: 1 convert_nanos: 7)"));
+  // Fields which are zero are still printed.
+  EXPECT_THAT(stats.ToJson(), HasSubstr("\"aux_parse_nanos\""));
+  EXPECT_THAT(stats.ToJson(), HasSubstr("\"records_kept\""));
+}
+
+TEST_F(IoStatsTest, TimersDoNothingWhileDisabled) {
+  IoStats stats;
+  {
+    ScopedIoTimer timer(&stats, IoStats::kHts);
+    ScopedIoTimer null_timer(nullptr, IoStats::kHts);
+  }
+  SetIoStatsEnabled(false);
+  {
+    ScopedIoTimer timer(&stats, IoStats::kConvert);
+  }
+  EXPECT_EQ(0, stats.ToProto().convert_nanos());
+}
+
+TEST_F(IoStatsTest, SamReaderCountsRecordsAndBytes) {
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData("test.bam"), SamReaderOptions())
+          .ValueOrDie());
+  const int64 num_reads = as_vector(reader->Iterate()).size();
+  const IoStatistics stats = reader->Stats();
+  EXPECT_EQ(num_reads, stats.records_decoded());
+  EXPECT_EQ(num_reads, stats.records_kept());
+  EXPECT_THAT(stats.compressed_bytes(), Gt(0));
+  // BAM records inflate to more than their compressed size.
+  EXPECT_THAT(stats.uncompressed_bytes(), Gt(stats.compressed_bytes()));
+  EXPECT_THAT(stats.hts_nanos(), Gt(0));
+  EXPECT_THAT(stats.convert_nanos(), Gt(stats.aux_parse_nanos()));
+  EXPECT_THAT(reader->Close(), IsOK());
+}
+
+TEST_F(IoStatsTest, SamReaderCountsFilteredReads) {
+  SamReaderOptions options;
+  options.mutable_read_requirements()->set_min_mapping_quality(1000);
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData("test.bam"), options).ValueOrDie());
+  EXPECT_TRUE(as_vector(reader->Iterate()).empty());
+  EXPECT_THAT(reader->Stats().records_decoded(), Gt(0));
+  EXPECT_EQ(0, reader->Stats().records_kept());
+}
+
+TEST_F(IoStatsTest, TextReadersCountRecordsAndBytes) {
+  std::unique_ptr<BedReader> bed_reader = std::move(
+      BedReader::FromFile(GetTestData("test_regions.bed.gz"),
+                          BedReaderOptions())
+          .ValueOrDie());
+  const int64 num_records = as_vector(bed_reader->Iterate()).size();
+  const IoStatistics bed_stats = bed_reader->Stats();
+  EXPECT_EQ(num_records, bed_stats.records_decoded());
+  EXPECT_EQ(num_records, bed_stats.records_kept());
+  EXPECT_THAT(bed_stats.compressed_bytes(), Gt(0));
+  EXPECT_THAT(bed_stats.uncompressed_bytes(), Gt(0));
+  EXPECT_THAT(bed_stats.hts_nanos(), Gt(0));
+
+  std::unique_ptr<FastqReader> fastq_reader = std::move(
+      FastqReader::FromFile(GetTestData("test_reads.fastq"),
+                            FastqReaderOptions())
+          .ValueOrDie());
+  const int64 num_reads = as_vector(fastq_reader->Iterate()).size();
+  const IoStatistics fastq_stats = fastq_reader->Stats();
+  EXPECT_EQ(num_reads, fastq_stats.records_kept());
+  // The file is uncompressed.
+  EXPECT_EQ(fastq_stats.compressed_bytes(), fastq_stats.uncompressed_bytes());
+  EXPECT_THAT(fastq_stats.uncompressed_bytes(), Gt(0));
+}
+
+// Returns the size of the file at path.
+int64 FileSize(const string& path) {
+  uint64 size;
+  TF_CHECK_OK(tensorflow::Env::Default()->GetFileSize(path, &size));
+  return size;
+}
+
+TEST_F(IoStatsTest, TextWritersCountRecordsAndBytes) {
+  const string fastq_path = MakeTempFile("stats.fastq");
+  std::unique_ptr<FastqWriter> fastq_writer = std::move(
+      FastqWriter::ToFile(fastq_path, FastqWriterOptions()).ValueOrDie());
+  FastqRecord read;
+  read.set_id("read");
+  read.set_sequence("ACGT");
+  read.set_quality("ABCD");
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_THAT(fastq_writer->Write(read), IsOK());
+  }
+  ASSERT_THAT(fastq_writer->Close(), IsOK());
+  const IoStatistics fastq_stats = fastq_writer->Stats();
+  EXPECT_EQ(3, fastq_stats.records_decoded());
+  // The file is uncompressed, and its text was all flushed on closing.
+  EXPECT_EQ(FileSize(fastq_path), fastq_stats.uncompressed_bytes());
+  EXPECT_EQ(FileSize(fastq_path), fastq_stats.compressed_bytes());
+
+  const string bedgraph_path = MakeTempFile("stats.bedgraph");
+  std::unique_ptr<BedGraphWriter> bedgraph_writer =
+      std::move(BedGraphWriter::ToFile(bedgraph_path).ValueOrDie());
+  BedGraphRecord record;
+  record.set_reference_name("chr1");
+  record.set_end(10);
+  ASSERT_THAT(bedgraph_writer->Write(record), IsOK());
+  ASSERT_THAT(bedgraph_writer->Close(), IsOK());
+  const IoStatistics bedgraph_stats = bedgraph_writer->Stats();
+  EXPECT_EQ(1, bedgraph_stats.records_decoded());
+  EXPECT_EQ(FileSize(bedgraph_path), bedgraph_stats.uncompressed_bytes());
+}
+
+TEST_F(IoStatsTest, TFRecordsCountRecordsAndBytes) {
+  const std::vector<string> records = {"a", "bb", "ccc"};
+  // Each record is framed by a 12 byte header and a 4 byte footer.
+  const int64 uncompressed_bytes = 3 * 16 + 6;
+  for (const char* compression_type : {"", "GZIP"}) {
+    const string path = MakeTempFile("stats.tfrecord");
+    std::unique_ptr<TFRecordWriter> writer =
+        TFRecordWriter::New(path, compression_type);
+    ASSERT_NE(writer, nullptr);
+    for (const string& record : records) {
+      ASSERT_TRUE(writer->WriteRecord(record));
+    }
+    ASSERT_TRUE(writer->Close());
+    const IoStatistics written = writer->Stats();
+    EXPECT_EQ(3, written.records_decoded());
+    EXPECT_EQ(uncompressed_bytes, written.uncompressed_bytes());
+    EXPECT_EQ(FileSize(path), written.compressed_bytes());
+
+    std::unique_ptr<TFRecordReader> reader =
+        TFRecordReader::New(path, compression_type);
+    ASSERT_NE(reader, nullptr);
+    while (reader->GetNext()) {
+    }
+    reader->Close();
+    const IoStatistics read = reader->Stats();
+    EXPECT_EQ(3, read.records_decoded());
+    EXPECT_EQ(3, read.records_kept());
+    EXPECT_EQ(uncompressed_bytes, read.uncompressed_bytes());
+    EXPECT_EQ(FileSize(path), read.compressed_bytes());
+  }
+}
+
+TEST(IoStatsDisabledTest, ReadersCollectNothing) {
+  ASSERT_FALSE(IoStatsEnabled());
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData("test.bam"), SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_FALSE(as_vector(reader->Iterate()).empty());
+  EXPECT_THAT(reader->Stats(), EqualsProto(IoStatistics()));
+}
+
+}  // namespace nucleus
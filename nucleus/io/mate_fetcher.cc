@@ -0,0 +1,164 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of mate_fetcher.h
+#include "nucleus/io/mate_fetcher.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::MateFetcherOptions;
+using genomics::v1::Read;
+
+namespace {
+
+constexpr int64 kDefaultMaxGap = 1000;
+constexpr int64 kDefaultMaxWindowSize = 100000;
+constexpr int kDefaultMaxCachedWindows = 16;
+
+// Returns true if candidate is the mate of read.
+bool IsMate(const Read& read, const Read& candidate) {
+  return candidate.fragment_name() == read.fragment_name() &&
+         candidate.read_number() ==
+             (read.read_number() + 1) % std::max(read.number_reads(), 1) &&
+         candidate.alignment().position().reverse_strand() ==
+             read.next_mate_position().reverse_strand();
+}
+
+}  // namespace
+
+MateFetcher::MateFetcher(const SamReader* reader,
+                         const MateFetcherOptions& options)
+    : reader_(reader),
+      max_gap_(options.max_gap() > 0 ? options.max_gap() : kDefaultMaxGap),
+      max_window_size_(options.max_window_size() > 0
+                           ? options.max_window_size()
+                           : kDefaultMaxWindowSize),
+      max_cached_windows_(options.max_cached_windows() > 0
+                              ? options.max_cached_windows()
+                              : kDefaultMaxCachedWindows) {}
+
+tf::Status MateFetcher::GetWindow(const string& reference_name, int64 start,
+                                  int64 end, const Window** window) {
+  for (auto it = windows_.begin(); it != windows_.end(); ++it) {
+    if (it->range.reference_name() == reference_name &&
+        it->range.start() <= start && end <= it->range.end()) {
+      windows_.splice(windows_.begin(), windows_, it);
+      *window = &windows_.front();
+      return tf::Status::OK();
+    }
+  }
+
+  Window fetched;
+  fetched.range = MakeRange(reference_name, start, end);
+  ++num_queries_;
+  StatusOr<std::shared_ptr<SamIterable>> reads = reader_->Query(fetched.range);
+  TF_RETURN_IF_ERROR(reads.status());
+  if (reads.ValueOrDie() == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot fetch mates while the SamReader is being iterated");
+  }
+  Read read;
+  while (true) {
+    StatusOr<bool> more = reads.ValueOrDie()->Next(&read);
+    TF_RETURN_IF_ERROR(more.status());
+    if (!more.ValueOrDie()) break;
+    // Only primary alignments starting in the window can be mates; the query
+    // also returns reads overlapping it from further left.
+    if (ReadStart(read) >= start && !read.secondary_alignment() &&
+        !read.supplementary_alignment()) {
+      fetched.reads.push_back(std::move(read));
+    }
+  }
+
+  windows_.push_front(std::move(fetched));
+  if (windows_.size() > max_cached_windows_) {
+    windows_.pop_back();
+  }
+  *window = &windows_.front();
+  return tf::Status::OK();
+}
+
+tf::Status MateFetcher::FetchMates(absl::Span<const Read> reads,
+                                   std::vector<absl::optional<Read>>* mates) {
+  mates->assign(reads.size(), absl::nullopt);
+
+  // The reads with a mapped mate, ordered by mate position.
+  std::vector<size_t> order;
+  for (size_t i = 0; i < reads.size(); ++i) {
+    if (reads[i].has_next_mate_position()) {
+      order.push_back(i);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&reads](size_t a, size_t b) {
+    const auto& pa = reads[a].next_mate_position();
+    const auto& pb = reads[b].next_mate_position();
+    return pa.reference_name() != pb.reference_name()
+               ? pa.reference_name() < pb.reference_name()
+               : pa.position() < pb.position();
+  });
+
+  size_t first = 0;
+  while (first < order.size()) {
+    // Extend the window over mates close to the previous one.
+    const auto& first_position = reads[order[first]].next_mate_position();
+    const int64 start = first_position.position();
+    int64 end = start + 1;
+    size_t last = first + 1;
+    for (; last < order.size(); ++last) {
+      const auto& position = reads[order[last]].next_mate_position();
+      if (position.reference_name() != first_position.reference_name() ||
+          position.position() >= end + max_gap_ ||
+          position.position() + 1 - start > max_window_size_) {
+        break;
+      }
+      end = position.position() + 1;
+    }
+
+    const Window* window;
+    TF_RETURN_IF_ERROR(
+        GetWindow(first_position.reference_name(), start, end, &window));
+    for (size_t i = first; i < last; ++i) {
+      const Read& read = reads[order[i]];
+      const int64 mate_start = read.next_mate_position().position();
+      auto it = std::lower_bound(
+          window->reads.begin(), window->reads.end(), mate_start,
+          [](const Read& r, int64 position) {
+            return ReadStart(r) < position;
+          });
+      for (; it != window->reads.end() && ReadStart(*it) == mate_start; ++it) {
+        if (IsMate(read, *it)) {
+          (*mates)[order[i]] = *it;
+          break;
+        }
+      }
+    }
+    first = last;
+  }
+  return tf::Status::OK();
+}
+
+}  // namespace nucleus
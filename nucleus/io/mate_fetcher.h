@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef THIRD_PARTY_NUCLEUS_IO_MATE_FETCHER_H_
+#define THIRD_PARTY_NUCLEUS_IO_MATE_FETCHER_H_
+
+#include <list>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/protos/reads.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+// Fetches the mates of reads from an indexed SamReader in batches.
+//
+// Querying the reader once per mate position re-reads and re-decodes the same
+// BGZF blocks whenever mates lie close together. Instead, the mate positions
+// of a batch are sorted and merged into query windows, each window is queried
+// once, and the reads of the most recently queried windows are cached so that
+// later batches over nearby mates need not query again.
+//
+// The mate of a read is the primary alignment with the same fragment_name and
+// the next read_number, starting at the read's next_mate_position. The
+// reader's options apply, so a mate filtered out by the reader is not found.
+class MateFetcher {
+ public:
+  // Creates a MateFetcher querying reader, which must have an index and
+  // outlive the MateFetcher. The reader must not be iterated while FetchMates
+  // runs.
+  MateFetcher(const SamReader* reader,
+              const nucleus::genomics::v1::MateFetcherOptions& options);
+
+  // Disable copy and assignment operations.
+  MateFetcher(const MateFetcher& other) = delete;
+  MateFetcher& operator=(const MateFetcher&) = delete;
+
+  // Replaces *mates with the mate of each of reads, or nullopt for reads
+  // without a mapped mate and for mates that are not found.
+  tensorflow::Status FetchMates(
+      absl::Span<const nucleus::genomics::v1::Read> reads,
+      std::vector<absl::optional<nucleus::genomics::v1::Read>>* mates);
+
+  // The number of queries made of the reader so far.
+  int64 NumQueries() const { return num_queries_; }
+
+ private:
+  // The primary alignments starting in a queried window, by position.
+  struct Window {
+    nucleus::genomics::v1::Range range;
+    std::vector<nucleus::genomics::v1::Read> reads;
+  };
+
+  // Returns a window covering [start, end) of reference_name, from the cache
+  // or by querying the reader.
+  tensorflow::Status GetWindow(const string& reference_name, int64 start,
+                               int64 end, const Window** window);
+
+  const SamReader* reader_;
+  const int64 max_gap_;
+  const int64 max_window_size_;
+  const size_t max_cached_windows_;
+
+  // The cached windows, most recently used first.
+  std::list<Window> windows_;
+  int64 num_queries_ = 0;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_MATE_FETCHER_H_
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/mate_fetcher.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+using genomics::v1::MateFetcherOptions;
+using genomics::v1::Read;
+using genomics::v1::SamReaderOptions;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+
+constexpr char kBamTestFilename[] = "test.bam";
+
+class MateFetcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    reader_ = std::move(SamReader::FromFile(GetTestData(kBamTestFilename),
+                                            SamReaderOptions())
+                            .ValueOrDie());
+    reads_ = as_vector(reader_->Iterate());
+  }
+
+  std::unique_ptr<SamReader> reader_;
+  std::vector<Read> reads_;
+};
+
+TEST_F(MateFetcherTest, FindsMatesWithFewQueries) {
+  MateFetcher fetcher(reader_.get(), MateFetcherOptions());
+  std::vector<absl::optional<Read>> mates;
+  ASSERT_THAT(fetcher.FetchMates(reads_, &mates), IsOK());
+  ASSERT_THAT(mates.size(), Eq(reads_.size()));
+
+  int num_with_mates = 0;
+  int num_found = 0;
+  for (size_t i = 0; i < reads_.size(); ++i) {
+    const Read& read = reads_[i];
+    if (!read.has_next_mate_position()) {
+      EXPECT_FALSE(mates[i].has_value());
+      continue;
+    }
+    ++num_with_mates;
+    if (!mates[i].has_value()) continue;
+    ++num_found;
+    const Read& mate = *mates[i];
+    EXPECT_THAT(mate.fragment_name(), Eq(read.fragment_name()));
+    EXPECT_THAT(mate.read_number(), Eq(1 - read.read_number()));
+    EXPECT_THAT(mate.alignment().position().reference_name(),
+                Eq(read.next_mate_position().reference_name()));
+    EXPECT_THAT(mate.alignment().position().position(),
+                Eq(read.next_mate_position().position()));
+    EXPECT_THAT(mate.next_mate_position().position(),
+                Eq(read.alignment().position().position()));
+  }
+  EXPECT_THAT(num_found, Gt(0));
+  EXPECT_THAT(fetcher.NumQueries(), Lt(num_with_mates));
+
+  // The windows are cached, so fetching again does not query.
+  const int64 num_queries = fetcher.NumQueries();
+  ASSERT_THAT(fetcher.FetchMates(reads_, &mates), IsOK());
+  EXPECT_THAT(fetcher.NumQueries(), Eq(num_queries));
+}
+
+TEST_F(MateFetcherTest, LimitsWindowSize) {
+  // Windows of a single position find the same mates with more queries.
+  MateFetcherOptions options;
+  options.set_max_window_size(1);
+  options.set_max_cached_windows(1);
+  MateFetcher single(reader_.get(), options);
+  std::vector<absl::optional<Read>> single_mates;
+  ASSERT_THAT(single.FetchMates(reads_, &single_mates), IsOK());
+
+  MateFetcher batched(reader_.get(), MateFetcherOptions());
+  std::vector<absl::optional<Read>> mates;
+  ASSERT_THAT(batched.FetchMates(reads_, &mates), IsOK());
+  EXPECT_THAT(batched.NumQueries(), Lt(single.NumQueries()));
+  ASSERT_THAT(single_mates.size(), Eq(mates.size()));
+  for (size_t i = 0; i < mates.size(); ++i) {
+    ASSERT_THAT(single_mates[i].has_value(), Eq(mates[i].has_value()));
+    if (mates[i].has_value()) {
+      EXPECT_THAT(single_mates[i]->fragment_name(),
+                  Eq(mates[i]->fragment_name()));
+    }
+  }
+}
+
+TEST_F(MateFetcherTest, FailsWhileReaderIsIterated) {
+  MateFetcher fetcher(reader_.get(), MateFetcherOptions());
+  auto iterable = reader_->Iterate();
+  std::vector<absl::optional<Read>> mates;
+  EXPECT_THAT(fetcher.FetchMates(reads_, &mates),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
+}  // namespace nucleus
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of parallel_region_executor.h
+#include "nucleus/io/parallel_region_executor.h"
+
+#include "nucleus/util/utils.h"
+
+namespace nucleus {
+
+using genomics::v1::Range;
+
+std::vector<Range> PartitionRegions(absl::Span<const Range> regions,
+                                    int64 partition_size) {
+  std::vector<Range> partitions;
+  for (const Range& region : regions) {
+    if (partition_size <= 0) {
+      partitions.push_back(region);
+      continue;
+    }
+    for (int64 start = region.start(); start < region.end();
+         start += partition_size) {
+      partitions.push_back(
+          MakeRange(region.reference_name(), start,
+                    std::min<int64>(start + partition_size, region.end())));
+    }
+  }
+  return partitions;
+}
+
+}  // namespace nucleus
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Runs a function over the regions of a genome on several threads, each with
+// readers of its own, and hands back the results in the order of the regions.
+#ifndef THIRD_PARTY_NUCLEUS_IO_PARALLEL_REGION_EXECUTOR_H_
+#define THIRD_PARTY_NUCLEUS_IO_PARALLEL_REGION_EXECUTOR_H_
+
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/protos/reference.pb.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace nucleus {
+
+// Splits each of regions into consecutive regions of at most partition_size
+// bases. Regions are kept whole if partition_size <= 0.
+std::vector<nucleus::genomics::v1::Range> PartitionRegions(
+    absl::Span<const nucleus::genomics::v1::Range> regions,
+    int64 partition_size);
+
+// Splits each of contigs, a container of ContigInfo such as the contigs of a
+// SamHeader or VcfHeader or of a GenomeReference, into regions of at most
+// partition_size bases, in the order of contigs.
+template <class Contigs>
+std::vector<nucleus::genomics::v1::Range> PartitionContigs(
+    const Contigs& contigs, int64 partition_size) {
+  std::vector<nucleus::genomics::v1::Range> regions;
+  for (const nucleus::genomics::v1::ContigInfo& contig : contigs) {
+    nucleus::genomics::v1::Range range;
+    range.set_reference_name(contig.name());
+    range.set_start(0);
+    range.set_end(contig.n_bases());
+    regions.push_back(std::move(range));
+  }
+  return PartitionRegions(regions, partition_size);
+}
+
+namespace parallel_region_internal {
+
+// Hands out region indices to worker threads and collects their results,
+// keeping the workers no more than max_ahead regions ahead of the consumer so
+// that the buffered results stay bounded.
+template <class Result>
+class ShardQueue {
+ public:
+  ShardQueue(size_t num_regions, size_t max_ahead)
+      : results_(num_regions), max_ahead_(std::max<size_t>(max_ahead, 1)) {}
+
+  // Returns the next region to process, or -1 once there are none left.
+  int64 Take() {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(this, &ShardQueue::CanTake));
+    if (cancelled_ || next_region_ >= results_.size()) return -1;
+    return next_region_++;
+  }
+
+  // Records the outcome of processing region i.
+  void Finish(size_t i, Result result, const tensorflow::Status& status) {
+    absl::MutexLock lock(&mutex_);
+    results_[i].result = std::move(result);
+    results_[i].status = status;
+    results_[i].done = true;
+  }
+
+  // Waits for region i, moves its result to *result and returns its status.
+  tensorflow::Status Wait(size_t i, Result* result) {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(&results_[i].done));
+    *result = std::move(results_[i].result);
+    results_[i].result = Result();
+    next_output_ = i + 1;
+    return results_[i].status;
+  }
+
+  // Stops handing out regions.
+  void Cancel() {
+    absl::MutexLock lock(&mutex_);
+    cancelled_ = true;
+  }
+
+ private:
+  struct Slot {
+    Result result{};
+    tensorflow::Status status;
+    bool done = false;
+  };
+
+  bool CanTake() const {
+    return cancelled_ || next_region_ >= results_.size() ||
+           next_region_ < next_output_ + max_ahead_;
+  }
+
+  absl::Mutex mutex_;
+  std::vector<Slot> results_;
+  const size_t max_ahead_;
+  size_t next_region_ = 0;
+  size_t next_output_ = 0;
+  bool cancelled_ = false;
+};
+
+}  // namespace parallel_region_internal
+
+// Maps a function over regions in parallel, reducing the results in order.
+//
+// Readers is whatever a shard needs to read its region: a single reader such
+// as std::unique_ptr<SamReader>, or a struct or tuple of several. Each worker
+// thread opens its own Readers once, with the factory, and reuses them for
+// every region it takes, so readers are never shared between threads.
+// Workers take the next unprocessed region as soon as they finish one, so
+// slow regions do not hold up the others, but never run more than
+// max_regions_ahead regions ahead of the consumer, which bounds the memory
+// held by finished results waiting for an earlier region.
+//
+// For example, counting the reads of a BAM file in 10 Mb shards:
+//
+//   ParallelRegionExecutor<std::unique_ptr<SamReader>, int64> executor(
+//       [&]() { return SamReader::FromFile(path, options); }, 8);
+//   int64 total = 0;
+//   TF_RETURN_IF_ERROR(executor.Run(
+//       PartitionContigs(header.contigs(), 10000000),
+//       [](std::unique_ptr<SamReader>* reader, const Range& region,
+//          int64* count) { ... },
+//       [&total](const Range& region, int64* count) {
+//         total += *count;
+//         return tf::Status::OK();
+//       }));
+template <class Readers, class Result>
+class ParallelRegionExecutor {
+ public:
+  // Opens the readers of one worker.
+  using ReaderFactory = std::function<StatusOr<Readers>()>;
+  // Processes region into *result, which starts out value-initialized, so
+  // zero for scalar Results.
+  using ShardFunction = std::function<tensorflow::Status(
+      Readers* readers, const nucleus::genomics::v1::Range& region,
+      Result* result)>;
+  // Consumes the result of region.
+  using ResultConsumer = std::function<tensorflow::Status(
+      const nucleus::genomics::v1::Range& region, Result* result)>;
+
+  // Creates an executor running num_threads workers, or processing the
+  // regions on the calling thread if num_threads <= 0. max_regions_ahead
+  // defaults to twice the number of threads if <= 0.
+  ParallelRegionExecutor(ReaderFactory open_readers, int num_threads,
+                         int max_regions_ahead = 0)
+      : open_readers_(std::move(open_readers)),
+        num_threads_(num_threads),
+        max_regions_ahead_(max_regions_ahead > 0 ? max_regions_ahead
+                                                 : 2 * num_threads) {}
+
+  // Processes every region, calling consume on the calling thread with the
+  // result of each region in the order of regions. Stops at, and returns, the
+  // first error from opening readers, process or consume, in the order of
+  // regions; the results of later regions are then discarded.
+  tensorflow::Status Run(absl::Span<const nucleus::genomics::v1::Range> regions,
+                         const ShardFunction& process,
+                         const ResultConsumer& consume) const {
+    if (num_threads_ <= 0 || regions.size() <= 1) {
+      return RunSequentially(regions, process, consume);
+    }
+
+    parallel_region_internal::ShardQueue<Result> shards(regions.size(),
+                                                        max_regions_ahead_);
+    std::vector<std::thread> threads;
+    const int num_threads =
+        std::min<int>(num_threads_, static_cast<int>(regions.size()));
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([this, &regions, &process, &shards]() {
+        StatusOr<Readers> readers = open_readers_();
+        for (int64 i = shards.Take(); i >= 0; i = shards.Take()) {
+          Result result{};
+          tensorflow::Status status = readers.status();
+          if (status.ok()) {
+            status = process(&readers.ValueOrDie(), regions[i], &result);
+          }
+          shards.Finish(i, std::move(result), status);
+        }
+      });
+    }
+
+    tensorflow::Status status;
+    Result result{};
+    for (size_t i = 0; i < regions.size() && status.ok(); ++i) {
+      status = shards.Wait(i, &result);
+      if (status.ok()) {
+        status = consume(regions[i], &result);
+      }
+    }
+    shards.Cancel();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    return status;
+  }
+
+  // Processes every region, returning the results in the order of regions.
+  StatusOr<std::vector<Result>> Map(
+      absl::Span<const nucleus::genomics::v1::Range> regions,
+      const ShardFunction& process) const {
+    std::vector<Result> results;
+    results.reserve(regions.size());
+    TF_RETURN_IF_ERROR(Run(
+        regions, process,
+        [&results](const nucleus::genomics::v1::Range& region,
+                   Result* result) {
+          results.push_back(std::move(*result));
+          return tensorflow::Status::OK();
+        }));
+    return std::move(results);
+  }
+
+ private:
+  tensorflow::Status RunSequentially(
+      absl::Span<const nucleus::genomics::v1::Range> regions,
+      const ShardFunction& process, const ResultConsumer& consume) const {
+    if (regions.empty()) return tensorflow::Status::OK();
+    StatusOr<Readers> readers = open_readers_();
+    TF_RETURN_IF_ERROR(readers.status());
+    for (const nucleus::genomics::v1::Range& region : regions) {
+      Result result{};
+      TF_RETURN_IF_ERROR(process(&readers.ValueOrDie(), region, &result));
+      TF_RETURN_IF_ERROR(consume(region, &result));
+    }
+    return tensorflow::Status::OK();
+  }
+
+  const ReaderFactory open_readers_;
+  const int num_threads_;
+  const int max_regions_ahead_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_PARALLEL_REGION_EXECUTOR_H_
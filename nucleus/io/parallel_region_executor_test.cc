@@ -0,0 +1,201 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/parallel_region_executor.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/util/utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+using genomics::v1::ContigInfo;
+using genomics::v1::Range;
+using genomics::v1::SamReaderOptions;
+using ::testing::ElementsAre;
+using ::testing::Le;
+using ::testing::Pointwise;
+using ::testing::SizeIs;
+
+// The readers of the tests below: just the number of the worker.
+using WorkerId = std::unique_ptr<int>;
+
+std::vector<Range> ManyRegions(int n) {
+  std::vector<Range> regions;
+  for (int i = 0; i < n; ++i) {
+    regions.push_back(MakeRange("chr1", 10 * i, 10 * i + 10));
+  }
+  return regions;
+}
+
+TEST(PartitionRegionsTest, SplitsRegions) {
+  const std::vector<Range> regions = {MakeRange("chr1", 0, 25),
+                                      MakeRange("chr2", 5, 10)};
+  EXPECT_THAT(PartitionRegions(regions, 10),
+              Pointwise(EqualsProto(), std::vector<Range>{
+                                           MakeRange("chr1", 0, 10),
+                                           MakeRange("chr1", 10, 20),
+                                           MakeRange("chr1", 20, 25),
+                                           MakeRange("chr2", 5, 10)}));
+  EXPECT_THAT(PartitionRegions(regions, 0), Pointwise(EqualsProto(), regions));
+}
+
+TEST(PartitionRegionsTest, PartitionsContigs) {
+  std::vector<ContigInfo> contigs(2);
+  contigs[0].set_name("chr1");
+  contigs[0].set_n_bases(15);
+  contigs[1].set_name("chr2");
+  contigs[1].set_n_bases(5);
+  EXPECT_THAT(PartitionContigs(contigs, 10),
+              Pointwise(EqualsProto(), std::vector<Range>{
+                                           MakeRange("chr1", 0, 10),
+                                           MakeRange("chr1", 10, 15),
+                                           MakeRange("chr2", 0, 5)}));
+}
+
+class ParallelRegionExecutorTest : public ::testing::TestWithParam<int> {
+ protected:
+  ParallelRegionExecutor<WorkerId, int64>::ReaderFactory OpenWorker() {
+    return [this]() -> StatusOr<WorkerId> {
+      return WorkerId(new int(num_opened_++));
+    };
+  }
+
+  std::atomic<int> num_opened_{0};
+};
+
+TEST_P(ParallelRegionExecutorTest, ReturnsResultsInOrder) {
+  const std::vector<Range> regions = ManyRegions(100);
+  ParallelRegionExecutor<WorkerId, int64> executor(OpenWorker(), GetParam());
+  StatusOr<std::vector<int64>> starts = executor.Map(
+      regions, [](WorkerId* worker, const Range& region, int64* start) {
+        *start = region.start();
+        return tf::Status::OK();
+      });
+  ASSERT_THAT(starts, IsOK());
+  ASSERT_THAT(starts.ValueOrDie(), SizeIs(regions.size()));
+  for (size_t i = 0; i < regions.size(); ++i) {
+    EXPECT_EQ(regions[i].start(), starts.ValueOrDie()[i]);
+  }
+  // Each worker opens its readers once.
+  EXPECT_THAT(num_opened_.load(), Le(std::max(GetParam(), 1)));
+}
+
+TEST_P(ParallelRegionExecutorTest, StaysBoundedAheadOfConsumer) {
+  const int max_ahead = 3;
+  ParallelRegionExecutor<WorkerId, int64> executor(OpenWorker(), GetParam(),
+                                                   max_ahead);
+  std::atomic<int64> num_consumed(0);
+  std::atomic<int64> max_distance(0);
+  ASSERT_THAT(
+      executor.Run(
+          ManyRegions(50),
+          [&](WorkerId* worker, const Range& region, int64* index) {
+            *index = region.start() / 10;
+            const int64 distance = *index - num_consumed.load();
+            int64 seen = max_distance.load();
+            while (distance > seen &&
+                   !max_distance.compare_exchange_weak(seen, distance)) {
+            }
+            return tf::Status::OK();
+          },
+          [&](const Range& region, int64* index) {
+            EXPECT_EQ(num_consumed.load(), *index);
+            ++num_consumed;
+            return tf::Status::OK();
+          }),
+      IsOK());
+  EXPECT_EQ(50, num_consumed.load());
+  EXPECT_THAT(max_distance.load(), Le(max_ahead));
+}
+
+TEST_P(ParallelRegionExecutorTest, StopsAtFirstErrorInOrder) {
+  ParallelRegionExecutor<WorkerId, int64> executor(OpenWorker(), GetParam());
+  std::vector<int64> consumed;
+  EXPECT_THAT(
+      executor.Run(
+          ManyRegions(20),
+          [](WorkerId* worker, const Range& region, int64* index) {
+            *index = region.start() / 10;
+            if (*index == 7 || *index == 12) {
+              return tf::errors::DataLoss("Bad region ", *index);
+            }
+            return tf::Status::OK();
+          },
+          [&consumed](const Range& region, int64* index) {
+            consumed.push_back(*index);
+            return tf::Status::OK();
+          }),
+      IsNotOKWithMessage("Bad region 7"));
+  EXPECT_THAT(consumed, ElementsAre(0, 1, 2, 3, 4, 5, 6));
+}
+
+TEST_P(ParallelRegionExecutorTest, PropagatesReaderErrors) {
+  ParallelRegionExecutor<WorkerId, int64> executor(
+      []() -> StatusOr<WorkerId> {
+        return tf::errors::NotFound("No such file");
+      },
+      GetParam());
+  EXPECT_THAT(executor.Map(ManyRegions(5),
+                           [](WorkerId* worker, const Range& region,
+                              int64* result) { return tf::Status::OK(); }),
+              IsNotOKWithCode(tf::error::NOT_FOUND));
+}
+
+TEST_P(ParallelRegionExecutorTest, CountsReadsOfBamShards) {
+  const string path = GetTestData("test.bam");
+  const std::vector<Range> regions =
+      PartitionRegions({MakeRange("chr20", 9999000, 10003000)}, 500);
+  ParallelRegionExecutor<std::unique_ptr<SamReader>, int64> executor(
+      [&path]() { return SamReader::FromFile(path, SamReaderOptions()); },
+      GetParam());
+  StatusOr<std::vector<int64>> counts = executor.Map(
+      regions,
+      [](std::unique_ptr<SamReader>* reader, const Range& region,
+         int64* count) {
+        *count = as_vector((*reader)->Query(region)).size();
+        return tf::Status::OK();
+      });
+  ASSERT_THAT(counts, IsOK());
+
+  std::unique_ptr<SamReader> reader =
+      std::move(SamReader::FromFile(path, SamReaderOptions()).ValueOrDie());
+  ASSERT_THAT(counts.ValueOrDie(), SizeIs(regions.size()));
+  for (size_t i = 0; i < regions.size(); ++i) {
+    EXPECT_EQ(as_vector(reader->Query(regions[i])).size(),
+              counts.ValueOrDie()[i]);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(Threads, ParallelRegionExecutorTest,
+                        ::testing::Values(0, 1, 4));
+
+}  // namespace nucleus
@@ -21,6 +21,7 @@ from absl.testing import absltest
 from absl.testing import parameterized
 
 from nucleus.io import clif_postproc
+from nucleus.io.python import io_stats
 from nucleus.io.python import sam_reader
 from nucleus.protos import reads_pb2
 from nucleus.protos import reference_pb2
@@ -53,6 +54,42 @@ class SamReaderTest(parameterized.TestCase):
           self.assertIsInstance(iterable, clif_postproc.WrappedCppIterable)
           self.assertEqual(test_utils.iterable_len(iterable), n_expected)
 
+  def test_bam_seek_resumes_at_tell(self):
+    reader = sam_reader.SamReader.from_file(
+        reads_path=self.bam, ref_path='', options=self.options)
+    with reader:
+      with reader.iterate() as iterable:
+        for _ in range(10):
+          next(iterable)
+        offset = iterable.tell()
+        rest = list(iterable)
+      with reader.iterate() as iterable:
+        iterable.seek(offset)
+        self.assertEqual(list(iterable), rest)
+      self.assertLen(rest, 96)
+
+  def test_bam_index_statistics(self):
+    reader = sam_reader.SamReader.from_file(
+        reads_path=self.bam, ref_path='', options=self.options)
+    with reader:
+      stats = reader.index_statistics()
+      counts = {contig.name: (contig.n_mapped, contig.n_unmapped)
+                for contig in stats.contigs if contig.n_mapped}
+      self.assertEqual(counts, {'chr20': (105, 1)})
+      self.assertEqual(stats.n_no_coordinate, 0)
+
+  def test_bam_io_statistics(self):
+    io_stats.set_enabled(True)
+    self.addCleanup(io_stats.set_enabled, False)
+    reader = sam_reader.SamReader.from_file(
+        reads_path=self.bam, ref_path='', options=self.options)
+    with reader:
+      self.assertEqual(test_utils.iterable_len(reader.iterate()), 106)
+      stats = reader.io_statistics()
+      self.assertEqual(stats.records_decoded, 106)
+      self.assertEqual(stats.records_kept, 106)
+      self.assertGreater(stats.uncompressed_bytes, stats.compressed_bytes)
+
   def test_bam_samples(self):
     reader = sam_reader.SamReader.from_file(
         reads_path=self.bam, ref_path='', options=self.options)
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of read_name_index.h
+#include "nucleus/io/read_name_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "htslib/bgzf.h"
+#include "htslib/hts.h"
+#include "htslib/sam.h"
+#include "nucleus/io/file_util.h"
+#include "nucleus/io/hts_path.h"
+#include "nucleus/util/parallel_sort.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+namespace tf = tensorflow;
+
+namespace {
+
+// The size of an encoded entry and of the footer.
+constexpr size_t kEntrySize = 16;
+constexpr size_t kFooterSize = 24 + read_name_index::kMagicSize;
+
+// Names read name indexes in the errors of ReadExactly.
+constexpr char kFileKind[] = "Read name index";
+
+// A name hash and the virtual offset of a record with that name.
+using Entry = std::pair<uint64, uint64>;
+
+// Reads the name hash and virtual offset of every record of the BAM file fp.
+tf::Status ReadEntries(htsFile* fp, std::vector<Entry>* entries) {
+  bam_hdr_t* header = sam_hdr_read(fp);
+  if (header == nullptr) {
+    return tf::errors::DataLoss("Could not read the header of ", fp->fn);
+  }
+  bam1_t* b = bam_init1();
+  tf::Status status;
+  while (true) {
+    const uint64 offset = bgzf_tell(fp->fp.bgzf);
+    const int code = sam_read1(fp, header, b);
+    if (code == -1) break;
+    if (code < -1) {
+      status = tf::errors::DataLoss("Failed to parse BAM record in ", fp->fn);
+      break;
+    }
+    entries->emplace_back(ReadNameHash(bam_get_qname(b)), offset);
+  }
+  bam_destroy1(b);
+  bam_hdr_destroy(header);
+  return status;
+}
+
+// Writes the index of the sorted entries of the BAM file with bam_stats to
+// path.
+tf::Status WriteIndex(const std::vector<Entry>& entries,
+                      const tf::FileStatistics& bam_stats,
+                      const string& path) {
+  std::unique_ptr<tf::WritableFile> file;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->NewWritableFile(path, &file));
+  string buffer(read_name_index::kMagic, read_name_index::kMagicSize);
+  for (const Entry& entry : entries) {
+    tf::core::PutFixed64(&buffer, entry.first);
+    tf::core::PutFixed64(&buffer, entry.second);
+    if (buffer.size() >= (1 << 20)) {
+      TF_RETURN_IF_ERROR(file->Append(buffer));
+      buffer.clear();
+    }
+  }
+  for (size_t i = 0; i < entries.size();
+       i += read_name_index::kEntriesPerBlock) {
+    tf::core::PutFixed64(&buffer, entries[i].first);
+  }
+  tf::core::PutFixed64(&buffer, entries.size());
+  tf::core::PutFixed64(&buffer, bam_stats.length);
+  tf::core::PutFixed64(&buffer, bam_stats.mtime_nsec);
+  buffer.append(read_name_index::kMagic, read_name_index::kMagicSize);
+  TF_RETURN_IF_ERROR(file->Append(buffer));
+  return file->Close();
+}
+
+}  // namespace
+
+uint64 ReadNameHash(absl::string_view fragment_name) {
+  return tf::Hash64(fragment_name.data(), fragment_name.size());
+}
+
+tf::Status BuildReadNameIndex(const string& bam_path, const string& index_path,
+                              int num_threads) {
+  // Taken before reading, so that the index of a BAM file modified meanwhile
+  // is stale.
+  tf::FileStatistics bam_stats;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->Stat(bam_path, &bam_stats));
+  htsFile* fp = hts_open_x(bam_path, "r");
+  if (fp == nullptr) {
+    return tf::errors::NotFound("Could not open ", bam_path);
+  }
+  std::vector<Entry> entries;
+  tf::Status status;
+  if (fp->format.format != bam) {
+    status = tf::errors::InvalidArgument(
+        "Read name indexes can only be built for BAM files, not ", bam_path);
+  } else {
+    if (num_threads > 0 && hts_set_threads(fp, num_threads) != 0) {
+      LOG(WARNING) << "Could not use " << num_threads << " threads to read "
+                   << bam_path;
+    }
+    status = ReadEntries(fp, &entries);
+  }
+  if (hts_close(fp) < 0 && status.ok()) {
+    status = tf::errors::Internal("hts_close() failed on ", bam_path);
+  }
+  TF_RETURN_IF_ERROR(status);
+  ParallelSort(entries.begin(), entries.end(), num_threads);
+  return WriteIndex(entries, bam_stats, index_path);
+}
+
+StatusOr<std::unique_ptr<ReadNameIndex>> ReadNameIndex::FromFile(
+    const string& path, const string& bam_path) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->GetFileSize(path, &file_size));
+  std::unique_ptr<tf::RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->NewRandomAccessFile(path, &file));
+
+  const absl::string_view magic(read_name_index::kMagic,
+                                read_name_index::kMagicSize);
+  string scratch;
+  absl::string_view data;
+  if (file_size < read_name_index::kMagicSize + kFooterSize) {
+    return tf::errors::DataLoss(path, " is too small to be a read name index");
+  }
+  TF_RETURN_IF_ERROR(
+      ReadExactly(*file, 0, magic.size(), kFileKind, &scratch, &data));
+  if (data != magic) {
+    return tf::errors::DataLoss(path, " is not a read name index");
+  }
+  TF_RETURN_IF_ERROR(ReadExactly(*file, file_size - kFooterSize, kFooterSize,
+                                 kFileKind, &scratch, &data));
+  if (data.substr(24) != magic) {
+    return tf::errors::DataLoss(path, " has a corrupt footer");
+  }
+  const uint64 num_entries = tf::core::DecodeFixed64(data.data());
+  tf::FileStatistics bam_stats;
+  TF_RETURN_IF_ERROR(tf::Env::Default()->Stat(bam_path, &bam_stats));
+  if (tf::core::DecodeFixed64(data.data() + 8) !=
+          static_cast<uint64>(bam_stats.length) ||
+      tf::core::DecodeFixed64(data.data() + 16) !=
+          static_cast<uint64>(bam_stats.mtime_nsec)) {
+    return tf::errors::FailedPrecondition(
+        path, " is stale: ", bam_path,
+        " has changed since it was indexed, so the index must be rebuilt");
+  }
+  const uint64 num_blocks =
+      (num_entries + read_name_index::kEntriesPerBlock - 1) /
+      read_name_index::kEntriesPerBlock;
+  const uint64 entries_end =
+      read_name_index::kMagicSize + num_entries * kEntrySize;
+  if (num_entries > file_size / kEntrySize ||
+      entries_end + num_blocks * 8 + kFooterSize != file_size) {
+    return tf::errors::DataLoss(path, " has a size inconsistent with its ",
+                                num_entries, " entries");
+  }
+
+  TF_RETURN_IF_ERROR(
+      ReadExactly(*file, entries_end, num_blocks * 8, kFileKind, &scratch,
+                  &data));
+  std::vector<uint64> fences(num_blocks);
+  for (uint64 i = 0; i < num_blocks; ++i) {
+    fences[i] = tf::core::DecodeFixed64(data.data() + 8 * i);
+  }
+  if (!std::is_sorted(fences.begin(), fences.end())) {
+    return tf::errors::DataLoss(path, " has unsorted blocks");
+  }
+  return absl::WrapUnique(
+      new ReadNameIndex(std::move(file), num_entries, std::move(fences)));
+}
+
+ReadNameIndex::ReadNameIndex(std::unique_ptr<tf::RandomAccessFile> file,
+                             int64 num_entries, std::vector<uint64> fences)
+    : file_(std::move(file)),
+      num_entries_(num_entries),
+      fences_(std::move(fences)) {}
+
+tf::Status ReadNameIndex::Lookup(absl::string_view fragment_name,
+                                 std::vector<uint64>* offsets) const {
+  offsets->clear();
+  const uint64 hash = ReadNameHash(fragment_name);
+  // Entries with this hash start in the last block whose first hash is
+  // smaller, or in the first block if there is none, and may run on into
+  // later blocks.
+  const auto first_fence =
+      std::lower_bound(fences_.begin(), fences_.end(), hash);
+  int64 block = std::max<int64>(0, first_fence - fences_.begin() - 1);
+  string scratch;
+  absl::string_view data;
+  for (; block < static_cast<int64>(fences_.size()); ++block) {
+    if (fences_[block] > hash) break;
+    const int64 first = block * read_name_index::kEntriesPerBlock;
+    const int64 n =
+        std::min(read_name_index::kEntriesPerBlock, num_entries_ - first);
+    TF_RETURN_IF_ERROR(ReadExactly(
+        *file_, read_name_index::kMagicSize + first * kEntrySize,
+        n * kEntrySize, kFileKind, &scratch, &data));
+    for (int64 i = 0; i < n; ++i) {
+      const uint64 entry_hash =
+          tf::core::DecodeFixed64(data.data() + i * kEntrySize);
+      if (entry_hash == hash) {
+        offsets->push_back(
+            tf::core::DecodeFixed64(data.data() + i * kEntrySize + 8));
+      } else if (entry_hash > hash) {
+        return tf::Status::OK();
+      }
+    }
+  }
+  return tf::Status::OK();
+}
+
+}  // namespace nucleus
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// A sidecar index mapping fragment names to the BAM records bearing them.
+//
+// The index of foo.bam is stored in foo.bam.rni and laid out as
+//
+//   kMagic
+//   entries: (name hash, BGZF virtual offset) pairs sorted by hash, then
+//            offset
+//   fences: the hash of the first entry of every block of kEntriesPerBlock
+//           entries
+//   footer: the number of entries, the size and modification time in
+//           nanoseconds of the BAM file when it was indexed, then kMagic
+//
+// with all numbers as little-endian fixed64. A lookup binary searches the
+// fences, which are kept in memory, and then reads a single block of entries
+// in most cases. Distinct names may share a hash, so the records found must
+// still be checked against the name. An index is only opened for a BAM file
+// whose size and modification time are still those in its footer, as the
+// offsets of a rewritten BAM file would point at arbitrary data.
+#ifndef THIRD_PARTY_NUCLEUS_IO_READ_NAME_INDEX_H_
+#define THIRD_PARTY_NUCLEUS_IO_READ_NAME_INDEX_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+
+namespace nucleus {
+
+namespace read_name_index {
+
+// Identifies read name index files. Includes the terminating NUL.
+constexpr char kMagic[] = "NUCRNI\x02";
+constexpr size_t kMagicSize = sizeof(kMagic);
+
+// The suffix added to the path of a BAM file to name its index.
+constexpr char kExtension[] = ".rni";
+
+// The number of entries per block.
+constexpr int64 kEntriesPerBlock = 512;
+
+}  // namespace read_name_index
+
+// Returns the hash of fragment_name stored in read name indexes.
+uint64 ReadNameHash(absl::string_view fragment_name);
+
+// Writes the read name index of the BAM file at bam_path to index_path,
+// reading the BAM file once. If num_threads > 0, that many threads decompress
+// the BAM file and sort the entries.
+tensorflow::Status BuildReadNameIndex(const string& bam_path,
+                                      const string& index_path,
+                                      int num_threads);
+
+// An open read name index.
+class ReadNameIndex {
+ public:
+  // Opens the index at path of the BAM file at bam_path, reading only its
+  // footer and fences. Returns a FailedPrecondition status if the BAM file has
+  // changed since it was indexed.
+  static StatusOr<std::unique_ptr<ReadNameIndex>> FromFile(
+      const string& path, const string& bam_path);
+
+  // Disable copy and assignment operations.
+  ReadNameIndex(const ReadNameIndex& other) = delete;
+  ReadNameIndex& operator=(const ReadNameIndex&) = delete;
+
+  // Replaces *offsets with the virtual offsets, in increasing order, of the
+  // records whose name has the hash of fragment_name.
+  tensorflow::Status Lookup(absl::string_view fragment_name,
+                            std::vector<uint64>* offsets) const;
+
+  // The number of records indexed.
+  int64 NumEntries() const { return num_entries_; }
+
+ private:
+  ReadNameIndex(std::unique_ptr<tensorflow::RandomAccessFile> file,
+                int64 num_entries, std::vector<uint64> fences);
+
+  std::unique_ptr<tensorflow::RandomAccessFile> file_;
+  const int64 num_entries_;
+  const std::vector<uint64> fences_;
+};
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_IO_READ_NAME_INDEX_H_
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/io/read_name_index.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "absl/strings/str_cat.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
+#include "nucleus/vendor/status_matchers.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace nucleus {
+
+using genomics::v1::Read;
+using genomics::v1::SamReaderOptions;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::Pointwise;
+
+namespace {
+
+constexpr char kBamTestFilename[] = "test.bam";
+
+// Copies the test BAM file to a temporary path, so that its read name index
+// can be written next to it.
+string CopyTestBam(const string& filename) {
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(
+      tensorflow::Env::Default(), GetTestData(kBamTestFilename), &contents));
+  const string path = MakeTempFile(filename);
+  TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                            contents));
+  return path;
+}
+
+}  // namespace
+
+class ReadNameIndexThreadsTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(ReadNameIndexThreadsTest, QueriesReadsByName) {
+  const string path = CopyTestBam(absl::StrCat("names", GetParam(), ".bam"));
+  ASSERT_THAT(BuildReadNameIndex(path, path + read_name_index::kExtension,
+                                 GetParam()),
+              IsOK());
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(path, SamReaderOptions()).ValueOrDie());
+  ASSERT_TRUE(reader->HasReadNameIndex());
+
+  const std::vector<Read> reads = as_vector(reader->Iterate());
+  ASSERT_FALSE(reads.empty());
+  for (size_t i = 0; i < reads.size(); i += 7) {
+    std::vector<Read> expected;
+    for (const Read& read : reads) {
+      if (read.fragment_name() == reads[i].fragment_name()) {
+        expected.push_back(read);
+      }
+    }
+    EXPECT_THAT(as_vector(reader->QueryName(reads[i].fragment_name())),
+                Pointwise(EqualsProto(), expected));
+  }
+  EXPECT_THAT(as_vector(reader->QueryName("no such read")), IsEmpty());
+}
+
+INSTANTIATE_TEST_CASE_P(Threads, ReadNameIndexThreadsTest,
+                        ::testing::Values(0, 3));
+
+TEST(ReadNameIndexTest, IndexesEveryRecord) {
+  const string path = CopyTestBam("count.bam");
+  const string index_path = path + read_name_index::kExtension;
+  ASSERT_THAT(BuildReadNameIndex(path, index_path, 0), IsOK());
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(path, SamReaderOptions()).ValueOrDie());
+  std::unique_ptr<ReadNameIndex> index =
+      std::move(ReadNameIndex::FromFile(index_path, path).ValueOrDie());
+  EXPECT_THAT(index->NumEntries(), Eq(as_vector(reader->Iterate()).size()));
+}
+
+TEST(ReadNameIndexTest, QueryNameRequiresIndex) {
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_FALSE(reader->HasReadNameIndex());
+  EXPECT_THAT(reader->QueryName("read").status(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
+TEST(ReadNameIndexTest, RejectsCorruptIndexes) {
+  const string path = CopyTestBam("corrupt.bam");
+  const string index_path = path + read_name_index::kExtension;
+  ASSERT_THAT(BuildReadNameIndex(path, index_path, 0), IsOK());
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(),
+                                           index_path, &contents));
+  TF_CHECK_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), index_path, contents.substr(1)));
+  EXPECT_THAT(ReadNameIndex::FromFile(index_path, path).status(),
+              IsNotOKWithCode(tensorflow::error::DATA_LOSS));
+  // The BAM file can still be read, just not queried by name.
+  StatusOr<std::unique_ptr<SamReader>> reader =
+      SamReader::FromFile(path, SamReaderOptions());
+  ASSERT_THAT(reader.status(), IsOK());
+  EXPECT_FALSE(reader.ValueOrDie()->HasReadNameIndex());
+  EXPECT_THAT(reader.ValueOrDie()->QueryName("read").status(),
+              IsNotOKWithCode(tensorflow::error::DATA_LOSS));
+  EXPECT_THAT(as_vector(reader.ValueOrDie()->Iterate()), Not(IsEmpty()));
+}
+
+TEST(ReadNameIndexTest, RejectsStaleIndexes) {
+  const string path = CopyTestBam("stale.bam");
+  const string index_path = path + read_name_index::kExtension;
+  ASSERT_THAT(BuildReadNameIndex(path, index_path, 0), IsOK());
+  // Rewrite the BAM file with an extra empty BGZF block, as if it had been
+  // regenerated after it was indexed.
+  string contents;
+  TF_CHECK_OK(tensorflow::ReadFileToString(tensorflow::Env::Default(), path,
+                                           &contents));
+  TF_CHECK_OK(tensorflow::WriteStringToFile(tensorflow::Env::Default(), path,
+                                            contents + contents.substr(
+                                                contents.size() - 28)));
+  EXPECT_THAT(ReadNameIndex::FromFile(index_path, path).status(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(path, SamReaderOptions()).ValueOrDie());
+  EXPECT_THAT(reader->QueryName("read").status(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
+}  // namespace nucleus
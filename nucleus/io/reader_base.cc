@@ -27,17 +27,26 @@ namespace nucleus {
 Reader::~Reader() {
   // If there is an outstanding iterable, we need to tell it that
   // the reader is dead so it doesn't still try to use it.
+  DetachIterables();
+}
+
+void Reader::DetachIterables() const {
   absl::MutexLock lock(&mutex_);
   if (live_iterable_ != nullptr) {
-    live_iterable_->reader_ = nullptr;
+    live_iterable_->alive_ = false;
+    live_iterable_ = nullptr;
+  }
+  for (IterableBase* cursor : live_cursors_) {
+    cursor->alive_ = false;
   }
+  live_cursors_.clear();
 }
 
 
 // IterableBase class methods
 
 IterableBase::IterableBase(const Reader* reader)
-    : reader_(reader)
+    : reader_(reader), alive_(reader != nullptr)
 {}
 
 IterableBase::~IterableBase() {
@@ -47,20 +56,24 @@ IterableBase::~IterableBase() {
 }
 
 tensorflow::Status IterableBase::Release() {
-  if (IsAlive()) {
-    absl::MutexLock lock(&reader_->mutex_);
-    if (reader_->live_iterable_ == nullptr) {
+  if (!IsAlive()) return tensorflow::Status::OK();
+  // Closing the reader detaches this iterable under the same lock, so once it
+  // is held this iterable is either still registered or already detached.
+  absl::MutexLock lock(&reader_->mutex_);
+  if (!IsAlive()) return tensorflow::Status::OK();
+  if (reader_->live_cursors_.erase(this) == 0) {
+    if (reader_->live_iterable_ != this) {
       return tensorflow::errors::FailedPrecondition(
-          "reader_->live_iterable_ is null");
+          "reader_->live_iterable_ is not this iterable");
     }
     reader_->live_iterable_ = nullptr;
-    reader_ = nullptr;
   }
+  alive_ = false;
   return tensorflow::Status::OK();
 }
 
 bool IterableBase::IsAlive() const {
-  return reader_ != nullptr;
+  return alive_;
 }
 
 tensorflow::Status IterableBase::CheckIsAlive() const {
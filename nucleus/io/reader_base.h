@@ -19,10 +19,17 @@
 #define THIRD_PARTY_NUCLEUS_IO_READER_BASE_H_
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "nucleus/io/io_stats.h"
+#include "nucleus/platform/types.h"
 #include "nucleus/util/proto_ptr.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -34,7 +41,9 @@ namespace nucleus {
 
 // The classes declared in this file support the functionality of a
 // "reader" class that allows iteration over records by a single
-// iterator at once.
+// iterator at once, plus any number of "cursors": iterables that read through
+// file handles and decoding state of their own, and so can be live alongside
+// the iterator and each other, each used from its own thread.
 
 // IterableBase and Reader are two base classes that are entwined as follows:
 //  - IterableBase has a reference to a reader, so that we can notify
@@ -51,8 +60,12 @@ class Reader {
  private:
   // Weak reference to live extant iterable, or null
   mutable IterableBase* live_iterable_ = nullptr;
-  // Mutex protecting live_iterable_count.
+  // Weak references to the live cursors.
+  mutable std::set<IterableBase*> live_cursors_;
+  // Mutex protecting live_iterable_ and live_cursors_.
   mutable absl::Mutex mutex_;
+  // The statistics of this reader, updated by its iterables and cursors.
+  mutable IoStats io_stats_;
 
  protected:
   // Construct a new Iterable object, *if* we can guarantee that there
@@ -75,15 +88,44 @@ class Reader {
     return std::shared_ptr<Iterable>(it);
   }
 
+  // Construct a new cursor: an Iterable object that shares no mutable state
+  // with the other Iterables of this Reader, which the caller guarantees by
+  // handing it its own file handle and decoding buffers. Unlike MakeIterable,
+  // this always succeeds, and the cursor is released independently of the
+  // other Iterables.
+  template<class Iterable, class Reader, typename... Args>
+  std::shared_ptr<Iterable> MakeCursor(Reader* reader, Args&&... args) const {
+    absl::MutexLock lock(&mutex_);
+    Iterable* it = new Iterable(reader, std::forward<Args>(args)...);
+    live_cursors_.insert(it);
+    return std::shared_ptr<Iterable>(it);
+  }
+
+  // Tells the live iterable and cursors that this reader is dead, so that
+  // they fail instead of using its state. Subclasses must call this before
+  // freeing state the iterables use, such as in Close(). A cursor can be in
+  // the middle of Next on another thread when this is called, so cursors must
+  // own, or share ownership of, any state that Close() frees.
+  void DetachIterables() const;
+
  public:
   virtual ~Reader();
 
+  // Returns the statistics of this reader, for its iterables to update.
+  IoStats* io_stats() const { return &io_stats_; }
+
+  // Returns a snapshot of the statistics of this reader (see io_stats.h).
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   friend class IterableBase;
 };
 
 
 class IterableBase {
  protected:
+  // The reader of this iterable. It is only valid to use while IsAlive().
   const Reader* reader_;
 
   explicit IterableBase(const Reader* reader);
@@ -115,6 +157,12 @@ class IterableBase {
   tensorflow::Status PythonExit();
 
   friend class Reader;
+
+ private:
+  // Whether reader_ is open and this iterable has not been released. It is
+  // only cleared under the mutex of reader_, and read without it by cursors
+  // running on other threads.
+  std::atomic<bool> alive_;
 };
 
 
@@ -146,6 +194,22 @@ class Iterable : public IterableBase {
   // called from Python.
   StatusOr<bool> PythonNext(EmptyProtoPtr<Record> p) { return Next(p.p_); }
 
+  // Tell returns a checkpoint of the position of this iterable: an offset
+  // from which Seek, on this iterable or another one over the same file,
+  // resumes iteration with the record following the last one returned by
+  // Next. Iterables that cannot checkpoint their position return an
+  // Unimplemented status.
+  virtual StatusOr<int64> Tell() {
+    return tensorflow::errors::Unimplemented(
+        "This iterable does not support Tell");
+  }
+
+  // Seek resumes iteration at offset, as returned by Tell.
+  virtual tensorflow::Status Seek(int64 offset) {
+    return tensorflow::errors::Unimplemented(
+        "This iterable does not support Seek");
+  }
+
  public:
   // C++ const iterator class.
   class iterator : public std::iterator<std::input_iterator_tag, Record> {
@@ -245,6 +309,94 @@ class Iterable : public IterableBase {
   }
 };
 
+// An Iterable producing the records of another Iterable ahead of time.
+//
+// A background thread drives the source Iterable into a ring buffer of
+// capacity records, so that decoding overlaps with whatever the consumer does
+// with each record. Records are swapped out of the buffer rather than copied,
+// and the consumer's previous record goes back into the buffer to be reused
+// by the next decode. The records, the end of iteration and any error of the
+// source are all seen in the order the source produced them; the source is
+// not advanced past an error.
+//
+// The PrefetchingIterable owns the source, whose reader must outlive it. It
+// is not registered with any reader, so releasing it is a no-op; the source
+// is released when the PrefetchingIterable is destroyed.
+template<class Record>
+class PrefetchingIterable : public Iterable<Record> {
+ public:
+  PrefetchingIterable(std::shared_ptr<Iterable<Record>> source, int capacity)
+      : Iterable<Record>(nullptr),
+        source_(std::move(source)),
+        slots_(std::max(capacity, 1)) {
+    CHECK(source_ != nullptr) << "Cannot prefetch from a null Iterable";
+    thread_ = std::thread(&PrefetchingIterable::Produce, this);
+  }
+
+  ~PrefetchingIterable() override {
+    {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+    }
+    thread_.join();
+  }
+
+  StatusOr<bool> Next(Record* out) override {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(this, &PrefetchingIterable::CanConsume));
+    if (count_ == 0) {
+      TF_RETURN_IF_ERROR(status_);
+      return false;
+    }
+    using std::swap;
+    swap(*out, slots_[head_]);
+    head_ = (head_ + 1) % slots_.size();
+    --count_;
+    return true;
+  }
+
+ private:
+  // The body of the background thread.
+  void Produce() {
+    while (true) {
+      size_t slot;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(this, &PrefetchingIterable::CanProduce));
+        if (cancelled_) return;
+        slot = (head_ + count_) % slots_.size();
+      }
+      // The consumer never touches the slot past the buffered records, so the
+      // source can decode into it without holding the lock.
+      StatusOr<bool> more = source_->Next(&slots_[slot]);
+      absl::MutexLock lock(&mutex_);
+      if (!more.ok() || !more.ValueOrDie()) {
+        status_ = more.status();
+        done_ = true;
+        return;
+      }
+      ++count_;
+    }
+  }
+
+  bool CanConsume() const { return count_ > 0 || done_; }
+  bool CanProduce() const { return count_ < slots_.size() || cancelled_; }
+
+  const std::shared_ptr<Iterable<Record>> source_;
+  std::thread thread_;
+
+  absl::Mutex mutex_;
+  // The ring buffer: count_ records starting at slots_[head_].
+  std::vector<Record> slots_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  // Set by the producer once the source is exhausted or failed with status_.
+  bool done_ = false;
+  tensorflow::Status status_;
+  // Set on destruction to stop the producer.
+  bool cancelled_ = false;
+};
+
 }  // namespace nucleus
 
 #endif  // THIRD_PARTY_NUCLEUS_IO_READER_BASE_H_
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include <gmock/gmock-generated-matchers.h>
@@ -26,6 +27,7 @@
 #include <gmock/gmock-more-matchers.h>
 
 #include "tensorflow/core/platform/test.h"
+#include "absl/strings/str_cat.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/vendor/status_matchers.h"
 #include "nucleus/vendor/statusor.h"
@@ -64,6 +66,12 @@ class ToyReader : public Reader {
     }
   }
 
+  std::shared_ptr<ToyIterable> CursorFrom(int startingPos = 0) {
+    return MakeCursor<ToyIterable>(this, startingPos);
+  }
+
+  void Close() { DetachIterables(); }
+
   friend class ToyIterable;
 };
 
@@ -229,4 +237,89 @@ TEST(ReaderIterableTest, TestReaderDiesBeforeIterable) {
   // in Python since destruction order is non-deterministic.
 }
 
+TEST(ReaderIterableTest, TestReleasingADetachedCursor) {
+  ToyReader tr({"ball", "doll", "house", "legos"});
+  std::shared_ptr<ToyIterable> cursor = tr.CursorFrom(0);
+  tr.Close();
+  std::shared_ptr<ToyIterable> it1 = tr.IterateFrom(0);
+  ASSERT_NE(it1, nullptr);
+  string s;
+  EXPECT_THAT(cursor->Next(&s), IsNotOKWithMessage("Reader is not alive"));
+  ASSERT_THAT(cursor->Release(), IsOK());
+  // Releasing the detached cursor leaves the live iterable registered.
+  EXPECT_EQ(tr.IterateFrom(0), nullptr);
+}
+
+TEST(ReaderIterableTest, TestClosingWhileCursorsRunOnOtherThreads) {
+  std::vector<string> toys(10000, "ball");
+  ToyReader tr(toys);
+  std::vector<std::thread> threads;
+  std::vector<tf::Status> statuses(4);
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    std::shared_ptr<ToyIterable> cursor = tr.CursorFrom(0);
+    threads.emplace_back([cursor, &statuses, i]() {
+      string s;
+      StatusOr<bool> more;
+      do {
+        more = cursor->Next(&s);
+      } while (more.ok() && more.ValueOrDie());
+      statuses[i] = more.status();
+      TF_CHECK_OK(cursor->Release());
+    });
+  }
+  tr.Close();
+  for (std::thread& thread : threads) thread.join();
+  // Each cursor either finished before the reader was closed, or failed.
+  for (const tf::Status& status : statuses) {
+    if (!status.ok()) {
+      EXPECT_THAT(status, IsNotOKWithMessage("Reader is not alive"));
+    }
+  }
+}
+
+TEST(PrefetchingIterableTest, ProducesAllRecordsInOrder) {
+  std::vector<string> toys;
+  for (int i = 0; i < 100; ++i) {
+    toys.push_back(absl::StrCat("toy", i));
+  }
+  ToyReader tr(toys);
+  for (int capacity : {1, 3, 1000}) {
+    auto it = std::make_shared<PrefetchingIterable<string>>(
+        tr.IterateFrom(0), capacity);
+    std::vector<string> gathered;
+    for (const StatusOr<string*> toy : it) {
+      ASSERT_THAT(toy, IsOK());
+      gathered.push_back(*toy.ValueOrDie());
+    }
+    EXPECT_EQ(toys, gathered);
+    // The source is released along with the PrefetchingIterable.
+    it = nullptr;
+  }
+}
+
+TEST(PrefetchingIterableTest, PropagatesErrorInOrder) {
+  ToyReader tr({StatusOr<string>("ball"),
+                tf::errors::Unknown("Malformed record: argybarg"),
+                StatusOr<string>("doll")});
+  PrefetchingIterable<string> it(tr.IterateFrom(0), 2);
+  string line;
+  StatusOr<bool> not_eof_or = it.Next(&line);
+  ASSERT_TRUE(not_eof_or.ok() && not_eof_or.ValueOrDie());
+  EXPECT_EQ(line, "ball");
+  EXPECT_THAT(it.Next(&line), IsNotOKWithMessage("Malformed record: argybarg"));
+  EXPECT_THAT(it.Next(&line), IsNotOKWithMessage("Malformed record: argybarg"));
+}
+
+TEST(PrefetchingIterableTest, CanBeDestroyedBeforeExhausted) {
+  ToyReader tr({"ball", "doll", "house", "legos"});
+  {
+    PrefetchingIterable<string> it(tr.IterateFrom(0), 1);
+    string line;
+    ASSERT_THAT(it.Next(&line), IsOK());
+    EXPECT_EQ(line, "ball");
+  }
+  // The source was released, so the reader can be iterated again.
+  EXPECT_NE(tr.IterateFrom(0), nullptr);
+}
+
 }  // namespace nucleus
@@ -30,6 +30,7 @@
 #include "nucleus/protos/fasta.pb.h"
 #include "nucleus/protos/range.pb.h"
 #include "nucleus/protos/reference.pb.h"
+#include "nucleus/util/sequence_kernels.h"
 #include "nucleus/util/utils.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -221,7 +222,7 @@ StatusOr<string> IndexedFastaReader::GetBases(const Range& range) const {
                                                range.ShortDebugString());
   string result(bases);
   if (!options_.keep_true_case()) {
-    absl::AsciiStrToUpper(&result);
+    ToUpper(&result);
   }
   free(bases);
 
@@ -398,8 +399,10 @@ StatusOr<bool> UnindexedFastaReaderIterable::Next(GenomeReferenceRecord* out) {
     if (out->first.empty()) {
       return tf::errors::DataLoss("Name not found in FASTA");
     }
-    out->second.append(
-        absl::AsciiStrToUpper(absl::StripTrailingAsciiWhitespace(l)));
+    const absl::string_view bases = absl::StripTrailingAsciiWhitespace(l);
+    const size_t bases_start = out->second.size();
+    out->second.append(bases.data(), bases.size());
+    ToUpper(&out->second[bases_start], bases.size());
   }
   if (eof && out->first.empty()) {
     // No more records.
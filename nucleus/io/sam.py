@@ -138,7 +138,10 @@ class NativeSamReader(genomics_reader.GenomicsReader):
                hts_block_size=None,
                downsample_fraction=None,
                random_seed=None,
-               use_original_base_quality_scores=False):
+               use_original_base_quality_scores=False,
+               share_index=False,
+               cache_alignment_end=False,
+               use_compact_encoding=False):
     """Initializes a NativeSamReader.
 
     Args:
@@ -169,6 +172,18 @@ class NativeSamReader(genomics_reader.GenomicsReader):
         needed. If None, a fixed random value will be assigned.
       use_original_base_quality_scores: optional bool, defaulting to False. If
         True, quality scores are read from OQ tag.
+      share_index: optional bool, defaulting to False. If True, the index of a
+        BAM file is shared with the other readers of the same file in this
+        process that set share_index, rather than loaded again.
+      cache_alignment_end: optional bool, defaulting to False. If True, the
+        end of each read's alignment is stored in its alignment.cached_end,
+        so that utils.read_end and read_overlaps_region need not walk its
+        CIGAR. Code changing the alignment of such reads must clear it.
+      use_compact_encoding: optional bool, defaulting to False. If True, the
+        qualities of reads are returned as bytes in compact_aligned_quality,
+        and their CIGAR in alignment.packed_cigar in the layout of htslib,
+        rather than in aligned_quality and alignment.cigar. Code reading the
+        legacy fields must not set it.
 
     Raises:
       ValueError: If downsample_fraction is not None and not in the interval
@@ -214,8 +229,10 @@ class NativeSamReader(genomics_reader.GenomicsReader):
               hts_block_size=(hts_block_size or 0),
               downsample_fraction=downsample_fraction,
               random_seed=random_seed,
-              use_original_base_quality_scores=use_original_base_quality_scores)
-      )
+              use_original_base_quality_scores=use_original_base_quality_scores,
+              share_index=share_index,
+              cache_alignment_end=cache_alignment_end,
+              use_compact_encoding=use_compact_encoding))
 
       self.header = self._reader.header
 
@@ -229,6 +246,46 @@ class NativeSamReader(genomics_reader.GenomicsReader):
     """Returns an iterator for going through the reads in the region."""
     return self._reader.query(region)
 
+  def query_cursor(self, region):
+    """Returns an iterator for going through the reads in the region.
+
+    Unlike query(), any number of these iterators can be in use at once. Only
+    indexed BAM files are supported.
+    """
+    return self._reader.query_cursor(region)
+
+  def query_name(self, fragment_name):
+    """Returns an iterator for going through the reads named fragment_name.
+
+    Requires a read name index next to the BAM file, with the '.rni' suffix,
+    built since the BAM file was last modified.
+    """
+    return self._reader.query_name(fragment_name)
+
+  def index_statistics(self):
+    """Returns the IndexStatistics proto read from the index of the file.
+
+    Gives per-contig mapped and unmapped read counts without reading any
+    reads. Only indexed BAM files are supported.
+    """
+    return self._reader.index_statistics()
+
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
+  def iterate_fragments(self):
+    """Returns an iterable of the Fragment protos in the file.
+
+    Each Fragment holds all of the reads sharing a fragment_name. The file must
+    be sorted by queryname or grouped by query.
+    """
+    return self._reader.iterate_fragments()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -270,6 +327,10 @@ class NativeSamWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
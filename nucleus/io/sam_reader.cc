@@ -20,7 +20,10 @@
 
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <utility>
 #include <vector>
@@ -30,20 +33,28 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "htslib/bgzf.h"
 #include "htslib/cram.h"
 #include "htslib/hts.h"
 #include "htslib/hts_endian.h"
 #include "htslib/sam.h"
+#include "nucleus/io/byte_balanced_partitioner.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
+#include "nucleus/io/index_cache.h"
+#include "nucleus/io/index_statistics.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/io/sam_utils.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/cigar.pb.h"
 #include "nucleus/protos/position.pb.h"
 #include "nucleus/protos/range.pb.h"
 #include "nucleus/protos/reads.pb.h"
+#include "nucleus/util/sequence_kernels.h"
 #include "nucleus/util/utils.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace nucleus {
@@ -53,6 +64,9 @@ namespace tf = tensorflow;
 using absl::string_view;
 using nucleus::genomics::v1::CigarUnit;
 using nucleus::genomics::v1::CigarUnit_Operation;
+using nucleus::genomics::v1::ContigInfo;
+using nucleus::genomics::v1::Fragment;
+using nucleus::genomics::v1::IndexStatistics;
 using nucleus::genomics::v1::Position;
 using nucleus::genomics::v1::Range;
 using nucleus::genomics::v1::Read;
@@ -422,6 +436,7 @@ tf::Status ParseAuxFields(const bam1_t* b, const SamReaderOptions& options,
 
 // Assign aligned_quality. Depending on the use_original_base_quality_scores
 // aligned_quality is read either from "QUAL" field or from "OQ" tag in SAM/BAM.
+// With use_compact_encoding the scores go to compact_aligned_quality instead.
 tf::Status AssignAlignedQuality(const bam1_t* b,
                                 const SamReaderOptions& options,
                                 Read* read_message) {
@@ -432,9 +447,15 @@ tf::Status AssignAlignedQuality(const bam1_t* b,
     auto info_it = info.find("OQ");
     if (info_it != read_message->info().end() &&
         !info_it->second.values().empty()) {
+      const auto& oq_tag_value = *(info_it->second.values().begin());
+      if (options.use_compact_encoding()) {
+        string* compact = read_message->mutable_compact_aligned_quality();
+        *compact = oq_tag_value.string_value();
+        for (char& q : *compact) q -= 33;
+        return tf::Status::OK();
+      }
       RepeatedField<int32>* quality = read_message->mutable_aligned_quality();
       quality->Reserve(c->l_qseq);
-      const auto& oq_tag_value = *(info_it->second.values().begin());
       for (char c : oq_tag_value.string_value()) {
         quality->Add(reinterpret_cast<int>(c - 33));
       }
@@ -444,6 +465,11 @@ tf::Status AssignAlignedQuality(const bam1_t* b,
     if (c->l_qseq) {
       uint8_t* quals = bam_get_qual(b);
       if (quals[0] != 0xff) {  // Not missing
+        if (options.use_compact_encoding()) {
+          read_message->set_compact_aligned_quality(
+              reinterpret_cast<const char*>(quals), c->l_qseq);
+          return tf::Status::OK();
+        }
         // TODO(b/35950011): Is there a more efficient way to do this?
         RepeatedField<int32>* quality = read_message->mutable_aligned_quality();
         quality->Reserve(c->l_qseq);
@@ -461,9 +487,11 @@ tf::Status AssignAlignedQuality(const bam1_t* b,
 // Returns with tensorflow::error::Code::ABORTED if the read doesn't
 // satisfy read requirements. When that happens, the function aborts early and
 // doesn't fill the other fields such as aligned_sequence, which can be
-// expensive in long reads.
+// expensive in long reads. The time spent parsing aux fields is added to
+// stats, if it is not null.
 tf::Status ConvertToPb(const bam_hdr_t* h, const bam1_t* b,
-                       const SamReaderOptions& options, Read* read_message) {
+                       const SamReaderOptions& options, Read* read_message,
+                       IoStats* stats = nullptr) {
   CHECK(h != nullptr) << "BAM header cannot be null";
   CHECK(b != nullptr) << "BAM record cannot be null";
   CHECK(read_message != nullptr) << "Read record cannot be null";
@@ -498,14 +526,11 @@ tf::Status ConvertToPb(const bam_hdr_t* h, const bam1_t* b,
 
   if (c->l_qseq) {
     // Convert the seq if it is present.
+    // seq is stored as 4-bit offsets into the constant seq_nt16_str from
+    // htslib, which DecodeNt16 converts to upper case characters.
     string* read_seq = read_message->mutable_aligned_sequence();
-    read_seq->reserve(c->l_qseq);
-    uint8_t* seq = bam_get_seq(b);  // seq is stored as 8-bit offsets.
-    for (int i = 0; i < c->l_qseq; ++i) {
-      // Convert the offsets to upper case characters by their offset in
-      // the constant seq_nt16_str from htslib.
-      read_seq->push_back(seq_nt16_str[bam_seqi(seq, i)]);
-    }
+    read_seq->resize(c->l_qseq);
+    DecodeNt16(bam_get_seq(b), c->l_qseq, &(*read_seq)[0]);
   }
 
   if (!(c->flag & BAM_FUNMAP)) {
@@ -513,7 +538,14 @@ tf::Status ConvertToPb(const bam_hdr_t* h, const bam1_t* b,
     auto* linear_alignment = read_message->mutable_alignment();
     linear_alignment->set_mapping_quality(c->qual);
 
-    if (c->n_cigar) {  // Convert our Cigar.
+    if (c->n_cigar && options.use_compact_encoding()) {
+      // The packed CIGAR has the layout of htslib's, so is copied as is.
+      RepeatedField<uint32>* packed_cigar =
+          linear_alignment->mutable_packed_cigar();
+      packed_cigar->Resize(c->n_cigar, 0);
+      memcpy(packed_cigar->mutable_data(), bam_get_cigar(b),
+             c->n_cigar * sizeof(uint32));
+    } else if (c->n_cigar) {  // Convert our Cigar.
       uint32* cigar = bam_get_cigar(b);
       for (uint32 i = 0; i < c->n_cigar; ++i) {
         CigarUnit* cigar_unit = linear_alignment->add_cigar();
@@ -528,6 +560,12 @@ tf::Status ConvertToPb(const bam_hdr_t* h, const bam1_t* b,
       position->set_reference_name(h->target_name[c->tid]);
       position->set_position(c->pos);
       position->set_reverse_strand(bam_is_rev(b));
+      if (options.cache_alignment_end()) {
+        // Unlike bam_endpos, which returns pos + 1 for alignments covering no
+        // reference bases, this matches ReadEnd.
+        linear_alignment->set_cached_end(
+            c->pos + bam_cigar2rlen(c->n_cigar, bam_get_cigar(b)));
+      }
     }
   }
 
@@ -545,10 +583,14 @@ tf::Status ConvertToPb(const bam_hdr_t* h, const bam1_t* b,
   }
 
   // Parse out our read aux fields.
-  tf::Status status = ParseAuxFields(b, options, read_message);
+  tf::Status status;
+  {
+    ScopedIoTimer timer(stats, IoStats::kAuxParse);
+    status = ParseAuxFields(b, options, read_message);
+  }
   if (!status.ok()) {
-    // Not thread safe.
-    static int counter = 0;
+    // Shared by the cursors, which may run on several threads.
+    static std::atomic<int> counter(0);
     if (counter++ < 1) {
       LOG(WARNING) << "Aux field parsing failure in read "
                    << bam_get_qname(b) << ": " << status;
@@ -576,6 +618,17 @@ class SamIterableBase : public SamIterable {
   // Advance to the next record.
   StatusOr<bool> Next(nucleus::genomics::v1::Read* out) override;
 
+  // Advances to the next record kept by sam_reader, without checking that
+  // this iterable is alive.
+  StatusOr<bool> NextKeptRead(const SamReader* sam_reader,
+                              nucleus::genomics::v1::Read* out);
+
+  // Returns true if read should be returned by this iterable.
+  virtual bool KeepRead(const SamReader* sam_reader,
+                        const nucleus::genomics::v1::Read& read) {
+    return sam_reader->KeepRead(read);
+  }
+
   // Base class constructor. Intializes common attrubutes.
   SamIterableBase(const SamReader* reader,
                   htsFile* fp,
@@ -596,6 +649,45 @@ class SamFullFileIterable : public SamIterableBase {
  public:
   // Constructor is invoked via SamReader::Iterate.
   SamFullFileIterable(const SamReader* reader, htsFile* fp, bam_hdr_t* header);
+
+  StatusOr<int64> Tell() override;
+  tf::Status Seek(int64 offset) override;
+};
+
+// Iterable class for traversing the fragments of a query-grouped file.
+class SamFragmentFileIterable : public SamFragmentIterable {
+ public:
+  // Constructor is invoked via SamReader::IterateFragments.
+  SamFragmentFileIterable(const SamReader* reader, htsFile* fp,
+                          bam_hdr_t* header);
+
+  StatusOr<bool> Next(nucleus::genomics::v1::Fragment* out) override;
+
+ private:
+  // The reads of the file. It is not registered with the reader, which only
+  // tracks this iterable.
+  SamFullFileIterable reads_;
+  // The first read of the next fragment, if has_next_read_.
+  Read next_read_;
+  bool has_next_read_ = false;
+};
+
+// Iterable class for traversing the BAM records at a list of virtual offsets
+// that are named fragment_name.
+class SamNameQueryIterable : public SamIterableBase {
+ protected:
+  virtual int next_sam_record();
+
+ public:
+  // Constructor will be invoked via SamReader::QueryName.
+  SamNameQueryIterable(const SamReader* reader, htsFile* fp,
+                       bam_hdr_t* header, std::vector<uint64> offsets,
+                       const string& fragment_name);
+
+ private:
+  const std::vector<uint64> offsets_;
+  const string fragment_name_;
+  size_t next_offset_ = 0;
 };
 
 // Iterable class for traversing BAM records returned in a query window.
@@ -616,12 +708,34 @@ class SamQueryIterable : public SamIterableBase {
   hts_itr_t* iter_;
 };
 
+// Iterable class for traversing BAM records returned in a query window
+// through a file handle, header and sampler of its own. It shares the index
+// with the reader, so that closing the reader while it runs frees neither.
+class SamQueryCursor : public SamQueryIterable {
+ public:
+  // Constructor will be invoked via SamReader::QueryCursor, which hands over
+  // ownership of fp and header.
+  SamQueryCursor(const SamReader* reader, htsFile* fp, bam_hdr_t* header,
+                 std::shared_ptr<hts_idx_t> idx, hts_itr_t* iter);
+
+  ~SamQueryCursor() override;
+
+  bool KeepRead(const SamReader* sam_reader,
+                const nucleus::genomics::v1::Read& read) override;
+
+ private:
+  const std::shared_ptr<hts_idx_t> idx_;
+  FractionalSampler sampler_;
+};
+
 SamReader::SamReader(const string& reads_path, const SamReaderOptions& options,
-                     htsFile* fp, bam_hdr_t* header, hts_idx_t* idx)
-    : options_(options),
+                     htsFile* fp, bam_hdr_t* header,
+                     std::shared_ptr<hts_idx_t> idx)
+    : reads_path_(reads_path),
+      options_(options),
       fp_(fp),
       header_(header),
-      idx_(idx),
+      idx_(std::move(idx)),
       sampler_(options.downsample_fraction(), options.random_seed()) {
   CHECK(fp != nullptr) << "pointer to SAM/BAM cannot be null";
   CHECK(header_ != nullptr) << "pointer to header cannot be null";
@@ -663,6 +777,7 @@ SamReader::SamReader(const string& reads_path, const SamReaderOptions& options,
     contig->set_name(header_->target_name[i]);
     contig->set_n_bases(header_->target_len[i]);
     contig->set_pos_in_fasta(i);
+    contig_ids_.emplace(header_->target_name[i], i);
   }
 }
 
@@ -703,11 +818,16 @@ StatusOr<std::unique_ptr<SamReader>> SamReader::FromFile(
     return tf::errors::Unknown("Could not parse file with ", errmsg);
   }
 
-  hts_idx_t* idx = nullptr;
+  std::shared_ptr<hts_idx_t> idx;
   if (FileTypeIsIndexable(fp->format)) {
     // TODO(b/35950011): use hts_idx_load after htslib upgrade.
-    // This call may return null, which we will look for at Query time.
-    idx = sam_index_load(fp, fp->fn);
+    // This call may return null, which we will look for at Query time. A CRAM
+    // index is bound to its file handle, and so cannot be shared.
+    if (options.share_index() && fp->format.format == bam) {
+      idx = IndexCache::Global()->LoadSamIndex(reads_path, fp);
+    } else if (hts_idx_t* own_idx = sam_index_load(fp, fp->fn)) {
+      idx.reset(own_idx, hts_idx_destroy);
+    }
   }
 
   // If we are decoding a CRAM file and the user wants to override the path to
@@ -728,7 +848,7 @@ StatusOr<std::unique_ptr<SamReader>> SamReader::FromFile(
   }
 
   return std::unique_ptr<SamReader>(
-      new SamReader(reads_path, options, fp, header, idx));
+      new SamReader(reads_path, options, fp, header, std::move(idx)));
 }
 
 SamReader::~SamReader() {
@@ -741,6 +861,11 @@ SamReader::~SamReader() {
 
 // Returns true if read should be returned to the client, or false otherwise.
 bool SamReader::KeepRead(const nucleus::genomics::v1::Read& read) const {
+  return KeepRead(read, sampler_);
+}
+
+bool SamReader::KeepRead(const nucleus::genomics::v1::Read& read,
+                         const FractionalSampler& sampler) const {
   return (!options_.has_read_requirements() ||
           sam_reader_internal::ReadSatisfiesRequirements(
               read, options_.read_requirements())) &&
@@ -750,7 +875,7 @@ bool SamReader::KeepRead(const nucleus::genomics::v1::Read& read) const {
          // proto but the logic to do so is much more complex than just eating
          // that cost and putting the sampling code here where it naturally fits
          // and is shared across all iteration methods.
-         (options_.downsample_fraction() == 0.0 || sampler_.Keep());
+         (options_.downsample_fraction() == 0.0 || sampler.Keep());
 }
 
 StatusOr<std::shared_ptr<SamIterable>> SamReader::Iterate() const {
@@ -760,6 +885,25 @@ StatusOr<std::shared_ptr<SamIterable>> SamReader::Iterate() const {
       MakeIterable<SamFullFileIterable>(this, fp_, header_));
 }
 
+StatusOr<std::shared_ptr<SamFragmentIterable>> SamReader::IterateFragments()
+    const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot IterateFragments a closed SamReader.");
+  }
+  if (sam_header_.sorting_order() != SamHeader::QUERYNAME &&
+      sam_header_.alignment_grouping() != SamHeader::QUERY) {
+    return tf::errors::FailedPrecondition(
+        "IterateFragments requires a file sorted by queryname or grouped by "
+        "query, but the header has sorting order ",
+        SamHeader::SortingOrder_Name(sam_header_.sorting_order()),
+        " and alignment grouping ",
+        SamHeader::AlignmentGrouping_Name(sam_header_.alignment_grouping()));
+  }
+  return StatusOr<std::shared_ptr<SamFragmentIterable>>(
+      MakeIterable<SamFragmentFileIterable>(this, fp_, header_));
+}
+
 StatusOr<std::shared_ptr<SamIterable>> SamReader::Query(
     const Range& region) const {
   if (fp_ == nullptr)
@@ -768,32 +912,150 @@ StatusOr<std::shared_ptr<SamIterable>> SamReader::Query(
     return tf::errors::FailedPrecondition("Cannot query without an index");
   }
 
-  const int tid = bam_name2id(header_, region.reference_name().c_str());
-  if (tid < 0) {
+  StatusOr<hts_itr_t*> iter = QueryIterator(region);
+  TF_RETURN_IF_ERROR(iter.status());
+  return StatusOr<std::shared_ptr<SamIterable>>(
+      MakeIterable<SamQueryIterable>(this, fp_, header_, iter.ValueOrDie()));
+}
+
+StatusOr<std::shared_ptr<SamIterable>> SamReader::QueryCursor(
+    const Range& region) const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot QueryCursor a closed SamReader.");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  }
+  // CRAM decoding shares reference and container state with the file the
+  // index was loaded for, so only BAM files can be read by several handles.
+  if (fp_->format.format != bam) {
+    return tf::errors::FailedPrecondition(
+        "Cursors are only supported for BAM files, not ", reads_path_);
+  }
+  StatusOr<hts_itr_t*> iter = QueryIterator(region);
+  TF_RETURN_IF_ERROR(iter.status());
+
+  htsFile* fp = hts_open_x(reads_path_, "r");
+  if (fp == nullptr) {
+    hts_itr_destroy(iter.ValueOrDie());
+    return tf::errors::NotFound("Could not open ", reads_path_);
+  }
+  if (options_.hts_block_size() > 0 &&
+      hts_set_opt(fp, HTS_OPT_BLOCK_SIZE, options_.hts_block_size()) != 0) {
+    hts_itr_destroy(iter.ValueOrDie());
+    hts_close(fp);
+    return tf::errors::Unknown("Failed to set HTS_OPT_BLOCK_SIZE");
+  }
+  // The cursor can outlive header_ if this reader is closed while it runs.
+  bam_hdr_t* header = bam_hdr_dup(header_);
+  if (header == nullptr) {
+    hts_itr_destroy(iter.ValueOrDie());
+    hts_close(fp);
+    return tf::errors::Unknown("Failed to copy the header of ", reads_path_);
+  }
+  return StatusOr<std::shared_ptr<SamIterable>>(MakeCursor<SamQueryCursor>(
+      this, fp, header, idx_, iter.ValueOrDie()));
+}
+
+StatusOr<std::vector<Range>> SamReader::PartitionByBytes(
+    absl::Span<const Range> regions, int num_shards) const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot PartitionByBytes a closed SamReader.");
+  }
+  if (!HasIndex() || fp_->format.format != bam) {
+    return tf::errors::FailedPrecondition(
+        "Partitioning by bytes requires an indexed BAM file");
+  }
+  for (const Range& region : regions) {
+    if (contig_ids_.find(region.reference_name()) == contig_ids_.end()) {
+      return tf::errors::NotFound("Unknown reference_name ",
+                                  region.ShortDebugString());
+    }
+  }
+  return PartitionByIndexedBytes(
+      idx_.get(),
+      [this](const string& name) { return contig_ids_.at(name); },
+      regions, num_shards);
+}
+
+StatusOr<IndexStatistics> SamReader::GetIndexStatistics() const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot GetIndexStatistics of a closed SamReader.");
+  }
+  if (!HasIndex() || fp_->format.format != bam) {
+    return tf::errors::FailedPrecondition(
+        "Index statistics require an indexed BAM file");
+  }
+  std::vector<string> names;
+  for (const ContigInfo& contig : sam_header_.contigs()) {
+    names.push_back(contig.name());
+  }
+  return ReadIndexStatistics(idx_.get(), names, [this](const string& name) {
+    return contig_ids_.at(name);
+  });
+}
+
+StatusOr<hts_itr_t*> SamReader::QueryIterator(const Range& region) const {
+  const auto tid = contig_ids_.find(region.reference_name());
+  if (tid == contig_ids_.end()) {
     return tf::errors::NotFound(
         "Unknown reference_name ", region.ShortDebugString());
   }
 
   // Note that query is 0-based inclusive on start and exclusive on end,
   // matching exactly the logic of our Range.
-  hts_itr_t* iter = sam_itr_queryi(idx_, tid, region.start(), region.end());
+  hts_itr_t* iter =
+      sam_itr_queryi(idx_.get(), tid->second, region.start(), region.end());
   if (iter == nullptr) {
     // The region isn't valid according to sam_itr_query(), blow up.
     return tf::errors::NotFound(
         "region '", region.ShortDebugString(),
         "' specifies an unknown reference interval");
   }
+  return iter;
+}
 
-    return StatusOr<std::shared_ptr<SamIterable>>(
-        MakeIterable<SamQueryIterable>(this, fp_, header_, iter));
+StatusOr<std::shared_ptr<SamIterable>> SamReader::QueryName(
+    const string& fragment_name) const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot QueryName a closed SamReader.");
+  }
+  TF_RETURN_IF_ERROR(LoadReadNameIndex());
+  std::vector<uint64> offsets;
+  TF_RETURN_IF_ERROR(name_index_->Lookup(fragment_name, &offsets));
+  return StatusOr<std::shared_ptr<SamIterable>>(
+      MakeIterable<SamNameQueryIterable>(this, fp_, header_,
+                                         std::move(offsets), fragment_name));
 }
 
+tf::Status SamReader::LoadReadNameIndex() const {
+  if (name_index_ != nullptr) return tf::Status::OK();
+  const string name_index_path = reads_path_ + read_name_index::kExtension;
+  if (fp_ == nullptr || fp_->format.format != bam ||
+      !tf::Env::Default()->FileExists(name_index_path).ok()) {
+    return tf::errors::FailedPrecondition(
+        "Cannot query by name without a read name index");
+  }
+  StatusOr<std::unique_ptr<ReadNameIndex>> name_index =
+      ReadNameIndex::FromFile(name_index_path, reads_path_);
+  TF_RETURN_IF_ERROR(name_index.status());
+  name_index_ = std::move(name_index.ValueOrDie());
+  return tf::Status::OK();
+}
 
 tf::Status SamReader::Close() {
-  if (HasIndex()) {
-    hts_idx_destroy(idx_);
-    idx_ = nullptr;
+  if (fp_ != nullptr && IoStatsEnabled()) {
+    LOG(INFO) << "SamReader statistics: " << io_stats()->ToJson();
   }
+  // Iterables and cursors use the header and index, so must not outlive them.
+  DetachIterables();
+  // The index is freed here unless other readers share it.
+  idx_.reset();
+  name_index_.reset();
   bam_hdr_destroy(header_);
   header_ = nullptr;
   int retval = hts_close(fp_);
@@ -810,23 +1072,39 @@ tf::Status SamReader::Close() {
 
 StatusOr<bool> SamIterableBase::Next(Read* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
+  return NextKeptRead(static_cast<const SamReader*>(reader_), out);
+}
+
+StatusOr<bool> SamIterableBase::NextKeptRead(const SamReader* sam_reader,
+                                             Read* out) {
+  IoStats* stats = IoStatsEnabled() ? sam_reader->io_stats() : nullptr;
+  ScopedHtsBytes bytes(fp_, stats);
   // Keep reading until "reader_->KeepRead(.)"
-  const SamReader* sam_reader = static_cast<const SamReader*>(reader_);
   do {
-    int code = next_sam_record();
+    int code;
+    {
+      ScopedIoTimer timer(stats, IoStats::kHts);
+      code = next_sam_record();
+    }
     if (code == -1) {
       return false;
     } else if (code < -1) {
       return tf::errors::DataLoss("Failed to parse SAM record");
     }
+    if (stats != nullptr) stats->AddRecordDecoded();
     // Convert to proto.
-    tf::Status status = ConvertToPb(header_, bam1_, sam_reader->options(), out);
+    tf::Status status;
+    {
+      ScopedIoTimer timer(stats, IoStats::kConvert);
+      status = ConvertToPb(header_, bam1_, sam_reader->options(), out, stats);
+    }
     if (status.code() == tensorflow::error::Code::ABORTED) {
       // "ABORT" from ConvertToPb means requirements were not met.
       continue;
     }
     TF_RETURN_IF_ERROR(status);
-  } while (!sam_reader->KeepRead(*out));
+  } while (!KeepRead(sam_reader, *out));
+  if (stats != nullptr) stats->AddRecordKept();
   return true;
 }
 
@@ -856,6 +1134,86 @@ SamFullFileIterable::SamFullFileIterable(const SamReader* reader,
     : SamIterableBase(reader, fp, header)
 {}
 
+StatusOr<int64> SamFullFileIterable::Tell() {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  // htslib reads the first record of a SAM file along with its header, and
+  // holds it until the first call to sam_read1.
+  if (fp_->format.format == sam && fp_->line.l > 0) {
+    return tf::errors::FailedPrecondition(
+        "Cannot Tell before the first record of a SAM file is read");
+  }
+  return TellRecordOffset(fp_);
+}
+
+tf::Status SamFullFileIterable::Seek(int64 offset) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  return SeekRecordOffset(fp_, offset);
+}
+
+
+SamFragmentFileIterable::SamFragmentFileIterable(const SamReader* reader,
+                                                 htsFile* fp,
+                                                 bam_hdr_t* header)
+    : Iterable(reader), reads_(nullptr, fp, header) {}
+
+StatusOr<bool> SamFragmentFileIterable::Next(Fragment* out) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  const SamReader* sam_reader = static_cast<const SamReader*>(reader_);
+  if (!has_next_read_) {
+    StatusOr<bool> more = reads_.NextKeptRead(sam_reader, &next_read_);
+    TF_RETURN_IF_ERROR(more.status());
+    if (!more.ValueOrDie()) return false;
+  }
+
+  // Gather reads until one with another name comes up. Read messages are
+  // swapped rather than copied, and the cleared ones reused.
+  out->Clear();
+  out->set_fragment_name(next_read_.fragment_name());
+  while (true) {
+    out->add_reads()->Swap(&next_read_);
+    StatusOr<bool> more = reads_.NextKeptRead(sam_reader, &next_read_);
+    TF_RETURN_IF_ERROR(more.status());
+    has_next_read_ = more.ValueOrDie();
+    if (!has_next_read_ || next_read_.fragment_name() != out->fragment_name()) {
+      break;
+    }
+  }
+
+  // Primary alignments sort before supplementary ones, and those before
+  // secondary ones.
+  const auto order = [](const Read& read) {
+    return std::make_pair(read.read_number(),
+                          read.secondary_alignment()
+                              ? 2
+                              : read.supplementary_alignment() ? 1 : 0);
+  };
+  std::stable_sort(
+      out->mutable_reads()->pointer_begin(),
+      out->mutable_reads()->pointer_end(),
+      [&order](const Read* a, const Read* b) { return order(*a) < order(*b); });
+  return true;
+}
+
+int SamNameQueryIterable::next_sam_record() {
+  // Distinct names can share a hash, so check the name of each record.
+  while (next_offset_ < offsets_.size()) {
+    if (bgzf_seek(fp_->fp.bgzf, offsets_[next_offset_++], SEEK_SET) < 0) {
+      return -2;
+    }
+    const int code = sam_read1(fp_, header_, bam1_);
+    if (code < 0) return code == -1 ? -2 : code;
+    if (fragment_name_ == bam_get_qname(bam1_)) return code;
+  }
+  return -1;
+}
+
+SamNameQueryIterable::SamNameQueryIterable(const SamReader* reader,
+                                           htsFile* fp, bam_hdr_t* header,
+                                           std::vector<uint64> offsets,
+                                           const string& fragment_name)
+    : SamIterableBase(reader, fp, header),
+      offsets_(std::move(offsets)),
+      fragment_name_(fragment_name) {}
 
 int SamQueryIterable::next_sam_record() {
   return sam_itr_next(fp_, iter_, bam1_);
@@ -872,4 +1230,23 @@ SamQueryIterable::SamQueryIterable(const SamReader* reader,
     : SamIterableBase(reader, fp, header), iter_(iter)
 {}
 
+SamQueryCursor::SamQueryCursor(const SamReader* reader, htsFile* fp,
+                               bam_hdr_t* header,
+                               std::shared_ptr<hts_idx_t> idx, hts_itr_t* iter)
+    : SamQueryIterable(reader, fp, header, iter),
+      idx_(std::move(idx)),
+      sampler_(reader->options().downsample_fraction(),
+               reader->options().random_seed()) {}
+
+SamQueryCursor::~SamQueryCursor() {
+  bam_hdr_destroy(header_);
+  if (hts_close(fp_) < 0) {
+    LOG(WARNING) << "hts_close() failed on a SamQueryCursor";
+  }
+}
+
+bool SamQueryCursor::KeepRead(const SamReader* sam_reader, const Read& read) {
+  return sam_reader->KeepRead(read, sampler_);
+}
+
 }  // namespace nucleus
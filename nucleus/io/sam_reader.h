@@ -20,9 +20,13 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "htslib/hts.h"
 #include "htslib/sam.h"
+#include "nucleus/io/read_name_index.h"
 #include "nucleus/io/reader_base.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/range.pb.h"
@@ -38,6 +42,9 @@ namespace nucleus {
 // Alias for the abstract base class for SAM record iterables.
 using SamIterable = Iterable<nucleus::genomics::v1::Read>;
 
+// Alias for the abstract base class for iterables over whole fragments.
+using SamFragmentIterable = Iterable<nucleus::genomics::v1::Fragment>;
+
 // A SAM/BAM/CRAM reader.
 //
 // SAM/BAM/CRAM files store information about next-generation DNA sequencing
@@ -82,7 +89,10 @@ class SamReader : public Reader {
   // If the filetype is BAM/CRAM, this constructor will attempt to load a BAI or
   // CRAI index from file reads_path + '.bai' or reads_path (without the .bam
   // extension) + '.bai'; if the index is not found, attempts to Query will
-  // fail.
+  // fail. Likewise, a BAM file's read name index is loaded from
+  // reads_path + '.rni' (see BuildReadNameIndex), though only when first
+  // needed by QueryName or HasReadNameIndex; without it, attempts to QueryName
+  // will fail.
   //
   // Returns a StatusOr that is OK if the SamReader could be successfully
   // created or an error code indicating the error that occurred.
@@ -131,9 +141,61 @@ class SamReader : public Reader {
   StatusOr<std::shared_ptr<SamIterable>> Query(
       const nucleus::genomics::v1::Range& region) const;
 
+  // Gets all of the reads that overlap any bases in range, through a cursor.
+  //
+  // Unlike the iterables returned by Query, any number of cursors can be live
+  // at once, alongside an iterable, and each can be used from its own thread:
+  // a cursor reads through a file handle, header and decoding buffers of its
+  // own, sharing only the immutable index with this reader. A cursor
+  // downsamples with a sampler of its own, seeded with options.random_seed.
+  // Closing this reader while cursors run on other threads is safe: their
+  // next call to Next fails, and they can still be released. This reader must
+  // not be destroyed while they run, though.
+  //
+  // Cursors are only supported for indexed BAM files; other files, and
+  // invalid ranges, give a non-OK status.
+  StatusOr<std::shared_ptr<SamIterable>> QueryCursor(
+      const nucleus::genomics::v1::Range& region) const;
+
+  // Splits regions into about num_shards shards holding roughly equal amounts
+  // of data, as estimated from the index alone (see
+  // byte_balanced_partitioner.h). Only supported for indexed BAM files.
+  StatusOr<std::vector<nucleus::genomics::v1::Range>> PartitionByBytes(
+      absl::Span<const nucleus::genomics::v1::Range> regions,
+      int num_shards) const;
+
+  // Returns the per-contig read counts and sizes recorded by the index, for
+  // each contig of the header, without reading any records (see
+  // index_statistics.h). Only supported for indexed BAM files.
+  StatusOr<nucleus::genomics::v1::IndexStatistics> GetIndexStatistics() const;
+
+  // Gets all of the fragments in this file in order.
+  //
+  // Each Fragment holds all of the reads sharing a fragment_name (the primary
+  // alignments of each read of the template along with their supplementary
+  // and secondary alignments), so pairs can be processed without buffering
+  // the file. The reads are filtered as in Iterate. Only one fragment is held
+  // in memory at a time, which requires the reads of each fragment to be
+  // adjacent in the file: the header must declare a QUERYNAME sorting order
+  // or QUERY alignment grouping, otherwise a FailedPrecondition status is
+  // returned.
+  StatusOr<std::shared_ptr<SamFragmentIterable>> IterateFragments() const;
+
+  // Gets all of the reads named fragment_name, in file order.
+  //
+  // The read name index gives the location of the reads, so the cost is
+  // independent of the size of the file. The reads are filtered as in
+  // Iterate. If no read name index was loaded a non-OK status is returned.
+  StatusOr<std::shared_ptr<SamIterable>> QueryName(
+      const string& fragment_name) const;
+
   // Returns True if this SamReader loaded an index file.
   bool HasIndex() const { return idx_ != nullptr; }
 
+  // Returns True if this SamReader has a usable read name index, loading it if
+  // it has not been yet.
+  bool HasReadNameIndex() const { return LoadReadNameIndex().ok(); }
+
   // Close the underlying resource descriptors. Returns a Status to indicate if
   // everything went OK with the close.
   tensorflow::Status Close();
@@ -144,6 +206,10 @@ class SamReader : public Reader {
 
   bool KeepRead(const nucleus::genomics::v1::Read& read) const;
 
+  // As above, but downsampling with sampler rather than our own sampler.
+  bool KeepRead(const nucleus::genomics::v1::Read& read,
+                const FractionalSampler& sampler) const;
+
   const nucleus::genomics::v1::SamReaderOptions& options() const {
     return options_;
   }
@@ -156,7 +222,15 @@ class SamReader : public Reader {
   // file.
   SamReader(const string& reads_path,
             const nucleus::genomics::v1::SamReaderOptions& options, htsFile* fp,
-            bam_hdr_t* header, hts_idx_t* idx);
+            bam_hdr_t* header, std::shared_ptr<hts_idx_t> idx);
+
+  // Creates an iterator over the records overlapping region, or returns a
+  // non-OK status if region is not in the index.
+  StatusOr<hts_itr_t*> QueryIterator(
+      const nucleus::genomics::v1::Range& region) const;
+
+  // The path of our SAM/BAM/CRAM file, reopened by each cursor.
+  const string reads_path_;
 
   // Our options that control the behavior of this class.
   const nucleus::genomics::v1::SamReaderOptions options_;
@@ -168,13 +242,26 @@ class SamReader : public Reader {
   bam_hdr_t * header_;
 
   // The htslib index data structure for our indexed BAM file. May be NULL if no
-  // index was loaded.
-  hts_idx_t* idx_;
+  // index was loaded. It is shared with other readers of the file if the
+  // share_index option is set.
+  std::shared_ptr<hts_idx_t> idx_;
+
+  // Loads name_index_ unless it is loaded already, returning a non-OK status
+  // if this file has no usable read name index.
+  tensorflow::Status LoadReadNameIndex() const;
+
+  // The read name index of our BAM file. NULL until LoadReadNameIndex
+  // succeeds.
+  mutable std::unique_ptr<ReadNameIndex> name_index_;
 
   // The sam.proto SamHeader message representing the structured header
   // information.
   nucleus::genomics::v1::SamHeader sam_header_;
 
+  // The target id of each contig in header_. bam_name2id builds its lookup
+  // table lazily, which cursors on several threads must not race on.
+  std::unordered_map<string, int> contig_ids_;
+
   // For downsampling reads.
   mutable FractionalSampler sampler_;
 };
@@ -18,6 +18,7 @@
 #include "nucleus/io/sam_reader.h"
 
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -26,15 +27,19 @@
 #include <gmock/gmock-more-matchers.h>
 
 #include "tensorflow/core/platform/test.h"
+#include "nucleus/io/sam_utils.h"
 #include "nucleus/io/sam_writer.h"
 #include "nucleus/testing/protocol-buffer-matchers.h"
 #include "nucleus/testing/test_utils.h"
 #include "nucleus/util/utils.h"
 #include "nucleus/vendor/status_matchers.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace nucleus {
 
+using nucleus::genomics::v1::ContigIndexStatistics;
+using nucleus::genomics::v1::IndexStatistics;
 using nucleus::genomics::v1::LinearAlignment;
 using nucleus::genomics::v1::Range;
 using nucleus::genomics::v1::Read;
@@ -45,6 +50,7 @@ using nucleus::proto::IgnoringFieldPaths;
 using nucleus::proto::Partially;
 using std::vector;
 using ::testing::IsEmpty;
+using ::testing::Not;
 using ::testing::Pointwise;
 using ::testing::SizeIs;
 
@@ -148,6 +154,82 @@ TEST(SamReaderTest, TestIterationRespectsReadRequirements) {
   EXPECT_THAT(as_vector(reader->Iterate()), SizeIs(5));
 }
 
+TEST(SamReaderTest, CachedAlignmentEndMatchesReadEnd) {
+  SamReaderOptions options;
+  options.mutable_read_requirements()->set_keep_unaligned(true);
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), options)
+          .ValueOrDie());
+  const std::vector<Read> reads = as_vector(reader->Iterate());
+
+  options.set_cache_alignment_end(true);
+  std::unique_ptr<SamReader> caching_reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), options)
+          .ValueOrDie());
+  const std::vector<Read> cached = as_vector(caching_reader->Iterate());
+
+  ASSERT_THAT(cached, SizeIs(reads.size()));
+  for (size_t i = 0; i < reads.size(); ++i) {
+    EXPECT_EQ(0, reads[i].alignment().cached_end());
+    if (reads[i].has_alignment()) {
+      EXPECT_EQ(ReadEnd(reads[i]), cached[i].alignment().cached_end());
+    } else {
+      EXPECT_EQ(0, cached[i].alignment().cached_end());
+    }
+  }
+}
+
+TEST(SamReaderTest, CompactEncodingMatchesLegacyEncoding) {
+  for (const bool use_oq : {false, true}) {
+    const string filename =
+        GetTestData(use_oq ? kSamOqTestFilename : kBamTestFilename);
+    SamReaderOptions options;
+    options.mutable_read_requirements()->set_keep_unaligned(true);
+    options.set_use_original_base_quality_scores(use_oq);
+    std::unique_ptr<SamReader> reader =
+        std::move(SamReader::FromFile(filename, options).ValueOrDie());
+    const std::vector<Read> reads = as_vector(reader->Iterate());
+
+    options.set_use_compact_encoding(true);
+    std::unique_ptr<SamReader> compact_reader =
+        std::move(SamReader::FromFile(filename, options).ValueOrDie());
+    std::vector<Read> compact = as_vector(compact_reader->Iterate());
+
+    ASSERT_THAT(compact, SizeIs(reads.size()));
+    for (size_t i = 0; i < reads.size(); ++i) {
+      EXPECT_THAT(compact[i].aligned_quality(), IsEmpty());
+      EXPECT_THAT(compact[i].alignment().cigar(), IsEmpty());
+      EXPECT_EQ(ReadEnd(reads[i]), ReadEnd(compact[i]));
+      ToLegacyEncoding(&compact[i]);
+      EXPECT_THAT(compact[i], EqualsProto(reads[i]));
+    }
+  }
+}
+
+TEST(SamReaderTest, WritesCompactEncoding) {
+  string output_filename(MakeTempFile("sam_reader_test_compact.bam"));
+  SamReaderOptions options;
+  options.mutable_read_requirements()->set_keep_unaligned(true);
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), options)
+          .ValueOrDie());
+  const std::vector<Read> reads = as_vector(reader->Iterate());
+  {
+    std::unique_ptr<SamWriter> writer = std::move(
+        SamWriter::ToFile(output_filename, reader->Header()).ValueOrDie());
+    for (Read read : reads) {
+      ToCompactEncoding(&read);
+      ASSERT_THAT(writer->Write(read), IsOK());
+    }
+  }
+
+  std::unique_ptr<SamReader> written_reader = std::move(
+      SamReader::FromFile(output_filename, options).ValueOrDie());
+  EXPECT_THAT(as_vector(written_reader->Iterate()),
+              Pointwise(EqualsProto(), reads));
+  TF_CHECK_OK(tensorflow::Env::Default()->DeleteFile(output_filename));
+}
+
 TEST(SamReaderTest, TestSamHeaderExtraction) {
   std::unique_ptr<SamReader> reader = std::move(
       SamReader::FromFile(GetTestData(kSamTestFilename), SamReaderOptions())
@@ -228,6 +310,97 @@ TEST(SamReaderTest, TestMatePosition) {
   TF_CHECK_OK(tensorflow::Env::Default()->DeleteFile(output_filename));
 }
 
+TEST(SamReaderTest, SeekResumesAtTell) {
+  for (const char* filename : {kBamTestFilename, kSamTestFilename}) {
+    std::unique_ptr<SamReader> reader = std::move(
+        SamReader::FromFile(GetTestData(filename), SamReaderOptions())
+            .ValueOrDie());
+    int64 offset;
+    vector<Read> rest;
+    {
+      std::shared_ptr<SamIterable> iterable = reader->Iterate().ValueOrDie();
+      Read read;
+      for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(iterable->Next(&read).ValueOrDie()) << filename;
+      }
+      StatusOr<int64> tell = iterable->Tell();
+      ASSERT_THAT(tell, IsOK()) << filename;
+      offset = tell.ValueOrDie();
+      while (iterable->Next(&read).ValueOrDie()) rest.push_back(read);
+      ASSERT_THAT(rest, Not(IsEmpty())) << filename;
+    }
+
+    std::shared_ptr<SamIterable> resumed = reader->Iterate().ValueOrDie();
+    ASSERT_THAT(resumed->Seek(offset), IsOK()) << filename;
+    EXPECT_THAT(as_vector(resumed), Pointwise(EqualsProto(), rest))
+        << filename;
+  }
+}
+
+TEST(SamReaderTest, TellAndSeekErrors) {
+  std::unique_ptr<SamReader> sam_reader = std::move(
+      SamReader::FromFile(GetTestData(kSamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  std::shared_ptr<SamIterable> iterable = sam_reader->Iterate().ValueOrDie();
+  // The first record of a SAM file is read along with the header.
+  EXPECT_THAT(iterable->Tell(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+  EXPECT_THAT(iterable->Seek(-1),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+  ASSERT_THAT(iterable->Release(), IsOK());
+
+  std::unique_ptr<SamReader> bam_reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  std::shared_ptr<SamIterable> query =
+      bam_reader->Query(MakeRange("chr20", 9999999, 10000000)).ValueOrDie();
+  EXPECT_THAT(query->Tell(), IsNotOKWithCode(tensorflow::error::UNIMPLEMENTED));
+}
+
+TEST(SamReaderTest, IteratesFragments) {
+  // The reads of fragment "a" are out of order, and their positions give their
+  // expected order.
+  const string filename = MakeTempFile("fragments.sam");
+  TF_CHECK_OK(tensorflow::WriteStringToFile(
+      tensorflow::Env::Default(), filename,
+      "@HD\tVN:1.5\tSO:queryname\n"
+      "@SQ\tSN:chr1\tLN:1000\n"
+      "a\t129\tchr1\t400\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "a\t321\tchr1\t300\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "a\t65\tchr1\t100\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "a\t2113\tchr1\t200\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "b\t0\tchr1\t50\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "c\t65\tchr1\t10\t60\t4M\t*\t0\t0\tACGT\t*\n"
+      "c\t129\tchr1\t20\t60\t4M\t*\t0\t0\tACGT\t*\n"));
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(filename, SamReaderOptions()).ValueOrDie());
+  std::vector<nucleus::genomics::v1::Fragment> fragments =
+      as_vector(reader->IterateFragments());
+
+  ASSERT_THAT(fragments, SizeIs(3));
+  const std::vector<string> names = {"a", "b", "c"};
+  const std::vector<std::vector<int64>> positions = {
+      {99, 199, 299, 399}, {49}, {9, 19}};
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(names[i], fragments[i].fragment_name());
+    std::vector<int64> fragment_positions;
+    for (const Read& read : fragments[i].reads()) {
+      EXPECT_EQ(names[i], read.fragment_name());
+      fragment_positions.push_back(read.alignment().position().position());
+    }
+    EXPECT_EQ(positions[i], fragment_positions);
+  }
+  TF_CHECK_OK(tensorflow::Env::Default()->DeleteFile(filename));
+}
+
+TEST(SamReaderTest, IterateFragmentsRequiresGroupedReads) {
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(GetTestData(kBamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_THAT(reader->IterateFragments(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
 class SamReaderQueryTest : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -374,6 +547,105 @@ TEST_F(SamReaderQueryTest, NextFailsOnReleasedIterable) {
   EXPECT_THAT(it->Next(&read), IsNotOKWithMessage("Reader is not alive"));
 }
 
+TEST_F(SamReaderQueryTest, ConcurrentCursorsMatchQueries) {
+  const std::vector<Range> ranges = {MakeRange("chr20", 9999999, 10000100),
+                                     MakeRange("chr20", 999999, 10000000),
+                                     MakeRange("chr20", 10000000, 10003000),
+                                     MakeRange("chr20", 9999999, 10000100)};
+  std::vector<std::vector<Read>> expected;
+  for (const Range& range : ranges) {
+    expected.push_back(as_vector(reader_->Query(range)));
+  }
+  const std::vector<Read> all_reads = as_vector(reader_->Iterate());
+
+  // The cursors are all live at once, alongside an iterable.
+  std::shared_ptr<SamIterable> iterable = reader_->Iterate().ValueOrDie();
+  std::vector<std::shared_ptr<SamIterable>> cursors;
+  for (const Range& range : ranges) {
+    cursors.push_back(reader_->QueryCursor(range).ValueOrDie());
+  }
+  std::vector<std::vector<Read>> actual(ranges.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < cursors.size(); ++i) {
+    threads.emplace_back([&cursors, &actual, i]() {
+      Read read;
+      while (cursors[i]->Next(&read).ValueOrDie()) {
+        actual[i].push_back(read);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    EXPECT_THAT(actual[i], SizeIs(expected[i].size()));
+    EXPECT_THAT(actual[i], Pointwise(EqualsProto(), expected[i]));
+  }
+  EXPECT_THAT(as_vector(iterable), SizeIs(all_reads.size()));
+}
+
+TEST_F(SamReaderQueryTest, CursorsOutliveReleaseOfOthers) {
+  Read read;
+  std::shared_ptr<SamIterable> first =
+      reader_->QueryCursor(MakeRange("chr20", 9999999, 10000000)).ValueOrDie();
+  std::shared_ptr<SamIterable> second =
+      reader_->QueryCursor(MakeRange("chr20", 9999999, 10000000)).ValueOrDie();
+  ASSERT_THAT(first->Release(), IsOK());
+  EXPECT_THAT(first->Next(&read), IsNotOKWithMessage("Reader is not alive"));
+  EXPECT_THAT(as_vector(second), SizeIs(45));
+  // Releasing the cursors leaves the reader free to make an iterable.
+  EXPECT_THAT(as_vector(reader_->Query(MakeRange("chr20", 9999999, 10000000))),
+              SizeIs(45));
+}
+
+TEST_F(SamReaderQueryTest, CloseDetachesCursors) {
+  Read read;
+  std::shared_ptr<SamIterable> cursor =
+      reader_->QueryCursor(MakeRange("chr20", 9999999, 10000000)).ValueOrDie();
+  ASSERT_THAT(cursor->Next(&read), IsOK());
+  ASSERT_THAT(reader_->Close(), IsOK());
+  EXPECT_THAT(cursor->Next(&read), IsNotOKWithMessage("Reader is not alive"));
+  EXPECT_THAT(cursor->Release(), IsOK());
+}
+
+TEST_F(SamReaderQueryTest, CursorErrors) {
+  EXPECT_THAT(reader_->QueryCursor(MakeRange("chrUnknown", 0, 100)),
+              IsNotOKWithCode(tensorflow::error::NOT_FOUND));
+  std::unique_ptr<SamReader> sam_reader = std::move(
+      SamReader::FromFile(GetTestData(kSamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_THAT(sam_reader->QueryCursor(MakeRange("chr20", 0, 100)),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+  ASSERT_THAT(reader_->Close(), IsOK());
+  EXPECT_THAT(reader_->QueryCursor(MakeRange("chr20", 9999999, 10000000)),
+              IsNotOKWithMessage("Cannot QueryCursor a closed SamReader."));
+}
+
+TEST_F(SamReaderQueryTest, IndexStatisticsCountReads) {
+  StatusOr<IndexStatistics> stats = reader_->GetIndexStatistics();
+  ASSERT_THAT(stats, IsOK());
+  ASSERT_THAT(stats.ValueOrDie().contigs(),
+              SizeIs(reader_->Header().contigs_size()));
+  // All of the reads of test.bam are on chr20, including one unmapped mate.
+  for (const ContigIndexStatistics& contig : stats.ValueOrDie().contigs()) {
+    if (contig.name() == "chr20") {
+      EXPECT_EQ(105, contig.n_mapped());
+      EXPECT_EQ(1, contig.n_unmapped());
+      EXPECT_GT(contig.n_compressed_bytes(), 0);
+    } else {
+      EXPECT_EQ(0, contig.n_mapped()) << contig.name();
+      EXPECT_EQ(0, contig.n_unmapped()) << contig.name();
+    }
+  }
+  EXPECT_EQ(0, stats.ValueOrDie().n_no_coordinate());
+
+  std::unique_ptr<SamReader> sam_reader = std::move(
+      SamReader::FromFile(GetTestData(kSamTestFilename), SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_THAT(sam_reader->GetIndexStatistics(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
 namespace sam_reader_internal {
 
 class ReadRequirementTest : public ::testing::Test {
@@ -96,4 +96,63 @@ const genomics::v1::CigarUnit_Operation kHtslibCigarToProto[] = {
     genomics::v1::CigarUnit::OPERATION_UNSPECIFIED,
 };
 
+genomics::v1::CigarUnit_Operation PackedCigarOperation(uint32 packed) {
+  const uint32 op = bam_cigar_op(packed);
+  return op <= BAM_CBACK ? kHtslibCigarToProto[op]
+                         : genomics::v1::CigarUnit::OPERATION_UNSPECIFIED;
+}
+
+uint32 PackCigarUnit(const genomics::v1::CigarUnit& unit) {
+  return bam_cigar_gen(unit.operation_length(),
+                       kProtoToHtslibCigar[unit.operation()]);
+}
+
+void ToLegacyEncoding(genomics::v1::Read* read) {
+  // Compact fields are dropped if the legacy ones are set, as they win.
+  if (read->aligned_quality_size() > 0) {
+    read->clear_compact_aligned_quality();
+  } else if (!read->compact_aligned_quality().empty()) {
+    const string& compact = read->compact_aligned_quality();
+    google::protobuf::RepeatedField<int32>* quality =
+        read->mutable_aligned_quality();
+    quality->Reserve(compact.size());
+    for (const char q : compact) {
+      quality->AddAlreadyReserved(static_cast<uint8>(q));
+    }
+    read->clear_compact_aligned_quality();
+  }
+  if (read->alignment().cigar_size() > 0) {
+    read->mutable_alignment()->clear_packed_cigar();
+  } else if (read->alignment().packed_cigar_size() > 0) {
+    genomics::v1::LinearAlignment* alignment = read->mutable_alignment();
+    alignment->mutable_cigar()->Reserve(alignment->packed_cigar_size());
+    for (const uint32 packed : alignment->packed_cigar()) {
+      genomics::v1::CigarUnit* unit = alignment->add_cigar();
+      unit->set_operation(PackedCigarOperation(packed));
+      unit->set_operation_length(PackedCigarLength(packed));
+    }
+    alignment->clear_packed_cigar();
+  }
+}
+
+void ToCompactEncoding(genomics::v1::Read* read) {
+  if (read->aligned_quality_size() > 0) {
+    string* compact = read->mutable_compact_aligned_quality();
+    compact->resize(read->aligned_quality_size());
+    for (int i = 0; i < read->aligned_quality_size(); ++i) {
+      (*compact)[i] = static_cast<char>(read->aligned_quality(i));
+    }
+    read->clear_aligned_quality();
+  }
+  if (read->alignment().cigar_size() > 0) {
+    genomics::v1::LinearAlignment* alignment = read->mutable_alignment();
+    alignment->clear_packed_cigar();
+    alignment->mutable_packed_cigar()->Reserve(alignment->cigar_size());
+    for (const genomics::v1::CigarUnit& unit : alignment->cigar()) {
+      alignment->add_packed_cigar(PackCigarUnit(unit));
+    }
+    alignment->clear_cigar();
+  }
+}
+
 }  // namespace nucleus
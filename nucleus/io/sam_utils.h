@@ -19,6 +19,7 @@
 
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/cigar.pb.h"
+#include "nucleus/protos/reads.pb.h"
 
 namespace nucleus {
 
@@ -71,6 +72,23 @@ extern const int kProtoToHtslibCigar[];
 // values.
 extern const genomics::v1::CigarUnit_Operation kHtslibCigarToProto[];
 
+// Return the operation and the length of an element of the packed_cigar of a
+// LinearAlignment. Invalid BAM operation codes give OPERATION_UNSPECIFIED.
+genomics::v1::CigarUnit_Operation PackedCigarOperation(uint32 packed);
+inline uint32 PackedCigarLength(uint32 packed) { return packed >> 4; }
+
+// Returns the packed_cigar element of unit.
+uint32 PackCigarUnit(const genomics::v1::CigarUnit& unit);
+
+// Convert read between the legacy encoding of its qualities and CIGAR, in
+// aligned_quality and alignment.cigar, and the compact encoding written by
+// SamReaders with use_compact_encoding, in compact_aligned_quality and
+// alignment.packed_cigar. The fields converted from are cleared. As
+// everywhere, when a read has both encodings of a field the legacy one wins:
+// ToLegacyEncoding drops the compact field and ToCompactEncoding replaces it.
+void ToLegacyEncoding(genomics::v1::Read* read);
+void ToCompactEncoding(genomics::v1::Read* read);
+
 }  // namespace nucleus
 
 #endif  // THIRD_PARTY_NUCLEUS_IO_SAM_UTILS_H_
@@ -24,12 +24,18 @@
 #include "tensorflow/core/platform/test.h"
 #include "htslib/sam.h"
 #include "nucleus/protos/cigar.pb.h"
+#include "nucleus/protos/reads.pb.h"
+#include "nucleus/testing/protocol-buffer-matchers.h"
+#include "nucleus/testing/test_utils.h"
 
 namespace nucleus {
 
 using genomics::v1::CigarUnit;
 using genomics::v1::CigarUnit_Operation_Operation_MAX;
 using genomics::v1::CigarUnit_Operation_Operation_MIN;
+using genomics::v1::Read;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 
 TEST(SamUtilsTest, Conversion) {
   for (int i = CigarUnit_Operation_Operation_MIN;
@@ -52,4 +58,54 @@ TEST(SamUtilsTest, ProtoConversion) {
   EXPECT_EQ(kProtoToHtslibCigar[CigarUnit::OPERATION_UNSPECIFIED], BAM_CBACK);
 }
 
+TEST(SamUtilsTest, PackedCigar) {
+  CigarUnit unit;
+  unit.set_operation(CigarUnit::DELETE);
+  unit.set_operation_length(19);
+  const uint32 packed = PackCigarUnit(unit);
+  EXPECT_EQ(bam_cigar_gen(19, BAM_CDEL), packed);
+  EXPECT_EQ(CigarUnit::DELETE, PackedCigarOperation(packed));
+  EXPECT_EQ(19, PackedCigarLength(packed));
+  EXPECT_EQ(CigarUnit::OPERATION_UNSPECIFIED,
+            PackedCigarOperation(bam_cigar_gen(3, 0xf)));
+}
+
+TEST(SamUtilsTest, CompactEncodingRoundTrips) {
+  Read read = MakeRead("chr20", 10, "ACGTA", {"1S", "2M", "3D", "1I", "1M"});
+  read.clear_aligned_quality();
+  for (int q : {0, 20, 40, 93, 255}) read.add_aligned_quality(q);
+  const Read legacy = read;
+
+  ToCompactEncoding(&read);
+  EXPECT_THAT(read.aligned_quality(), IsEmpty());
+  EXPECT_THAT(read.alignment().cigar(), IsEmpty());
+  EXPECT_EQ(string("\x00\x14\x28\x5d\xff", 5),
+            read.compact_aligned_quality());
+  EXPECT_THAT(read.alignment().packed_cigar(),
+              ElementsAre(bam_cigar_gen(1, BAM_CSOFT_CLIP),
+                          bam_cigar_gen(2, BAM_CMATCH),
+                          bam_cigar_gen(3, BAM_CDEL),
+                          bam_cigar_gen(1, BAM_CINS),
+                          bam_cigar_gen(1, BAM_CMATCH)));
+
+  ToLegacyEncoding(&read);
+  EXPECT_THAT(read, EqualsProto(legacy));
+}
+
+TEST(SamUtilsTest, LegacyEncodingWinsOverCompact) {
+  Read read = MakeRead("chr20", 10, "ACGT", {"4M"});
+  const Read legacy = read;
+  read.set_compact_aligned_quality("\x01\x02");
+  read.mutable_alignment()->add_packed_cigar(bam_cigar_gen(2, BAM_CINS));
+
+  Read converted = read;
+  ToLegacyEncoding(&converted);
+  EXPECT_THAT(converted, EqualsProto(legacy));
+
+  ToCompactEncoding(&read);
+  EXPECT_EQ(string(4, 30), read.compact_aligned_quality());
+  EXPECT_THAT(read.alignment().packed_cigar(),
+              ElementsAre(bam_cigar_gen(4, BAM_CMATCH)));
+}
+
 }  // namespace nucleus
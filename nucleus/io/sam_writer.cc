@@ -29,6 +29,7 @@
 #include "absl/strings/string_view.h"
 #include "htslib/cram.h"
 #include "htslib/hts_endian.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
 #include "nucleus/io/sam_utils.h"
 #include "nucleus/platform/types.h"
@@ -415,13 +416,20 @@ tf::Status PopulateNativeBody(const Read& read, const bam_hdr_t* h, bam1_t* b) {
 
   // Copy qname with a null terminator.
   c->l_qname = read.fragment_name().size() + 1;
-  // Each cigar takes 4 bytes.
-  const size_t cigar_bytes =
-      4 * (read.has_alignment() ? read.alignment().cigar_size() : 0);
+  // Each cigar takes 4 bytes. Reads in the compact encoding (see
+  // SamReaderOptions.use_compact_encoding) have a packed_cigar instead; as
+  // everywhere, the legacy fields win when a read has both.
+  const bool packed_cigar = read.alignment().cigar_size() == 0;
+  const int n_cigar = packed_cigar ? read.alignment().packed_cigar_size()
+                                   : read.alignment().cigar_size();
+  const size_t cigar_bytes = 4 * n_cigar;
   // Each base is represented using 4 bit, so one byte can represent 2 bases.
   const size_t encoded_base_bytes = (read.aligned_sequence().size() + 1) >> 1;
   // Each qual is 1 byte.
-  const size_t aligned_quality_bytes = read.aligned_quality_size();
+  const bool compact_quality = read.aligned_quality_size() == 0;
+  const size_t aligned_quality_bytes =
+      compact_quality ? read.compact_aligned_quality().size()
+                      : read.aligned_quality_size();
   // Use a helper class to calculate the number of bytes of all auxiliary info.
   AuxBuilder auxBuilder(read);
 
@@ -433,7 +441,7 @@ tf::Status PopulateNativeBody(const Read& read, const bam_hdr_t* h, bam1_t* b) {
   size_t data_array_bytes = c->l_qname + cigar_bytes + encoded_base_bytes +
                             aligned_quality_bytes + aux_bytes;
   if (read.has_alignment()) {
-    c->n_cigar = read.alignment().cigar_size();
+    c->n_cigar = n_cigar;
   }
 
   // array is freed by htslib
@@ -449,6 +457,11 @@ tf::Status PopulateNativeBody(const Read& read, const bam_hdr_t* h, bam1_t* b) {
   data_array_ptr += c->l_qname;
 
   // Copy cigars.
+  if (packed_cigar) {
+    memcpy(data_array_ptr, read.alignment().packed_cigar().data(),
+           cigar_bytes);
+    data_array_ptr += cigar_bytes;
+  }
   for (const auto& cigar : read.alignment().cigar()) {
     uint32_t value =
         (cigar.operation_length() << BAM_CIGAR_SHIFT) |
@@ -468,9 +481,15 @@ tf::Status PopulateNativeBody(const Read& read, const bam_hdr_t* h, bam1_t* b) {
   data_array_ptr += encoded_base_bytes;
 
   // Copy qual.
-  for (const auto& qual : read.aligned_quality()) {
-    memcpy(data_array_ptr, &qual, 1);
-    data_array_ptr += 1;
+  if (compact_quality) {
+    memcpy(data_array_ptr, read.compact_aligned_quality().data(),
+           aligned_quality_bytes);
+    data_array_ptr += aligned_quality_bytes;
+  } else {
+    for (const auto& qual : read.aligned_quality()) {
+      memcpy(data_array_ptr, &qual, 1);
+      data_array_ptr += 1;
+    }
   }
 
   if (aux_status.ok()) {
@@ -602,21 +621,36 @@ SamWriter::~SamWriter() {
 }
 
 tf::Status SamWriter::Close() {
+  if (native_file_ && IoStatsEnabled()) {
+    LOG(INFO) << "SamWriter statistics: " << io_stats_.ToJson();
+  }
   native_file_.reset();
   native_header_ = nullptr;
   return tf::Status::OK();
 }
 
 tf::Status SamWriter::Write(const Read& read) {
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  ScopedHtsBytes bytes(native_file_->value(), stats);
   auto body = absl::make_unique<NativeBody>(bam_init1());
-  tf::Status status =
-      PopulateNativeBody(read, native_header_->value(), body->value());
+  tf::Status status;
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    status = PopulateNativeBody(read, native_header_->value(), body->value());
+  }
   if (!status.ok()) {
     return status;
   }
-  if (sam_write1(native_file_->value(), native_header_->value(),
-                 body->value()) < 0) {
-    return tf::errors::Unknown("Cannot add record");
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    if (sam_write1(native_file_->value(), native_header_->value(),
+                   body->value()) < 0) {
+      return tf::errors::Unknown("Cannot add record");
+    }
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
   }
   return tf::Status::OK();
 }
@@ -22,6 +22,7 @@
 
 #include "htslib/hts.h"
 #include "htslib/sam.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/reads.pb.h"
 #include "nucleus/util/proto_ptr.h"
@@ -84,6 +85,12 @@ class SamWriter {
   // error occurred.
   tensorflow::Status Close();
 
+  // Returns a snapshot of the statistics of this writer (see io_stats.h).
+  // Bytes still buffered by htslib are not counted until they are flushed.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // This no-op function is needed only for Python context manager support. Do
   // not use it!
   void PythonEnter() const {}
@@ -101,6 +108,9 @@ class SamWriter {
 
   // A htslib header data structure obtained by parsing the header of this file.
   std::unique_ptr<NativeHeader> native_header_;
+
+  // The statistics of this writer.
+  IoStats io_stats_;
 };
 
 }  // namespace nucleus
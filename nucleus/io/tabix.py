@@ -11,7 +11,7 @@
 # WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 # See the License for the specific language governing permissions and
 # limitations under the License.
-"""Creates tabix indices for VCFs."""
+"""Creates tabix indices for VCF, BED, BedGraph and GFF files."""
 
 from __future__ import absolute_import
 from __future__ import division
@@ -20,11 +20,35 @@ from __future__ import print_function
 from nucleus.io.python import tabix_indexer
 
 
-def build_index(path):
-  """Builds a tabix index for VCF at the specified path."""
-  tabix_indexer.tbx_index_build(path)
+def build_index(path, preset='vcf'):
+  """Builds a tabix index for the bgzipped file at the specified path.
 
+  Args:
+    path: str. Path to the bgzipped file to index.
+    preset: str. The tabix preset describing the file's layout, as for
+      `tabix -p`. One of 'vcf', 'bed' (also used for BedGraph) or 'gff'.
+  """
+  tabix_indexer.tbx_index_build(path, preset)
 
-def build_csi_index(path, min_shift):
-  """Builds a csi index for VCF at the specified path."""
-  tabix_indexer.csi_index_build(path, min_shift)
+
+def build_csi_index(path, min_shift, preset='vcf'):
+  """Builds a csi index for the bgzipped file at the specified path.
+
+  Args:
+    path: str. Path to the bgzipped file to index.
+    min_shift: int. The minimum interval size of the index, as a power of two.
+    preset: str. The tabix preset describing the file's layout; see
+      build_index.
+  """
+  tabix_indexer.csi_index_build(path, min_shift, preset)
+
+
+def build_sam_index(path):
+  """Builds an index for the coordinate-sorted BAM or CRAM file at path.
+
+  Writes a BAI index next to a BAM file, or a CRAI index next to a CRAM file.
+
+  Args:
+    path: str. Path to the BAM or CRAM file to index.
+  """
+  tabix_indexer.sam_index_build(path)
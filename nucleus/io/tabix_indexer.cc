@@ -25,8 +25,29 @@ namespace nucleus {
 
 namespace tf = tensorflow;
 
-tf::Status TbxIndexBuild(const string& path) {
-  int val = tbx_index_build_x(path, 0, &tbx_conf_vcf);
+namespace {
+
+// Looks up the htslib tabix configuration for the preset named by preset.
+tf::Status TabixConf(const string& preset, const tbx_conf_t** conf) {
+  if (preset == "vcf") {
+    *conf = &tbx_conf_vcf;
+  } else if (preset == "bed") {
+    *conf = &tbx_conf_bed;
+  } else if (preset == "gff") {
+    *conf = &tbx_conf_gff;
+  } else {
+    return tf::errors::InvalidArgument("Unknown tabix preset '", preset,
+                                       "'; expected vcf, bed or gff");
+  }
+  return tf::Status::OK();
+}
+
+}  // namespace
+
+tf::Status TbxIndexBuild(const string& path, const string& preset) {
+  const tbx_conf_t* conf;
+  TF_RETURN_IF_ERROR(TabixConf(preset, &conf));
+  int val = tbx_index_build_x(path, 0, conf);
   if (val < 0) {
     LOG(WARNING) << "Return code: " << val << "\nFile path: " << path;
     return tf::errors::Internal("Failure to write tabix index.");
@@ -34,9 +55,11 @@ tf::Status TbxIndexBuild(const string& path) {
   return tf::Status::OK();
 }
 
-tf::Status CSIIndexBuild(string path, int min_shift) {
+tf::Status CSIIndexBuild(string path, int min_shift, const string& preset) {
+  const tbx_conf_t* conf;
+  TF_RETURN_IF_ERROR(TabixConf(preset, &conf));
   // Create a index file in CSI format by setting min_shift as a non-zero value.
-  int val = tbx_index_build_x(path, min_shift, &tbx_conf_vcf);
+  int val = tbx_index_build_x(path, min_shift, conf);
   if (val < 0) {
     LOG(WARNING) << "Return code: " << val << "\nFile path: " << path;
     return tf::errors::Internal("Failure to write CSI index.");
@@ -44,4 +67,15 @@ tf::Status CSIIndexBuild(string path, int min_shift) {
   return tf::Status::OK();
 }
 
+tf::Status SamIndexBuild(const string& path) {
+  // A min_shift of 0 selects BAI rather than CSI for BAM files; it is ignored
+  // for CRAM files, which are always indexed by a CRAI.
+  int val = sam_index_build_x(path, 0);
+  if (val < 0) {
+    LOG(WARNING) << "Return code: " << val << "\nFile path: " << path;
+    return tf::errors::Internal("Failure to write SAM index.");
+  }
+  return tf::Status::OK();
+}
+
 }  // namespace nucleus
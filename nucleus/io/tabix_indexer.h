@@ -23,9 +23,24 @@
 
 namespace nucleus {
 
-// Builds a tabix index for bgzipped VCF at the specified path.
-tensorflow::Status TbxIndexBuild(const string& path);
-tensorflow::Status CSIIndexBuild(string path, int min_shift);
+// Builds a tabix index for the bgzipped file at the specified path.
+//
+// preset names the tabix preset describing the file's layout, as for
+// `tabix -p`: "vcf" (the default), "bed" (also used for BedGraph) or "gff".
+// The preset determines which columns hold the contig, start and end, and
+// whether the file's coordinates are zero-based (bed) or one-based (vcf, gff).
+tensorflow::Status TbxIndexBuild(const string& path,
+                                 const string& preset = "vcf");
+
+// Builds a CSI index with the given min_shift for the bgzipped file at the
+// specified path, using the tabix preset named by preset as above.
+tensorflow::Status CSIIndexBuild(string path, int min_shift,
+                                 const string& preset = "vcf");
+
+// Builds an index for the coordinate-sorted BAM or CRAM file at the specified
+// path: a BAI index next to a BAM file, or a CRAI index next to a CRAM file.
+tensorflow::Status SamIndexBuild(const string& path);
+
 }  // namespace nucleus
 
 #endif  // THIRD_PARTY_NUCLEUS_IO_TABIX_INDEXER_H_
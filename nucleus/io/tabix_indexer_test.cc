@@ -22,6 +22,8 @@
 #include <gmock/gmock-more-matchers.h>
 
 #include "tensorflow/core/platform/test.h"
+#include "nucleus/io/sam_reader.h"
+#include "nucleus/io/sam_writer.h"
 #include "nucleus/io/vcf_reader.h"
 #include "nucleus/io/vcf_writer.h"
 #include "nucleus/testing/test_utils.h"
@@ -83,4 +85,39 @@ TEST(CSIIndexerTest, IndexBuildsCorrectly) {
   EXPECT_THAT(tensorflow::Env::Default()->FileExists(output_csi_index), IsOK());
   EXPECT_THAT(reader->Query(MakeRange("chr3", 14318, 14319)), IsOK());
 }
+
+TEST(TabixIndexerTest, RejectsUnknownPreset) {
+  string output_filename = MakeTempFile("unknown_preset.vcf.gz");
+  tensorflow::Status status = TbxIndexBuild(output_filename, "sam");
+  EXPECT_TRUE(tensorflow::errors::IsInvalidArgument(status));
+  EXPECT_TRUE(tensorflow::errors::IsInvalidArgument(
+      CSIIndexBuild(output_filename, 14, "sam")));
+}
+
+TEST(SamIndexerTest, IndexBuildsCorrectly) {
+  string output_filename = MakeTempFile("test.bam");
+  {
+    std::unique_ptr<SamReader> reader = std::move(
+        SamReader::FromFile(GetTestData("test.bam"),
+                            nucleus::genomics::v1::SamReaderOptions())
+            .ValueOrDie());
+    std::unique_ptr<SamWriter> writer = std::move(
+        SamWriter::ToFile(output_filename, reader->Header()).ValueOrDie());
+    for (const auto& read : as_vector(reader->Iterate())) {
+      TF_CHECK_OK(writer->Write(read));
+    }
+    TF_CHECK_OK(writer->Close());
+  }
+
+  EXPECT_THAT(SamIndexBuild(output_filename), IsOK());
+  EXPECT_THAT(tensorflow::Env::Default()->FileExists(output_filename + ".bai"),
+              IsOK());
+  std::unique_ptr<SamReader> reader = std::move(
+      SamReader::FromFile(output_filename,
+                          nucleus::genomics::v1::SamReaderOptions())
+          .ValueOrDie());
+  EXPECT_THAT(as_vector(reader->Query(MakeRange("chr20", 9999999, 10000000))),
+              ::testing::SizeIs(45));
+  EXPECT_FALSE(SamIndexBuild(MakeTempFile("missing.bam")).ok());
+}
 }  // namespace nucleus
@@ -133,6 +133,37 @@ TEST(TextWriterTest, NoCompressionWhenExtensionIsNotGz) {
   EXPECT_EQ(kHelloWorld, FileContents(dest));
 }
 
+// Tests that appended text is formatted like StrCat and written on flush.
+TEST(TextWriterTest, AppendsFormattedTextUntilFlushed) {
+  string dest = MakeTempFile("appended.txt");
+  const auto writer = std::move(TextWriter::ToFile(dest).ValueOrDie());
+  writer->Append("chr1", "\t", 10, "\t", int64{1} << 40, "\t", 2.5, "\t",
+                 1.0 / 3);
+  EXPECT_EQ(tf::Status::OK(), writer->MaybeFlush());
+  EXPECT_EQ("", FileContents(dest));
+  EXPECT_EQ(tf::Status::OK(), writer->Flush());
+  EXPECT_EQ("chr1\t10\t1099511627776\t2.5\t0.333333", FileContents(dest));
+
+  writer->Append("\n", -7);
+  EXPECT_EQ(tf::Status::OK(), writer->Close());
+  EXPECT_EQ("chr1\t10\t1099511627776\t2.5\t0.333333\n-7", FileContents(dest));
+}
+
+// Tests that large amounts of buffered text are written in chunks.
+TEST(TextWriterTest, MaybeFlushWritesLargeBuffers) {
+  string dest = MakeTempFile("large.txt");
+  const auto writer = std::move(TextWriter::ToFile(dest).ValueOrDie());
+  const string line(1000, 'x');
+  size_t written = 0;
+  while (written < TextWriter::kFlushSize) {
+    writer->Append(line);
+    written += line.size();
+    EXPECT_EQ(tf::Status::OK(), writer->MaybeFlush());
+  }
+  EXPECT_EQ(written, FileContents(dest).size());
+  EXPECT_EQ(tf::Status::OK(), writer->Close());
+}
+
 // -----------------------------------------------------------------------------
 // TextReader tests
 
@@ -165,5 +196,21 @@ TEST(TextReaderTest, ReadsCompressedFile) {
   EXPECT_TRUE(tf::errors::IsOutOfRange(rv.status()));
 }
 
+// Tests that the buffer-reusing ReadLine returns successive lines.
+TEST(TextReaderTest, ReadsLinesIntoStringView) {
+  string path = MakeTempFileWithContents("lines-for-reader.txt",
+                                         "first line\n\nthird\n");
+  const auto reader = std::move(TextReader::FromFile(path).ValueOrDie());
+
+  absl::string_view line;
+  EXPECT_EQ(tf::Status::OK(), reader->ReadLine(&line));
+  EXPECT_EQ("first line", line);
+  EXPECT_EQ(tf::Status::OK(), reader->ReadLine(&line));
+  EXPECT_EQ("", line);
+  EXPECT_EQ(tf::Status::OK(), reader->ReadLine(&line));
+  EXPECT_EQ("third", line);
+  EXPECT_TRUE(tf::errors::IsOutOfRange(reader->ReadLine(&line)));
+}
+
 
 }  // namespace nucleus
@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
 #include "tensorflow/core/lib/core/errors.h"
 
@@ -28,23 +29,30 @@ namespace tf = tensorflow;
 
 namespace nucleus {
 
-StatusOr<std::unique_ptr<TextReader>> TextReader::FromFile(const string& path) {
+StatusOr<std::unique_ptr<TextReader>> TextReader::FromFile(
+    const string& path, IndexPolicy index_policy) {
   htsFile* fp = hts_open_x(path, "r");
 
   if (fp == nullptr) {
     return tf::errors::NotFound("Could not open ", path,
                                 ". The file might not exist, or the format "
                                 "detected by htslib might be incorrect.");
-  } else {
-    auto reader = absl::WrapUnique(new TextReader(fp));
-    return std::move(reader);
   }
+  tbx_t* tbx = nullptr;
+  if (index_policy == LOAD_INDEX && fp->format.compression == bgzf) {
+    // Only bgzipped files can be indexed; a missing index is not an error.
+    tbx = tbx_index_load3(fp->fn, nullptr,
+                          HTS_IDX_SAVE_REMOTE | HTS_IDX_SILENT_FAIL);
+  }
+  auto reader = absl::WrapUnique(new TextReader(fp, tbx));
+  return std::move(reader);
 }
 
 TextReader::~TextReader() {
   if (hts_file_) {
     TF_CHECK_OK(Close());
   }
+  free(line_buffer_.s);
 }
 
 StatusOr<string> TextReader::ReadLine() {
@@ -52,7 +60,13 @@ StatusOr<string> TextReader::ReadLine() {
   string line;
   kstring_t k_line = {0, 0, nullptr};
 
-  int ret = hts_getline(hts_file_, '\n', &k_line);
+  int ret;
+  {
+    IoStats* stats = IoStatsEnabled() ? io_stats_ : nullptr;
+    ScopedHtsBytes bytes(hts_file_, stats);
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    ret = hts_getline(hts_file_, '\n', &k_line);
+  }
   if (ret == -1) {
     status = tf::errors::OutOfRange("EOF");
   } else if (ret < 0) {
@@ -70,11 +84,61 @@ StatusOr<string> TextReader::ReadLine() {
   }
 }
 
+tf::Status TextReader::ReadLine(absl::string_view* line) {
+  int ret;
+  {
+    IoStats* stats = IoStatsEnabled() ? io_stats_ : nullptr;
+    ScopedHtsBytes bytes(hts_file_, stats);
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    ret = hts_getline(hts_file_, '\n', &line_buffer_);
+  }
+  if (ret == -1) {
+    return tf::errors::OutOfRange("EOF");
+  } else if (ret < 0) {
+    return tf::errors::DataLoss("Failed to read text line");
+  }
+  *line = absl::string_view(line_buffer_.s, line_buffer_.l);
+  return tf::Status::OK();
+}
+
+StatusOr<std::unique_ptr<TextRegionIterator>> TextReader::Query(
+    const string& reference_name, int64 start, int64 end) {
+  if (!hts_file_) {
+    return tf::errors::FailedPrecondition("Cannot query a closed TextReader");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  }
+  if (start < 0 || start >= end) {
+    return tf::errors::InvalidArgument("Malformed region ", reference_name,
+                                       ":", start, "-", end);
+  }
+  hts_itr_t* iter = nullptr;
+  const int tid = tbx_name2id(tbx_, reference_name.c_str());
+  if (tid >= 0) {
+    iter = tbx_itr_queryi(tbx_, tid, start, end);
+    if (iter == nullptr) {
+      return tf::errors::NotFound("Region ", reference_name, ":", start, "-",
+                                  end, " returned an invalid tabix iterator");
+    }
+  }  // implicit else case:
+  // The contig isn't in the index, so it has no records => return an empty
+  // iterator by leaving iter null.
+  auto region_iterator =
+      absl::WrapUnique(new TextRegionIterator(hts_file_, tbx_, iter));
+  region_iterator->io_stats_ = io_stats_;
+  return std::move(region_iterator);
+}
+
 tf::Status TextReader::Close() {
   if (!hts_file_) {
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed file writer");
   }
+  if (tbx_) {
+    tbx_destroy(tbx_);
+    tbx_ = nullptr;
+  }
   int hts_ok = hts_close(hts_file_);
   hts_file_ = nullptr;
   if (hts_ok < 0) {
@@ -83,9 +147,38 @@ tf::Status TextReader::Close() {
   return tf::Status::OK();
 }
 
-TextReader::TextReader(htsFile* hts_file)
-    : hts_file_(hts_file) {
+TextReader::TextReader(htsFile* hts_file, tbx_t* tbx)
+    : hts_file_(hts_file), tbx_(tbx) {
   CHECK(hts_file_ != nullptr);
 }
 
+TextRegionIterator::TextRegionIterator(htsFile* hts_file, tbx_t* tbx,
+                                       hts_itr_t* iter)
+    : hts_file_(hts_file), tbx_(tbx), iter_(iter) {}
+
+TextRegionIterator::~TextRegionIterator() {
+  hts_itr_destroy(iter_);
+  free(line_buffer_.s);
+}
+
+tf::Status TextRegionIterator::ReadLine(absl::string_view* line) {
+  if (iter_ == nullptr) {
+    return tf::errors::OutOfRange("EOF");
+  }
+  int ret;
+  {
+    IoStats* stats = IoStatsEnabled() ? io_stats_ : nullptr;
+    ScopedHtsBytes bytes(hts_file_, stats);
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    ret = tbx_itr_next(hts_file_, tbx_, iter_, &line_buffer_);
+  }
+  if (ret == -1) {
+    return tf::errors::OutOfRange("EOF");
+  } else if (ret < 0) {
+    return tf::errors::DataLoss("Failed to read text line");
+  }
+  *line = absl::string_view(line_buffer_.s, line_buffer_.l);
+  return tf::Status::OK();
+}
+
 }  // namespace nucleus
@@ -22,20 +22,36 @@
 #include <string>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "htslib/hts.h"
+#include "htslib/kstring.h"
+#include "htslib/tbx.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/status.h"
 
 namespace nucleus {
 
+class TextRegionIterator;  // Forward declaration.
 
 // The TextReader class allows reading text from a (possibly compressed) file.
 class TextReader {
+ public:  // Types.
+  enum IndexPolicy {
+    IGNORE_INDEX = false,
+    LOAD_INDEX = true,
+  };
+
  public:
   // Factory method to construct a TextReader.
   // File compression is determined from file magic (contents), not filename.
-  static StatusOr<std::unique_ptr<TextReader>> FromFile(const string& path);
+  //
+  // With LOAD_INDEX, a tabix (.tbi) or CSI (.csi) index sitting next to a
+  // bgzip-compressed file is loaded so that the file can be queried by region.
+  // A missing index is not an error; use HasIndex() to check for one.
+  static StatusOr<std::unique_ptr<TextReader>> FromFile(
+      const string& path, IndexPolicy index_policy = IGNORE_INDEX);
 
   // Destructor; closes the file, if it's still open.
   ~TextReader();
@@ -47,15 +63,85 @@ class TextReader {
   //  - otherwise, an appropriate error Status.
   StatusOr<string> ReadLine();
 
+  // Reads a single line from the file into a buffer owned by this TextReader,
+  // avoiding a per-line allocation.
+  // On success *line points at the line (excluding trailing newline); the view
+  // is invalidated by the next call to ReadLine or Close. Returns
+  // tf::errors::OutOfRange at end-of-file, or another error Status on failure.
+  tensorflow::Status ReadLine(absl::string_view* line);
+
+  // Returns true if a tabix or CSI index was loaded for this file.
+  bool HasIndex() const { return tbx_ != nullptr; }
+
+  // Returns an iterator over the lines overlapping the zero-based, half-open
+  // interval [start, end) on reference_name, as determined by the index.
+  //
+  // The index records whether the file itself uses zero-based (BED) or
+  // one-based (GFF, VCF) coordinates, so the query interval is always
+  // zero-based. A reference_name absent from the index yields an empty
+  // iterator. The iterator shares this TextReader's file stream, so this
+  // TextReader must outlive it and must not be read from while it is in use.
+  StatusOr<std::unique_ptr<TextRegionIterator>> Query(
+      const string& reference_name, int64 start, int64 end);
+
   // Explicitly closes the underlying file stream.
   tensorflow::Status Close();
 
+  // Adds the bytes read by this TextReader and the iterators it returns from
+  // then on, and the time they spend in htslib, to *stats, which must outlive
+  // them. Nothing is counted while stats is null, as it is by default.
+  void set_io_stats(IoStats* stats) { io_stats_ = stats; }
+
  private:
   // Private constructor.
-  TextReader(htsFile* hts_file);
+  TextReader(htsFile* hts_file, tbx_t* tbx);
 
   // Underlying htslib file stream.
   htsFile* hts_file_;
+
+  // The tabix index for hts_file_, or nullptr if none was loaded.
+  tbx_t* tbx_;
+
+  // Buffer reused across ReadLine(absl::string_view*) calls.
+  kstring_t line_buffer_ = {0, 0, nullptr};
+
+  // Where reads are counted, or nullptr; not owned.
+  IoStats* io_stats_ = nullptr;
+};
+
+// Iterates over the lines of an indexed text file that overlap a region.
+// Created by TextReader::Query.
+class TextRegionIterator {
+ public:
+  ~TextRegionIterator();
+
+  // Disable copy and assignment operations.
+  TextRegionIterator(const TextRegionIterator& other) = delete;
+  TextRegionIterator& operator=(const TextRegionIterator&) = delete;
+
+  // Reads the next line overlapping the region, with the same contract as
+  // TextReader::ReadLine(absl::string_view*): returns tf::errors::OutOfRange
+  // once all overlapping lines have been read.
+  tensorflow::Status ReadLine(absl::string_view* line);
+
+ private:
+  // Private constructor; iter may be nullptr for an empty region.
+  TextRegionIterator(htsFile* hts_file, tbx_t* tbx, hts_itr_t* iter);
+
+  // Underlying htslib file stream and index; owned by the TextReader.
+  htsFile* hts_file_;
+  tbx_t* tbx_;
+
+  // The htslib iterator over the region; owned by this object.
+  hts_itr_t* iter_;
+
+  // Buffer reused across ReadLine calls.
+  kstring_t line_buffer_ = {0, 0, nullptr};
+
+  // Where reads are counted, or nullptr; not owned.
+  IoStats* io_stats_ = nullptr;
+
+  friend class TextReader;
 };
 
 
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Throughput benchmarks for the field scanner and the text format readers
+// built on top of it, and for the buffered text writers.
+//
+// Each reader benchmark writes a synthetic file of the requested number of
+// records once, then repeatedly iterates over it, reporting records/sec and
+// (uncompressed) bytes/sec. Each writer benchmark repeatedly writes the
+// requested number of records to a fresh file, reporting records/sec.
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "nucleus/io/bed_reader.h"
+#include "nucleus/io/bedgraph_reader.h"
+#include "nucleus/io/bedgraph_writer.h"
+#include "nucleus/io/field_scanner.h"
+#include "nucleus/io/gff_reader.h"
+#include "nucleus/io/gff_writer.h"
+#include "nucleus/platform/types.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace nucleus {
+
+namespace {
+
+constexpr char kBed12Line[] =
+    "chr1\t1000000\t1000500\tfeature_name\t960\t+\t1000100\t1000400\t"
+    "255,124,1\t3\t100,200,100\t0,150,400";
+
+string BedLine(int i) {
+  return absl::StrCat("chr", i % 22 + 1, "\t", 100 * i, "\t", 100 * i + 50,
+                      "\tname", i, "\t", i % 1000, "\t+\t", 100 * i + 10,
+                      "\t", 100 * i + 40, "\t255,0,0\t2\t10,20\t0,30");
+}
+
+string BedGraphLine(int i) {
+  return absl::StrCat("chr", i % 22 + 1, "\t", 100 * i, "\t", 100 * i + 100,
+                      "\t", i % 97, ".", i % 10);
+}
+
+string GffLine(int i) {
+  return absl::StrCat("chr", i % 22 + 1, "\tsource\texon\t", 100 * i + 1, "\t",
+                      100 * i + 100, "\t0.5\t-\t0\tID=exon", i,
+                      ";Parent=transcript", i / 4);
+}
+
+// Writes (once per process) a file with n_records lines produced by make_line,
+// returning its path and size in bytes.
+std::pair<string, int64> SyntheticFile(const string& name,
+                                       string (*make_line)(int),
+                                       int n_records) {
+  static auto* cache = new std::map<string, std::pair<string, int64>>();
+  const string key = absl::StrCat(name, ".", n_records);
+  auto it = cache->find(key);
+  if (it != cache->end()) return it->second;
+
+  const string path = tensorflow::io::JoinPath(
+      tensorflow::testing::TmpDir(), absl::StrCat("benchmark_", key));
+  std::ofstream out(path);
+  int64 n_bytes = 0;
+  for (int i = 0; i < n_records; ++i) {
+    const string line = make_line(i) + "\n";
+    out << line;
+    n_bytes += line.size();
+  }
+  CHECK(out.good()) << "Failed to write " << path;
+  return (*cache)[key] = std::make_pair(path, n_bytes);
+}
+
+void BM_SplitFields(benchmark::State& state) {
+  absl::string_view fields[12];
+  const absl::string_view line(kBed12Line);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(SplitFields(line, '\t', absl::MakeSpan(fields)));
+  }
+  state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK(BM_SplitFields);
+
+void BM_ParseInt64(benchmark::State& state) {
+  int64 value;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParseInt64("248956422", &value));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseInt64);
+
+void BM_ParseDouble(benchmark::State& state) {
+  double value;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParseDouble("150.125", &value));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseDouble);
+
+void BM_BedReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticFile("bed", BedLine, state.range(0));
+  for (auto _ : state) {
+    auto reader = std::move(
+        BedReader::FromFile(file.first,
+                            nucleus::genomics::v1::BedReaderOptions())
+            .ValueOrDie());
+    for (const auto& record : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(record.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+}
+BENCHMARK(BM_BedReaderIterate)->Arg(100000);
+
+void BM_BedGraphReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticFile("bedgraph", BedGraphLine, state.range(0));
+  for (auto _ : state) {
+    auto reader = std::move(BedGraphReader::FromFile(file.first).ValueOrDie());
+    for (const auto& record : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(record.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+}
+BENCHMARK(BM_BedGraphReaderIterate)->Arg(100000);
+
+void BM_GffReaderIterate(benchmark::State& state) {
+  const auto file = SyntheticFile("gff", GffLine, state.range(0));
+  for (auto _ : state) {
+    auto reader = std::move(GffReader::FromFile(file.first).ValueOrDie());
+    for (const auto& record : reader->Iterate().ValueOrDie()) {
+      benchmark::DoNotOptimize(record.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * file.second);
+}
+BENCHMARK(BM_GffReaderIterate)->Arg(100000);
+
+void BM_BedGraphWriterWrite(benchmark::State& state) {
+  const string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                               "benchmark_out.bedgraph");
+  nucleus::genomics::v1::BedGraphRecord record;
+  record.set_reference_name("chr1");
+  for (auto _ : state) {
+    auto writer = std::move(BedGraphWriter::ToFile(path).ValueOrDie());
+    for (int i = 0; i < state.range(0); ++i) {
+      record.set_start(100 * i);
+      record.set_end(100 * i + 100);
+      record.set_data_value(i * 0.125);
+      TF_CHECK_OK(writer->Write(record));
+    }
+    TF_CHECK_OK(writer->Close());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BedGraphWriterWrite)->Arg(100000);
+
+void BM_GffWriterWrite(benchmark::State& state) {
+  const string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                               "benchmark_out.gff");
+  nucleus::genomics::v1::GffRecord record;
+  record.mutable_range()->set_reference_name("chr1");
+  record.set_source("source");
+  record.set_type("exon");
+  record.set_score(0.5);
+  record.set_strand(nucleus::genomics::v1::GffRecord::REVERSE_STRAND);
+  record.set_phase(0);
+  for (auto _ : state) {
+    auto writer = std::move(
+        GffWriter::ToFile(path, nucleus::genomics::v1::GffHeader())
+            .ValueOrDie());
+    for (int i = 0; i < state.range(0); ++i) {
+      record.mutable_range()->set_start(100 * i);
+      record.mutable_range()->set_end(100 * i + 100);
+      (*record.mutable_attributes())["ID"] = absl::StrCat("exon", i);
+      (*record.mutable_attributes())["Parent"] =
+          absl::StrCat("transcript", i / 4);
+      TF_CHECK_OK(writer->Write(record));
+    }
+    TF_CHECK_OK(writer->Close());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GffWriterWrite)->Arg(100000);
+
+}  // namespace
+
+}  // namespace nucleus
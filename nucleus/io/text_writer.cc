@@ -19,7 +19,6 @@
 #include "nucleus/io/text_writer.h"
 
 #include <stddef.h>
-#include <string.h>
 #include <sys/types.h>
 #include <utility>
 
@@ -27,6 +26,7 @@
 #include "absl/strings/match.h"
 #include "htslib/bgzf.h"
 #include "htslib/hfile.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -37,8 +37,8 @@ namespace {
 // Write a string to an htslib file handle (compressed or not).
 // Parallels hts_getline; oddly, no function like this is exposed by
 // htslib.
-tensorflow::Status hts_write(htsFile* hts_file, const char *str) {
-  ssize_t str_len = strlen(str);
+tensorflow::Status hts_write(htsFile* hts_file, const char* str,
+                             ssize_t str_len) {
   ssize_t bytes_written;
 
   switch (hts_file->format.compression) {
@@ -66,6 +66,8 @@ tensorflow::Status hts_write(htsFile* hts_file, const char *str) {
 
 namespace nucleus {
 
+constexpr size_t TextWriter::kFlushSize;
+
 StatusOr<std::unique_ptr<TextWriter>> TextWriter::ToFile(
     const string& path, CompressionPolicy compression) {
   const char* mode = compression == COMPRESS ? "wb" : "w";
@@ -91,6 +93,8 @@ StatusOr<std::unique_ptr<TextWriter>> TextWriter::ToFile(const string& path) {
 TextWriter::TextWriter(htsFile* hts_file)
     : hts_file_(hts_file) {
   CHECK(hts_file_ != nullptr);
+  // Leave room for the record that takes the buffer past kFlushSize.
+  buffer_.reserve(2 * kFlushSize);
 }
 
 TextWriter::~TextWriter() {
@@ -99,12 +103,30 @@ TextWriter::~TextWriter() {
   }
 }
 
-tf::Status TextWriter::Write(const string& text) {
+tf::Status TextWriter::Write(absl::string_view text) {
   if (hts_file_ == nullptr) {
     return tf::errors::FailedPrecondition(
         "Cannot write to a closed TextWriter");
   }
-  return hts_write(hts_file_, text.c_str());
+  buffer_.append(text.data(), text.size());
+  return MaybeFlush();
+}
+
+tf::Status TextWriter::Flush() {
+  if (hts_file_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot flush a closed TextWriter");
+  }
+  if (buffer_.empty()) return tf::Status::OK();
+  tf::Status status;
+  {
+    IoStats* stats = IoStatsEnabled() ? io_stats_ : nullptr;
+    ScopedHtsBytes bytes(hts_file_, stats);
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    status = hts_write(hts_file_, buffer_.data(), buffer_.size());
+  }
+  buffer_.clear();
+  return status;
 }
 
 
@@ -113,12 +135,13 @@ tf::Status TextWriter::Close() {
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed file writer");
   }
+  tf::Status flush_status = Flush();
   int hts_ok = hts_close(hts_file_);
   hts_file_ = nullptr;
   if (hts_ok < 0) {
     return tf::errors::Internal("hts_close() failed with return code ", hts_ok);
   }
-  return tf::Status::OK();
+  return flush_status;
 }
 
 
@@ -21,7 +21,10 @@
 #include <memory>
 #include <string>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "htslib/hts.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/vendor/statusor.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -32,6 +35,11 @@ namespace nucleus {
 
 // TextWriter is a class allowing writing text to a (possibly compressed) file
 // stream
+//
+// Text is collected in an in-memory buffer and handed to htslib in large
+// chunks. Record writers format their output directly into that buffer with
+// Append, which converts numbers without allocating temporary strings, and
+// call MaybeFlush once per record.
 class TextWriter {
  public:  // Types.
   enum CompressionPolicy {
@@ -51,17 +59,48 @@ class TextWriter {
   ~TextWriter();
 
   // Write a string to the file stream.
-  tensorflow::Status Write(const string& text);
-
-  // Close the underlying file stream.
+  tensorflow::Status Write(absl::string_view text);
+
+  // Appends the concatenation of args to the buffer, formatting numbers
+  // exactly as absl::StrCat does. The text is not written to the file until
+  // the buffer is flushed.
+  template <typename... Args>
+  void Append(const Args&... args) {
+    absl::StrAppend(&buffer_, args...);
+  }
+
+  // Writes the buffer to the file stream if it holds at least kFlushSize
+  // bytes.
+  tensorflow::Status MaybeFlush() {
+    return buffer_.size() >= kFlushSize ? Flush() : tensorflow::Status::OK();
+  }
+
+  // Writes any buffered text to the file stream.
+  tensorflow::Status Flush();
+
+  // Flushes the buffer and closes the underlying file stream.
   tensorflow::Status Close();
 
+  // The buffer size above which MaybeFlush writes to the file stream.
+  static constexpr size_t kFlushSize = 256 * 1024;
+
+  // Adds the bytes this TextWriter flushes from then on, and the time it
+  // spends in htslib, to *stats, which must outlive it. Nothing is counted
+  // while stats is null, as it is by default.
+  void set_io_stats(IoStats* stats) { io_stats_ = stats; }
+
  private:
   // Private constructor.
   TextWriter(htsFile* hts_file);
 
   // Underlying htslib file stream.
   htsFile* hts_file_;
+
+  // Text appended since the last flush.
+  string buffer_;
+
+  // The statistics to update, or null.
+  IoStats* io_stats_ = nullptr;
 };
 
 }  // namespace nucleus
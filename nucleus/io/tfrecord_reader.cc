@@ -22,6 +22,35 @@
 
 namespace nucleus {
 
+namespace {
+
+// A RandomAccessFile counting the bytes read from another one as compressed
+// bytes of an IoStats.
+class CountingRandomAccessFile : public tensorflow::RandomAccessFile {
+ public:
+  CountingRandomAccessFile(std::unique_ptr<tensorflow::RandomAccessFile> file,
+                           IoStats* stats)
+      : file_(std::move(file)), stats_(stats) {}
+
+  tensorflow::Status Name(tensorflow::StringPiece* result) const override {
+    return file_->Name(result);
+  }
+
+  tensorflow::Status Read(tensorflow::uint64 offset, size_t n,
+                          tensorflow::StringPiece* result,
+                          char* scratch) const override {
+    tensorflow::Status s = file_->Read(offset, n, result, scratch);
+    if (IoStatsEnabled()) stats_->AddBytes(result->size(), 0);
+    return s;
+  }
+
+ private:
+  const std::unique_ptr<tensorflow::RandomAccessFile> file_;
+  IoStats* const stats_;
+};
+
+}  // namespace
+
 TFRecordReader::TFRecordReader() {}
 
 std::unique_ptr<TFRecordReader> TFRecordReader::New(
@@ -36,7 +65,8 @@ std::unique_ptr<TFRecordReader> TFRecordReader::New(
 
   auto reader = absl::WrapUnique<TFRecordReader>(new TFRecordReader);
   reader->offset_ = 0;
-  reader->file_ = std::move(file);
+  reader->file_ = absl::make_unique<CountingRandomAccessFile>(
+      std::move(file), &reader->io_stats_);
 
   tensorflow::io::RecordReaderOptions options =
       tensorflow::io::RecordReaderOptions::CreateRecordReaderOptions(
@@ -56,12 +86,27 @@ bool TFRecordReader::GetNext() {
     return false;
   }
 
-  tensorflow::Status s = reader_->ReadRecord(&offset_, &record_);
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  const tensorflow::uint64 start = offset_;
+  tensorflow::Status s;
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    s = reader_->ReadRecord(&offset_, &record_);
+  }
+  if (s.ok() && stats != nullptr) {
+    // The offsets are those of the uncompressed records, with their framing.
+    stats->AddBytes(0, offset_ - start);
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
 
   return s.ok();
 }
 
 void TFRecordReader::Close() {
+  if (reader_ != nullptr && IoStatsEnabled()) {
+    LOG(INFO) << "TFRecordReader statistics: " << io_stats_.ToJson();
+  }
   reader_ = nullptr;
   file_ = nullptr;
 }
@@ -21,6 +21,7 @@
 #include <memory>
 #include <string>
 
+#include "nucleus/io/io_stats.h"
 #include "nucleus/platform/types.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/platform/types.h"
@@ -55,9 +56,24 @@ class TFRecordReader {
   // has returned true.
   tensorflow::tstring record() const { return record_; }
 
+  // Returns the offset of the record the next GetNext() reads, which can be
+  // passed to Seek to resume reading there, even from another reader of the
+  // same file.
+  tensorflow::uint64 Tell() const { return offset_; }
+
+  // Makes the next GetNext() read the record at offset, as returned by Tell.
+  void Seek(tensorflow::uint64 offset) { offset_ = offset; }
+
   // Close the file and release its resources.
   void Close();
 
+  // Returns a snapshot of the statistics of this reader (see io_stats.h).
+  // Records are parsed into protos by the caller, so no conversion time is
+  // counted.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // Disallow copy and assignment operations.
   TFRecordReader(const TFRecordReader& other) = delete;
   TFRecordReader& operator=(const TFRecordReader&) = delete;
@@ -67,6 +83,9 @@ class TFRecordReader {
 
   tensorflow::uint64 offset_;
 
+  // Counts the bytes |file_| reads, so it must outlive |file_|.
+  IoStats io_stats_;
+
   // |reader_| has a non-owning pointer on |file_|, so destruct it first.
   std::unique_ptr<tensorflow::RandomAccessFile> file_;
   std::unique_ptr<tensorflow::io::RecordReader> reader_;
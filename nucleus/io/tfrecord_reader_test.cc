@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "nucleus/io/tfrecord_reader.h"
 
@@ -42,6 +43,33 @@ TEST(TFRecordReaderTest, Simple) {
   reader->Close();
 }
 
+TEST(TFRecordReaderTest, SeekResumesAtTell) {
+  const string path = GetTestData("test_likelihoods.vcf.golden.tfrecord");
+  std::unique_ptr<TFRecordReader> reader = TFRecordReader::New(path, "");
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(0u, reader->Tell());
+  ASSERT_TRUE(reader->GetNext());
+  const tensorflow::uint64 second = reader->Tell();
+  EXPECT_GT(second, 0u);
+  std::vector<tensorflow::tstring> rest;
+  while (reader->GetNext()) rest.push_back(reader->record());
+  ASSERT_FALSE(rest.empty());
+
+  // A fresh reader resumes at the checkpoint.
+  std::unique_ptr<TFRecordReader> resumed = TFRecordReader::New(path, "");
+  ASSERT_NE(resumed, nullptr);
+  resumed->Seek(second);
+  for (const auto& record : rest) {
+    ASSERT_TRUE(resumed->GetNext());
+    EXPECT_EQ(record, resumed->record());
+  }
+  EXPECT_FALSE(resumed->GetNext());
+
+  // Seeking backwards re-reads records.
+  reader->Seek(second);
+  ASSERT_TRUE(reader->GetNext());
+  EXPECT_EQ(rest[0], reader->record());
+}
 
 TEST(TFRecordReaderTest, NotFound) {
   std::unique_ptr<TFRecordReader> reader =
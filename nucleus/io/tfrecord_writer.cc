@@ -22,6 +22,42 @@
 
 namespace nucleus {
 
+namespace {
+
+// A WritableFile counting the bytes written to another one as compressed bytes
+// of an IoStats.
+class CountingWritableFile : public tensorflow::WritableFile {
+ public:
+  CountingWritableFile(std::unique_ptr<tensorflow::WritableFile> file,
+                       IoStats* stats)
+      : file_(std::move(file)), stats_(stats) {}
+
+  tensorflow::Status Append(tensorflow::StringPiece data) override {
+    if (IoStatsEnabled()) stats_->AddBytes(data.size(), 0);
+    return file_->Append(data);
+  }
+
+  tensorflow::Status Close() override { return file_->Close(); }
+
+  tensorflow::Status Flush() override { return file_->Flush(); }
+
+  tensorflow::Status Name(tensorflow::StringPiece* result) const override {
+    return file_->Name(result);
+  }
+
+  tensorflow::Status Sync() override { return file_->Sync(); }
+
+  tensorflow::Status Tell(tensorflow::int64* position) override {
+    return file_->Tell(position);
+  }
+
+ private:
+  const std::unique_ptr<tensorflow::WritableFile> file_;
+  IoStats* const stats_;
+};
+
+}  // namespace
+
 TFRecordWriter::TFRecordWriter() {}
 
 std::unique_ptr<TFRecordWriter> TFRecordWriter::New(
@@ -34,7 +70,8 @@ std::unique_ptr<TFRecordWriter> TFRecordWriter::New(
     return nullptr;
   }
   auto writer = absl::WrapUnique<TFRecordWriter>(new TFRecordWriter());
-  writer->file_ = std::move(file);
+  writer->file_ = absl::make_unique<CountingWritableFile>(std::move(file),
+                                                         &writer->io_stats_);
 
   const tensorflow::io::RecordWriterOptions& options =
       tensorflow::io::RecordWriterOptions::CreateRecordWriterOptions(
@@ -51,7 +88,19 @@ bool TFRecordWriter::WriteRecord(const std::string& record) {
   if (writer_ == nullptr) {
     return false;
   }
-  tensorflow::Status s = writer_->WriteRecord(record);
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  tensorflow::Status s;
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    s = writer_->WriteRecord(record);
+  }
+  if (s.ok() && stats != nullptr) {
+    stats->AddBytes(0, tensorflow::io::RecordWriter::kHeaderSize +
+                           record.size() +
+                           tensorflow::io::RecordWriter::kFooterSize);
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
   return s.ok();
 }
 
@@ -59,17 +108,25 @@ bool TFRecordWriter::Flush() {
   if (writer_ == nullptr) {
     return false;
   }
+  ScopedIoTimer timer(&io_stats_, IoStats::kHts);
   tensorflow:: Status s = writer_->Flush();
   return s.ok();
 }
 
 bool TFRecordWriter::Close() {
   if (writer_ != nullptr) {
-    tensorflow::Status s = writer_->Close();
+    tensorflow::Status s;
+    {
+      ScopedIoTimer timer(&io_stats_, IoStats::kHts);
+      s = writer_->Close();
+    }
     if (!s.ok()) {
       return false;
     }
     writer_ = nullptr;
+    if (IoStatsEnabled()) {
+      LOG(INFO) << "TFRecordWriter statistics: " << io_stats_.ToJson();
+    }
   }
 
   if (file_ != nullptr) {
@@ -21,6 +21,8 @@
 #include <memory>
 #include <string>
 
+#include "nucleus/io/io_stats.h"
+
 namespace tensorflow {
 class WritableFile;
 namespace io {
@@ -53,6 +55,14 @@ class TFRecordWriter {
   // Close the file and release its resources.
   bool Close();
 
+  // Returns a snapshot of the statistics of this writer (see io_stats.h).
+  // Records are serialized by the caller, so no conversion time is counted,
+  // and compressed bytes still buffered are not counted until they are
+  // flushed.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // Disallow copy and assignment operations.
   TFRecordWriter(const TFRecordWriter& other) = delete;
   TFRecordWriter& operator=(const TFRecordWriter&) = delete;
@@ -60,6 +70,9 @@ class TFRecordWriter {
  private:
   TFRecordWriter();
 
+  // Counts the bytes |file_| writes, so it must outlive |file_|.
+  IoStats io_stats_;
+
   // |writer_| has a non-owning pointer on |file_|, so destruct it first.
   std::unique_ptr<tensorflow::WritableFile> file_;
   std::unique_ptr<tensorflow::io::RecordWriter> writer_;
@@ -0,0 +1,307 @@
+# Copyright 2018 Google LLC.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""End-to-end throughput benchmark of the nucleus readers and writers.
+
+Generates a synthetic dataset of the requested size (see
+nucleus/testing/synthetic_data.py), then times these operations on the file
+of each format:
+
+  iterate: reading every record.
+  query:   reading the records of --n_queries random regions (indexed formats
+           only).
+  write:   copying every record to a new file of the same format.
+  convert: copying every record to a gzipped TFRecord file.
+
+Each operation runs in a child process of its own, so that its peak resident
+set size is measured separately; it includes the footprint of the Python
+interpreter and of nucleus itself, reported as the baseline. CPU utilization
+is the CPU time of the operation divided by its wall time, and so exceeds 1 if
+htslib uses several threads.
+
+Usage:
+
+  throughput_benchmark --output_dir=/tmp/bench --n_reads=10000000 \
+      --formats=bam,cram --json_output=/tmp/bench/results.json
+
+With --generate_only the dataset is written and nothing is timed.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import json
+import os
+import random
+import resource
+import tempfile
+import time
+
+from absl import app
+from absl import flags
+from absl import logging
+
+from nucleus.io import bed
+from nucleus.io import fastq
+from nucleus.io import gff
+from nucleus.io import sam
+from nucleus.io import vcf
+from nucleus.testing import synthetic_data
+from nucleus.util import ranges
+
+FLAGS = flags.FLAGS
+
+flags.DEFINE_string(
+    'output_dir', None,
+    'Directory of the generated dataset and of the files written by the '
+    'benchmark. Defaults to a new temporary directory.')
+flags.DEFINE_list('formats', list(synthetic_data.FORMATS),
+                  'The formats to benchmark.')
+flags.DEFINE_list('operations', ['iterate', 'query', 'write', 'convert'],
+                  'The operations to time.')
+flags.DEFINE_integer('seed', 0, 'The seed of the synthetic dataset.')
+flags.DEFINE_integer('n_contigs', 2, 'The number of reference contigs.')
+flags.DEFINE_integer('contig_length', 1000000, 'The length of each contig.')
+flags.DEFINE_integer('n_reads', 100000, 'The number of BAM/CRAM/FASTQ reads.')
+flags.DEFINE_integer('read_length', 100, 'The length of each read.')
+flags.DEFINE_integer('n_tags', 4, 'The number of aux tags of each read.')
+flags.DEFINE_integer('n_variants', 10000, 'The number of VCF/BCF variants.')
+flags.DEFINE_integer('n_samples', 10, 'The number of VCF/BCF samples.')
+flags.DEFINE_integer('n_features', 100000,
+                     'The number of BED and GFF records.')
+flags.DEFINE_integer('n_queries', 100, 'The number of regions queried.')
+flags.DEFINE_integer('query_length', 10000,
+                     'The number of bases of each queried region.')
+flags.DEFINE_string('json_output', None,
+                    'If set, the results are also written to this JSON file.')
+flags.DEFINE_boolean('generate_only', False,
+                     'If true, only write the dataset.')
+
+# The reader and writer class of each format.
+_READERS = {
+    'bam': sam.SamReader,
+    'cram': sam.SamReader,
+    'vcf': vcf.VcfReader,
+    'bcf': vcf.VcfReader,
+    'fastq': fastq.FastqReader,
+    'bed': bed.BedReader,
+    'gff': gff.GffReader,
+}
+_WRITERS = {
+    'bam': sam.SamWriter,
+    'cram': sam.SamWriter,
+    'vcf': vcf.VcfWriter,
+    'bcf': vcf.VcfWriter,
+    'fastq': fastq.FastqWriter,
+    'bed': bed.BedWriter,
+    'gff': gff.GffWriter,
+}
+# The formats whose files are indexed, and so can be queried.
+_QUERYABLE = frozenset(['bam', 'cram', 'vcf', 'bed', 'gff'])
+
+
+def _open_reader(fmt, paths):
+  if fmt == 'cram':
+    return sam.SamReader(paths[fmt], ref_path=paths['reference'])
+  return _READERS[fmt](paths[fmt])
+
+
+def _open_writer(fmt, path, header, paths):
+  if fmt == 'cram' and not path.endswith('.tfrecord.gz'):
+    return sam.SamWriter(path, header=header, ref_path=paths['reference'])
+  if fmt == 'fastq':
+    return fastq.FastqWriter(path)
+  return _WRITERS[fmt](path, header=header)
+
+
+def query_regions(config, n_queries, query_length, seed):
+  """Returns n_queries random Ranges of query_length bases."""
+  rng = random.Random(seed)
+  contigs = synthetic_data.contigs(config)
+  regions = []
+  for _ in range(n_queries):
+    contig = rng.choice(contigs)
+    start = rng.randrange(max(1, contig.n_bases - query_length))
+    regions.append(
+        ranges.make_range(contig.name, start,
+                          min(start + query_length, contig.n_bases)))
+  return regions
+
+
+def _copy(fmt, paths, output_path):
+  """Copies the records of the file of fmt to output_path, returning their
+  number."""
+  n = 0
+  with _open_reader(fmt, paths) as reader:
+    header = getattr(reader, 'header', None)
+    with _open_writer(fmt, output_path, header, paths) as writer:
+      for record in reader.iterate():
+        writer.write(record)
+        n += 1
+  return n
+
+
+def run_operation(fmt, operation, paths, regions):
+  """Runs operation on the file of fmt, returning the number of records."""
+  if operation == 'iterate':
+    with _open_reader(fmt, paths) as reader:
+      return sum(1 for _ in reader.iterate())
+  elif operation == 'query':
+    with _open_reader(fmt, paths) as reader:
+      return sum(sum(1 for _ in reader.query(region)) for region in regions)
+  elif operation == 'write':
+    name = os.path.basename(paths[fmt])
+    return _copy(fmt, paths,
+                 os.path.join(os.path.dirname(paths[fmt]), 'copy_' + name))
+  elif operation == 'convert':
+    return _copy(fmt, paths, paths[fmt] + '.tfrecord.gz')
+  raise ValueError('Unknown operation ' + operation)
+
+
+def measure(fn):
+  """Runs fn in a child process, returning its result and resource usage.
+
+  Args:
+    fn: callable returning a JSON-serializable value.
+
+  Returns:
+    A dict of the result, the wall and CPU seconds spent in fn, and the peak
+    resident set size of the child process in megabytes.
+
+  Raises:
+    RuntimeError: if fn fails.
+  """
+  read_fd, write_fd = os.pipe()
+  pid = os.fork()
+  if pid == 0:
+    os.close(read_fd)
+    status = 0
+    try:
+      start_cpu = os.times()
+      start = time.time()
+      result = fn()
+      seconds = time.time() - start
+      end_cpu = os.times()
+      cpu_seconds = (end_cpu.user - start_cpu.user + end_cpu.system -
+                     start_cpu.system)
+      message = json.dumps({
+          'result': result,
+          'seconds': seconds,
+          'cpu_seconds': cpu_seconds
+      })
+    except Exception as e:  # pylint: disable=broad-except
+      message = json.dumps({'error': repr(e)})
+      status = 1
+    with os.fdopen(write_fd, 'w') as out:
+      out.write(message)
+    os._exit(status)  # pylint: disable=protected-access
+
+  os.close(write_fd)
+  with os.fdopen(read_fd) as child:
+    message = json.loads(child.read())
+  _, _, usage = os.wait4(pid, 0)
+  if 'error' in message:
+    raise RuntimeError(message['error'])
+  # ru_maxrss is in kilobytes on Linux.
+  message['peak_rss_mb'] = usage.ru_maxrss / 1024
+  return message
+
+
+def benchmark(paths, formats, operations, regions):
+  """Times operations on the files of formats, returning a list of dicts."""
+  results = []
+  for fmt in formats:
+    size = os.path.getsize(paths[fmt])
+    for operation in operations:
+      if operation == 'query' and fmt not in _QUERYABLE:
+        continue
+      # Binds the loop variables of this iteration.
+      run = lambda f=fmt, o=operation: run_operation(f, o, paths, regions)
+      usage = measure(run)
+      result = {
+          'format': fmt,
+          'operation': operation,
+          'records': usage['result'],
+          'seconds': usage['seconds'],
+          'records_per_second': usage['result'] / max(usage['seconds'], 1e-9),
+          'cpu_utilization': usage['cpu_seconds'] / max(usage['seconds'],
+                                                        1e-9),
+          'peak_rss_mb': usage['peak_rss_mb'],
+      }
+      # Queries read only parts of the file.
+      if operation != 'query':
+        result['file_bytes'] = size
+        result['mb_per_second'] = size / 1e6 / max(usage['seconds'], 1e-9)
+      results.append(result)
+      logging.info('%s', result)
+  return results
+
+
+def _format_table(results, baseline_rss_mb):
+  lines = [
+      'Baseline RSS: {:.1f} MB'.format(baseline_rss_mb),
+      '{:<6} {:<8} {:>10} {:>9} {:>12} {:>8} {:>6} {:>9}'.format(
+          'format', 'op', 'records', 'seconds', 'records/s', 'MB/s', 'cpu',
+          'rss MB')
+  ]
+  for r in results:
+    lines.append('{:<6} {:<8} {:>10} {:>9.3f} {:>12.0f} {:>8} {:>6.2f} '
+                  '{:>9.1f}'.format(
+                      r['format'], r['operation'], r['records'], r['seconds'],
+                      r['records_per_second'],
+                      '{:.1f}'.format(r['mb_per_second'])
+                      if 'mb_per_second' in r else '-', r['cpu_utilization'],
+                      r['peak_rss_mb']))
+  return '\n'.join(lines)
+
+
+def main(argv):
+  if len(argv) > 1:
+    raise app.UsageError('Too many command-line arguments.')
+  for fmt in FLAGS.formats:
+    if fmt not in synthetic_data.FILENAMES:
+      raise app.UsageError('Unknown format ' + fmt)
+
+  output_dir = FLAGS.output_dir or tempfile.mkdtemp()
+  config = synthetic_data.SyntheticConfig(
+      seed=FLAGS.seed,
+      n_contigs=FLAGS.n_contigs,
+      contig_length=FLAGS.contig_length,
+      n_reads=FLAGS.n_reads,
+      read_length=FLAGS.read_length,
+      n_tags=FLAGS.n_tags,
+      n_variants=FLAGS.n_variants,
+      n_samples=FLAGS.n_samples,
+      n_features=FLAGS.n_features)
+  start = time.time()
+  paths = synthetic_data.write_dataset(output_dir, config, FLAGS.formats)
+  logging.info('Wrote the dataset to %s in %.1f seconds.', output_dir,
+               time.time() - start)
+  if FLAGS.generate_only:
+    return
+
+  regions = query_regions(config, FLAGS.n_queries, FLAGS.query_length,
+                          FLAGS.seed)
+  results = benchmark(paths, FLAGS.formats, FLAGS.operations, regions)
+  baseline_rss_mb = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024
+  print(_format_table(results, baseline_rss_mb))
+  if FLAGS.json_output:
+    with open(FLAGS.json_output, 'w') as f:
+      json.dump({'baseline_rss_mb': baseline_rss_mb, 'results': results},
+                f,
+                indent=2)
+
+
+if __name__ == '__main__':
+  app.run(main)
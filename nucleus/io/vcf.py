@@ -149,7 +149,8 @@ class NativeVcfReader(genomics_reader.GenomicsReader):
                excluded_info_fields=None,
                excluded_format_fields=None,
                store_gl_and_pl_in_info_map=False,
-               header=None):
+               header=None,
+               share_index=False):
     """Initializer for NativeVcfReader.
 
     Args:
@@ -164,13 +165,17 @@ class NativeVcfReader(genomics_reader.GenomicsReader):
         values in the VariantCall.genotype_likelihood field.
       header: If not None, specifies the variants_pb2.VcfHeader. The file at
         input_path must not contain any header information.
+      share_index: bool. If True, the tabix index is shared with the other
+        readers of the same file in this process that set share_index, rather
+        than loaded again.
     """
     super(NativeVcfReader, self).__init__()
 
     options = variants_pb2.VcfReaderOptions(
         excluded_info_fields=excluded_info_fields,
         excluded_format_fields=excluded_format_fields,
-        store_gl_and_pl_in_info_map=store_gl_and_pl_in_info_map)
+        store_gl_and_pl_in_info_map=store_gl_and_pl_in_info_map,
+        share_index=share_index)
     if header is not None:
       self._reader = vcf_reader.VcfReader.from_file_with_header(
           input_path.encode('utf8'), options, header)
@@ -189,6 +194,18 @@ class NativeVcfReader(genomics_reader.GenomicsReader):
     """Returns an iterator for going through variants in the region."""
     return self._reader.query(region)
 
+  def index_statistics(self):
+    """Returns the IndexStatistics proto read from the index of the file."""
+    return self._reader.index_statistics()
+
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this reader.
+
+    The statistics are only collected while enabled with
+    nucleus.io.python.io_stats.set_enabled(True).
+    """
+    return self._reader.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._reader.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -276,6 +293,10 @@ class NativeVcfWriter(genomics_writer.GenomicsWriter):
   def write(self, proto):
     self._writer.write(proto)
 
+  def io_statistics(self):
+    """Returns the IoStatistics proto of this writer."""
+    return self._writer.io_statistics()
+
   def __exit__(self, exit_type, exit_value, exit_traceback):
     self._writer.__exit__(exit_type, exit_value, exit_traceback)
 
@@ -29,7 +29,12 @@
 #include "absl/memory/memory.h"
 #include "htslib/kstring.h"
 #include "htslib/vcf.h"
+#include "nucleus/io/byte_balanced_partitioner.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
+#include "nucleus/io/index_cache.h"
+#include "nucleus/io/index_statistics.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/io/vcf_conversion.h"
 #include "nucleus/protos/range.pb.h"
 #include "nucleus/protos/reference.pb.h"
@@ -45,6 +50,8 @@ namespace nucleus {
 namespace tf = tensorflow;
 
 using std::vector;
+using nucleus::genomics::v1::ContigInfo;
+using nucleus::genomics::v1::IndexStatistics;
 using nucleus::genomics::v1::Range;
 using nucleus::genomics::v1::Variant;
 using nucleus::genomics::v1::VariantCall;
@@ -55,6 +62,22 @@ bool FileTypeIsIndexable(htsFormat format) {
   return format.format == vcf && format.compression == bgzf;
 }
 
+// Converts record to out with the converter of reader, adding the time spent
+// to stats if it is not null.
+tf::Status ConvertRecord(const VcfReader* reader, const bcf_hdr_t* header,
+                         bcf1_t* record, IoStats* stats, Variant* out) {
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(
+        reader->RecordConverter().ConvertToPb(header, record, out));
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
+  }
+  return tf::Status::OK();
+}
+
 
 }  // namespace
 
@@ -73,15 +96,40 @@ class VcfQueryIterable : public VariantIterable {
 
   ~VcfQueryIterable() override;
 
- private:
+ protected:
   htsFile* fp_;
   bcf_hdr_t* header_;
+
+ private:
   bcf1_t* bcf1_;
   tbx_t* idx_;
   hts_itr_t* iter_;
   kstring_t str_;
 };
 
+// Iterable class for traversing VCF records returned in a query window
+// through a file handle and header of its own. It shares the index with the
+// reader, so that closing the reader while it runs frees neither.
+class VcfQueryCursor : public VcfQueryIterable {
+ public:
+  // Constructor will be invoked via VcfReader::QueryCursor, which hands over
+  // ownership of fp and header.
+  VcfQueryCursor(const VcfReader* reader, htsFile* fp, bcf_hdr_t* header,
+                 std::shared_ptr<tbx_t> idx, hts_itr_t* iter)
+      : VcfQueryIterable(reader, fp, header, idx.get(), iter),
+        shared_idx_(std::move(idx)) {}
+
+  ~VcfQueryCursor() override {
+    bcf_hdr_destroy(header_);
+    if (hts_close(fp_) < 0) {
+      LOG(WARNING) << "hts_close() failed on a VcfQueryCursor";
+    }
+  }
+
+ private:
+  const std::shared_ptr<tbx_t> shared_idx_;
+};
+
 
 // Iterable class for traversing all VCF records in the file.
 class VcfFullFileIterable : public VariantIterable {
@@ -96,6 +144,9 @@ class VcfFullFileIterable : public VariantIterable {
 
   ~VcfFullFileIterable() override;
 
+  StatusOr<int64> Tell() override;
+  tf::Status Seek(int64 offset) override;
+
  private:
   htsFile* fp_;
   bcf_hdr_t* header_;
@@ -146,14 +197,18 @@ StatusOr<std::unique_ptr<VcfReader>> VcfReader::FromFileHelper(
   }
 
   // Try to load the Tabix index if requested.
-  tbx_t* idx = nullptr;
+  std::shared_ptr<tbx_t> idx;
   if (FileTypeIsIndexable(fp->format)) {
-    idx = tbx_index_load(fp->fn);
     // idx may be null; only an error if we try to Query later.
+    if (options.share_index()) {
+      idx = IndexCache::Global()->LoadTabixIndex(vcf_filepath, fp);
+    } else if (tbx_t* own_idx = tbx_index_load(fp->fn)) {
+      idx.reset(own_idx, tbx_destroy);
+    }
   }
 
   return absl::WrapUnique<VcfReader>(
-      new VcfReader(vcf_filepath, options, fp, h, idx));
+      new VcfReader(vcf_filepath, options, fp, h, std::move(idx)));
 }
 
 void VcfReader::NativeHeaderUpdated() {
@@ -169,12 +224,13 @@ void VcfReader::NativeHeaderUpdated() {
 
 VcfReader::VcfReader(const string& vcf_filepath,
                      const nucleus::genomics::v1::VcfReaderOptions& options,
-                     htsFile* fp, bcf_hdr_t* header, tbx_t* idx)
+                     htsFile* fp, bcf_hdr_t* header,
+                     std::shared_ptr<tbx_t> idx)
     : vcf_filepath_(vcf_filepath),
       options_(options),
       fp_(fp),
       header_(header),
-      idx_(idx),
+      idx_(std::move(idx)),
       bcf1_(bcf_init()) {
   NativeHeaderUpdated();
 }
@@ -202,7 +258,86 @@ StatusOr<std::shared_ptr<VariantIterable>> VcfReader::Query(
   if (!HasIndex()) {
     return tf::errors::FailedPrecondition("Cannot query without an index");
   }
+  StatusOr<hts_itr_t*> iter = QueryIterator(region);
+  TF_RETURN_IF_ERROR(iter.status());
+  return StatusOr<std::shared_ptr<VariantIterable>>(
+      MakeIterable<VcfQueryIterable>(this, fp_, header_, idx_.get(),
+                                     iter.ValueOrDie()));
+}
+
+StatusOr<std::shared_ptr<VariantIterable>> VcfReader::QueryCursor(
+    const Range& region) const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot QueryCursor a closed VcfReader.");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition("Cannot query without an index");
+  }
+  StatusOr<hts_itr_t*> iter = QueryIterator(region);
+  TF_RETURN_IF_ERROR(iter.status());
 
+  htsFile* fp = hts_open_x(vcf_filepath_, "r");
+  if (fp == nullptr) {
+    hts_itr_destroy(iter.ValueOrDie());
+    return tf::errors::NotFound("Could not open ", vcf_filepath_);
+  }
+  // Parsing a record adds the contigs and fields it uses that are missing
+  // from the header, so each cursor parses with a copy of its own. The copy
+  // also outlives header_ if this reader is closed while the cursor runs.
+  bcf_hdr_t* header = bcf_hdr_dup(header_);
+  if (header == nullptr) {
+    hts_itr_destroy(iter.ValueOrDie());
+    hts_close(fp);
+    return tf::errors::Unknown("Failed to copy the header of ", vcf_filepath_);
+  }
+  return StatusOr<std::shared_ptr<VariantIterable>>(MakeCursor<VcfQueryCursor>(
+      this, fp, header, idx_, iter.ValueOrDie()));
+}
+
+StatusOr<std::vector<Range>> VcfReader::PartitionByBytes(
+    absl::Span<const Range> regions, int num_shards) const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot PartitionByBytes a closed VcfReader.");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition(
+        "Partitioning by bytes requires an index");
+  }
+  for (const Range& region : regions) {
+    if (bcf_hdr_name2id(header_, region.reference_name().c_str()) < 0) {
+      return tf::errors::NotFound("Unknown reference_name '",
+                                  region.reference_name(), "'");
+    }
+  }
+  // Contigs without records are not in the tabix index, and get no bytes.
+  return PartitionByIndexedBytes(
+      idx_->idx,
+      [this](const string& name) {
+        return tbx_name2id(idx_.get(), name.c_str());
+      },
+      regions, num_shards);
+}
+
+StatusOr<IndexStatistics> VcfReader::GetIndexStatistics() const {
+  if (fp_ == nullptr) {
+    return tf::errors::FailedPrecondition(
+        "Cannot GetIndexStatistics of a closed VcfReader.");
+  }
+  if (!HasIndex()) {
+    return tf::errors::FailedPrecondition("Index statistics require an index");
+  }
+  std::vector<string> names;
+  for (const ContigInfo& contig : vcf_header_.contigs()) {
+    names.push_back(contig.name());
+  }
+  return ReadIndexStatistics(idx_->idx, names, [this](const string& name) {
+    return tbx_name2id(idx_.get(), name.c_str());
+  });
+}
+
+StatusOr<hts_itr_t*> VcfReader::QueryIterator(const Range& region) const {
   const char* reference_name = region.reference_name().c_str();
   if (bcf_hdr_name2id(header_, reference_name) < 0) {
     return tf::errors::NotFound(
@@ -213,12 +348,12 @@ StatusOr<std::shared_ptr<VariantIterable>> VcfReader::Query(
         "Malformed region '", region.ShortDebugString(), "'");
 
   // Get the tid (index of reference_name in our tabix index),
-  const int tid = tbx_name2id(idx_, reference_name);
+  const int tid = tbx_name2id(idx_.get(), reference_name);
   hts_itr_t* iter = nullptr;
   if (tid >= 0) {
     // Note that query is 0-based inclusive on start and exclusive on end,
     // matching exactly the logic of our Range.
-    iter = tbx_itr_queryi(idx_, tid, region.start(), region.end());
+    iter = tbx_itr_queryi(idx_.get(), tid, region.start(), region.end());
     if (iter == nullptr) {
       return tf::errors::NotFound(
           "region '", region.ShortDebugString(),
@@ -227,8 +362,7 @@ StatusOr<std::shared_ptr<VariantIterable>> VcfReader::Query(
   }  // implicit else case:
   // The chromosome isn't reflected in the tabix index (meaning, no
   // variant records) => return an *empty* iterable by leaving iter empty.
-  return StatusOr<std::shared_ptr<VariantIterable>>(
-      MakeIterable<VcfQueryIterable>(this, fp_, header_, idx_, iter));
+  return iter;
 }
 
 tf::Status VcfReader::FromString(
@@ -273,10 +407,13 @@ StatusOr<bool> VcfReader::FromStringPython(
 tf::Status VcfReader::Close() {
   if (fp_ == nullptr)
     return tf::errors::FailedPrecondition("VcfReader already closed");
-  if (HasIndex()) {
-    tbx_destroy(idx_);
-    idx_ = nullptr;
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "VcfReader statistics: " << io_stats()->ToJson();
   }
+  // Iterables and cursors use the header and index, so must not outlive them.
+  DetachIterables();
+  // The index is freed here unless other readers share it.
+  idx_.reset();
   bcf_hdr_destroy(header_);
   header_ = nullptr;
   int retval = hts_close(fp_);
@@ -292,13 +429,17 @@ tf::Status VcfReader::Close() {
 
 StatusOr<bool> VcfQueryIterable::Next(Variant* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
-  if (tbx_itr_next(fp_, idx_, iter_, &str_) < 0) return false;
-  if (vcf_parse1(&str_, header_, bcf1_) < 0) {
-    return tf::errors::DataLoss("Failed to parse VCF record: ", str_.s);
-  }
   const VcfReader* reader = static_cast<const VcfReader*>(reader_);
-  TF_RETURN_IF_ERROR(
-      reader->RecordConverter().ConvertToPb(header_, bcf1_, out));
+  IoStats* stats = IoStatsEnabled() ? reader->io_stats() : nullptr;
+  ScopedHtsBytes bytes(fp_, stats);
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    if (tbx_itr_next(fp_, idx_, iter_, &str_) < 0) return false;
+    if (vcf_parse1(&str_, header_, bcf1_) < 0) {
+      return tf::errors::DataLoss("Failed to parse VCF record: ", str_.s);
+    }
+  }
+  TF_RETURN_IF_ERROR(ConvertRecord(reader, header_, bcf1_, stats, out));
   return true;
 }
 
@@ -325,16 +466,20 @@ VcfQueryIterable::VcfQueryIterable(const VcfReader* reader,
 
 StatusOr<bool> VcfFullFileIterable::Next(Variant* out) {
   TF_RETURN_IF_ERROR(CheckIsAlive());
-  if (bcf_read(fp_, header_, bcf1_) < 0) {
-    if (bcf1_->errcode) {
-      return tf::errors::DataLoss("Failed to parse VCF record");
-    } else {
-      return false;
+  const VcfReader* reader = static_cast<const VcfReader*>(reader_);
+  IoStats* stats = IoStatsEnabled() ? reader->io_stats() : nullptr;
+  ScopedHtsBytes bytes(fp_, stats);
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    if (bcf_read(fp_, header_, bcf1_) < 0) {
+      if (bcf1_->errcode) {
+        return tf::errors::DataLoss("Failed to parse VCF record");
+      } else {
+        return false;
+      }
     }
   }
-  const VcfReader* reader = static_cast<const VcfReader*>(reader_);
-  TF_RETURN_IF_ERROR(
-      reader->RecordConverter().ConvertToPb(header_, bcf1_, out));
+  TF_RETURN_IF_ERROR(ConvertRecord(reader, header_, bcf1_, stats, out));
   return true;
 }
 
@@ -342,6 +487,16 @@ VcfFullFileIterable::~VcfFullFileIterable() {
   bcf_destroy(bcf1_);
 }
 
+StatusOr<int64> VcfFullFileIterable::Tell() {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  return TellRecordOffset(fp_);
+}
+
+tf::Status VcfFullFileIterable::Seek(int64 offset) {
+  TF_RETURN_IF_ERROR(CheckIsAlive());
+  return SeekRecordOffset(fp_, offset);
+}
+
 VcfFullFileIterable::VcfFullFileIterable(const VcfReader* reader,
                                          htsFile* fp,
                                          bcf_hdr_t* header)
@@ -20,8 +20,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "htslib/hts.h"
 #include "htslib/sam.h"
 #include "htslib/tbx.h"
@@ -121,6 +123,32 @@ class VcfReader : public Reader {
   StatusOr<std::shared_ptr<VariantIterable>> Query(
       const nucleus::genomics::v1::Range& region);
 
+  // Gets all of the variants that overlap any bases in range, through a
+  // cursor.
+  //
+  // Unlike the iterables returned by Query, any number of cursors can be live
+  // at once, alongside an iterable, and each can be used from its own thread:
+  // a cursor reads through a file handle and a copy of the htslib header of
+  // its own, sharing only the index and record converter with this reader.
+  // FromString must not be called while cursors are in use, as it may update
+  // the record converter. Closing this reader while cursors run on other
+  // threads is safe: their next call to Next fails, and they can still be
+  // released. This reader must not be destroyed while they run, though.
+  StatusOr<std::shared_ptr<VariantIterable>> QueryCursor(
+      const nucleus::genomics::v1::Range& region) const;
+
+  // Splits regions into about num_shards shards holding roughly equal amounts
+  // of data, as estimated from the tabix index alone (see
+  // byte_balanced_partitioner.h).
+  StatusOr<std::vector<nucleus::genomics::v1::Range>> PartitionByBytes(
+      absl::Span<const nucleus::genomics::v1::Range> regions,
+      int num_shards) const;
+
+  // Returns the per-contig record counts and sizes recorded by the tabix
+  // index, for each contig of the header, without reading any records (see
+  // index_statistics.h). All records are counted as mapped.
+  StatusOr<nucleus::genomics::v1::IndexStatistics> GetIndexStatistics() const;
+
   // Parses vcf_line and puts the result into v.
   tensorflow::Status FromString(const absl::string_view& vcf_line,
                                 nucleus::genomics::v1::Variant* v);
@@ -156,7 +184,13 @@ class VcfReader : public Reader {
  private:
   VcfReader(const string& variants_path,
             const nucleus::genomics::v1::VcfReaderOptions& options, htsFile* fp,
-            bcf_hdr_t* header, tbx_t* idx);
+            bcf_hdr_t* header, std::shared_ptr<tbx_t> idx);
+
+  // Creates an iterator over the records overlapping region, or returns a
+  // non-OK status if region is malformed. The iterator is null if the index
+  // has no records on the region's contig.
+  StatusOr<hts_itr_t*> QueryIterator(
+      const nucleus::genomics::v1::Range& region) const;
 
   // Shared by FromFile methods. If |h| is non-null, use it as the header for
   // the vcf file at |vcf_filepath|.
@@ -182,8 +216,9 @@ class VcfReader : public Reader {
   bcf_hdr_t * header_;
 
   // The htslib tbx_t data structure for tabix indexed files. May be NULL if no
-  // index was loaded.
-  tbx_t* idx_;
+  // index was loaded. It is shared with other readers of the file if the
+  // share_index option is set.
+  std::shared_ptr<tbx_t> idx_;
 
   // The VcfHeader data structure that represents the information in the header
   // of the VCF.
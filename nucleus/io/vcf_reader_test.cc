@@ -18,6 +18,8 @@
 #include "nucleus/io/vcf_reader.h"
 
 #include <stddef.h>
+#include <map>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -45,6 +47,8 @@ using ::testing::Not;
 using ::testing::Pointwise;
 using ::testing::SizeIs;
 
+using nucleus::genomics::v1::ContigIndexStatistics;
+using nucleus::genomics::v1::IndexStatistics;
 using nucleus::genomics::v1::Variant;
 using nucleus::proto::IgnoringFieldPaths;
 
@@ -323,6 +327,34 @@ TEST_F(VcfWithSamplesReaderTest, IterationWorksWithIndex) {
   EXPECT_THAT(as_vector(reader_->Iterate()), Pointwise(EqualsProto(), golden_));
 }
 
+TEST_F(VcfWithSamplesReaderTest, SeekResumesAtTell) {
+  for (const char* filename : {kVcfIndexSamplesFilename, kVcfSamplesFilename}) {
+    std::unique_ptr<VcfReader> reader = std::move(
+        VcfReader::FromFile(GetTestData(filename), options_).ValueOrDie());
+    std::shared_ptr<VariantIterable> iterable = reader->Iterate().ValueOrDie();
+    // Checkpoint before any variant is read, and after 100 of them.
+    StatusOr<int64> start = iterable->Tell();
+    ASSERT_THAT(start, IsOK()) << filename;
+    Variant variant;
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(iterable->Next(&variant).ValueOrDie()) << filename;
+    }
+    StatusOr<int64> middle = iterable->Tell();
+    ASSERT_THAT(middle, IsOK()) << filename;
+    ASSERT_THAT(iterable->Release(), IsOK());
+
+    std::shared_ptr<VariantIterable> resumed = reader->Iterate().ValueOrDie();
+    ASSERT_THAT(resumed->Seek(middle.ValueOrDie()), IsOK()) << filename;
+    EXPECT_THAT(as_vector(resumed),
+                Pointwise(EqualsProto(), vector<Variant>(golden_.begin() + 100,
+                                                         golden_.end())))
+        << filename;
+    ASSERT_THAT(resumed->Seek(start.ValueOrDie()), IsOK()) << filename;
+    EXPECT_THAT(as_vector(resumed), Pointwise(EqualsProto(), golden_))
+        << filename;
+  }
+}
+
 TEST_F(VcfWithSamplesReaderTest, FilteringInfoFieldsWorks) {
   // Checks that iterate() filters FORMAT fields out as we expect.
   nucleus::genomics::v1::VcfReaderOptions options;
@@ -411,6 +443,52 @@ TEST_F(VcfWithSamplesReaderTest, QueryWorks) {
               Pointwise(EqualsProto(), subgolden));
 }
 
+TEST_F(VcfWithSamplesReaderTest, ConcurrentCursorsMatchGolden) {
+  const vector<string> contigs = {"chr1", "chr2", "chr3", "chr4", "chrX"};
+  vector<vector<Variant>> expected(contigs.size());
+  for (const Variant& v : golden_) {
+    for (size_t i = 0; i < contigs.size(); ++i) {
+      if (v.reference_name() == contigs[i]) expected[i].push_back(v);
+    }
+  }
+
+  // The cursors are all live at once, alongside an iterable.
+  std::shared_ptr<VariantIterable> iterable = reader_->Iterate().ValueOrDie();
+  vector<std::shared_ptr<VariantIterable>> cursors;
+  for (const string& contig : contigs) {
+    cursors.push_back(
+        reader_->QueryCursor(MakeRange(contig, 0, CHR1_SIZE)).ValueOrDie());
+  }
+  vector<vector<Variant>> actual(contigs.size());
+  vector<std::thread> threads;
+  for (size_t i = 0; i < cursors.size(); ++i) {
+    threads.emplace_back([&cursors, &actual, i]() {
+      Variant variant;
+      while (cursors[i]->Next(&variant).ValueOrDie()) {
+        actual[i].push_back(variant);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < contigs.size(); ++i) {
+    EXPECT_THAT(actual[i], Pointwise(EqualsProto(), expected[i]));
+  }
+  EXPECT_THAT(as_vector(iterable), Pointwise(EqualsProto(), golden_));
+}
+
+TEST_F(VcfWithSamplesReaderTest, CloseDetachesCursors) {
+  Variant variant;
+  std::shared_ptr<VariantIterable> cursor =
+      reader_->QueryCursor(MakeRange("chr1", 0, CHR1_SIZE)).ValueOrDie();
+  ASSERT_THAT(cursor->Next(&variant), IsOK());
+  ASSERT_THAT(reader_->Close(), IsOK());
+  EXPECT_THAT(cursor->Next(&variant),
+              IsNotOKWithMessage("Reader is not alive"));
+  EXPECT_THAT(cursor->Release(), IsOK());
+}
+
 TEST_F(VcfWithSamplesReaderTest, QueryRangesIsCorrect) {
   // There's a variant at chr3:14319, test that query works exactly.
   EXPECT_THAT(as_vector(reader_->Query(MakeRange("chr3", 14318, 14319))),
@@ -447,6 +525,30 @@ TEST_F(VcfWithSamplesReaderTest, WholeChromosomeQueries) {
               SizeIs(2));
 }
 
+TEST_F(VcfWithSamplesReaderTest, IndexStatisticsCountRecords) {
+  StatusOr<IndexStatistics> stats = reader_->GetIndexStatistics();
+  ASSERT_THAT(stats, IsOK());
+  ASSERT_THAT(stats.ValueOrDie().contigs(),
+              SizeIs(reader_->Header().contigs_size()));
+  // The same counts as the whole chromosome queries above.
+  const std::map<string, int64> expected = {
+      {"chr1", 711}, {"chr2", 34}, {"chr3", 6}, {"chrX", 2}};
+  for (const ContigIndexStatistics& contig : stats.ValueOrDie().contigs()) {
+    const auto it = expected.find(contig.name());
+    EXPECT_EQ(it == expected.end() ? 0 : it->second, contig.n_mapped())
+        << contig.name();
+    EXPECT_EQ(0, contig.n_unmapped()) << contig.name();
+  }
+  EXPECT_GT(stats.ValueOrDie().contigs(0).n_compressed_bytes(), 0);
+
+  std::unique_ptr<VcfReader> unindexed = std::move(
+      VcfReader::FromFile(GetTestData(kVcfSamplesFilename),
+                          nucleus::genomics::v1::VcfReaderOptions())
+          .ValueOrDie());
+  EXPECT_THAT(unindexed->GetIndexStatistics(),
+              IsNotOKWithCode(tensorflow::error::FAILED_PRECONDITION));
+}
+
 TEST(VcfReaderLikelihoodsTest, MatchesGolden) {
   std::unique_ptr<VcfReader> reader =
       std::move(VcfReader::FromFile(GetTestData(kVcfLikelihoodsFilename),
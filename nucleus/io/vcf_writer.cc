@@ -28,6 +28,7 @@
 #include "absl/strings/substitute.h"
 #include "htslib/hts.h"
 #include "htslib/sam.h"
+#include "nucleus/io/hts_offsets.h"
 #include "nucleus/io/hts_path.h"
 #include "nucleus/io/vcf_conversion.h"
 #include "nucleus/protos/reference.pb.h"
@@ -126,20 +127,32 @@ VcfWriter::~VcfWriter() {
 tf::Status VcfWriter::Write(const Variant& variant_message) {
   if (fp_ == nullptr)
     return tf::errors::FailedPrecondition("Cannot write to closed VCF stream.");
+  IoStats* stats = IoStatsEnabled() ? &io_stats_ : nullptr;
+  ScopedHtsBytes bytes(fp_, stats);
   BCFRecord v;
   if (v.get_bcf1() == nullptr) {
     return tf::errors::Unknown("bcf_init call failed");
   }
-  TF_RETURN_IF_ERROR(
-      RecordConverter().ConvertFromPb(variant_message, *header_, v.get_bcf1()));
+  {
+    ScopedIoTimer timer(stats, IoStats::kConvert);
+    TF_RETURN_IF_ERROR(RecordConverter().ConvertFromPb(variant_message,
+                                                       *header_, v.get_bcf1()));
+  }
   if (options_.round_qual_values() &&
       !bcf_float_is_missing(v.get_bcf1()->qual)) {
     // Round quality value printed out to one digit past the decimal point.
     double rounded_quality = floor(variant_message.quality() * 10 + 0.5) / 10;
     v.get_bcf1()->qual = rounded_quality;
   }
-  if (bcf_write(fp_, header_, v.get_bcf1()) != 0) {
-    return tf::errors::Unknown("bcf_write call failed");
+  {
+    ScopedIoTimer timer(stats, IoStats::kHts);
+    if (bcf_write(fp_, header_, v.get_bcf1()) != 0) {
+      return tf::errors::Unknown("bcf_write call failed");
+    }
+  }
+  if (stats != nullptr) {
+    stats->AddRecordDecoded();
+    stats->AddRecordKept();
   }
   return tf::Status::OK();
 }
@@ -148,6 +161,9 @@ tf::Status VcfWriter::Close() {
   if (fp_ == nullptr)
     return tf::errors::FailedPrecondition(
         "Cannot close an already closed VcfWriter");
+  if (IoStatsEnabled()) {
+    LOG(INFO) << "VcfWriter statistics: " << io_stats_.ToJson();
+  }
   if (hts_close(fp_) < 0)
     return tf::errors::Unknown("hts_close call failed");
   fp_ = nullptr;
@@ -24,6 +24,7 @@
 #include "htslib/hts.h"
 #include "htslib/sam.h"
 #include "htslib/vcf.h"
+#include "nucleus/io/io_stats.h"
 #include "nucleus/io/vcf_conversion.h"
 #include "nucleus/platform/types.h"
 #include "nucleus/protos/range.pb.h"
@@ -67,6 +68,12 @@ class VcfWriter {
   // error occurred.
   tensorflow::Status Close();
 
+  // Returns a snapshot of the statistics of this writer (see io_stats.h).
+  // Bytes still buffered by htslib are not counted until they are flushed.
+  nucleus::genomics::v1::IoStatistics Stats() const {
+    return io_stats_.ToProto();
+  }
+
   // This no-op function is needed only for Python context manager support.  Do
   // not use it!
   void PythonEnter() const {}
@@ -106,6 +113,9 @@ class VcfWriter {
 
   // VCF record interconverter.
   VcfRecordConverter record_converter_;
+
+  // The statistics of this writer.
+  IoStats io_stats_;
 };
 
 }  // namespace nucleus
@@ -0,0 +1,452 @@
+# Copyright 2018 Google LLC.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Deterministic generator of large synthetic genomics files.
+
+The files in nucleus/testdata are tiny. This module writes files of realistic
+volume for throughput testing: a reference FASTA, coordinate-sorted BAM and
+CRAM files with their indexes, bgzipped VCF with a tabix index and BCF with
+many samples, and FASTQ, BED and GFF files, the last two bgzipped with tabix
+indexes.
+
+Every record is a pure function of a SyntheticConfig, so a configuration always
+produces the same records, and the same files as long as htslib compresses them
+the same way.
+
+Typical usage:
+
+  config = synthetic_data.SyntheticConfig(n_reads=10000000, n_samples=1000)
+  paths = synthetic_data.write_dataset(output_dir, config)
+  with sam.SamReader(paths['bam']) as reader:
+    ...
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import random
+
+from nucleus.io import bed
+from nucleus.io import fastq
+from nucleus.io import gff
+from nucleus.io import sam
+from nucleus.io import tabix
+from nucleus.io import vcf
+from nucleus.protos import bed_pb2
+from nucleus.protos import cigar_pb2
+from nucleus.protos import fastq_pb2
+from nucleus.protos import gff_pb2
+from nucleus.protos import position_pb2
+from nucleus.protos import range_pb2
+from nucleus.protos import reads_pb2
+from nucleus.protos import reference_pb2
+from nucleus.protos import variants_pb2
+
+# The formats written by write_dataset, and the names of their files.
+FILENAMES = {
+    'bam': 'reads.bam',
+    'cram': 'reads.cram',
+    'vcf': 'variants.vcf.gz',
+    'bcf': 'variants.bcf',
+    'fastq': 'reads.fastq.gz',
+    'bed': 'features.bed.gz',
+    'gff': 'features.gff.gz',
+}
+FORMATS = tuple(sorted(FILENAMES))
+
+# The name of the reference FASTA written alongside the CRAM file.
+REFERENCE_FILENAME = 'reference.fa'
+
+_BASES = 'ACGT'
+# The sequences of all bytes, two bits per base.
+_BYTE_BASES = [
+    ''.join(_BASES[(b >> shift) & 3] for shift in (0, 2, 4, 6))
+    for b in range(256)
+]
+# Aux tags reserved for end users, so never clashing with standard tags.
+_TAG_CHARS = '0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ'
+_TAGS = [first + c for first in 'XYZ' for c in _TAG_CHARS]
+# The number of distinct base quality strings used by the reads.
+_N_QUALITY_PROFILES = 64
+# The bases between consecutive reference FASTA lines.
+_FASTA_LINE_BASES = 60
+
+
+class SyntheticConfig(object):
+  """The sizes and shapes of a synthetic dataset.
+
+  Attributes:
+    seed: int. The seed of all of the random choices.
+    n_contigs: int. The number of contigs of the reference, named chr1, chr2...
+    contig_length: int. The number of bases of each contig.
+    n_reads: int. The number of reads of the BAM, CRAM and FASTQ files.
+    read_length: int. The number of bases of each read.
+    n_tags: int. The number of aux tags of each read, at most 108.
+    n_variants: int. The number of variants of the VCF and BCF files.
+    n_samples: int. The number of samples of the VCF and BCF files.
+    n_features: int. The number of records of the BED and GFF files.
+  """
+
+  def __init__(self,
+               seed=0,
+               n_contigs=2,
+               contig_length=1000000,
+               n_reads=100000,
+               read_length=100,
+               n_tags=4,
+               n_variants=10000,
+               n_samples=10,
+               n_features=100000):
+    if n_tags > len(_TAGS):
+      raise ValueError('At most {} tags are supported, not {}'.format(
+          len(_TAGS), n_tags))
+    if read_length > contig_length:
+      raise ValueError('read_length must not exceed contig_length')
+    self.seed = seed
+    self.n_contigs = n_contigs
+    self.contig_length = contig_length
+    self.n_reads = n_reads
+    self.read_length = read_length
+    self.n_tags = n_tags
+    self.n_variants = n_variants
+    self.n_samples = n_samples
+    self.n_features = n_features
+
+
+def contigs(config):
+  """Returns the ContigInfo protos of the reference of config."""
+  return [
+      reference_pb2.ContigInfo(
+          name='chr{}'.format(i + 1), n_bases=config.contig_length,
+          pos_in_fasta=i) for i in range(config.n_contigs)
+  ]
+
+
+def reference_sequences(config):
+  """Returns a dict from contig name to the bases of the reference."""
+  rng = random.Random(config.seed)
+  sequences = {}
+  for contig in contigs(config):
+    n_bytes = (contig.n_bases + 3) // 4
+    data = rng.getrandbits(8 * n_bytes).to_bytes(n_bytes, 'little')
+    sequences[contig.name] = ''.join(
+        _BYTE_BASES[b] for b in data)[:contig.n_bases]
+  return sequences
+
+
+def _positions(config, rng, n_records, length):
+  """Yields sorted (contig, start) pairs of n_records records of length bases.
+
+  The records are spread evenly over the contigs, each starting at a random
+  position within its own equal slice of the contig.
+
+  Args:
+    config: SyntheticConfig.
+    rng: random.Random.
+    n_records: int.
+    length: int.
+  """
+  for index, contig in enumerate(contigs(config)):
+    n = n_records // config.n_contigs
+    if index < n_records % config.n_contigs:
+      n += 1
+    if n == 0:
+      continue
+    span = contig.n_bases - length + 1
+    for i in range(n):
+      slice_start = i * span // n
+      slice_end = max(slice_start + 1, (i + 1) * span // n)
+      yield contig, rng.randrange(slice_start, slice_end)
+
+
+def _mutate(bases, rng):
+  """Returns bases with a single random substitution."""
+  i = rng.randrange(len(bases))
+  alt = _BASES[(_BASES.index(bases[i]) + rng.randrange(1, 4)) % 4]
+  return bases[:i] + alt + bases[i + 1:]
+
+
+def reads(config, sequences=None):
+  """Yields the coordinate-sorted Read protos of config.
+
+  Each read is a copy of the reference, with one substitution in half of the
+  reads, and has config.n_tags aux tags alternating between integer and
+  string values.
+
+  Args:
+    config: SyntheticConfig.
+    sequences: dict or None. The result of reference_sequences(config), if
+      already computed.
+  """
+  if sequences is None:
+    sequences = reference_sequences(config)
+  rng = random.Random(config.seed + 1)
+  qualities = [[rng.randrange(10, 41)
+                for _ in range(config.read_length)]
+               for _ in range(_N_QUALITY_PROFILES)]
+  for i, (contig, start) in enumerate(
+      _positions(config, rng, config.n_reads, config.read_length)):
+    bases = sequences[contig.name][start:start + config.read_length]
+    if rng.random() < 0.5:
+      bases = _mutate(bases, rng)
+    read = reads_pb2.Read(
+        fragment_name='read_{}'.format(i),
+        number_reads=1,
+        aligned_sequence=bases,
+        aligned_quality=qualities[rng.randrange(_N_QUALITY_PROFILES)],
+        alignment=reads_pb2.LinearAlignment(
+            position=position_pb2.Position(
+                reference_name=contig.name,
+                position=start,
+                reverse_strand=rng.random() < 0.5),
+            mapping_quality=60,
+            cigar=[
+                cigar_pb2.CigarUnit(
+                    operation=cigar_pb2.CigarUnit.ALIGNMENT_MATCH,
+                    operation_length=config.read_length)
+            ]))
+    for j in range(config.n_tags):
+      value = read.info[_TAGS[j]].values.add()
+      if j % 2 == 0:
+        value.int_value = rng.randrange(1000)
+      else:
+        value.string_value = 'value_{}_{}'.format(i, j)
+    yield read
+
+
+def fastq_records(config, sequences=None):
+  """Yields the FastqRecord protos of the reads of config.
+
+  Args:
+    config: SyntheticConfig.
+    sequences: dict or None. The result of reference_sequences(config), if
+      already computed.
+  """
+  for read in reads(config, sequences):
+    yield fastq_pb2.FastqRecord(
+        id=read.fragment_name,
+        description='synthetic',
+        sequence=read.aligned_sequence,
+        quality=''.join(chr(q + 33) for q in read.aligned_quality))
+
+
+def vcf_header(config):
+  """Returns the VcfHeader of the variants of config."""
+  return variants_pb2.VcfHeader(
+      contigs=contigs(config),
+      filters=[
+          variants_pb2.VcfFilterInfo(
+              id='PASS', description='All filters passed')
+      ],
+      infos=[
+          variants_pb2.VcfInfo(
+              id='DP', number='1', type='Integer', description='Total depth')
+      ],
+      formats=[
+          variants_pb2.VcfFormatInfo(
+              id='GT', number='1', type='String', description='Genotype'),
+          variants_pb2.VcfFormatInfo(
+              id='GQ',
+              number='1',
+              type='Integer',
+              description='Genotype quality'),
+          variants_pb2.VcfFormatInfo(
+              id='DP', number='1', type='Integer', description='Read depth'),
+          variants_pb2.VcfFormatInfo(
+              id='AD',
+              number='R',
+              type='Integer',
+              description='Allelic depths'),
+      ],
+      sample_names=['sample_{}'.format(s) for s in range(config.n_samples)])
+
+
+def variants(config, sequences=None):
+  """Yields the coordinate-sorted biallelic SNP Variant protos of config.
+
+  Args:
+    config: SyntheticConfig.
+    sequences: dict or None. The result of reference_sequences(config), if
+      already computed.
+  """
+  if sequences is None:
+    sequences = reference_sequences(config)
+  rng = random.Random(config.seed + 2)
+  sample_names = vcf_header(config).sample_names
+  genotypes = ([0, 0], [0, 1], [1, 1])
+  for contig, start in _positions(config, rng, config.n_variants, 1):
+    ref = sequences[contig.name][start]
+    variant = variants_pb2.Variant(
+        reference_name=contig.name,
+        start=start,
+        end=start + 1,
+        reference_bases=ref,
+        alternate_bases=[_BASES[(_BASES.index(ref) + rng.randrange(1, 4)) % 4]],
+        quality=rng.randrange(10, 100),
+        filter=['PASS'])
+    # Drawing a single number per variant keeps 10k-sample files fast to
+    # generate; the calls of the samples are derived from it.
+    base = rng.getrandbits(32)
+    total_depth = 0
+    for s, name in enumerate(sample_names):
+      h = (base ^ (s * 2654435761)) & 0xffffffff
+      depth = 10 + h % 31
+      alt_depth = (h >> 8) % (depth + 1)
+      total_depth += depth
+      call = variant.calls.add(
+          call_set_name=name, genotype=genotypes[(h >> 16) % 3])
+      call.info['GQ'].values.add().int_value = (h >> 4) % 100
+      call.info['DP'].values.add().int_value = depth
+      ad = call.info['AD'].values
+      ad.add().int_value = depth - alt_depth
+      ad.add().int_value = alt_depth
+    variant.info['DP'].values.add().int_value = total_depth
+    yield variant
+
+
+def bed_records(config):
+  """Yields the coordinate-sorted six-column BedRecord protos of config."""
+  rng = random.Random(config.seed + 3)
+  for i, (contig, start) in enumerate(
+      _positions(config, rng, config.n_features, 1000)):
+    yield bed_pb2.BedRecord(
+        reference_name=contig.name,
+        start=start,
+        end=start + rng.randrange(100, 1001),
+        name='feature_{}'.format(i),
+        score=rng.randrange(1000),
+        strand=(bed_pb2.BedRecord.FORWARD_STRAND
+                if rng.random() < 0.5 else bed_pb2.BedRecord.REVERSE_STRAND))
+
+
+def gff_records(config):
+  """Yields the coordinate-sorted GffRecord protos of config."""
+  rng = random.Random(config.seed + 4)
+  for i, (contig, start) in enumerate(
+      _positions(config, rng, config.n_features, 1000)):
+    yield gff_pb2.GffRecord(
+        range=range_pb2.Range(
+            reference_name=contig.name,
+            start=start,
+            end=start + rng.randrange(100, 1001)),
+        source='synthetic',
+        type='exon',
+        score=rng.random(),
+        strand=(gff_pb2.GffRecord.FORWARD_STRAND
+                if rng.random() < 0.5 else gff_pb2.GffRecord.REVERSE_STRAND),
+        phase=rng.randrange(3),
+        attributes={
+            'ID': 'exon_{}'.format(i),
+            'Parent': 'transcript_{}'.format(i // 4)
+        })
+
+
+def write_reference(path, config, sequences=None):
+  """Writes the reference of config as FASTA to path, with a .fai index."""
+  if sequences is None:
+    sequences = reference_sequences(config)
+  offset = 0
+  with open(path, 'w') as fasta, open(path + '.fai', 'w') as fai:
+    for contig in contigs(config):
+      header = '>{}\n'.format(contig.name)
+      offset += len(header)
+      fasta.write(header)
+      fai.write('{}\t{}\t{}\t{}\t{}\n'.format(contig.name, contig.n_bases,
+                                             offset, _FASTA_LINE_BASES,
+                                             _FASTA_LINE_BASES + 1))
+      sequence = sequences[contig.name]
+      for i in range(0, len(sequence), _FASTA_LINE_BASES):
+        line = sequence[i:i + _FASTA_LINE_BASES] + '\n'
+        fasta.write(line)
+        offset += len(line)
+
+
+def write_records(path, config, fmt, ref_path=None, sequences=None):
+  """Writes the records of config in format fmt to path, and indexes them.
+
+  Args:
+    path: str. The path of the file to write.
+    config: SyntheticConfig.
+    fmt: str. One of FORMATS.
+    ref_path: str or None. The reference FASTA; required for CRAM files.
+    sequences: dict or None. The result of reference_sequences(config), if
+      already computed.
+
+  Raises:
+    ValueError: if fmt is not one of FORMATS.
+  """
+  if fmt in ('bam', 'cram'):
+    header = reads_pb2.SamHeader(
+        format_version='1.6',
+        sorting_order=reads_pb2.SamHeader.COORDINATE,
+        contigs=contigs(config))
+    with sam.SamWriter(path, header=header, ref_path=ref_path) as writer:
+      for read in reads(config, sequences):
+        writer.write(read)
+    tabix.build_sam_index(path)
+  elif fmt in ('vcf', 'bcf'):
+    with vcf.VcfWriter(path, header=vcf_header(config)) as writer:
+      for variant in variants(config, sequences):
+        writer.write(variant)
+    if fmt == 'vcf':
+      tabix.build_index(path, preset='vcf')
+  elif fmt == 'fastq':
+    with fastq.FastqWriter(path) as writer:
+      for record in fastq_records(config, sequences):
+        writer.write(record)
+  elif fmt == 'bed':
+    with bed.BedWriter(path, header=bed_pb2.BedHeader(num_fields=6)) as writer:
+      for record in bed_records(config):
+        writer.write(record)
+    tabix.build_index(path, preset='bed')
+  elif fmt == 'gff':
+    header = gff_pb2.GffHeader(sequence_regions=[
+        range_pb2.Range(reference_name=c.name, start=0, end=c.n_bases)
+        for c in contigs(config)
+    ])
+    with gff.GffWriter(path, header=header) as writer:
+      for record in gff_records(config):
+        writer.write(record)
+    tabix.build_index(path, preset='gff')
+  else:
+    raise ValueError('Unknown format {}; expected one of {}'.format(
+        fmt, ', '.join(FORMATS)))
+
+
+def write_dataset(output_dir, config, formats=FORMATS):
+  """Writes the files of config in formats to output_dir.
+
+  Args:
+    output_dir: str. An existing directory.
+    config: SyntheticConfig.
+    formats: iterable of str. A subset of FORMATS.
+
+  Returns:
+    A dict from format to the path of its file, plus 'reference' to the
+    reference FASTA.
+  """
+  sequences = reference_sequences(config)
+  paths = {'reference': os.path.join(output_dir, REFERENCE_FILENAME)}
+  write_reference(paths['reference'], config, sequences)
+  for fmt in formats:
+    paths[fmt] = os.path.join(output_dir, FILENAMES[fmt])
+    write_records(
+        paths[fmt],
+        config,
+        fmt,
+        ref_path=paths['reference'] if fmt == 'cram' else None,
+        sequences=sequences)
+  return paths
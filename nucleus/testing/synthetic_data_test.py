@@ -0,0 +1,108 @@
+# Copyright 2018 Google LLC.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tests for nucleus's testing.synthetic_data."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import tempfile
+
+from absl.testing import absltest
+
+from nucleus.io import bed
+from nucleus.io import fastq
+from nucleus.io import gff
+from nucleus.io import sam
+from nucleus.io import vcf
+from nucleus.testing import synthetic_data
+from nucleus.util import ranges
+from nucleus.util import utils
+from nucleus.util import variant_utils
+
+_CONFIG = synthetic_data.SyntheticConfig(
+    seed=1,
+    n_contigs=2,
+    contig_length=20000,
+    n_reads=500,
+    read_length=50,
+    n_tags=3,
+    n_variants=100,
+    n_samples=5,
+    n_features=200)
+
+
+class SyntheticDataTest(absltest.TestCase):
+
+  @classmethod
+  def setUpClass(cls):
+    super(SyntheticDataTest, cls).setUpClass()
+    cls.paths = synthetic_data.write_dataset(
+        tempfile.mkdtemp(dir=absltest.get_default_test_tmpdir()), _CONFIG)
+
+  def test_records_are_deterministic(self):
+    self.assertEqual(
+        list(synthetic_data.reads(_CONFIG)),
+        list(synthetic_data.reads(_CONFIG)))
+    self.assertEqual(
+        list(synthetic_data.variants(_CONFIG)),
+        list(synthetic_data.variants(_CONFIG)))
+    other = synthetic_data.SyntheticConfig(seed=2, n_reads=10)
+    self.assertNotEqual(
+        list(synthetic_data.reads(other)),
+        list(synthetic_data.reads(synthetic_data.SyntheticConfig(n_reads=10))))
+
+  def test_reads(self):
+    for fmt in ('bam', 'cram'):
+      with sam.SamReader(
+          self.paths[fmt], ref_path=self.paths['reference']) as reader:
+        reads = list(reader.iterate())
+        self.assertLen(reads, _CONFIG.n_reads)
+        self.assertLen(reads[0].info, _CONFIG.n_tags)
+        self.assertLen(reads[0].aligned_sequence, _CONFIG.read_length)
+        region = ranges.make_range('chr1', 0, 10000)
+        self.assertEqual(
+            sum(1 for r in reads if utils.read_overlaps_region(r, region)),
+            sum(1 for _ in reader.query(region)))
+
+  def test_variants(self):
+    for fmt in ('vcf', 'bcf'):
+      with vcf.VcfReader(self.paths[fmt]) as reader:
+        self.assertLen(reader.header.sample_names, _CONFIG.n_samples)
+        variants = list(reader.iterate())
+        self.assertLen(variants, _CONFIG.n_variants)
+        self.assertLen(variants[0].calls, _CONFIG.n_samples)
+    with vcf.VcfReader(self.paths['vcf']) as reader:
+      region = ranges.make_range('chr2', 0, 10000)
+      self.assertEqual(
+          sum(1 for v in variants if ranges.ranges_overlap(variant_utils.variant_range(v), region)),
+          sum(1 for _ in reader.query(region)))
+
+  def test_features(self):
+    with fastq.FastqReader(self.paths['fastq']) as reader:
+      self.assertLen(list(reader.iterate()), _CONFIG.n_reads)
+    with bed.BedReader(self.paths['bed']) as reader:
+      self.assertLen(list(reader.iterate()), _CONFIG.n_features)
+    with gff.GffReader(self.paths['gff']) as reader:
+      self.assertLen(list(reader.iterate()), _CONFIG.n_features)
+
+  def test_invalid_config(self):
+    with self.assertRaises(ValueError):
+      synthetic_data.SyntheticConfig(n_tags=1000)
+    with self.assertRaises(ValueError):
+      synthetic_data.SyntheticConfig(contig_length=10, read_length=100)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of contig_dictionary.h
+#include "nucleus/util/contig_dictionary.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace nucleus {
+
+constexpr int ContigDictionary::kUnknownContig;
+
+void ContigDictionary::Init(
+    std::vector<const nucleus::genomics::v1::ContigInfo*> contigs) {
+  CHECK_LE(contigs.size(), static_cast<size_t>(kMaxContigId) + 1)
+      << "Too many contigs for sort keys";
+  std::stable_sort(contigs.begin(), contigs.end(),
+                   [](const nucleus::genomics::v1::ContigInfo* a,
+                      const nucleus::genomics::v1::ContigInfo* b) {
+                     return a->pos_in_fasta() < b->pos_in_fasta();
+                   });
+  names_.reserve(contigs.size());
+  ids_.reserve(contigs.size());
+  for (const nucleus::genomics::v1::ContigInfo* contig : contigs) {
+    if (ids_.emplace(contig->name(), names_.size()).second) {
+      names_.push_back(contig->name());
+    } else {
+      LOG(WARNING) << "Ignoring duplicate contig " << contig->name();
+    }
+  }
+}
+
+}  // namespace nucleus
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Dense integer ids for the contigs of a header or reference, and 64-bit sort
+// keys built from them, so that sorting records by position compares integers
+// instead of contig names.
+#ifndef THIRD_PARTY_NUCLEUS_UTIL_CONTIG_DICTIONARY_H_
+#define THIRD_PARTY_NUCLEUS_UTIL_CONTIG_DICTIONARY_H_
+
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "nucleus/platform/types.h"
+#include "nucleus/protos/position.pb.h"
+#include "nucleus/protos/range.pb.h"
+#include "nucleus/protos/reads.pb.h"
+#include "nucleus/protos/reference.pb.h"
+#include "nucleus/protos/variants.pb.h"
+#include "nucleus/util/parallel_sort.h"
+
+namespace nucleus {
+
+// A sort key packs a contig id into its high kContigIdBits bits and a
+// position into its low kPositionBits bits, so that keys compare like
+// (contig id, position) pairs.
+constexpr int kContigIdBits = 24;
+constexpr int kPositionBits = 64 - kContigIdBits;
+constexpr int kMaxContigId = (1 << kContigIdBits) - 2;
+constexpr int64 kMaxSortKeyPosition = (int64{1} << kPositionBits) - 1;
+
+// The key of records on contigs missing from the dictionary, and of unmapped
+// reads, which sorts after all others.
+constexpr uint64 kUnplacedSortKey = ~uint64{0};
+
+// Returns the sort key of position on the contig with id contig_id, which must
+// be in [0, kMaxContigId]. Negative positions are clamped to 0, and positions
+// above kMaxSortKeyPosition to it.
+inline uint64 PackSortKey(int contig_id, int64 position) {
+  position = position < 0 ? 0 : position;
+  position = position > kMaxSortKeyPosition ? kMaxSortKeyPosition : position;
+  return (static_cast<uint64>(contig_id) << kPositionBits) |
+         static_cast<uint64>(position);
+}
+
+// Return the contig id and the position of a key made by PackSortKey.
+inline int SortKeyContigId(uint64 key) {
+  return static_cast<int>(key >> kPositionBits);
+}
+inline int64 SortKeyPosition(uint64 key) {
+  return static_cast<int64>(key & static_cast<uint64>(kMaxSortKeyPosition));
+}
+
+// Maps the names of contigs to dense ids, 0 to size() - 1, in the order of
+// their pos_in_fasta; contigs with the same pos_in_fasta keep their order.
+// Ids therefore order records like CompareVariants does.
+class ContigDictionary {
+ public:
+  // The id of names missing from the dictionary.
+  static constexpr int kUnknownContig = -1;
+
+  ContigDictionary() = default;
+
+  // Builds the dictionary of contigs, a container of ContigInfo such as the
+  // contigs of a SamHeader or VcfHeader or of a GenomeReference.
+  template <class Contigs>
+  explicit ContigDictionary(const Contigs& contigs) {
+    std::vector<const nucleus::genomics::v1::ContigInfo*> infos;
+    for (const nucleus::genomics::v1::ContigInfo& contig : contigs) {
+      infos.push_back(&contig);
+    }
+    Init(infos);
+  }
+
+  // Builds the dictionary of the contigs of header.
+  explicit ContigDictionary(const nucleus::genomics::v1::SamHeader& header)
+      : ContigDictionary(header.contigs()) {}
+  explicit ContigDictionary(const nucleus::genomics::v1::VcfHeader& header)
+      : ContigDictionary(header.contigs()) {}
+
+  // Returns the number of contigs.
+  int size() const { return static_cast<int>(names_.size()); }
+
+  // Returns the id of the contig called name, or kUnknownContig.
+  int Id(const string& name) const {
+    const auto it = ids_.find(name);
+    return it == ids_.end() ? kUnknownContig : it->second;
+  }
+
+  // Returns the name of the contig with the given id, in [0, size()).
+  const string& Name(int id) const { return names_[id]; }
+
+  // Returns the sort key of position on the contig called reference_name, or
+  // kUnplacedSortKey if the contig is unknown.
+  uint64 SortKey(const string& reference_name, int64 position) const {
+    const int id = Id(reference_name);
+    return id == kUnknownContig ? kUnplacedSortKey : PackSortKey(id, position);
+  }
+
+  // Return the sort keys of the start of a record. Unmapped reads, which have
+  // no contig, have kUnplacedSortKey.
+  uint64 SortKey(const nucleus::genomics::v1::Position& position) const {
+    return SortKey(position.reference_name(), position.position());
+  }
+  uint64 SortKey(const nucleus::genomics::v1::Range& range) const {
+    return SortKey(range.reference_name(), range.start());
+  }
+  uint64 SortKey(const nucleus::genomics::v1::Variant& variant) const {
+    return SortKey(variant.reference_name(), variant.start());
+  }
+  uint64 SortKey(const nucleus::genomics::v1::Read& read) const {
+    return SortKey(read.alignment().position());
+  }
+
+ private:
+  void Init(std::vector<const nucleus::genomics::v1::ContigInfo*> contigs);
+
+  std::vector<string> names_;
+  std::unordered_map<string, int> ids_;
+};
+
+namespace contig_dictionary_internal {
+
+// Return the contig name and the position of the start of record. Unmapped
+// reads have an empty contig name.
+inline const string& ContigName(const nucleus::genomics::v1::Range& range) {
+  return range.reference_name();
+}
+inline const string& ContigName(const nucleus::genomics::v1::Variant& variant) {
+  return variant.reference_name();
+}
+inline const string& ContigName(const nucleus::genomics::v1::Read& read) {
+  return read.alignment().position().reference_name();
+}
+inline int64 Start(const nucleus::genomics::v1::Range& range) {
+  return range.start();
+}
+inline int64 Start(const nucleus::genomics::v1::Variant& variant) {
+  return variant.start();
+}
+inline int64 Start(const nucleus::genomics::v1::Read& read) {
+  return read.alignment().position().position();
+}
+
+// Returns the position breaking ties between records with the same sort key:
+// the end of ranges and variants, as in CompareVariants. Reads have none.
+inline int64 TieBreak(const nucleus::genomics::v1::Range& range) {
+  return range.end();
+}
+inline int64 TieBreak(const nucleus::genomics::v1::Variant& variant) {
+  return variant.end();
+}
+inline int64 TieBreak(const nucleus::genomics::v1::Read&) { return 0; }
+
+}  // namespace contig_dictionary_internal
+
+// Sorts records, a vector of Read, Variant or Range, by the sort keys of
+// dictionary, then by the end of variants and ranges, splitting the work over
+// num_threads threads. Records on unknown contigs and unmapped reads go last,
+// in their original order. The sort is stable.
+//
+// Only the keys are sorted; records are then moved into place, once each.
+template <class Record>
+void SortByContigAndPosition(const ContigDictionary& dictionary,
+                             std::vector<Record>* records, int num_threads) {
+  using contig_dictionary_internal::ContigName;
+  using contig_dictionary_internal::Start;
+  using contig_dictionary_internal::TieBreak;
+  // The sort key, tie break and index of each record. Records mostly share
+  // their contig with the one before, so its id is only looked up on changes.
+  std::vector<std::tuple<uint64, int64, size_t>> keys(records->size());
+  const string* last_name = nullptr;
+  int id = ContigDictionary::kUnknownContig;
+  for (size_t i = 0; i < records->size(); ++i) {
+    const Record& record = (*records)[i];
+    const string& name = ContigName(record);
+    if (last_name == nullptr || name != *last_name) {
+      last_name = &name;
+      id = dictionary.Id(name);
+    }
+    // Unplaced records keep their order.
+    if (id == ContigDictionary::kUnknownContig) {
+      keys[i] = std::make_tuple(kUnplacedSortKey, 0, i);
+    } else {
+      keys[i] = std::make_tuple(PackSortKey(id, Start(record)),
+                                TieBreak(record), i);
+    }
+  }
+  ParallelSort(keys.begin(), keys.end(), num_threads);
+
+  // Applies the permutation by following its cycles, swapping each record into
+  // place.
+  std::vector<bool> placed(records->size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (placed[i]) continue;
+    size_t to = i;
+    size_t from = std::get<2>(keys[i]);
+    while (from != i) {
+      using std::swap;
+      swap((*records)[to], (*records)[from]);
+      placed[to] = true;
+      to = from;
+      from = std::get<2>(keys[from]);
+    }
+    placed[to] = true;
+  }
+}
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_UTIL_CONTIG_DICTIONARY_H_
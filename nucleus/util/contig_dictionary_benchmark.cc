@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks of sorting the given number of Variants with CompareVariants
+// against SortByContigAndPosition on one and four threads.
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "nucleus/util/contig_dictionary.h"
+#include "nucleus/util/utils.h"
+
+namespace nucleus {
+
+namespace {
+
+using genomics::v1::ContigInfo;
+using genomics::v1::Variant;
+
+// Returns the 25 contigs of a human reference.
+std::vector<ContigInfo> Contigs() {
+  std::vector<ContigInfo> contigs(25);
+  for (int i = 0; i < 25; ++i) {
+    contigs[i].set_name(i < 22 ? "chr" + std::to_string(i + 1)
+                               : i == 22 ? "chrX" : i == 23 ? "chrY" : "chrM");
+    contigs[i].set_pos_in_fasta(i);
+  }
+  return contigs;
+}
+
+// Returns n variants at random positions of contigs.
+std::vector<Variant> Variants(const std::vector<ContigInfo>& contigs, int n) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> contig(0, contigs.size() - 1);
+  std::uniform_int_distribution<int64> position(0, 100000000);
+  std::vector<Variant> variants(n);
+  for (Variant& variant : variants) {
+    variant.set_reference_name(contigs[contig(rng)].name());
+    variant.set_start(position(rng));
+    variant.set_end(variant.start() + 1);
+  }
+  return variants;
+}
+
+}  // namespace
+
+void BM_SortWithCompareVariants(benchmark::State& state) {
+  const std::vector<ContigInfo> contigs = Contigs();
+  const std::map<string, int> pos_in_fasta = MapContigNameToPosInFasta(contigs);
+  const std::vector<Variant> variants = Variants(contigs, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Variant> sorted = variants;
+    state.ResumeTiming();
+    std::sort(sorted.begin(), sorted.end(),
+              [&pos_in_fasta](const Variant& a, const Variant& b) {
+                return CompareVariants(a, b, pos_in_fasta);
+              });
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SortByContigAndPosition(benchmark::State& state) {
+  const std::vector<ContigInfo> contigs = Contigs();
+  const ContigDictionary dictionary(contigs);
+  const std::vector<Variant> variants = Variants(contigs, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Variant> sorted = variants;
+    state.ResumeTiming();
+    SortByContigAndPosition(dictionary, &sorted, state.range(1));
+    benchmark::DoNotOptimize(sorted.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_SortWithCompareVariants)->Arg(10000)->Arg(1000000);
+BENCHMARK(BM_SortByContigAndPosition)
+    ->Args({10000, 1})
+    ->Args({10000, 4})
+    ->Args({1000000, 1})
+    ->Args({1000000, 4});
+
+}  // namespace nucleus
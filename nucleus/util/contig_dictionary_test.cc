@@ -0,0 +1,192 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/util/contig_dictionary.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "nucleus/util/utils.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace nucleus {
+
+using genomics::v1::ContigInfo;
+using genomics::v1::Range;
+using genomics::v1::Read;
+using genomics::v1::SamHeader;
+using genomics::v1::Variant;
+using genomics::v1::VcfHeader;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+
+// Returns contigs chr1, chr2 and chrM, with chrM first in the FASTA.
+std::vector<ContigInfo> TestContigs() {
+  std::vector<ContigInfo> contigs(3);
+  contigs[0].set_name("chr1");
+  contigs[0].set_pos_in_fasta(1);
+  contigs[1].set_name("chr2");
+  contigs[1].set_pos_in_fasta(2);
+  contigs[2].set_name("chrM");
+  contigs[2].set_pos_in_fasta(0);
+  return contigs;
+}
+
+Variant MakeVariant(const string& chrom, int64 start, int64 end) {
+  Variant variant;
+  variant.set_reference_name(chrom);
+  variant.set_start(start);
+  variant.set_end(end);
+  return variant;
+}
+
+TEST(ContigDictionary, OrdersContigsByPosInFasta) {
+  const ContigDictionary dictionary(TestContigs());
+  EXPECT_THAT(dictionary.size(), Eq(3));
+  EXPECT_THAT(dictionary.Id("chrM"), Eq(0));
+  EXPECT_THAT(dictionary.Id("chr1"), Eq(1));
+  EXPECT_THAT(dictionary.Id("chr2"), Eq(2));
+  EXPECT_THAT(dictionary.Id("chr3"), Eq(ContigDictionary::kUnknownContig));
+  EXPECT_THAT(dictionary.Name(0), Eq("chrM"));
+  EXPECT_THAT(dictionary.Name(2), Eq("chr2"));
+}
+
+TEST(ContigDictionary, BuildsFromHeaders) {
+  SamHeader sam_header;
+  VcfHeader vcf_header;
+  for (const ContigInfo& contig : TestContigs()) {
+    *sam_header.add_contigs() = contig;
+    *vcf_header.add_contigs() = contig;
+  }
+  for (const ContigDictionary& dictionary :
+       {ContigDictionary(sam_header), ContigDictionary(vcf_header)}) {
+    EXPECT_THAT(dictionary.size(), Eq(3));
+    EXPECT_THAT(dictionary.Id("chrM"), Eq(0));
+    EXPECT_THAT(dictionary.Id("chr2"), Eq(2));
+  }
+}
+
+TEST(ContigDictionary, KeepsOrderOfContigsWithoutPosInFasta) {
+  std::vector<ContigInfo> contigs(3);
+  contigs[0].set_name("b");
+  contigs[1].set_name("c");
+  contigs[2].set_name("a");
+  const ContigDictionary dictionary(contigs);
+  EXPECT_THAT(dictionary.Id("b"), Eq(0));
+  EXPECT_THAT(dictionary.Id("c"), Eq(1));
+  EXPECT_THAT(dictionary.Id("a"), Eq(2));
+}
+
+TEST(SortKey, PacksContigIdAndPosition) {
+  const uint64 key = PackSortKey(5, 123456789012);
+  EXPECT_THAT(SortKeyContigId(key), Eq(5));
+  EXPECT_THAT(SortKeyPosition(key), Eq(123456789012));
+  EXPECT_THAT(SortKeyPosition(PackSortKey(1, -1)), Eq(0));
+  EXPECT_THAT(SortKeyPosition(PackSortKey(1, kMaxSortKeyPosition + 10)),
+              Eq(kMaxSortKeyPosition));
+  EXPECT_THAT(PackSortKey(kMaxContigId, kMaxSortKeyPosition),
+              Lt(kUnplacedSortKey));
+  // Contig ids take precedence over positions.
+  EXPECT_THAT(PackSortKey(1, 0), Gt(PackSortKey(0, kMaxSortKeyPosition)));
+  EXPECT_THAT(PackSortKey(1, 10), Gt(PackSortKey(1, 9)));
+}
+
+TEST(SortKey, OfRecords) {
+  const ContigDictionary dictionary(TestContigs());
+  EXPECT_THAT(dictionary.SortKey(MakeVariant("chr1", 10, 11)),
+              Eq(PackSortKey(1, 10)));
+  EXPECT_THAT(dictionary.SortKey(MakeVariant("chrX", 10, 11)),
+              Eq(kUnplacedSortKey));
+  EXPECT_THAT(dictionary.SortKey(MakeRange("chr2", 3, 8)),
+              Eq(PackSortKey(2, 3)));
+  EXPECT_THAT(dictionary.SortKey(MakePosition("chrM", 7)),
+              Eq(PackSortKey(0, 7)));
+  Read read;
+  EXPECT_THAT(dictionary.SortKey(read), Eq(kUnplacedSortKey));
+  *read.mutable_alignment()->mutable_position() = MakePosition("chr2", 42);
+  EXPECT_THAT(dictionary.SortKey(read), Eq(PackSortKey(2, 42)));
+}
+
+class SortByContigAndPositionTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(SortByContigAndPositionTest, SortsVariantsLikeCompareVariants) {
+  const std::vector<ContigInfo> contigs = TestContigs();
+  const std::map<string, int> pos_in_fasta =
+      MapContigNameToPosInFasta(contigs);
+  std::mt19937 rng(GetParam());
+  std::uniform_int_distribution<int> contig(0, 2);
+  std::uniform_int_distribution<int> position(0, 50);
+  std::vector<Variant> variants;
+  for (int i = 0; i < 1000; ++i) {
+    const int64 start = position(rng);
+    variants.push_back(MakeVariant(contigs[contig(rng)].name(), start,
+                                   start + position(rng) % 3 + 1));
+    // Tags each variant, so that the test can check stability.
+    variants.back().add_names(std::to_string(i));
+  }
+  std::vector<Variant> expected = variants;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&pos_in_fasta](const Variant& a, const Variant& b) {
+                     return CompareVariants(a, b, pos_in_fasta);
+                   });
+  SortByContigAndPosition(ContigDictionary(contigs), &variants, GetParam());
+  ASSERT_THAT(variants.size(), Eq(expected.size()));
+  for (size_t i = 0; i < variants.size(); ++i) {
+    EXPECT_THAT(variants[i].names(0), Eq(expected[i].names(0)));
+  }
+}
+
+TEST_P(SortByContigAndPositionTest, PutsUnplacedReadsLast) {
+  const ContigDictionary dictionary(TestContigs());
+  std::vector<Read> reads(6);
+  const std::vector<std::pair<string, int64>> positions = {
+      {"chr2", 5}, {"", 0}, {"chrX", 1}, {"chrM", 9}, {"chr2", 1}, {"", 0}};
+  for (size_t i = 0; i < reads.size(); ++i) {
+    reads[i].set_fragment_name(std::to_string(i));
+    if (!positions[i].first.empty()) {
+      *reads[i].mutable_alignment()->mutable_position() =
+          MakePosition(positions[i].first, positions[i].second);
+    }
+  }
+  SortByContigAndPosition(dictionary, &reads, GetParam());
+  std::vector<string> names;
+  for (const Read& read : reads) names.push_back(read.fragment_name());
+  EXPECT_THAT(names, ::testing::ElementsAre("3", "4", "0", "1", "2", "5"));
+}
+
+TEST_P(SortByContigAndPositionTest, SortsRanges) {
+  const ContigDictionary dictionary(TestContigs());
+  std::vector<Range> ranges = {MakeRange("chr1", 10, 20),
+                               MakeRange("chr1", 10, 15),
+                               MakeRange("chrM", 100, 200)};
+  SortByContigAndPosition(dictionary, &ranges, GetParam());
+  EXPECT_THAT(ranges[0].reference_name(), Eq("chrM"));
+  EXPECT_THAT(ranges[1].end(), Eq(15));
+  EXPECT_THAT(ranges[2].end(), Eq(20));
+}
+
+INSTANTIATE_TEST_CASE_P(NumThreads, SortByContigAndPositionTest,
+                        ::testing::Values(1, 2, 3, 8));
+
+}  // namespace nucleus
@@ -79,6 +79,9 @@ perror_to_rounded_phred = math_.perror_to_rounded_phred
 log10_perror_to_rounded_phred = math_.log10_perror_to_rounded_phred
 log10_perror_to_perror = math_.log10_perror_to_perror
 zero_shift_log10_probs = math_.zero_shift_log10_probs
+fast_log10 = math_.fast_log10
+fast_pow10 = math_.fast_pow10
+phreds_to_perrors = math_.phreds_to_perrors
 
 # Maximum confidence in a variant call. Used to prevent overflow with log10.
 # Note: -10 * log_10(1.25e-10) ~= 99.
@@ -174,8 +177,7 @@ def log10sumexp(log10_probs):
   Returns:
     Float.
   """
-  m = max(log10_probs)
-  return m + math.log10(sum(pow(10.0, x - m) for x in log10_probs))
+  return math_.log10sumexp(list(log10_probs))
 
 
 def normalize_log10_probs(log10_probs):
@@ -234,6 +236,7 @@ def normalize_log10_probs(log10_probs):
   log10_probs = np.array(log10_probs)
   if np.max(log10_probs) > 0.0:
     raise ValueError('log10_probs all must be <= 0', log10_probs)
-  lse = log10sumexp(log10_probs)
-  # np.minimum protects us from producing values slightly > 0.0 (e.g., 1e-16).
-  return np.minimum(log10_probs - lse, 0.0)
+  # The C++ implementation also caps the results at 0.0, protecting us from
+  # producing values slightly > 0.0 (e.g., 1e-16).
+  return np.array(math_.normalize_log10_probs(
+      log10_probs.ravel().tolist())).reshape(log10_probs.shape)
@@ -16,13 +16,154 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <cfloat>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
+#include "nucleus/platform/types.h"
 #include "nucleus/util/math.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace nucleus {
 
+namespace {
+
+// Adding and then subtracting kShifter rounds a double of magnitude below 2^51
+// to the nearest integer, which is then held in the low bits of the sum.
+constexpr double kShifter = 6755399441055744.0;  // 1.5 * 2^52.
+
+// log10(2), split so that its product with an integer below 2^12 in magnitude
+// is exact in the high part.
+constexpr double kLog10Of2Hi = 0.30102999566383914;
+constexpr double kLog10Of2Lo = 1.42050232272661e-13;
+constexpr double kLog2Of10 = 3.321928094887362;
+constexpr double kLnOf10 = 2.302585092994046;
+constexpr double kLog10OfE = 0.4342944819032518;
+
+// The bits of sqrt(1/2). FastLog10 reduces its argument to the interval
+// [sqrt(1/2), sqrt(2)).
+constexpr uint64 kSqrtHalfBits = 0x3fe6a09e667f3bcdULL;
+
+// FastPow10 returns 0 and +inf beyond +/- kMaxPow10Arg.
+constexpr double kMaxPow10Arg = 307.0;
+
+// The number of Phred values tabulated by PErrorTable().
+constexpr int kNumTabulatedPhreds = 256;
+
+uint64 DoubleBits(double x) {
+  uint64 bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+double BitsDouble(uint64 bits) {
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// log10(x) for positive, normal and finite x.
+//
+// Writes x = z * 2^k with z in [sqrt(1/2), sqrt(2)), and evaluates
+// ln(z) = 2 * atanh(s) with s = (z - 1) / (z + 1), |s| < 0.1716, by its series
+// up to s^17, whose truncation error is below 3e-16.
+inline double Log10Kernel(double x) {
+  const uint64 bits = DoubleBits(x);
+  const uint64 tmp = bits - kSqrtHalfBits;
+  const int64 k = static_cast<int64>(tmp) >> 52;
+  const double z = BitsDouble(bits - (tmp & (0xfffULL << 52)));
+  // k as a double, without an int64 conversion, which few SIMD units have.
+  const double kd = BitsDouble(DoubleBits(kShifter) + k) - kShifter;
+  const double s = (z - 1) / (z + 1);
+  const double s2 = s * s;
+  // Horner's scheme, written out so that the compiler need not unroll a loop
+  // before vectorizing the callers.
+  double series = 1.0 / 17;
+  series = series * s2 + 1.0 / 15;
+  series = series * s2 + 1.0 / 13;
+  series = series * s2 + 1.0 / 11;
+  series = series * s2 + 1.0 / 9;
+  series = series * s2 + 1.0 / 7;
+  series = series * s2 + 1.0 / 5;
+  series = series * s2 + 1.0 / 3;
+  series = series * s2 + 1.0;
+  const double ln_z = 2 * s * series;
+  return kd * kLog10Of2Hi + (kd * kLog10Of2Lo + ln_z * kLog10OfE);
+}
+
+// True if Log10Kernel(x) is valid.
+inline bool InLog10KernelDomain(double x) {
+  return x >= DBL_MIN && x <= DBL_MAX;
+}
+
+// 10^x, with the saturation documented for FastPow10.
+//
+// Writes 10^x = 2^n * e^y with integer n and |y| <= ln(2) / 2, and evaluates
+// e^y by its Taylor series up to y^12, whose truncation error is below 2e-16.
+inline double Pow10Kernel(double x) {
+  const double clamped = std::min(std::max(x, -kMaxPow10Arg), kMaxPow10Arg);
+  const double t = clamped * kLog2Of10 + kShifter;
+  const double n = t - kShifter;
+  const double r = (clamped - n * kLog10Of2Hi) - n * kLog10Of2Lo;
+  const double y = r * kLnOf10;
+  double e_y = 1.0 / 479001600;
+  e_y = e_y * y + 1.0 / 39916800;
+  e_y = e_y * y + 1.0 / 3628800;
+  e_y = e_y * y + 1.0 / 362880;
+  e_y = e_y * y + 1.0 / 40320;
+  e_y = e_y * y + 1.0 / 5040;
+  e_y = e_y * y + 1.0 / 720;
+  e_y = e_y * y + 1.0 / 120;
+  e_y = e_y * y + 1.0 / 24;
+  e_y = e_y * y + 1.0 / 6;
+  e_y = e_y * y + 1.0 / 2;
+  e_y = e_y * y + 1.0;
+  e_y = e_y * y + 1.0;
+  // 2^n, from the integer in the low bits of t.
+  const double scale =
+      BitsDouble((DoubleBits(t) - DoubleBits(kShifter) + 1023) << 52);
+  // Selects rather than branches, which would prevent vectorization.
+  double result = e_y * scale;
+  result = x < -kMaxPow10Arg ? 0.0 : result;
+  result = x > kMaxPow10Arg ? std::numeric_limits<double>::infinity() : result;
+  return x == x ? result : x;
+}
+
+// Returns the pError of each Phred value below kNumTabulatedPhreds.
+const double* PErrorTable() {
+  static const auto* const table = [] {
+    auto* table = new std::array<double, kNumTabulatedPhreds>;
+    for (int phred = 0; phred < kNumTabulatedPhreds; ++phred) {
+      (*table)[phred] = PhredToPError(phred);
+    }
+    return table;
+  }();
+  return table->data();
+}
+
+// Log10SumExp, given the maximum of log10_probs.
+double Log10SumExpWithMax(absl::Span<const double> log10_probs, double max) {
+  // Handles empty spans, and spans of only zero probabilities.
+  if (!std::isfinite(max)) return max;
+  const size_t n = log10_probs.size();
+  const double* in = log10_probs.data();
+  double sum = 0;
+#pragma omp simd reduction(+ : sum)
+  for (size_t i = 0; i < n; ++i) sum += Pow10Kernel(in[i] - max);
+  // sum >= 1, as the maximum contributes 1.
+  return max + Log10Kernel(sum);
+}
+
+double Max(absl::Span<const double> values) {
+  double max = -std::numeric_limits<double>::infinity();
+  for (double value : values) max = std::max(max, value);
+  return max;
+}
+
+}  // namespace
+
 double PhredToPError(const int phred) {
   CHECK_GE(phred, 0);
   return std::pow(10.0, -static_cast<double>(phred) / 10.0);
@@ -82,4 +223,90 @@ std::vector<double> ZeroShiftLikelihoods(
   return normalized;
 }
 
+double FastLog10(double x) {
+  return InLog10KernelDomain(x) ? Log10Kernel(x) : std::log10(x);
+}
+
+double FastPow10(double x) { return Pow10Kernel(x); }
+
+void FastLog10(absl::Span<const double> values, absl::Span<double> log10s) {
+  CHECK_EQ(values.size(), log10s.size());
+  const size_t n = values.size();
+  const double* in = values.data();
+  double* out = log10s.data();
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) out[i] = Log10Kernel(in[i]);
+  // Kept out of the loop above so that it stays branch-free.
+  for (size_t i = 0; i < n; ++i) {
+    if (!InLog10KernelDomain(in[i])) out[i] = std::log10(in[i]);
+  }
+}
+
+void FastPow10(absl::Span<const double> log10s, absl::Span<double> values) {
+  CHECK_EQ(log10s.size(), values.size());
+  const size_t n = log10s.size();
+  const double* in = log10s.data();
+  double* out = values.data();
+#pragma omp simd
+  for (size_t i = 0; i < n; ++i) out[i] = Pow10Kernel(in[i]);
+}
+
+void PhredToPError(absl::Span<const int> phreds, absl::Span<double> perrors) {
+  CHECK_EQ(phreds.size(), perrors.size());
+  const double* table = PErrorTable();
+  for (size_t i = 0; i < phreds.size(); ++i) {
+    const int phred = phreds[i];
+    perrors[i] = static_cast<unsigned int>(phred) < kNumTabulatedPhreds
+                     ? table[phred]
+                     : PhredToPError(phred);
+  }
+}
+
+double Log10SumExp(absl::Span<const double> log10_probs) {
+  return Log10SumExpWithMax(log10_probs, Max(log10_probs));
+}
+
+void NormalizeLog10ProbsInPlace(absl::Span<double> log10_probs) {
+  const double max = Max(log10_probs);
+  CHECK_LE(max, 0.0);
+  const double lse = Log10SumExpWithMax(log10_probs, max);
+  for (double& log10_prob : log10_probs) {
+    log10_prob = std::min(log10_prob - lse, 0.0);
+  }
+}
+
+void ZeroShiftLikelihoodsInPlace(absl::Span<double> likelihoods) {
+  const double max = Max(likelihoods);
+  for (double& likelihood : likelihoods) likelihood -= max;
+}
+
+std::vector<double> FastLog10(const std::vector<double>& values) {
+  std::vector<double> log10s(values.size());
+  FastLog10(values, absl::MakeSpan(log10s));
+  return log10s;
+}
+
+std::vector<double> FastPow10(const std::vector<double>& log10s) {
+  std::vector<double> values(log10s.size());
+  FastPow10(log10s, absl::MakeSpan(values));
+  return values;
+}
+
+std::vector<double> PhredToPError(const std::vector<int>& phreds) {
+  std::vector<double> perrors(phreds.size());
+  PhredToPError(phreds, absl::MakeSpan(perrors));
+  return perrors;
+}
+
+double Log10SumExp(const std::vector<double>& log10_probs) {
+  return Log10SumExp(absl::MakeConstSpan(log10_probs));
+}
+
+std::vector<double> NormalizeLog10Probs(
+    const std::vector<double>& log10_probs) {
+  std::vector<double> normalized(log10_probs);
+  NormalizeLog10ProbsInPlace(absl::MakeSpan(normalized));
+  return normalized;
+}
+
 }  // namespace nucleus
@@ -62,6 +62,8 @@
 
 #include <vector>
 
+#include "absl/types/span.h"
+
 namespace nucleus {
 
 // Converts Phred scale to probability scale. Phred value must be >= 0.
@@ -104,6 +106,49 @@ double Log10ToReal(double log10_probability);
 std::vector<double> ZeroShiftLikelihoods(
     const std::vector<double>& likelihoods);
 
+// Batch routines.
+//
+// Genotype likelihood code applies the conversions above to every base of
+// every read, where the per-call std::pow / std::log10 and CHECKs dominate.
+// The routines below instead work over whole arrays, with branch-free inner
+// loops the compiler can vectorize. Each output span must have the size of the
+// corresponding input span.
+
+// Approximations of log10(x) and 10^x. FastLog10 is within 1e-15 of log10(x),
+// or within 1e-15 * |log10(x)| if |log10(x)| > 1, and matches std::log10 for
+// zero, negative, subnormal and non-finite inputs. FastPow10 is within a
+// relative error of 1e-15, except that it returns 0 for x < -307 and +inf for
+// x > 307, and propagates NaNs.
+double FastLog10(double x);
+double FastPow10(double x);
+void FastLog10(absl::Span<const double> values, absl::Span<double> log10s);
+void FastPow10(absl::Span<const double> log10s, absl::Span<double> values);
+
+// Converts Phred-scaled values to pError probabilities, exactly as
+// PhredToPError does, using a table for the common values in [0, 255].
+// Phred values must be >= 0.
+void PhredToPError(absl::Span<const int> phreds, absl::Span<double> perrors);
+
+// Returns log10(sum(10^log10_probs)) computed in a numerically-stable way, or
+// -inf if log10_probs is empty. Uses FastLog10 and FastPow10.
+double Log10SumExp(absl::Span<const double> log10_probs);
+
+// Subtracts Log10SumExp(log10_probs) from each of log10_probs, capping the
+// results at 0.0, so that sum(10^log10_probs) ~= 1. Each of log10_probs must be
+// <= 0.
+void NormalizeLog10ProbsInPlace(absl::Span<double> log10_probs);
+
+// ZeroShiftLikelihoods, without the copy.
+void ZeroShiftLikelihoodsInPlace(absl::Span<double> likelihoods);
+
+// Versions of the batch routines above on vectors, as used by the Python
+// wrappers.
+std::vector<double> FastLog10(const std::vector<double>& values);
+std::vector<double> FastPow10(const std::vector<double>& log10s);
+std::vector<double> PhredToPError(const std::vector<int>& phreds);
+double Log10SumExp(const std::vector<double>& log10_probs);
+std::vector<double> NormalizeLog10Probs(const std::vector<double>& log10_probs);
+
 }  // namespace nucleus
 
 #endif  // THIRD_PARTY_NUCLEUS_UTIL_MATH_H_
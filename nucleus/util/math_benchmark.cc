@@ -0,0 +1,170 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks of the batch routines of math.h against the scalar routines they
+// replace, over arrays of the given number of values. The sizes cover a
+// genotype's likelihoods, a read's base qualities and a large pileup.
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/types/span.h"
+#include "nucleus/util/math.h"
+
+namespace nucleus {
+
+namespace {
+
+// Returns n log10 probabilities in [-30, 0].
+std::vector<double> Log10Probs(int n) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> log10_prob(-30, 0);
+  std::vector<double> values(n);
+  for (double& value : values) value = log10_prob(rng);
+  return values;
+}
+
+// Returns n probabilities in (0, 1].
+std::vector<double> Probs(int n) {
+  std::vector<double> values = Log10Probs(n);
+  for (double& value : values) value = std::pow(10.0, value);
+  return values;
+}
+
+// Returns n Phred-scaled base qualities in [0, 60].
+std::vector<int> Phreds(int n) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> phred(0, 60);
+  std::vector<int> values(n);
+  for (int& value : values) value = phred(rng);
+  return values;
+}
+
+void SetProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+void BM_PhredToPErrorScalar(benchmark::State& state) {
+  const std::vector<int> phreds = Phreds(state.range(0));
+  std::vector<double> perrors(phreds.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < phreds.size(); ++i) {
+      perrors[i] = PhredToPError(phreds[i]);
+    }
+    benchmark::DoNotOptimize(perrors.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_PhredToPErrorBatch(benchmark::State& state) {
+  const std::vector<int> phreds = Phreds(state.range(0));
+  std::vector<double> perrors(phreds.size());
+  for (auto _ : state) {
+    PhredToPError(phreds, absl::MakeSpan(perrors));
+    benchmark::DoNotOptimize(perrors.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_Log10Scalar(benchmark::State& state) {
+  const std::vector<double> perrors = Probs(state.range(0));
+  std::vector<double> log10s(perrors.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < perrors.size(); ++i) {
+      log10s[i] = PErrorToLog10PError(perrors[i]);
+    }
+    benchmark::DoNotOptimize(log10s.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_Log10Batch(benchmark::State& state) {
+  const std::vector<double> perrors = Probs(state.range(0));
+  std::vector<double> log10s(perrors.size());
+  for (auto _ : state) {
+    FastLog10(perrors, absl::MakeSpan(log10s));
+    benchmark::DoNotOptimize(log10s.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_Pow10Scalar(benchmark::State& state) {
+  const std::vector<double> log10s = Log10Probs(state.range(0));
+  std::vector<double> values(log10s.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < log10s.size(); ++i) {
+      values[i] = Log10ToReal(log10s[i]);
+    }
+    benchmark::DoNotOptimize(values.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_Pow10Batch(benchmark::State& state) {
+  const std::vector<double> log10s = Log10Probs(state.range(0));
+  std::vector<double> values(log10s.size());
+  for (auto _ : state) {
+    FastPow10(log10s, absl::MakeSpan(values));
+    benchmark::DoNotOptimize(values.data());
+  }
+  SetProcessed(state);
+}
+
+// The computation of genomics_math.normalize_log10_probs, on the scalar
+// routines.
+void BM_NormalizeLog10ProbsScalar(benchmark::State& state) {
+  const std::vector<double> log10_probs = Log10Probs(state.range(0));
+  std::vector<double> normalized(log10_probs.size());
+  for (auto _ : state) {
+    const double max = *std::max_element(log10_probs.begin(),
+                                         log10_probs.end());
+    double sum = 0;
+    for (double log10_prob : log10_probs) sum += Log10ToReal(log10_prob - max);
+    const double lse = max + std::log10(sum);
+    for (size_t i = 0; i < log10_probs.size(); ++i) {
+      normalized[i] = std::min(log10_probs[i] - lse, 0.0);
+    }
+    benchmark::DoNotOptimize(normalized.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_NormalizeLog10ProbsBatch(benchmark::State& state) {
+  const std::vector<double> log10_probs = Log10Probs(state.range(0));
+  std::vector<double> normalized(log10_probs.size());
+  for (auto _ : state) {
+    std::copy(log10_probs.begin(), log10_probs.end(), normalized.begin());
+    NormalizeLog10ProbsInPlace(absl::MakeSpan(normalized));
+    benchmark::DoNotOptimize(normalized.data());
+  }
+  SetProcessed(state);
+}
+
+BENCHMARK(BM_PhredToPErrorScalar)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_PhredToPErrorBatch)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_Log10Scalar)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_Log10Batch)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_Pow10Scalar)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_Pow10Batch)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_NormalizeLog10ProbsScalar)->Arg(3)->Arg(100)->Arg(10000);
+BENCHMARK(BM_NormalizeLog10ProbsBatch)->Arg(3)->Arg(100)->Arg(10000);
+
+}  // namespace nucleus
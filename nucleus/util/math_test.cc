@@ -17,6 +17,11 @@
 
 #include "nucleus/util/math.h"
 
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
 #include <gmock/gmock-generated-matchers.h>
 #include <gmock/gmock-matchers.h>
 #include <gmock/gmock-more-matchers.h>
@@ -28,7 +33,10 @@ namespace nucleus {
 using ::testing::Eq;
 using ::testing::DoubleEq;
 using ::testing::DoubleNear;
+using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::IsNan;
+using ::testing::Pointwise;
 
 constexpr double TOL = 1e-4;
 
@@ -146,4 +154,95 @@ TEST(ZeroShiftLikelihoods, HandlesValidInputs) {
               ElementsAreArray({0.0, -97.7, -85.0}));
 }
 
+TEST(FastLog10, MatchesLog10) {
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<double> exponent(-1020, 1020);
+  std::vector<double> values(100000);
+  for (double& value : values) value = std::exp2(exponent(rng));
+  std::vector<double> log10s(values.size());
+  FastLog10(values, absl::MakeSpan(log10s));
+  for (size_t i = 0; i < values.size(); ++i) {
+    const double expected = std::log10(values[i]);
+    const double tolerance = 1e-15 * std::max(1.0, std::abs(expected));
+    ASSERT_THAT(log10s[i], DoubleNear(expected, tolerance)) << values[i];
+    ASSERT_THAT(FastLog10(values[i]), DoubleEq(log10s[i]));
+  }
+}
+
+TEST(FastLog10, HandlesSpecialValues) {
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_THAT(FastLog10(1.0), Eq(0.0));
+  EXPECT_THAT(FastLog10(0.0), Eq(-inf));
+  EXPECT_THAT(FastLog10(inf), Eq(inf));
+  EXPECT_THAT(FastLog10(-1.0), IsNan());
+  EXPECT_THAT(FastLog10(1e-310), DoubleEq(std::log10(1e-310)));
+  EXPECT_THAT(FastLog10(std::vector<double>{0.1, 0.0, 1e-310}),
+              ElementsAre(DoubleEq(-1.0), Eq(-inf),
+                          DoubleEq(std::log10(1e-310))));
+}
+
+TEST(FastPow10, MatchesPow) {
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<double> log10(-307, 307);
+  std::vector<double> log10s(100000);
+  for (double& x : log10s) x = log10(rng);
+  std::vector<double> values(log10s.size());
+  FastPow10(log10s, absl::MakeSpan(values));
+  for (size_t i = 0; i < log10s.size(); ++i) {
+    const double expected = std::pow(10.0, log10s[i]);
+    ASSERT_THAT(values[i], DoubleNear(expected, 1e-15 * expected))
+        << log10s[i];
+    ASSERT_THAT(FastPow10(log10s[i]), DoubleEq(values[i]));
+  }
+}
+
+TEST(FastPow10, HandlesSpecialValues) {
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_THAT(FastPow10(0.0), DoubleEq(1.0));
+  EXPECT_THAT(FastPow10(-2.0), DoubleEq(0.01));
+  EXPECT_THAT(FastPow10(-400.0), Eq(0.0));
+  EXPECT_THAT(FastPow10(-inf), Eq(0.0));
+  EXPECT_THAT(FastPow10(400.0), Eq(inf));
+  EXPECT_THAT(FastPow10(std::nan("")), IsNan());
+}
+
+TEST(PhredToPErrorBatch, MatchesScalar) {
+  std::vector<int> phreds;
+  for (int phred = 0; phred < 300; ++phred) phreds.push_back(phred);
+  const std::vector<double> perrors = PhredToPError(phreds);
+  ASSERT_EQ(phreds.size(), perrors.size());
+  for (size_t i = 0; i < phreds.size(); ++i) {
+    EXPECT_THAT(perrors[i], Eq(PhredToPError(phreds[i])));
+  }
+}
+
+TEST(Log10SumExp, HandlesValidInputs) {
+  using V = std::vector<double>;
+  const double inf = std::numeric_limits<double>::infinity();
+  EXPECT_THAT(Log10SumExp(V{0.0}), DoubleEq(0.0));
+  EXPECT_THAT(Log10SumExp(V{0.0, -10000.0}), DoubleEq(0.0));
+  EXPECT_THAT(Log10SumExp(V{-1000.0, -10000.0}), DoubleEq(-1000.0));
+  EXPECT_THAT(Log10SumExp(V{-1, -10, -1}), DoubleNear(-0.69897, TOL));
+  EXPECT_THAT(Log10SumExp(V{-1, -1, -1, -100, -1000}),
+              DoubleNear(-0.5228787, TOL));
+  EXPECT_THAT(Log10SumExp(V{-inf, -inf}), Eq(-inf));
+  EXPECT_THAT(Log10SumExp(V{}), Eq(-inf));
+}
+
+TEST(NormalizeLog10Probs, HandlesValidInputs) {
+  EXPECT_THAT(NormalizeLog10Probs({0.0}), ElementsAreArray({0.0}));
+  EXPECT_THAT(NormalizeLog10Probs({-1.0, -2.0, -3.0, -100.0}),
+              Pointwise(DoubleNear(1e-6),
+                        {-0.045323, -1.045323, -2.045323, -99.045323}));
+  std::vector<double> log10_probs = {-1.0, -100.0};
+  NormalizeLog10ProbsInPlace(absl::MakeSpan(log10_probs));
+  EXPECT_THAT(log10_probs, Pointwise(DoubleNear(1e-6), {0.0, -99.0}));
+}
+
+TEST(ZeroShiftLikelihoodsInPlace, HandlesValidInputs) {
+  std::vector<double> test_data{-3.0, -100.7, -88.0};
+  ZeroShiftLikelihoodsInPlace(absl::MakeSpan(test_data));
+  EXPECT_THAT(test_data, ElementsAreArray({0.0, -97.7, -85.0}));
+}
+
 }  // namespace nucleus
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Sorting of large in-memory arrays over several threads.
+#ifndef THIRD_PARTY_NUCLEUS_UTIL_PARALLEL_SORT_H_
+#define THIRD_PARTY_NUCLEUS_UTIL_PARALLEL_SORT_H_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace nucleus {
+
+// Sorts [first, last) by comp, splitting the work over num_threads threads:
+// each sorts a part of the range, then neighbouring parts are merged in
+// rounds until one remains. Like std::sort, the sort is not stable.
+template <class RandomIt, class Compare>
+void ParallelSort(RandomIt first, RandomIt last, int num_threads,
+                  Compare comp) {
+  const size_t size = std::distance(first, last);
+  const size_t num_parts = std::max(1, num_threads);
+  const size_t part_size = (size + num_parts - 1) / num_parts;
+  if (num_parts == 1 || part_size == 0) {
+    std::sort(first, last, comp);
+    return;
+  }
+  const auto part_begin = [&](size_t part) {
+    return first + std::min(part * part_size, size);
+  };
+  std::vector<std::thread> threads;
+  for (size_t part = 0; part < num_parts; ++part) {
+    threads.emplace_back([&part_begin, &comp, part]() {
+      std::sort(part_begin(part), part_begin(part + 1), comp);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (size_t width = 1; width < num_parts; width *= 2) {
+    threads.clear();
+    for (size_t part = 0; part + width < num_parts; part += 2 * width) {
+      threads.emplace_back([&part_begin, &comp, part, width]() {
+        std::inplace_merge(part_begin(part), part_begin(part + width),
+                           part_begin(part + 2 * width), comp);
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+template <class RandomIt>
+void ParallelSort(RandomIt first, RandomIt last, int num_threads) {
+  ParallelSort(first, last, num_threads, std::less<>());
+}
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_UTIL_PARALLEL_SORT_H_
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/util/parallel_sort.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace nucleus {
+
+using ::testing::Eq;
+
+class ParallelSortTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(ParallelSortTest, MatchesStdSort) {
+  std::mt19937 rng(GetParam());
+  for (const size_t size : {0, 1, 2, 7, 1000, 12345}) {
+    std::vector<int> values(size);
+    for (int& value : values) value = rng() % 100;
+    std::vector<int> expected = values;
+    std::sort(expected.begin(), expected.end());
+    ParallelSort(values.begin(), values.end(), GetParam());
+    EXPECT_THAT(values, Eq(expected));
+  }
+}
+
+TEST_P(ParallelSortTest, UsesComparator) {
+  std::vector<int> values = {3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+  ParallelSort(values.begin(), values.end(), GetParam(), std::greater<int>());
+  EXPECT_TRUE(std::is_sorted(values.begin(), values.end(),
+                             std::greater<int>()));
+}
+
+INSTANTIATE_TEST_CASE_P(NumThreads, ParallelSortTest,
+                        ::testing::Values(0, 1, 2, 3, 8));
+
+}  // namespace nucleus
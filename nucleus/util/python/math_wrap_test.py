@@ -56,6 +56,27 @@ class MathWrapTest(absltest.TestCase):
     self.assertSequenceEqual([0, -1, -2],
                              math.zero_shift_log10_probs([-1, -2, -3]))
 
+  def test_fast_log10(self):
+    for actual, expected in zip(math.fast_log10([0.1, 1, 1000]), [-1, 0, 3]):
+      self.assertAlmostEqual(expected, actual)
+
+  def test_fast_pow10(self):
+    for actual, expected in zip(math.fast_pow10([-1, 0, 3]), [0.1, 1, 1000]):
+      self.assertAlmostEqual(expected, actual)
+
+  def test_phreds_to_perrors(self):
+    self.assertSequenceEqual([1.0, 0.1, 0.01],
+                             math.phreds_to_perrors([0, 10, 20]))
+
+  def test_log10sumexp(self):
+    self.assertAlmostEqual(-0.5228787, math.log10sumexp([-1, -1, -1, -100]))
+
+  def test_normalize_log10_probs(self):
+    for actual, expected in zip(
+        math.normalize_log10_probs([-1, -2, -100]),
+        [-0.041393, -1.041393, -99.041393]):
+      self.assertAlmostEqual(expected, actual, places=6)
+
 
 if __name__ == '__main__':
   absltest.main()
@@ -0,0 +1,60 @@
+# Copyright 2018 Google LLC.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tests for sequence kernel CLIF python wrappers."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from absl.testing import absltest
+
+from nucleus.util.python import sequence_kernels
+
+
+class SequenceKernelsWrapTest(absltest.TestCase):
+
+  def test_find_non_acgt_base(self):
+    self.assertEqual(-1, sequence_kernels.find_non_acgt_base('ACGT', False))
+    self.assertEqual(2, sequence_kernels.find_non_acgt_base('ACNT', False))
+    self.assertEqual(-1, sequence_kernels.find_non_acgt_base('ACNT', True))
+    self.assertEqual(0, sequence_kernels.find_non_acgt_base('aCGT', True))
+
+  def test_reverse_complement(self):
+    self.assertEqual((True, 'nGTRac'),
+                     sequence_kernels.reverse_complement('gtYACn'))
+    self.assertFalse(sequence_kernels.reverse_complement('ACXT')[0])
+
+  def test_to_upper(self):
+    self.assertEqual('ACGTN', sequence_kernels.to_upper('acgTn'))
+
+  def test_count_gc_and_n(self):
+    self.assertEqual((4, 2), sequence_kernels.count_gc_and_n('GCgcATNn'))
+
+  def test_pack_two_bit(self):
+    ok, packed = sequence_kernels.pack_two_bit('ACGTt')
+    self.assertTrue(ok)
+    self.assertEqual(b'\x1b\xc0', packed)
+    self.assertEqual('ACGTT', sequence_kernels.unpack_two_bit(packed, 5))
+    self.assertFalse(sequence_kernels.pack_two_bit('ACGN')[0])
+
+  def test_unpack_two_bit_rejects_bad_lengths(self):
+    with self.assertRaisesRegexp(ValueError, 'n_bases must be in'):
+      sequence_kernels.unpack_two_bit(b'\x1b', 5)
+    with self.assertRaisesRegexp(ValueError, 'n_bases must be in'):
+      sequence_kernels.unpack_two_bit(b'\x1b', -1)
+    self.assertEqual('', sequence_kernels.unpack_two_bit(b'', 0))
+
+
+if __name__ == '__main__':
+  absltest.main()
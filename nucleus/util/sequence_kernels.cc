@@ -0,0 +1,467 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Implementation of sequence_kernels.h
+#include "nucleus/util/sequence_kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "tensorflow/core/platform/logging.h"
+
+// The AVX2 kernels are compiled with target attributes, so the rest of the
+// build needs no special flags, and are only run if the CPU supports AVX2.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NUCLEUS_HAVE_AVX2_KERNELS 1
+#include <immintrin.h>
+#define NUCLEUS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace nucleus {
+
+namespace {
+
+// The characters of BAM's 4-bit base encoding.
+constexpr char kNt16Chars[] = "=ACMGRSVTWYHKDBN";
+
+// The characters of the 2-bit base encoding of PackTwoBit.
+constexpr char kTwoBitChars[] = "ACGT";
+
+// Per-character lookup tables of the scalar kernels.
+struct Tables {
+  Tables();
+
+  // 1 for the characters FindNonAcgtBase accepts, without and with N.
+  uint8 acgt[256];
+  uint8 acgtn[256];
+  // The complement of each IUPAC code, or 0.
+  char complement[256];
+  // The 2-bit code of each base, or 4 if it has none.
+  uint8 two_bit_code[256];
+  // The four bases of each byte written by PackTwoBit.
+  char two_bit_bases[256][4];
+  // The two bases of each byte of BAM's 4-bit encoding.
+  char nt16_bases[256][2];
+};
+
+Tables::Tables() {
+  std::memset(acgt, 0, sizeof(acgt));
+  std::memset(acgtn, 0, sizeof(acgtn));
+  std::memset(complement, 0, sizeof(complement));
+  std::memset(two_bit_code, 4, sizeof(two_bit_code));
+  for (const char base : {'A', 'C', 'G', 'T'}) {
+    acgt[static_cast<uint8>(base)] = 1;
+    acgtn[static_cast<uint8>(base)] = 1;
+  }
+  acgtn[static_cast<uint8>('N')] = 1;
+
+  constexpr char kComplementPairs[][2] = {
+      {'A', 'T'}, {'C', 'G'}, {'R', 'Y'}, {'S', 'S'}, {'W', 'W'},
+      {'K', 'M'}, {'B', 'V'}, {'D', 'H'}, {'N', 'N'}};
+  for (const auto& pair : kComplementPairs) {
+    for (const int lowercase : {0, 0x20}) {
+      const char a = pair[0] | lowercase;
+      const char b = pair[1] | lowercase;
+      complement[static_cast<uint8>(a)] = b;
+      complement[static_cast<uint8>(b)] = a;
+    }
+  }
+
+  for (int code = 0; code < 4; ++code) {
+    const char base = kTwoBitChars[code];
+    two_bit_code[static_cast<uint8>(base)] = code;
+    two_bit_code[static_cast<uint8>(base | 0x20)] = code;
+  }
+  for (int byte = 0; byte < 256; ++byte) {
+    for (int i = 0; i < 4; ++i) {
+      two_bit_bases[byte][i] = kTwoBitChars[(byte >> (6 - 2 * i)) & 3];
+    }
+    nt16_bases[byte][0] = kNt16Chars[byte >> 4];
+    nt16_bases[byte][1] = kNt16Chars[byte & 0xF];
+  }
+}
+
+const Tables& GetTables() {
+  static const Tables* const tables = new Tables;
+  return *tables;
+}
+
+// Scalar kernels, which the AVX2 kernels also use for the bases left over
+// after their last full block.
+
+size_t FindNonAcgtBaseScalar(const char* bases, size_t length, bool allow_n) {
+  const uint8* accepted = allow_n ? GetTables().acgtn : GetTables().acgt;
+  for (size_t i = 0; i < length; ++i) {
+    if (!accepted[static_cast<uint8>(bases[i])]) return i;
+  }
+  return string::npos;
+}
+
+bool ReverseComplementScalar(const char* bases, size_t length, char* out) {
+  const char* complement = GetTables().complement;
+  bool ok = true;
+  for (size_t i = 0; i < length; ++i) {
+    const char c = complement[static_cast<uint8>(bases[length - 1 - i])];
+    out[i] = c;
+    ok &= c != 0;
+  }
+  return ok;
+}
+
+void ToUpperScalar(char* bases, size_t length) {
+  for (size_t i = 0; i < length; ++i) {
+    if (bases[i] >= 'a' && bases[i] <= 'z') bases[i] -= 'a' - 'A';
+  }
+}
+
+void CountGcAndNScalar(const char* bases, size_t length, int64* gc,
+                       int64* n) {
+  for (size_t i = 0; i < length; ++i) {
+    // Clears the lowercase bit.
+    const uint8 upper = static_cast<uint8>(bases[i]) & 0xDF;
+    *gc += upper == 'G' || upper == 'C';
+    *n += upper == 'N';
+  }
+}
+
+bool PackTwoBitScalar(const char* bases, size_t length, uint8* packed) {
+  const uint8* two_bit_code = GetTables().two_bit_code;
+  uint8 invalid = 0;
+  for (size_t i = 0; i < length; i += 4) {
+    uint8 byte = 0;
+    for (size_t j = i; j < i + 4; ++j) {
+      const uint8 code = j < length ? two_bit_code[static_cast<uint8>(bases[j])]
+                                    : 0;
+      invalid |= code;
+      byte = (byte << 2) | (code & 3);
+    }
+    packed[i / 4] = byte;
+  }
+  return !(invalid & 4);
+}
+
+void DecodeNt16Scalar(const uint8* packed, size_t n_bases, char* out) {
+  const auto& nt16_bases = GetTables().nt16_bases;
+  for (size_t i = 0; i < n_bases / 2; ++i) {
+    std::memcpy(out + 2 * i, nt16_bases[packed[i]], 2);
+  }
+  if (n_bases % 2) out[n_bases - 1] = kNt16Chars[packed[n_bases / 2] >> 4];
+}
+
+#ifdef NUCLEUS_HAVE_AVX2_KERNELS
+
+// AVX2 kernels, processing blocks of 32 bases.
+
+NUCLEUS_TARGET_AVX2 __m256i Load(const void* p) {
+  return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+}
+
+NUCLEUS_TARGET_AVX2 void Store(void* p, __m256i v) {
+  _mm256_storeu_si256(static_cast<__m256i*>(p), v);
+}
+
+// The same 16 bytes in both 128-bit lanes, for byte shuffles.
+NUCLEUS_TARGET_AVX2 __m256i Broadcast16(const char* bytes) {
+  return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)));
+}
+
+NUCLEUS_TARGET_AVX2 size_t FindNonAcgtBaseAvx2(const char* bases,
+                                               size_t length, bool allow_n) {
+  const __m256i a = _mm256_set1_epi8('A');
+  const __m256i c = _mm256_set1_epi8('C');
+  const __m256i g = _mm256_set1_epi8('G');
+  const __m256i t = _mm256_set1_epi8('T');
+  const __m256i n = _mm256_set1_epi8(allow_n ? 'N' : 'A');
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    const __m256i v = Load(bases + i);
+    const __m256i ok = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, a), _mm256_cmpeq_epi8(v, c)),
+        _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, g), _mm256_cmpeq_epi8(v, t)),
+            _mm256_cmpeq_epi8(v, n)));
+    const uint32 bad = ~static_cast<uint32>(_mm256_movemask_epi8(ok));
+    if (bad != 0) return i + __builtin_ctz(bad);
+  }
+  const size_t rest = FindNonAcgtBaseScalar(bases + i, length - i, allow_n);
+  return rest == string::npos ? rest : i + rest;
+}
+
+NUCLEUS_TARGET_AVX2 bool ReverseComplementAvx2(const char* bases,
+                                               size_t length, char* out) {
+  // The complements of the uppercase characters 0x40 to 0x4F and 0x50 to
+  // 0x5F, indexed by their low 4 bits, or 0 if they have none.
+  static constexpr char kLowComplements[16] = {
+      0, 'T', 'V', 'G', 'H', 0, 0, 'C', 'D', 0, 0, 'M', 0, 'K', 'N', 0};
+  static constexpr char kHighComplements[16] = {
+      0, 0, 'Y', 'S', 'A', 0, 'B', 'W', 0, 'R', 0, 0, 0, 0, 0, 0};
+  static constexpr char kReverse[16] = {15, 14, 13, 12, 11, 10, 9, 8,
+                                        7,  6,  5,  4,  3,  2,  1, 0};
+  const __m256i low_complements = Broadcast16(kLowComplements);
+  const __m256i high_complements = Broadcast16(kHighComplements);
+  const __m256i reverse = Broadcast16(kReverse);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i valid = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i v = Load(bases + length - i - 32);
+    // Reverses the bytes of each lane, then swaps the lanes.
+    v = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, reverse), 0x4E);
+    const __m256i index = _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+    const __m256i high = _mm256_cmpeq_epi8(
+        _mm256_and_si256(v, _mm256_set1_epi8(0x10)), _mm256_set1_epi8(0x10));
+    const __m256i complement =
+        _mm256_blendv_epi8(_mm256_shuffle_epi8(low_complements, index),
+                           _mm256_shuffle_epi8(high_complements, index), high);
+    // Letters are 0x40 to 0x7F, with bit 0x20 set in lowercase.
+    const __m256i letter = _mm256_cmpeq_epi8(
+        _mm256_and_si256(v, _mm256_set1_epi8(static_cast<char>(0xC0))),
+        _mm256_set1_epi8(0x40));
+    valid = _mm256_and_si256(
+        valid,
+        _mm256_andnot_si256(_mm256_cmpeq_epi8(complement, zero), letter));
+    Store(out + i, _mm256_or_si256(
+                       complement,
+                       _mm256_and_si256(v, _mm256_set1_epi8(0x20))));
+  }
+  const bool ok = ReverseComplementScalar(bases, length - i, out + i);
+  return ok && _mm256_movemask_epi8(valid) == -1;
+}
+
+NUCLEUS_TARGET_AVX2 void ToUpperAvx2(char* bases, size_t length) {
+  const __m256i before_a = _mm256_set1_epi8('a' - 1);
+  const __m256i after_z = _mm256_set1_epi8('z' + 1);
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    const __m256i v = Load(bases + i);
+    // Bytes >= 0x80 are negative, and so not lowercase.
+    const __m256i lowercase = _mm256_and_si256(
+        _mm256_cmpgt_epi8(v, before_a), _mm256_cmpgt_epi8(after_z, v));
+    Store(bases + i, _mm256_xor_si256(v, _mm256_and_si256(lowercase, case_bit)));
+  }
+  ToUpperScalar(bases + i, length - i);
+}
+
+// Returns the sum of the bytes of v.
+NUCLEUS_TARGET_AVX2 int64 SumBytes(__m256i v) {
+  const __m256i sums = _mm256_sad_epu8(v, _mm256_setzero_si256());
+  return _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+         _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+}
+
+NUCLEUS_TARGET_AVX2 void CountGcAndNAvx2(const char* bases, size_t length,
+                                         int64* gc, int64* n) {
+  const __m256i uppercase = _mm256_set1_epi8(static_cast<char>(0xDF));
+  const __m256i g = _mm256_set1_epi8('G');
+  const __m256i c = _mm256_set1_epi8('C');
+  const __m256i n_base = _mm256_set1_epi8('N');
+  size_t i = 0;
+  while (i + 32 <= length) {
+    // Counts in bytes, which hold the counts of up to 255 blocks.
+    __m256i gc_counts = _mm256_setzero_si256();
+    __m256i n_counts = _mm256_setzero_si256();
+    const size_t end = i + 32 * std::min<size_t>((length - i) / 32, 255);
+    for (; i < end; i += 32) {
+      const __m256i v = _mm256_and_si256(Load(bases + i), uppercase);
+      // Matches are -1, so subtracting them counts them.
+      gc_counts = _mm256_sub_epi8(
+          gc_counts,
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, g), _mm256_cmpeq_epi8(v, c)));
+      n_counts = _mm256_sub_epi8(n_counts, _mm256_cmpeq_epi8(v, n_base));
+    }
+    *gc += SumBytes(gc_counts);
+    *n += SumBytes(n_counts);
+  }
+  CountGcAndNScalar(bases + i, length - i, gc, n);
+}
+
+NUCLEUS_TARGET_AVX2 bool PackTwoBitAvx2(const char* bases, size_t length,
+                                        uint8* packed) {
+  const __m256i uppercase = _mm256_set1_epi8(static_cast<char>(0xDF));
+  const __m256i a = _mm256_set1_epi8('A');
+  const __m256i c = _mm256_set1_epi8('C');
+  const __m256i g = _mm256_set1_epi8('G');
+  const __m256i t = _mm256_set1_epi8('T');
+  // Gathers byte 0 of each 32-bit element of a lane into its first 4 bytes,
+  // then the first 4 bytes of both lanes into the first 8 bytes.
+  static constexpr char kGather[16] = {0,  4,  8,  12, -1, -1, -1, -1,
+                                       -1, -1, -1, -1, -1, -1, -1, -1};
+  const __m256i gather = Broadcast16(kGather);
+  const __m256i join_lanes = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+  __m256i valid = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    const __m256i v = Load(bases + i);
+    const __m256i upper = _mm256_and_si256(v, uppercase);
+    valid = _mm256_and_si256(
+        valid,
+        _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(upper, a),
+                            _mm256_cmpeq_epi8(upper, c)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(upper, g),
+                            _mm256_cmpeq_epi8(upper, t))));
+    // ((base >> 1) ^ (base >> 2)) & 3 maps A, C, G and T, in either case, to
+    // 0, 1, 2 and 3. The 16-bit shifts move bits across bytes, but only into
+    // bits the mask clears.
+    const __m256i codes = _mm256_and_si256(
+        _mm256_xor_si256(_mm256_srli_epi16(v, 1), _mm256_srli_epi16(v, 2)),
+        _mm256_set1_epi8(3));
+    // Combines the codes of each pair of bases, then of each pair of pairs,
+    // the first in the highest bits.
+    const __m256i pairs =
+        _mm256_maddubs_epi16(codes, _mm256_set1_epi16(0x0104));
+    const __m256i quads =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00010010));
+    const __m256i bytes = _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(quads, gather), join_lanes);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(packed + i / 4),
+                     _mm256_castsi256_si128(bytes));
+  }
+  const bool ok = PackTwoBitScalar(bases + i, length - i, packed + i / 4);
+  return ok && _mm256_movemask_epi8(valid) == -1;
+}
+
+NUCLEUS_TARGET_AVX2 void DecodeNt16Avx2(const uint8* packed, size_t n_bases,
+                                        char* out) {
+  const __m256i chars = Broadcast16(kNt16Chars);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  size_t i = 0;  // Index into packed, which holds 2 bases per byte.
+  for (; 2 * (i + 32) <= n_bases; i += 32) {
+    const __m256i v = Load(packed + i);
+    const __m256i first = _mm256_shuffle_epi8(
+        chars, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble));
+    const __m256i second =
+        _mm256_shuffle_epi8(chars, _mm256_and_si256(v, low_nibble));
+    // Interleaves the bases within each lane, then puts the lanes in order.
+    const __m256i low = _mm256_unpacklo_epi8(first, second);
+    const __m256i high = _mm256_unpackhi_epi8(first, second);
+    Store(out + 2 * i, _mm256_permute2x128_si256(low, high, 0x20));
+    Store(out + 2 * i + 32, _mm256_permute2x128_si256(low, high, 0x31));
+  }
+  DecodeNt16Scalar(packed + i, n_bases - 2 * i, out + 2 * i);
+}
+
+#endif  // NUCLEUS_HAVE_AVX2_KERNELS
+
+// The kernels of one SimdLevel.
+struct Kernels {
+  SimdLevel level;
+  size_t (*find_non_acgt_base)(const char*, size_t, bool);
+  bool (*reverse_complement)(const char*, size_t, char*);
+  void (*to_upper)(char*, size_t);
+  void (*count_gc_and_n)(const char*, size_t, int64*, int64*);
+  bool (*pack_two_bit)(const char*, size_t, uint8*);
+  void (*decode_nt16)(const uint8*, size_t, char*);
+};
+
+constexpr Kernels kScalarKernels = {
+    SimdLevel::kScalar, FindNonAcgtBaseScalar, ReverseComplementScalar,
+    ToUpperScalar,      CountGcAndNScalar,     PackTwoBitScalar,
+    DecodeNt16Scalar};
+
+#ifdef NUCLEUS_HAVE_AVX2_KERNELS
+constexpr Kernels kAvx2Kernels = {
+    SimdLevel::kAvx2, FindNonAcgtBaseAvx2, ReverseComplementAvx2,
+    ToUpperAvx2,      CountGcAndNAvx2,     PackTwoBitAvx2,
+    DecodeNt16Avx2};
+#endif
+
+SimdLevel DetectSimdLevel() {
+#ifdef NUCLEUS_HAVE_AVX2_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return SimdLevel::kAvx2;
+#endif
+  return SimdLevel::kScalar;
+}
+
+const Kernels* KernelsFor(SimdLevel level) {
+#ifdef NUCLEUS_HAVE_AVX2_KERNELS
+  if (level == SimdLevel::kAvx2) return &kAvx2Kernels;
+#endif
+  return &kScalarKernels;
+}
+
+std::atomic<const Kernels*>& ActiveKernels() {
+  static std::atomic<const Kernels*> kernels(KernelsFor(DetectedSimdLevel()));
+  return kernels;
+}
+
+const Kernels& Active() {
+  return *ActiveKernels().load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+SimdLevel DetectedSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+SimdLevel ActiveSimdLevel() { return Active().level; }
+
+SimdLevel SetSimdLevel(SimdLevel level) {
+  if (level > DetectedSimdLevel()) level = DetectedSimdLevel();
+  ActiveKernels().store(KernelsFor(level), std::memory_order_relaxed);
+  return ActiveSimdLevel();
+}
+
+size_t FindNonAcgtBase(absl::string_view bases, bool allow_n) {
+  return Active().find_non_acgt_base(bases.data(), bases.size(), allow_n);
+}
+
+bool ReverseComplement(absl::string_view bases, string* out) {
+  out->resize(bases.size());
+  return Active().reverse_complement(bases.data(), bases.size(), &(*out)[0]);
+}
+
+void ToUpper(char* bases, size_t length) { Active().to_upper(bases, length); }
+
+void ToUpper(string* bases) { ToUpper(&(*bases)[0], bases->size()); }
+
+void CountGcAndN(absl::string_view bases, int64* gc, int64* n) {
+  *gc = 0;
+  *n = 0;
+  Active().count_gc_and_n(bases.data(), bases.size(), gc, n);
+}
+
+bool PackTwoBit(absl::string_view bases, string* packed) {
+  packed->assign((bases.size() + 3) / 4, '\0');
+  return Active().pack_two_bit(bases.data(), bases.size(),
+                               reinterpret_cast<uint8*>(&(*packed)[0]));
+}
+
+void UnpackTwoBit(absl::string_view packed, size_t n_bases, string* bases) {
+  CHECK_GE(packed.size(), (n_bases + 3) / 4);
+  const auto& two_bit_bases = GetTables().two_bit_bases;
+  bases->resize(n_bases);
+  char* out = &(*bases)[0];
+  for (size_t i = 0; i < n_bases / 4; ++i) {
+    std::memcpy(out + 4 * i, two_bit_bases[static_cast<uint8>(packed[i])], 4);
+  }
+  for (size_t i = n_bases / 4 * 4; i < n_bases; ++i) {
+    out[i] = two_bit_bases[static_cast<uint8>(packed[i / 4])][i % 4];
+  }
+}
+
+void DecodeNt16(const uint8* packed, size_t n_bases, char* out) {
+  Active().decode_nt16(packed, n_bases, out);
+}
+
+}  // namespace nucleus
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Kernels over DNA sequences, which run for every read and every reference
+// window.
+//
+// Each kernel has a portable scalar implementation and, on x86-64, an AVX2
+// implementation processing 32 bases at a time. The implementation is chosen
+// once, at first use, from the features of the CPU running the code; both
+// produce identical results.
+#ifndef THIRD_PARTY_NUCLEUS_UTIL_SEQUENCE_KERNELS_H_
+#define THIRD_PARTY_NUCLEUS_UTIL_SEQUENCE_KERNELS_H_
+
+#include "absl/strings/string_view.h"
+#include "nucleus/platform/types.h"
+#include "nucleus/vendor/statusor.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace nucleus {
+
+// The instruction sets the kernels can use, in increasing order of speed.
+enum class SimdLevel {
+  kScalar,
+  kAvx2,
+};
+
+// Returns the fastest SimdLevel supported by this CPU and build.
+SimdLevel DetectedSimdLevel();
+
+// Returns the SimdLevel the kernels currently use.
+SimdLevel ActiveSimdLevel();
+
+// Makes the kernels use level, or DetectedSimdLevel() if level is not
+// supported, and returns the level now active. For tests and benchmarks.
+SimdLevel SetSimdLevel(SimdLevel level);
+
+// Returns the index of the first base of bases that is not one of the
+// uppercase bases A, C, G and T, or also N if allow_n is true. Returns
+// string::npos if there is none.
+size_t FindNonAcgtBase(absl::string_view bases, bool allow_n);
+
+// Writes the reverse complement of bases to *out, preserving case. Handles the
+// IUPAC codes ACGTRYSWKMBDHVN in either case. Returns false, leaving *out
+// unspecified, if bases contains any other character.
+bool ReverseComplement(absl::string_view bases, string* out);
+
+// Converts the ASCII letters of bases to upper case, in place.
+void ToUpper(char* bases, size_t length);
+void ToUpper(string* bases);
+
+// Returns the numbers of G or C bases, and of N bases, in bases, ignoring
+// case.
+void CountGcAndN(absl::string_view bases, int64* gc, int64* n);
+
+// Packs bases into 2 bits each, encoding A, C, G and T as 0, 1, 2 and 3 and
+// ignoring case, four bases per byte with the first in the highest bits.
+// Writes (bases.size() + 3) / 4 bytes to *packed, zero-padding the last.
+// Returns false, leaving *packed unspecified, if bases contains any other
+// character.
+bool PackTwoBit(absl::string_view bases, string* packed);
+
+// Unpacks the first n_bases uppercase bases of packed, as written by
+// PackTwoBit, to *bases. packed must hold at least (n_bases + 3) / 4 bytes.
+void UnpackTwoBit(absl::string_view packed, size_t n_bases, string* bases);
+
+// Decodes n_bases bases of BAM's 4-bit encoding, two bases per byte with the
+// first in the high bits, to the characters of "=ACMGRSVTWYHKDBN" in out,
+// which must have room for n_bases characters.
+void DecodeNt16(const uint8* packed, size_t n_bases, char* out);
+
+// Wrappers of the kernels above for CLIF, which passes Python strings as
+// std::strings.
+inline int64 FindNonAcgtBasePython(const string& bases, bool allow_n) {
+  const size_t position = FindNonAcgtBase(bases, allow_n);
+  return position == string::npos ? -1 : static_cast<int64>(position);
+}
+
+inline bool ReverseComplementPython(const string& bases, string* out) {
+  return ReverseComplement(bases, out);
+}
+
+inline string ToUpperPython(const string& bases) {
+  string upper(bases);
+  ToUpper(&upper);
+  return upper;
+}
+
+inline void CountGcAndNPython(const string& bases, int64* gc, int64* n) {
+  CountGcAndN(bases, gc, n);
+}
+
+inline bool PackTwoBitPython(const string& bases, string* packed) {
+  return PackTwoBit(bases, packed);
+}
+
+// Unlike UnpackTwoBit, which CHECK-fails, this returns an error if packed is
+// too short to hold n_bases bases, or n_bases is negative.
+inline StatusOr<string> UnpackTwoBitPython(const string& packed,
+                                           int64 n_bases) {
+  if (n_bases < 0 || n_bases > 4 * static_cast<int64>(packed.size())) {
+    return tensorflow::errors::InvalidArgument(
+        "n_bases must be in [0, ", 4 * packed.size(), "] but is ", n_bases);
+  }
+  string bases;
+  UnpackTwoBit(packed, n_bases, &bases);
+  return bases;
+}
+
+}  // namespace nucleus
+
+#endif  // THIRD_PARTY_NUCLEUS_UTIL_SEQUENCE_KERNELS_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmarks of the kernels of sequence_kernels.h at each SimdLevel, over
+// sequences of the given number of bases: a short read, a long read and a
+// reference window.
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "nucleus/util/sequence_kernels.h"
+
+namespace nucleus {
+
+namespace {
+
+// Returns n random bases.
+string Bases(int n) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> index(0, 3);
+  string bases(n, ' ');
+  for (char& c : bases) c = "ACGT"[index(rng)];
+  return bases;
+}
+
+// Sets the SimdLevel of state.range(1), returning false and skipping the
+// benchmark if this CPU does not support it.
+bool SetLevel(benchmark::State& state) {
+  const SimdLevel level = static_cast<SimdLevel>(state.range(1));
+  if (SetSimdLevel(level) != level) {
+    state.SkipWithError("SimdLevel not supported");
+    return false;
+  }
+  return true;
+}
+
+void SetProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetLabel(state.range(1) == static_cast<int>(SimdLevel::kScalar)
+                     ? "scalar"
+                     : "avx2");
+}
+
+void Args(benchmark::internal::Benchmark* benchmark) {
+  for (const int level : {static_cast<int>(SimdLevel::kScalar),
+                          static_cast<int>(SimdLevel::kAvx2)}) {
+    for (const int n : {150, 10000, 1000000}) benchmark->Args({n, level});
+  }
+}
+
+}  // namespace
+
+void BM_FindNonAcgtBase(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  const string bases = Bases(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FindNonAcgtBase(bases, false));
+  }
+  SetProcessed(state);
+}
+
+void BM_ReverseComplement(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  const string bases = Bases(state.range(0));
+  string out;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReverseComplement(bases, &out));
+  }
+  SetProcessed(state);
+}
+
+void BM_ToUpper(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  string bases = Bases(state.range(0));
+  for (auto _ : state) {
+    ToUpper(&bases);
+    benchmark::DoNotOptimize(bases.data());
+  }
+  SetProcessed(state);
+}
+
+void BM_CountGcAndN(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  const string bases = Bases(state.range(0));
+  int64 gc, n;
+  for (auto _ : state) {
+    CountGcAndN(bases, &gc, &n);
+    benchmark::DoNotOptimize(gc);
+    benchmark::DoNotOptimize(n);
+  }
+  SetProcessed(state);
+}
+
+void BM_PackTwoBit(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  const string bases = Bases(state.range(0));
+  string packed;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PackTwoBit(bases, &packed));
+  }
+  SetProcessed(state);
+}
+
+void BM_DecodeNt16(benchmark::State& state) {
+  if (!SetLevel(state)) return;
+  const string bases = Bases(state.range(0));
+  const std::vector<uint8> packed(bases.begin(),
+                                  bases.begin() + (bases.size() + 1) / 2);
+  string out(bases.size(), ' ');
+  for (auto _ : state) {
+    DecodeNt16(packed.data(), out.size(), &out[0]);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetProcessed(state);
+}
+
+BENCHMARK(BM_FindNonAcgtBase)->Apply(Args);
+BENCHMARK(BM_ReverseComplement)->Apply(Args);
+BENCHMARK(BM_ToUpper)->Apply(Args);
+BENCHMARK(BM_CountGcAndN)->Apply(Args);
+BENCHMARK(BM_PackTwoBit)->Apply(Args);
+BENCHMARK(BM_DecodeNt16)->Apply(Args);
+
+}  // namespace nucleus
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2018 Google LLC.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "nucleus/util/sequence_kernels.h"
+
+#include <random>
+#include <vector>
+
+#include <gmock/gmock-generated-matchers.h>
+#include <gmock/gmock-matchers.h>
+#include <gmock/gmock-more-matchers.h>
+
+#include "tensorflow/core/platform/test.h"
+#include "nucleus/vendor/status_matchers.h"
+
+namespace nucleus {
+
+using ::testing::Eq;
+
+// Naive implementations the kernels are compared against.
+
+size_t NaiveFindNonAcgtBase(const string& bases, bool allow_n) {
+  const string accepted = allow_n ? "ACGTN" : "ACGT";
+  for (size_t i = 0; i < bases.size(); ++i) {
+    if (accepted.find(bases[i]) == string::npos) return i;
+  }
+  return string::npos;
+}
+
+char NaiveComplement(char base) {
+  const string from = "ACGTRYSWKMBDHVNacgtryswkmbdhvn";
+  const string to = "TGCAYRSWMKVHDBNtgcayrswmkvhdbn";
+  const size_t i = from.find(base);
+  return i == string::npos || base == '\0' ? '\0' : to[i];
+}
+
+string NaiveToUpper(string bases) {
+  for (char& c : bases) {
+    if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+  }
+  return bases;
+}
+
+// Returns a random sequence of length characters drawn from alphabet.
+string RandomSequence(std::mt19937* rng, const string& alphabet,
+                      size_t length) {
+  std::uniform_int_distribution<size_t> index(0, alphabet.size() - 1);
+  string bases(length, ' ');
+  for (char& c : bases) c = alphabet[index(*rng)];
+  return bases;
+}
+
+// Lengths covering empty inputs, partial and full SIMD blocks, and the tails
+// after them.
+std::vector<size_t> TestLengths() {
+  std::vector<size_t> lengths;
+  for (size_t length = 0; length <= 100; ++length) lengths.push_back(length);
+  lengths.push_back(1000);
+  // More blocks than the byte counters of CountGcAndN can hold.
+  lengths.push_back(32 * 300 + 7);
+  return lengths;
+}
+
+// Every byte value, so the kernels see non-ASCII and control characters too.
+string AllBytes() {
+  string bytes;
+  for (int c = 1; c < 256; ++c) bytes.push_back(static_cast<char>(c));
+  return bytes;
+}
+
+class SequenceKernelsTest : public ::testing::TestWithParam<SimdLevel> {
+ protected:
+  void SetUp() override {
+    previous_ = ActiveSimdLevel();
+    supported_ = SetSimdLevel(GetParam()) == GetParam();
+  }
+
+  void TearDown() override { SetSimdLevel(previous_); }
+
+  SimdLevel previous_;
+  bool supported_;
+  std::mt19937 rng_{1234};
+};
+
+TEST_P(SequenceKernelsTest, FindNonAcgtBase) {
+  if (!supported_) return;
+  for (const size_t length : TestLengths()) {
+    const string clean = RandomSequence(&rng_, "ACGT", length);
+    EXPECT_THAT(FindNonAcgtBase(clean, false), Eq(string::npos));
+    EXPECT_THAT(FindNonAcgtBase(clean, true), Eq(string::npos));
+    const string with_n = RandomSequence(&rng_, "ACGTN", length);
+    EXPECT_THAT(FindNonAcgtBase(with_n, true), Eq(string::npos));
+    EXPECT_THAT(FindNonAcgtBase(with_n, false),
+                Eq(NaiveFindNonAcgtBase(with_n, false)));
+    // A single bad base at each position of the last block.
+    for (size_t i = length >= 40 ? length - 40 : 0; i < length; ++i) {
+      for (const char bad : {'a', 'n', 'X', '\0', '\xC1'}) {
+        string bases = clean;
+        bases[i] = bad;
+        EXPECT_THAT(FindNonAcgtBase(bases, false), Eq(i));
+        EXPECT_THAT(FindNonAcgtBase(bases, true), Eq(i));
+      }
+    }
+  }
+}
+
+TEST_P(SequenceKernelsTest, ReverseComplement) {
+  if (!supported_) return;
+  for (const size_t length : TestLengths()) {
+    const string bases =
+        RandomSequence(&rng_, "ACGTRYSWKMBDHVNacgtryswkmbdhvn", length);
+    string expected(bases.rbegin(), bases.rend());
+    for (char& c : expected) c = NaiveComplement(c);
+    string out;
+    EXPECT_TRUE(ReverseComplement(bases, &out));
+    EXPECT_THAT(out, Eq(expected));
+    // Reverse complementing twice gives back the bases.
+    string twice;
+    EXPECT_TRUE(ReverseComplement(out, &twice));
+    EXPECT_THAT(twice, Eq(bases));
+  }
+}
+
+TEST_P(SequenceKernelsTest, ReverseComplementRejectsOtherCharacters) {
+  if (!supported_) return;
+  for (const char c : AllBytes()) {
+    for (const size_t length : {size_t{1}, size_t{40}, size_t{100}}) {
+      string bases = RandomSequence(&rng_, "ACGT", length);
+      bases[length / 3] = c;
+      string out;
+      EXPECT_THAT(ReverseComplement(bases, &out), Eq(NaiveComplement(c) != 0))
+          << "for character " << static_cast<int>(c);
+    }
+  }
+}
+
+TEST_P(SequenceKernelsTest, ToUpper) {
+  if (!supported_) return;
+  const string bytes = AllBytes();
+  for (const size_t length : TestLengths()) {
+    const string bases = RandomSequence(&rng_, bytes, length);
+    string upper = bases;
+    ToUpper(&upper);
+    EXPECT_THAT(upper, Eq(NaiveToUpper(bases)));
+  }
+}
+
+TEST_P(SequenceKernelsTest, CountGcAndN) {
+  if (!supported_) return;
+  for (const size_t length : TestLengths()) {
+    const string bases = RandomSequence(&rng_, "ACGTNacgtnX\xC7", length);
+    int64 expected_gc = 0;
+    int64 expected_n = 0;
+    for (const char c : bases) {
+      expected_gc += c == 'G' || c == 'C' || c == 'g' || c == 'c';
+      expected_n += c == 'N' || c == 'n';
+    }
+    int64 gc = -1;
+    int64 n = -1;
+    CountGcAndN(bases, &gc, &n);
+    EXPECT_THAT(gc, Eq(expected_gc));
+    EXPECT_THAT(n, Eq(expected_n));
+  }
+}
+
+TEST_P(SequenceKernelsTest, PackTwoBit) {
+  if (!supported_) return;
+  for (const size_t length : TestLengths()) {
+    const string bases = RandomSequence(&rng_, "ACGTacgt", length);
+    string packed;
+    EXPECT_TRUE(PackTwoBit(bases, &packed));
+    string expected((length + 3) / 4, '\0');
+    for (size_t i = 0; i < length; ++i) {
+      const int code = string("ACGT").find(NaiveToUpper(bases.substr(i, 1)));
+      expected[i / 4] |= code << (6 - 2 * (i % 4));
+    }
+    EXPECT_THAT(packed, Eq(expected));
+    string unpacked;
+    UnpackTwoBit(packed, length, &unpacked);
+    EXPECT_THAT(unpacked, Eq(NaiveToUpper(bases)));
+  }
+}
+
+TEST_P(SequenceKernelsTest, PackTwoBitRejectsOtherCharacters) {
+  if (!supported_) return;
+  for (const char c : AllBytes()) {
+    for (const size_t length : {size_t{1}, size_t{40}, size_t{100}}) {
+      string bases = RandomSequence(&rng_, "ACGT", length);
+      bases[length - 1 - length / 3] = c;
+      string packed;
+      const bool is_acgt = string("ACGTacgt").find(c) != string::npos;
+      EXPECT_THAT(PackTwoBit(bases, &packed), Eq(is_acgt))
+          << "for character " << static_cast<int>(c);
+    }
+  }
+}
+
+TEST_P(SequenceKernelsTest, DecodeNt16) {
+  if (!supported_) return;
+  const string nt16 = "=ACMGRSVTWYHKDBN";
+  for (const size_t length : TestLengths()) {
+    std::vector<uint8> packed((length + 1) / 2);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (uint8& b : packed) b = byte(rng_);
+    string expected;
+    for (size_t i = 0; i < length; ++i) {
+      expected.push_back(nt16[(packed[i / 2] >> (i % 2 ? 0 : 4)) & 0xF]);
+    }
+    string out(length, ' ');
+    DecodeNt16(packed.data(), length, &out[0]);
+    EXPECT_THAT(out, Eq(expected));
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(SimdLevels, SequenceKernelsTest,
+                        ::testing::Values(SimdLevel::kScalar,
+                                          SimdLevel::kAvx2));
+
+TEST(SetSimdLevel, ClampsToDetectedLevel) {
+  const SimdLevel previous = ActiveSimdLevel();
+  EXPECT_THAT(SetSimdLevel(SimdLevel::kScalar), Eq(SimdLevel::kScalar));
+  EXPECT_THAT(SetSimdLevel(SimdLevel::kAvx2), Eq(DetectedSimdLevel()));
+  SetSimdLevel(previous);
+}
+
+TEST(SequenceKernelsPython, WrappersMatchKernels) {
+  EXPECT_THAT(FindNonAcgtBasePython("ACGT", false), Eq(-1));
+  EXPECT_THAT(FindNonAcgtBasePython("ACNT", false), Eq(2));
+  EXPECT_THAT(FindNonAcgtBasePython("ACNT", true), Eq(-1));
+  EXPECT_THAT(ToUpperPython("acgTn"), Eq("ACGTN"));
+  int64 gc, n;
+  CountGcAndNPython("GCgcATNn", &gc, &n);
+  EXPECT_THAT(gc, Eq(4));
+  EXPECT_THAT(n, Eq(2));
+  string packed;
+  EXPECT_TRUE(PackTwoBitPython("ACGTA", &packed));
+  EXPECT_THAT(UnpackTwoBitPython(packed, 5).ValueOrDie(), Eq("ACGTA"));
+  EXPECT_THAT(UnpackTwoBitPython(packed, 8).ValueOrDie(), Eq("ACGTAAAA"));
+  EXPECT_THAT(UnpackTwoBitPython(packed, 9),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+  EXPECT_THAT(UnpackTwoBitPython(packed, -1),
+              IsNotOKWithCode(tensorflow::error::INVALID_ARGUMENT));
+}
+
+}  // namespace nucleus
@@ -17,6 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+from nucleus.util.python import sequence_kernels
 
 class Error(Exception):
   """Base error class."""
@@ -99,8 +100,50 @@ def reverse_complement(sequence, complement_dict=None):
   if complement_dict is None:
     complement_dict = STRICT_DNA_COMPLEMENT_UPPER
 
-  try:
-    return ''.join(complement_dict[nt] for nt in reversed(sequence))
-  except KeyError:
-    raise Error('Unknown base in {}, cannot reverse complement using {}'.format(
-        sequence, str(complement_dict)))
+  valid = _valid_for_kernel(sequence, complement_dict)
+  if valid is not None:
+    ok, complement = sequence_kernels.reverse_complement(sequence)
+    if valid and ok:
+      return complement
+  else:
+    try:
+      return ''.join(complement_dict[nt] for nt in reversed(sequence))
+    except KeyError:
+      pass
+  raise Error('Unknown base in {}, cannot reverse complement using {}'.format(
+      sequence, str(complement_dict)))
+
+
+def _valid_for_kernel(sequence, complement_dict):
+  """Returns whether the reverse complement kernel can handle sequence.
+
+  The kernel complements the IUPAC codes in either case and rejects anything
+  else, so for the dicts of this module only their narrower alphabets need
+  checking here.
+
+  Args:
+    sequence: str. The sequence passed to reverse_complement.
+    complement_dict: dict[str, str]. The dict passed to reverse_complement.
+
+  Returns:
+    None if sequence is not a str or complement_dict is not one of this
+    module's, and the kernel cannot be used. Otherwise whether sequence only
+    holds bases of complement_dict, IUPAC codes aside.
+  """
+  if not isinstance(sequence, str):
+    return None
+  if complement_dict is STRICT_DNA_COMPLEMENT_UPPER:
+    return sequence_kernels.find_non_acgt_base(sequence, False) == -1
+  elif complement_dict is DNA_COMPLEMENT_UPPER:
+    return sequence_kernels.find_non_acgt_base(sequence, True) == -1
+  elif complement_dict is STRICT_DNA_COMPLEMENT:
+    return sequence_kernels.find_non_acgt_base(
+        sequence_kernels.to_upper(sequence), False) == -1
+  elif complement_dict is DNA_COMPLEMENT:
+    return sequence_kernels.find_non_acgt_base(
+        sequence_kernels.to_upper(sequence), True) == -1
+  elif complement_dict is IUPAC_DNA_COMPLEMENT_UPPER:
+    return sequence_kernels.to_upper(sequence) == sequence
+  elif complement_dict is IUPAC_DNA_COMPLEMENT:
+    return True
+  return None
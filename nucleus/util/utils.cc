@@ -25,6 +25,7 @@
 #include "absl/strings/substitute.h"
 #include "nucleus/protos/cigar.pb.h"
 #include "nucleus/protos/reads.pb.h"
+#include "nucleus/util/sequence_kernels.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace nucleus {
@@ -77,13 +78,7 @@ bool IsCanonicalBase(const char base, const CanonicalBases canon) {
 }
 
 size_t FindNonCanonicalBase(string_view bases, const CanonicalBases canon) {
-  for (size_t i = 0; i < bases.size(); i++) {
-    // Meh.  This should be a static lookup table.
-    if (!IsCanonicalBase(bases[i], canon)) {
-      return i;
-    }
-  }
-  return string::npos;
+  return FindNonAcgtBase(bases, canon == CanonicalBases::ACGTN);
 }
 
 bool AreCanonicalBases(string_view bases, const CanonicalBases canon,
@@ -153,10 +148,26 @@ bool ReadOverlapsRegion(const ::nucleus::genomics::v1::Read& read,
       // This is the cheapest calculation as read start is cheap to determine.
       range.end() > ReadStart(read) &&
       // Next we check read end, which is slightly more expensive as we need to
-      // compute the end from the cigar.
+      // compute the end from the cigar, unless the reader cached it.
       range.start() < ReadEnd(read) &&
       // Finally we compute if the reference_names are the same.
-      range.reference_name() == AlignedContig(read);
+      range.reference_name() == read.alignment().position().reference_name();
+}
+
+std::vector<bool> ReadsOverlapRegion(absl::Span<const Read* const> reads,
+                                     const Range& range) {
+  std::vector<bool> overlaps(reads.size());
+  for (size_t i = 0; i < reads.size(); ++i) {
+    overlaps[i] = ReadOverlapsRegion(*reads[i], range);
+  }
+  return overlaps;
+}
+
+std::vector<bool> ReadsOverlapRegion(absl::Span<const Read> reads,
+                                     const Range& range) {
+  std::vector<const Read*> pointers(reads.size());
+  for (size_t i = 0; i < reads.size(); ++i) pointers[i] = &reads[i];
+  return ReadsOverlapRegion(pointers, range);
 }
 
 // Creates an interval string from its arguments, like chr:start-end
@@ -192,6 +203,7 @@ int64 ReadStart(const Read& read) {
 }
 
 int64 ReadEnd(const Read& read) {
+  if (read.alignment().cached_end() > 0) return read.alignment().cached_end();
   int64 position = ReadStart(read);
   for (const auto& cigar : read.alignment().cigar()) {
     switch (cigar.operation()) {
@@ -207,6 +219,18 @@ int64 ReadEnd(const Read& read) {
         break;
     }
   }
+  // Reads in the compact encoding have a packed cigar instead, each unit of
+  // which holds its length above the 4 bits of its BAM operation code. It is
+  // ignored if the read also has a cigar.
+  if (read.alignment().cigar_size() > 0) return position;
+  for (const uint32 packed : read.alignment().packed_cigar()) {
+    // The BAM codes of M, D, N, = and X, which consume the reference.
+    constexpr uint32 kConsumesReference =
+        (1 << 0) | (1 << 2) | (1 << 3) | (1 << 7) | (1 << 8);
+    if (kConsumesReference & (1 << (packed & 0xf))) {
+      position += packed >> 4;
+    }
+  }
 
   return position;
 }
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "nucleus/protos/position.pb.h"
 #include "nucleus/protos/range.pb.h"
 #include "nucleus/protos/reads.pb.h"
@@ -116,7 +117,8 @@ int64 ReadStart(const nucleus::genomics::v1::Read& read);
 // genome covered by cigar operations in the read. Note this means that the
 // end is INCLUSIVE, not exclusive, as many range operations are. Note that
 // this operation is substantially more expensive than ReadStart as the
-// end must be computed by examining the cigar elements of Read. Implements
+// end must be computed by examining the cigar elements of Read, unless the
+// reader cached it in the cached_end of its alignment. Implements
 // getReferenceLength (excludes padding) as found at:
 // http://grepcode.com/file/repo1.maven.org/maven2/org.seqdoop/htsjdk/1.118/htsjdk/samtools/Cigar.java#Cigar.getReferenceLength%28%29
 int64 ReadEnd(const nucleus::genomics::v1::Read& read);
@@ -159,6 +161,29 @@ inline bool ReadOverlapsRegionPython(
   return ReadOverlapsRegion(*(read_wrapped.p_), *(range_wrapped.p_));
 }
 
+// Returns, for each of reads, whether it overlaps range, as ReadOverlapsRegion
+// does.
+std::vector<bool> ReadsOverlapRegion(
+    absl::Span<const ::nucleus::genomics::v1::Read* const> reads,
+    const ::nucleus::genomics::v1::Range& range);
+std::vector<bool> ReadsOverlapRegion(
+    absl::Span<const ::nucleus::genomics::v1::Read> reads,
+    const ::nucleus::genomics::v1::Range& range);
+
+// Wrapper around ReadsOverlapRegion that tests a list of reads from Python in
+// one call.
+inline std::vector<bool> ReadsOverlapRegionPython(
+    const std::vector<
+        nucleus::ConstProtoPtr<const ::nucleus::genomics::v1::Read>>&
+        reads_wrapped,
+    const nucleus::ConstProtoPtr<const ::nucleus::genomics::v1::Range>
+        range_wrapped) {
+  std::vector<const ::nucleus::genomics::v1::Read*> reads;
+  reads.reserve(reads_wrapped.size());
+  for (const auto& read : reads_wrapped) reads.push_back(read.p_);
+  return ReadsOverlapRegion(reads, *(range_wrapped.p_));
+}
+
 // Returns true if the read is properly placed. We define properly placed as
 // read and mate both mapped to the same contig if mapped at all. This is less
 // strict than the proper pair SAM flag.
@@ -183,6 +208,8 @@ std::map<string, int> MapContigNameToPosInFasta(
 //  type Compare, when contextually converted to bool, yields true if the
 //  first argument of the call appears before the second in the strict weak
 //  ordering relation induced by this Compare type, and false otherwise."
+// SortByContigAndPosition in contig_dictionary.h sorts in the same order
+// without looking up names on every comparison.
 bool CompareVariants(const nucleus::genomics::v1::Variant& a,
                      const nucleus::genomics::v1::Variant& b,
                      const std::map<string, int>& contig_name_to_pos_in_fasta);
@@ -43,6 +43,22 @@ def read_overlaps_region(read, region):
   return utils_cpp.read_overlaps_region(read, region)
 
 
+def reads_overlap_region(reads, region):
+  """Returns whether each of reads overlaps region.
+
+  This is equivalent to calling read_overlaps_region on each read, but tests
+  all the reads in one call to C++.
+
+  Args:
+    reads: list of nucleus.genomics.v1.Read.
+    region: nucleus.genomics.v1.Range.
+
+  Returns:
+    A list of bool, True where the read overlaps region.
+  """
+  return utils_cpp.reads_overlap_region(list(reads), region)
+
+
 def read_range(read):
   """Creates a Range proto from the alignment of Read.
 
@@ -295,6 +295,50 @@ TEST(UtilsTest, TestReadEnd) {
   }
 }
 
+TEST(UtilsTest, TestReadEndUsesCachedEnd) {
+  Read read = MakeRead("chr20", 100, "TAAACCGT", {"8M"});
+  read.mutable_alignment()->set_cached_end(120);
+  EXPECT_EQ(120, ReadEnd(read));
+  EXPECT_THAT(MakeRange(read), EqualsProto(MakeRange("chr20", 100, 120)));
+  read.mutable_alignment()->clear_cached_end();
+  EXPECT_EQ(108, ReadEnd(read));
+}
+
+TEST(UtilsTest, TestReadEndWithPackedCigar) {
+  // 5H 1M 3I 19D 1M 3S, packed as length << 4 | BAM operation code.
+  Read read = MakeRead("chr20", 100, "TAAACCGT", {});
+  for (const uint32 packed : {5u << 4 | 5, 1u << 4 | 0, 3u << 4 | 1,
+                              19u << 4 | 2, 1u << 4 | 0, 3u << 4 | 4}) {
+    read.mutable_alignment()->add_packed_cigar(packed);
+  }
+  EXPECT_EQ(100 + 2 + 19, ReadEnd(read));
+
+  // The cigar wins over the packed cigar when a read has both.
+  read.mutable_alignment()->add_cigar()->set_operation_length(8);
+  read.mutable_alignment()->mutable_cigar(0)->set_operation(
+      CigarUnit::ALIGNMENT_MATCH);
+  EXPECT_EQ(108, ReadEnd(read));
+}
+
+TEST(UtilsTest, TestReadsOverlapRegion) {
+  std::vector<Read> reads = {
+      MakeRead("chr1", 10, "ACGT", {"4M"}),
+      MakeRead("chr1", 14, "ACGT", {"4M"}),
+      MakeRead("chr1", 5, "ACGT", {"2M", "10D", "2M"}),
+      MakeRead("chr2", 12, "ACGT", {"4M"}),
+      MakeRead("chr1", 20, "ACGT", {"4M"}),
+  };
+  reads[4].mutable_alignment()->set_cached_end(24);
+  const auto region = MakeRange("chr1", 12, 15);
+  const std::vector<bool> overlaps = ReadsOverlapRegion(reads, region);
+  EXPECT_THAT(overlaps, ElementsAre(true, true, true, false, false));
+  for (size_t i = 0; i < reads.size(); ++i) {
+    EXPECT_EQ(ReadOverlapsRegion(reads[i], region), overlaps[i]);
+  }
+  const std::vector<const Read*> pointers = {&reads[3], &reads[1]};
+  EXPECT_THAT(ReadsOverlapRegion(pointers, region), ElementsAre(false, true));
+}
+
 TEST(UtilsTest, TestIsReadProperlyPlaced) {
   Read read;
   read.set_fragment_name("read1");
@@ -148,6 +148,24 @@ class UtilsTest(parameterized.TestCase):
     check_overlaps(ref1, s1, e1, ref2, s2, e2, expected)
     check_overlaps(ref2, s2, e2, ref1, s1, e1, expected)
 
+  def test_reads_overlap_region(self):
+    reads = [
+        test_utils.make_read('AAAA', chrom='chr1', start=10, cigar='4M'),
+        test_utils.make_read('AAAA', chrom='chr1', start=15, cigar='4M'),
+        test_utils.make_read('AAAA', chrom='chr2', start=10, cigar='4M'),
+        test_utils.make_read('AA', chrom='chr1', start=2, cigar='1M10D1M'),
+    ]
+    region = ranges.make_range('chr1', 12, 15)
+    self.assertEqual([True, False, False, True],
+                     utils.reads_overlap_region(reads, region))
+    self.assertEqual([], utils.reads_overlap_region([], region))
+
+  def test_read_end_uses_cached_end(self):
+    read = test_utils.make_read('AAAA', chrom='chr1', start=10, cigar='4M')
+    self.assertEqual(14, utils.read_end(read))
+    read.alignment.cached_end = 20
+    self.assertEqual(20, utils.read_end(read))
+
 
 if __name__ == '__main__':
   absltest.main()